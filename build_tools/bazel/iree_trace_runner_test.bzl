@@ -215,13 +215,16 @@ def iree_generated_trace_runner_test(
         trace_runner: trace-runner program to run.
         timeout: timeout for the generated tests.
         target_cpu_features_variants: list of target cpu features variants. Currently unimplemented, so each
-            entry must be either "default" or start with "aarch64:" so as Bazel builds are currently x86-only,
-            we know that it is correct to ignore this.
+            entry must be either "default" or start with "aarch64:" or "x86_64:". Bazel builds are currently
+            x86-only so "aarch64:" entries can't apply, and "x86_64:" entries are skipped as they would only add
+            coverage on top of "default", so we know that it is correct to ignore this.
         **kwargs: any additional attributes to pass to the underlying tests and test suite.
     """
 
     for target_cpu_features in target_cpu_features_variants:
-        if not (target_cpu_features == "default" or target_cpu_features.startswith("aarch64:")):
+        if not (target_cpu_features == "default" or
+                target_cpu_features.startswith("aarch64:") or
+                target_cpu_features.startswith("x86_64:")):
             fail("Entry %s in target_cpu_features_variants: unimplemented" % target_cpu_features)
 
     tests = []
@@ -191,4 +191,23 @@
 #define IREE_ATTRIBUTE_UNUSED
 #endif  // IREE_HAVE_ATTRIBUTE(maybe_unused / unused)
 
+//===----------------------------------------------------------------------===//
+// IREE_THREAD_LOCAL
+//===----------------------------------------------------------------------===//
+
+// Declares a variable with thread storage duration. Only valid on variables of
+// static storage duration with constant initializers.
+//
+// Example:
+//   static IREE_THREAD_LOCAL int32_t thread_counter = 0;
+#if defined(__cplusplus)
+#define IREE_THREAD_LOCAL thread_local
+#elif defined(_MSC_VER)
+#define IREE_THREAD_LOCAL __declspec(thread)
+#elif defined(__GNUC__) || defined(__clang__)
+#define IREE_THREAD_LOCAL __thread
+#else
+#define IREE_THREAD_LOCAL _Thread_local
+#endif  // __cplusplus / _MSC_VER / __GNUC__
+
 #endif  // IREE_BASE_ATTRIBUTES_H_
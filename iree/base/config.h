@@ -195,6 +195,25 @@ typedef IREE_DEVICE_SIZE_T iree_device_size_t;
 #define IREE_VM_BACKTRACE_ENABLE 1
 #endif  // !IREE_VM_BACKTRACE_ENABLE
 
+#if !defined(IREE_VM_REF_THREAD_AFFINITY_ENABLE)
+// Enables thread-affine reference counting of ref objects (see
+// iree_vm_ref_object_make_thread_affine). Retains and releases of all objects
+// must check the counting mode when enabled and so this is opt-in for programs
+// that make use of it.
+#define IREE_VM_REF_THREAD_AFFINITY_ENABLE 0
+#endif  // !IREE_VM_REF_THREAD_AFFINITY_ENABLE
+
+#if !defined(IREE_VM_REF_THREAD_AFFINITY_CHECKS_ENABLE)
+// Enables verification that thread-affine ref objects are only retained and
+// released from the thread that owns them. Requires thread-local storage.
+#if !IREE_VM_REF_THREAD_AFFINITY_ENABLE || defined(NDEBUG) || \
+    IREE_SYNCHRONIZATION_DISABLE_UNSAFE
+#define IREE_VM_REF_THREAD_AFFINITY_CHECKS_ENABLE 0
+#else
+#define IREE_VM_REF_THREAD_AFFINITY_CHECKS_ENABLE 1
+#endif  // !IREE_VM_REF_THREAD_AFFINITY_ENABLE || NDEBUG || ...
+#endif  // !IREE_VM_REF_THREAD_AFFINITY_CHECKS_ENABLE
+
 #if !defined(IREE_VM_EXECUTION_TRACING_ENABLE)
 // Enables disassembly of vm bytecode functions and stderr dumping of execution.
 // Increases code size quite, lowers VM performance, and is generally unsafe;
@@ -96,6 +96,29 @@ typedef unsigned long long uint64_t;
 
 #endif  // !INT8_MIN
 
+//===----------------------------------------------------------------------===//
+// Vector types
+//===----------------------------------------------------------------------===//
+// Fixed-width vectors using the GCC/Clang vector extension that implement the
+// vector builtins below. Each bitcode variant is built with the ISA flags of
+// its target so the portable implementations lower to the target vector
+// instructions. How vectors are passed by value depends on the target ABI (and
+// its ISA flags) so they never appear in the exported signatures.
+
+#if defined(__GNUC__)
+#define IREE_DEVICE_HAVE_VECTOR_TYPES 1
+
+typedef float iree_device_f32x4_t __attribute__((vector_size(16)));
+typedef float iree_device_f32x8_t __attribute__((vector_size(32)));
+typedef int32_t iree_device_i32x4_t __attribute__((vector_size(16)));
+typedef int32_t iree_device_i32x8_t __attribute__((vector_size(32)));
+typedef uint32_t iree_device_u32x4_t __attribute__((vector_size(16)));
+typedef uint32_t iree_device_u32x8_t __attribute__((vector_size(32)));
+typedef int16_t iree_device_i16x4_t __attribute__((vector_size(8)));
+typedef int16_t iree_device_i16x8_t __attribute__((vector_size(16)));
+
+#endif  // __GNUC__
+
 //===----------------------------------------------------------------------===//
 // Target-specific queries
 //===----------------------------------------------------------------------===//
@@ -117,4 +140,65 @@ IREE_DEVICE_EXPORT float iree_h2f_ieee(short param);
 // Converts a 32-bit C `float` value to a 16-bit floating-point value.
 IREE_DEVICE_EXPORT short iree_f2h_ieee(float param);
 
+// Converts a bfloat16 value to a 32-bit C `float`.
+IREE_DEVICE_EXPORT float iree_bf2f(short param);
+
+// Converts a 32-bit C `float` value to a bfloat16 value, rounding to nearest
+// even. NaNs are kept quiet.
+IREE_DEVICE_EXPORT short iree_f2bf(float param);
+
+#if defined(IREE_DEVICE_HAVE_VECTOR_TYPES)
+
+// Vector builtins processing 4 or 8 lanes (the _x4/_x8 suffix) read from |x|
+// and written to |result|, which need not be aligned. Vectors are passed
+// through memory so that the signatures are the same on every target and ABI;
+// the builtins are linked into and inlined by the generated code where the
+// loads and stores fold away.
+
+// Vector variants of the float16/bfloat16 conversions. 16-bit values are passed
+// as integers as not all targets have a native half type.
+IREE_DEVICE_EXPORT void iree_h2f_ieee_x4(const short* IREE_DEVICE_RESTRICT x,
+                                         float* IREE_DEVICE_RESTRICT result);
+IREE_DEVICE_EXPORT void iree_h2f_ieee_x8(const short* IREE_DEVICE_RESTRICT x,
+                                         float* IREE_DEVICE_RESTRICT result);
+IREE_DEVICE_EXPORT void iree_f2h_ieee_x4(const float* IREE_DEVICE_RESTRICT x,
+                                         short* IREE_DEVICE_RESTRICT result);
+IREE_DEVICE_EXPORT void iree_f2h_ieee_x8(const float* IREE_DEVICE_RESTRICT x,
+                                         short* IREE_DEVICE_RESTRICT result);
+IREE_DEVICE_EXPORT void iree_bf2f_x4(const short* IREE_DEVICE_RESTRICT x,
+                                     float* IREE_DEVICE_RESTRICT result);
+IREE_DEVICE_EXPORT void iree_bf2f_x8(const short* IREE_DEVICE_RESTRICT x,
+                                     float* IREE_DEVICE_RESTRICT result);
+IREE_DEVICE_EXPORT void iree_f2bf_x4(const float* IREE_DEVICE_RESTRICT x,
+                                     short* IREE_DEVICE_RESTRICT result);
+IREE_DEVICE_EXPORT void iree_f2bf_x8(const float* IREE_DEVICE_RESTRICT x,
+                                     short* IREE_DEVICE_RESTRICT result);
+
+// Elementwise math functions on vectors of 32-bit floats. These are
+// approximations with a maximum error of a few ulp (erff: ~4e-7 absolute) that
+// handle NaN, infinite and denormal inputs.
+IREE_DEVICE_EXPORT void iree_math_expf_x4(const float* IREE_DEVICE_RESTRICT x,
+                                          float* IREE_DEVICE_RESTRICT result);
+IREE_DEVICE_EXPORT void iree_math_expf_x8(const float* IREE_DEVICE_RESTRICT x,
+                                          float* IREE_DEVICE_RESTRICT result);
+IREE_DEVICE_EXPORT void iree_math_logf_x4(const float* IREE_DEVICE_RESTRICT x,
+                                          float* IREE_DEVICE_RESTRICT result);
+IREE_DEVICE_EXPORT void iree_math_logf_x8(const float* IREE_DEVICE_RESTRICT x,
+                                          float* IREE_DEVICE_RESTRICT result);
+IREE_DEVICE_EXPORT void iree_math_tanhf_x4(const float* IREE_DEVICE_RESTRICT x,
+                                           float* IREE_DEVICE_RESTRICT result);
+IREE_DEVICE_EXPORT void iree_math_tanhf_x8(const float* IREE_DEVICE_RESTRICT x,
+                                           float* IREE_DEVICE_RESTRICT result);
+IREE_DEVICE_EXPORT void iree_math_erff_x4(const float* IREE_DEVICE_RESTRICT x,
+                                          float* IREE_DEVICE_RESTRICT result);
+IREE_DEVICE_EXPORT void iree_math_erff_x8(const float* IREE_DEVICE_RESTRICT x,
+                                          float* IREE_DEVICE_RESTRICT result);
+// Computes 1 / (1 + exp(-x)).
+IREE_DEVICE_EXPORT void iree_math_sigmoidf_x4(
+    const float* IREE_DEVICE_RESTRICT x, float* IREE_DEVICE_RESTRICT result);
+IREE_DEVICE_EXPORT void iree_math_sigmoidf_x8(
+    const float* IREE_DEVICE_RESTRICT x, float* IREE_DEVICE_RESTRICT result);
+
+#endif  // IREE_DEVICE_HAVE_VECTOR_TYPES
+
 #endif  // IREE_BUILTINS_DEVICE_DEVICE_H_
@@ -10,6 +10,25 @@
 int libdevice_platform_example_flag = LIBDEVICE_PLATFORM_EXAMPLE_FLAG;
 #endif  // IREE_DEVICE_STANDALONE
 
+// Reinterprets the bits of a 32-bit int/float. Type punning through a union is
+// well-defined in C where casting the pointers violates strict aliasing.
+typedef union {
+  float f;
+  unsigned int u;
+} iree_device_f32_bits_t;
+
+static inline float iree_device_f32_from_bits(unsigned int bits) {
+  iree_device_f32_bits_t value;
+  value.u = bits;
+  return value.f;
+}
+
+static inline unsigned int iree_device_f32_to_bits(float f) {
+  iree_device_f32_bits_t value;
+  value.f = f;
+  return value.u;
+}
+
 IREE_DEVICE_EXPORT float iree_h2f_ieee(short param) {
   unsigned short expHalf16 = param & 0x7C00;
   int exp1 = (int)expHalf16;
@@ -22,22 +41,17 @@ IREE_DEVICE_EXPORT float iree_h2f_ieee(short param) {
   if (expHalf16 == 0x7C00) {
     // nan
     if (mantissa16 > 0) {
-      int res = (0x7FC00000 | sign);
-      float fres = *((float*)(&res));
-      return fres;
+      return iree_device_f32_from_bits(0x7FC00000 | sign);
     }
     // inf
-    int res = (0x7F800000 | sign);
-    float fres = *((float*)(&res));
-    return fres;
+    return iree_device_f32_from_bits(0x7F800000 | sign);
   }
   if (expHalf16 != 0) {
     exp1 += ((127 - 15) << 10);  // exponents converted to float32 bias
     int res = (exp1 | mantissa1);
     res = res << 13;
     res = (res | sign);
-    float fres = *((float*)(&res));
-    return fres;
+    return iree_device_f32_from_bits(res);
   }
 
   int xmm1 = exp1 > (1 << 10) ? exp1 : (1 << 10);
@@ -46,13 +60,13 @@ IREE_DEVICE_EXPORT float iree_h2f_ieee(short param) {
   xmm1 = xmm1 | sign;               // Combine with the sign mask
 
   float res = (float)mantissa1;  // Convert mantissa to float
-  res *= *((float*)(&xmm1));
+  res *= iree_device_f32_from_bits(xmm1);
 
   return res;
 }
 
 IREE_DEVICE_EXPORT short iree_f2h_ieee(float param) {
-  unsigned int param_bit = *((unsigned int*)(&param));
+  unsigned int param_bit = iree_device_f32_to_bits(param);
   int sign = param_bit >> 31;
   int mantissa = param_bit & 0x007FFFFF;
   int exp = ((param_bit & 0x7F800000) >> 23) + 15 - 127;
@@ -108,6 +122,56 @@ IREE_DEVICE_EXPORT short iree_f2h_ieee(float param) {
   return res;
 }
 
+IREE_DEVICE_EXPORT float iree_bf2f(short param) {
+  return iree_device_f32_from_bits(((unsigned int)(unsigned short)param) << 16);
+}
+
+IREE_DEVICE_EXPORT short iree_f2bf(float param) {
+  unsigned int param_bit = iree_device_f32_to_bits(param);
+  if ((param_bit & 0x7FFFFFFF) > 0x7F800000) {
+    // nan: truncate and keep it quiet
+    return (short)((param_bit >> 16) | 0x40);
+  }
+  // round to nearest even
+  unsigned int lsb = (param_bit >> 16) & 1;
+  return (short)((param_bit + 0x7FFF + lsb) >> 16);
+}
+
+#if defined(IREE_DEVICE_HAVE_VECTOR_TYPES)
+
+#define IREE_DEVICE_VECTOR_WIDTH 4
+#include "device_math.inl"
+#undef IREE_DEVICE_VECTOR_WIDTH
+
+#if (defined(__x86_64__) || defined(__i386__)) && !defined(__AVX__)
+// Without AVX 8 lanes span two SSE registers, which is what the width 8 code
+// would compile to anyway, and GCC notes (-Wpsabi) that passing 32-byte
+// vectors between the helpers changes the ABI. Process the two halves with the
+// width 4 builtins instead.
+#define IREE_DEVICE_SPLIT_X8(name, T, U)                              \
+  IREE_DEVICE_EXPORT void name##_x8(const T* IREE_DEVICE_RESTRICT x,  \
+                                    U* IREE_DEVICE_RESTRICT result) { \
+    name##_x4(x, result);                                             \
+    name##_x4(x + 4, result + 4);                                     \
+  }
+IREE_DEVICE_SPLIT_X8(iree_h2f_ieee, short, float)
+IREE_DEVICE_SPLIT_X8(iree_f2h_ieee, float, short)
+IREE_DEVICE_SPLIT_X8(iree_bf2f, short, float)
+IREE_DEVICE_SPLIT_X8(iree_f2bf, float, short)
+IREE_DEVICE_SPLIT_X8(iree_math_expf, float, float)
+IREE_DEVICE_SPLIT_X8(iree_math_logf, float, float)
+IREE_DEVICE_SPLIT_X8(iree_math_tanhf, float, float)
+IREE_DEVICE_SPLIT_X8(iree_math_erff, float, float)
+IREE_DEVICE_SPLIT_X8(iree_math_sigmoidf, float, float)
+#undef IREE_DEVICE_SPLIT_X8
+#else
+#define IREE_DEVICE_VECTOR_WIDTH 8
+#include "device_math.inl"
+#undef IREE_DEVICE_VECTOR_WIDTH
+#endif  // x86 without AVX
+
+#endif  // IREE_DEVICE_HAVE_VECTOR_TYPES
+
 #if defined(IREE_DEVICE_STANDALONE)
 
 IREE_DEVICE_EXPORT float __gnu_h2f_ieee(short param) {
@@ -0,0 +1,318 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+//===----------------------------------------------------------------------===//
+// Vector math and float16/bfloat16 conversion builtins
+//===----------------------------------------------------------------------===//
+// Included by device_generic.c once per vector width with
+// IREE_DEVICE_VECTOR_WIDTH set to the number of 32-bit lanes. Everything here
+// is written with the GCC/Clang vector extension and is branch-free so that the
+// bitcode variants compile it to the vector instructions of their target ISA.
+// Vectors are only passed by value between the static helpers; the exported
+// builtins load and store them through pointers (see device.h).
+//
+// The math functions follow the Cephes single-precision implementations (expf,
+// logf, tanhf) and Abramowitz & Stegun 7.1.26 (erff). The float16 conversions
+// follow the round-to-nearest-even bit manipulations from
+// https://gist.github.com/rygorous/2156668 and use the conversion instructions
+// of the target when the bitcode variant is compiled with them.
+
+#if !defined(IREE_DEVICE_VECTOR_WIDTH)
+#error "IREE_DEVICE_VECTOR_WIDTH must be defined to the number of lanes"
+#endif  // IREE_DEVICE_VECTOR_WIDTH
+
+#define IREE_DEVICE_CONCAT_(a, b, c) a##b##c
+#define IREE_DEVICE_CONCAT(a, b, c) IREE_DEVICE_CONCAT_(a, b, c)
+
+#define VF IREE_DEVICE_CONCAT(iree_device_f32x, IREE_DEVICE_VECTOR_WIDTH, _t)
+#define VI IREE_DEVICE_CONCAT(iree_device_i32x, IREE_DEVICE_VECTOR_WIDTH, _t)
+#define VU IREE_DEVICE_CONCAT(iree_device_u32x, IREE_DEVICE_VECTOR_WIDTH, _t)
+#define VH IREE_DEVICE_CONCAT(iree_device_i16x, IREE_DEVICE_VECTOR_WIDTH, _t)
+#define FN(name) IREE_DEVICE_CONCAT(name, _x, IREE_DEVICE_VECTOR_WIDTH)
+#define SPLAT(value) ((VF){0} + (value))
+#define SPLATI(value) ((VI){0} + (value))
+
+//===----------------------------------------------------------------------===//
+// Helpers
+//===----------------------------------------------------------------------===//
+
+static inline VF FN(iree_device_loadf)(const float* IREE_DEVICE_RESTRICT p) {
+  VF v;
+  __builtin_memcpy(&v, p, sizeof(v));
+  return v;
+}
+static inline VH FN(iree_device_loadh)(const short* IREE_DEVICE_RESTRICT p) {
+  VH v;
+  __builtin_memcpy(&v, p, sizeof(v));
+  return v;
+}
+static inline void FN(iree_device_storef)(float* IREE_DEVICE_RESTRICT p,
+                                          VF v) {
+  __builtin_memcpy(p, &v, sizeof(v));
+}
+static inline void FN(iree_device_storeh)(short* IREE_DEVICE_RESTRICT p,
+                                          VH v) {
+  __builtin_memcpy(p, &v, sizeof(v));
+}
+
+// Returns |a| in the lanes where |mask| is all ones and |b| elsewhere.
+static inline VF FN(iree_device_select)(VI mask, VF a, VF b) {
+  return (VF)(((VI)a & mask) | ((VI)b & ~mask));
+}
+static inline VI FN(iree_device_selecti)(VI mask, VI a, VI b) {
+  return (a & mask) | (b & ~mask);
+}
+
+// Rounds toward negative infinity; |x| must fit in an int32_t.
+static inline VF FN(iree_device_floor)(VF x) {
+  VF t = __builtin_convertvector(__builtin_convertvector(x, VI), VF);
+  // Lanes where truncation rounded up are all ones (-1).
+  return t + __builtin_convertvector((VI)(t > x), VF);
+}
+
+static inline VF FN(iree_device_abs)(VF x) { return (VF)((VI)x & 0x7FFFFFFF); }
+
+// Returns |x| with the sign of |sign|; |x| must be positive.
+static inline VF FN(iree_device_copysign)(VF x, VF sign) {
+  return (VF)((VI)x | ((VI)sign & ~0x7FFFFFFF));
+}
+
+//===----------------------------------------------------------------------===//
+// float16/bfloat16 conversions
+//===----------------------------------------------------------------------===//
+
+static inline VF FN(iree_device_h2f_ieee)(VH param) {
+#if defined(__F16C__)
+#if IREE_DEVICE_VECTOR_WIDTH == 8
+  return __builtin_ia32_vcvtph2ps256(param);
+#else
+  return __builtin_ia32_vcvtph2ps(
+      __builtin_shufflevector(param, param, 0, 1, 2, 3, 0, 1, 2, 3));
+#endif  // IREE_DEVICE_VECTOR_WIDTH
+#elif defined(__aarch64__) && defined(__clang__)
+  typedef _Float16 f16_t
+      __attribute__((vector_size(IREE_DEVICE_VECTOR_WIDTH * 2)));
+  return __builtin_convertvector((f16_t)param, VF);
+#else
+  VI h = __builtin_convertvector(param, VI);
+  VI o = (h & 0x7FFF) << 13;
+  VI exp = o & (0x7C00 << 13);
+  o += (127 - 15) << 23;
+  // Inf/NaN: extend the exponent.
+  o += (VI)(exp == (0x7C00 << 13)) & ((128 - 16) << 23);
+  // Zero/denormal: renormalize through a float subtraction.
+  VF denormal = (VF)(o + (1 << 23)) - (VF)SPLATI(113 << 23);
+  o = FN(iree_device_selecti)((VI)(exp == 0), (VI)denormal, o);
+  return (VF)(o | ((h & 0x8000) << 16));
+#endif  // __F16C__
+}
+
+static inline VH FN(iree_device_f2h_ieee)(VF param) {
+#if defined(__F16C__)
+  // Immediate 0 selects round-to-nearest-even.
+#if IREE_DEVICE_VECTOR_WIDTH == 8
+  return __builtin_ia32_vcvtps2ph256(param, 0);
+#else
+  iree_device_i16x8_t h = __builtin_ia32_vcvtps2ph(param, 0);
+  return __builtin_shufflevector(h, h, 0, 1, 2, 3);
+#endif  // IREE_DEVICE_VECTOR_WIDTH
+#elif defined(__aarch64__) && defined(__clang__)
+  typedef _Float16 f16_t
+      __attribute__((vector_size(IREE_DEVICE_VECTOR_WIDTH * 2)));
+  return (VH)__builtin_convertvector(param, f16_t);
+#else
+  VI f = (VI)param;
+  VI sign = f & ~0x7FFFFFFF;
+  f ^= sign;
+  // Values too large for float16 become inf, NaNs stay (quiet) NaNs.
+  VI overflow = (VI)(f >= ((127 + 16) << 23));
+  VI o_overflow = FN(iree_device_selecti)((VI)(f > (255 << 23)),
+                                          SPLATI(0x7E00), SPLATI(0x7C00));
+  // Denormals are rounded by the float addition of 0.5.
+  VI denormal = (VI)(f < (113 << 23));
+  VI o_denormal = (VI)((VF)f + (VF)SPLATI(126 << 23)) - (126 << 23);
+  // Normals are rounded to nearest even on the integer bits.
+  VI mantissa_odd = (f >> 13) & 1;
+  VI o_normal = (f - (112 << 23) + 0xFFF + mantissa_odd) >> 13;
+  VI o = FN(iree_device_selecti)(
+      overflow, o_overflow,
+      FN(iree_device_selecti)(denormal, o_denormal, o_normal));
+  return __builtin_convertvector(o | (sign >> 16), VH);
+#endif  // __F16C__
+}
+
+static inline VF FN(iree_device_bf2f)(VH param) {
+  return (VF)(__builtin_convertvector(param, VU) << 16);
+}
+
+static inline VH FN(iree_device_f2bf)(VF param) {
+  VU u = (VU)param;
+  VU rounded = (u + 0x7FFF + ((u >> 16) & 1)) >> 16;
+  VU quiet_nan = (u >> 16) | 0x40;
+  VI is_nan = (VI)(param != param);
+  return __builtin_convertvector(
+      FN(iree_device_selecti)(is_nan, (VI)quiet_nan, (VI)rounded), VH);
+}
+
+//===----------------------------------------------------------------------===//
+// Math functions
+//===----------------------------------------------------------------------===//
+
+static inline VF FN(iree_device_expf)(VF x) {
+  // Inputs outside of this range overflow to inf or underflow to zero.
+  VF xc = FN(iree_device_select)((VI)(x > 88.7228391f), SPLAT(88.7228391f), x);
+  xc = FN(iree_device_select)((VI)(xc < -104.0f), SPLAT(-104.0f), xc);
+
+  // exp(x) = 2^n * exp(r) with n = round(x / ln(2)), |r| <= ln(2) / 2.
+  VF n = FN(iree_device_floor)(xc * 1.44269504088896341f + 0.5f);
+  VF r = xc - n * 0.693359375f + n * 2.12194440e-4f;
+  VF p = r * 1.9875691500e-4f + 1.3981999507e-3f;
+  p = p * r + 8.3334519073e-3f;
+  p = p * r + 4.1665795894e-2f;
+  p = p * r + 1.6666665459e-1f;
+  p = p * r + 5.0000001201e-1f;
+  VF y = p * (r * r) + r + 1.0f;
+
+  // Scale by 2^n in two steps as n may be out of the normal exponent range.
+  VI n0 = __builtin_convertvector(n, VI) >> 1;
+  VI n1 = __builtin_convertvector(n, VI) - n0;
+  y = y * (VF)((n0 + 127) << 23) * (VF)((n1 + 127) << 23);
+
+  y = FN(iree_device_select)((VI)(x > 88.7228391f), SPLAT(__builtin_inff()),
+                             y);
+  y = FN(iree_device_select)((VI)(x < -104.0f), SPLAT(0.0f), y);
+  return FN(iree_device_select)((VI)(x != x), x, y);
+}
+
+static inline VF FN(iree_device_logf)(VF x) {
+  // Scale denormals into the normal range.
+  VI is_denormal = (VI)(x < 1.17549435e-38f);
+  VF xs = FN(iree_device_select)(is_denormal, x * 8388608.0f, x);
+
+  // x = m * 2^e with m in [sqrt(1/2), sqrt(2)).
+  VI bits = (VI)xs;
+  VI e = (bits >> 23) - 126 + (is_denormal & -23);
+  VF m = (VF)((bits & 0x007FFFFF) | 0x3F000000);
+  VI is_small = (VI)(m < 0.707106781186547524f);
+  e += is_small;
+  m = FN(iree_device_select)(is_small, m + m, m) - 1.0f;
+
+  VF z = m * m;
+  VF p = m * 7.0376836292e-2f - 1.1514610310e-1f;
+  p = p * m + 1.1676998740e-1f;
+  p = p * m - 1.2420140846e-1f;
+  p = p * m + 1.4249322787e-1f;
+  p = p * m - 1.6668057665e-1f;
+  p = p * m + 2.0000714765e-1f;
+  p = p * m - 2.4999993993e-1f;
+  p = p * m + 3.3333331174e-1f;
+  VF fe = __builtin_convertvector(e, VF);
+  VF y = p * m * z - fe * 2.12194440e-4f - 0.5f * z;
+  y = m + y + fe * 0.693359375f;
+
+  y = FN(iree_device_select)((VI)(x == __builtin_inff()), x, y);
+  y = FN(iree_device_select)((VI)(x == 0.0f), SPLAT(-__builtin_inff()), y);
+  return FN(iree_device_select)((VI)(x < 0.0f) | (VI)(x != x),
+                                SPLAT(__builtin_nanf("")), y);
+}
+
+static inline VF FN(iree_device_tanhf)(VF x) {
+  VF ax = FN(iree_device_abs)(x);
+
+  // Small inputs: odd polynomial, avoiding the cancellation below.
+  VF z = x * x;
+  VF p = z * -5.70498872745e-3f + 2.06390887954e-2f;
+  p = p * z - 5.37397155531e-2f;
+  p = p * z + 1.33314422036e-1f;
+  p = p * z - 3.33332819422e-1f;
+  VF y_small = x + x * z * p;
+
+  // tanh(|x|) = 1 - 2 / (exp(2|x|) + 1).
+  VF y_large = 1.0f - 2.0f / (FN(iree_device_expf)(ax + ax) + 1.0f);
+  y_large = FN(iree_device_copysign)(y_large, x);
+
+  return FN(iree_device_select)((VI)(ax < 0.625f), y_small, y_large);
+}
+
+static inline VF FN(iree_device_erff)(VF x) {
+  VF ax = FN(iree_device_abs)(x);
+
+  // Small inputs: Taylor series of 2/sqrt(pi) * (x - x^3/3 + x^5/10 - ...).
+  VF z = x * x;
+  VF p = z * -8.5483270234508e-4f + 5.22397762544219e-3f;
+  p = p * z - 2.686617064513125e-2f;
+  p = p * z + 1.1283791670955126e-1f;
+  p = p * z - 3.7612638903183752e-1f;
+  p = p * z + 1.12837916709551257f;
+  VF y_small = x * p;
+
+  // erf(|x|) = 1 - q(t) * t * exp(-x^2) with t = 1 / (1 + 0.3275911|x|).
+  VF t = 1.0f / (ax * 0.3275911f + 1.0f);
+  VF q = t * 1.061405429f - 1.453152027f;
+  q = q * t + 1.421413741f;
+  q = q * t - 0.284496736f;
+  q = q * t + 0.254829592f;
+  VF y_large = 1.0f - q * t * FN(iree_device_expf)(-z);
+  y_large = FN(iree_device_copysign)(y_large, x);
+
+  return FN(iree_device_select)((VI)(ax < 0.5f), y_small, y_large);
+}
+
+static inline VF FN(iree_device_sigmoidf)(VF x) {
+  return 1.0f / (FN(iree_device_expf)(-x) + 1.0f);
+}
+
+//===----------------------------------------------------------------------===//
+// Exported builtins
+//===----------------------------------------------------------------------===//
+
+IREE_DEVICE_EXPORT void FN(iree_h2f_ieee)(const short* IREE_DEVICE_RESTRICT x,
+                                          float* IREE_DEVICE_RESTRICT result) {
+  VF y = FN(iree_device_h2f_ieee)(FN(iree_device_loadh)(x));
+  FN(iree_device_storef)(result, y);
+}
+
+IREE_DEVICE_EXPORT void FN(iree_f2h_ieee)(const float* IREE_DEVICE_RESTRICT x,
+                                          short* IREE_DEVICE_RESTRICT result) {
+  VH y = FN(iree_device_f2h_ieee)(FN(iree_device_loadf)(x));
+  FN(iree_device_storeh)(result, y);
+}
+
+IREE_DEVICE_EXPORT void FN(iree_bf2f)(const short* IREE_DEVICE_RESTRICT x,
+                                      float* IREE_DEVICE_RESTRICT result) {
+  VF y = FN(iree_device_bf2f)(FN(iree_device_loadh)(x));
+  FN(iree_device_storef)(result, y);
+}
+
+IREE_DEVICE_EXPORT void FN(iree_f2bf)(const float* IREE_DEVICE_RESTRICT x,
+                                      short* IREE_DEVICE_RESTRICT result) {
+  VH y = FN(iree_device_f2bf)(FN(iree_device_loadf)(x));
+  FN(iree_device_storeh)(result, y);
+}
+
+#define IREE_DEVICE_MATH_EXPORT(name)                                     \
+  IREE_DEVICE_EXPORT void FN(iree_math_##name)(                           \
+      const float* IREE_DEVICE_RESTRICT x,                                \
+      float* IREE_DEVICE_RESTRICT result) {                               \
+    VF y = FN(iree_device_##name)(FN(iree_device_loadf)(x));              \
+    FN(iree_device_storef)(result, y);                                    \
+  }
+IREE_DEVICE_MATH_EXPORT(expf)
+IREE_DEVICE_MATH_EXPORT(logf)
+IREE_DEVICE_MATH_EXPORT(tanhf)
+IREE_DEVICE_MATH_EXPORT(erff)
+IREE_DEVICE_MATH_EXPORT(sigmoidf)
+#undef IREE_DEVICE_MATH_EXPORT
+
+#undef SPLATI
+#undef SPLAT
+#undef FN
+#undef VH
+#undef VU
+#undef VI
+#undef VF
+#undef IREE_DEVICE_CONCAT
+#undef IREE_DEVICE_CONCAT_
@@ -38,6 +38,41 @@ static iree_status_t iree_f2h_ieee_benchmark(
   return iree_ok_status();
 }
 
+#if defined(IREE_DEVICE_HAVE_VECTOR_TYPES)
+
+static iree_status_t iree_math_expf_x8_benchmark(
+    const iree_benchmark_def_t* benchmark_def,
+    iree_benchmark_state_t* benchmark_state) {
+  while (iree_benchmark_keep_running(benchmark_state,
+                                     /*batch_count=*/FLAG_batch_count)) {
+    for (int i = 0; i < FLAG_batch_count; ++i) {
+      // TODO(benvanik): iree_do_not_optimize barrier.
+      float x[8] = {0.25f, 1.0f, -2.0f, 3.0f, 4.0f, 5.0f, 6.0f, i};
+      float result[8];
+      iree_math_expf_x8(x, result);
+    }
+  }
+  return iree_ok_status();
+}
+
+static iree_status_t iree_h2f_ieee_x8_benchmark(
+    const iree_benchmark_def_t* benchmark_def,
+    iree_benchmark_state_t* benchmark_state) {
+  while (iree_benchmark_keep_running(benchmark_state,
+                                     /*batch_count=*/FLAG_batch_count)) {
+    for (int i = 0; i < FLAG_batch_count; ++i) {
+      // TODO(benvanik): iree_do_not_optimize barrier.
+      short h[8] = {0x3400, 0x3C00, 0x0001, 0x7C00,
+                    0xBC00, 0x0400, 0x3555, 0x3400 + i};
+      float result[8];
+      iree_h2f_ieee_x8(h, result);
+    }
+  }
+  return iree_ok_status();
+}
+
+#endif  // IREE_DEVICE_HAVE_VECTOR_TYPES
+
 int main(int argc, char** argv) {
   iree_flags_set_usage(
       "libdevice_benchmark",
@@ -73,6 +108,34 @@ int main(int argc, char** argv) {
     iree_benchmark_register(IREE_SV("iree_f2h_ieee"), &benchmark_def);
   }
 
+#if defined(IREE_DEVICE_HAVE_VECTOR_TYPES)
+  {
+    static const iree_benchmark_def_t benchmark_def = {
+        .flags = IREE_BENCHMARK_FLAG_MEASURE_PROCESS_CPU_TIME |
+                 IREE_BENCHMARK_FLAG_USE_REAL_TIME,
+        .time_unit = IREE_BENCHMARK_UNIT_NANOSECOND,
+        .minimum_duration_ns = 0,
+        .iteration_count = 0,
+        .run = iree_math_expf_x8_benchmark,
+        .user_data = NULL,
+    };
+    iree_benchmark_register(IREE_SV("iree_math_expf_x8"), &benchmark_def);
+  }
+
+  {
+    static const iree_benchmark_def_t benchmark_def = {
+        .flags = IREE_BENCHMARK_FLAG_MEASURE_PROCESS_CPU_TIME |
+                 IREE_BENCHMARK_FLAG_USE_REAL_TIME,
+        .time_unit = IREE_BENCHMARK_UNIT_NANOSECOND,
+        .minimum_duration_ns = 0,
+        .iteration_count = 0,
+        .run = iree_h2f_ieee_x8_benchmark,
+        .user_data = NULL,
+    };
+    iree_benchmark_register(IREE_SV("iree_h2f_ieee_x8"), &benchmark_def);
+  }
+#endif  // IREE_DEVICE_HAVE_VECTOR_TYPES
+
   iree_benchmark_run_specified();
   return 0;
 }
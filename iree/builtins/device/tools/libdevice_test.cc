@@ -4,7 +4,10 @@
 // See https://llvm.org/LICENSE.txt for license information.
 // SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
 
+#include <algorithm>
+#include <cmath>
 #include <cstring>
+#include <limits>
 
 #include "iree/base/api.h"
 #include "iree/builtins/device/device.h"
@@ -20,3 +23,130 @@ TEST(LibDeviceTest, iree_f2h_ieee) {
   // Just ensuring that the code links.
   EXPECT_EQ(0x3400, iree_f2h_ieee(0.25f));
 }
+
+TEST(LibDeviceTest, iree_bf2f) {
+  EXPECT_EQ(0.25f, iree_bf2f(0x3E80));
+  EXPECT_EQ(-2.0f, iree_bf2f((short)0xC000));
+}
+
+TEST(LibDeviceTest, iree_f2bf) {
+  EXPECT_EQ(0x3E80, iree_f2bf(0.25f));
+  // Rounds to nearest even.
+  EXPECT_EQ(0x3F80, iree_f2bf(1.00390625f));
+  EXPECT_EQ(0x3F82, iree_f2bf(1.01171875f));
+}
+
+#if defined(IREE_DEVICE_HAVE_VECTOR_TYPES)
+
+TEST(LibDeviceTest, iree_h2f_ieee_x8) {
+  // Checks all float16 values against the scalar implementation.
+  for (int i = 0; i < 0x10000; i += 8) {
+    int16_t h[8];
+    for (int j = 0; j < 8; ++j) h[j] = (int16_t)(i + j);
+    float f[8];
+    iree_h2f_ieee_x8(h, f);
+    for (int j = 0; j < 8; ++j) {
+      float expected = iree_h2f_ieee(h[j]);
+      if (std::isnan(expected)) {
+        EXPECT_TRUE(std::isnan(f[j]));
+      } else {
+        EXPECT_EQ(expected, f[j]);
+      }
+    }
+  }
+}
+
+TEST(LibDeviceTest, iree_f2h_ieee_x4) {
+  float f[4] = {0.25f, -65504.0f, 1e9f, 1.0009765625f};
+  int16_t h[4];
+  iree_f2h_ieee_x4(f, h);
+  EXPECT_EQ(0x3400, (uint16_t)h[0]);
+  EXPECT_EQ(0xFBFF, (uint16_t)h[1]);
+  EXPECT_EQ(0x7C00, (uint16_t)h[2]);
+  EXPECT_EQ(0x3C01, (uint16_t)h[3]);
+}
+
+TEST(LibDeviceTest, iree_bf16_x8) {
+  float f[8] = {0.25f, -2.0f, 1.00390625f, 1.01171875f,
+                0.0f,  -0.0f, 3.0f,        1e30f};
+  int16_t bf[8];
+  iree_f2bf_x8(f, bf);
+  float back[8];
+  iree_bf2f_x8(bf, back);
+  for (int j = 0; j < 8; ++j) {
+    EXPECT_EQ(iree_f2bf(f[j]), bf[j]);
+    EXPECT_EQ(iree_bf2f(bf[j]), back[j]);
+  }
+}
+
+TEST(LibDeviceTest, iree_math_unaligned_x4) {
+  // The builtins must not assume the vectors are aligned.
+  float buffer[9] = {0.0f, 0.0f, 1.0f, -1.0f, 2.0f};
+  iree_math_expf_x4(&buffer[1], &buffer[5]);
+  EXPECT_EQ(1.0f, buffer[5]);
+  EXPECT_NEAR(::expf(1.0f), buffer[6], 1e-6f);
+  EXPECT_NEAR(::expf(-1.0f), buffer[7], 1e-6f);
+  EXPECT_NEAR(::expf(2.0f), buffer[8], 1e-5f);
+}
+
+// Compares |fn| against |reference| at |count| points in [|lo|, |hi|].
+template <typename R>
+static void CheckVectorMath(void (*fn)(const float*, float*), R reference,
+                            float lo, float hi, float max_relative_error,
+                            float max_error) {
+  const int count = 10000;
+  for (int i = 0; i < count; i += 4) {
+    float x[4];
+    for (int j = 0; j < 4; ++j) x[j] = lo + (hi - lo) * (i + j) / (count - 1);
+    float y[4];
+    fn(x, y);
+    for (int j = 0; j < 4; ++j) {
+      float expected = reference(x[j]);
+      EXPECT_NEAR(expected, y[j],
+                  std::max(max_error, std::fabs(expected) * max_relative_error))
+          << "at x = " << x[j];
+    }
+  }
+}
+
+TEST(LibDeviceTest, iree_math_x4) {
+  CheckVectorMath(iree_math_expf_x4, ::expf, -87.0f, 88.0f, 2e-7f, 0.0f);
+  CheckVectorMath(iree_math_logf_x4, ::logf, 1e-30f, 1e30f, 2e-7f, 0.0f);
+  CheckVectorMath(iree_math_tanhf_x4, ::tanhf, -10.0f, 10.0f, 3e-7f, 0.0f);
+  CheckVectorMath(iree_math_erff_x4, ::erff, -6.0f, 6.0f, 4e-7f, 4e-7f);
+  CheckVectorMath(
+      iree_math_sigmoidf_x4, [](float x) { return 1.0f / (1.0f + expf(-x)); },
+      -80.0f, 80.0f, 5e-7f, 1e-37f);
+}
+
+TEST(LibDeviceTest, iree_math_special_values_x8) {
+  float inf = std::numeric_limits<float>::infinity();
+  float nan = std::numeric_limits<float>::quiet_NaN();
+  float x[8] = {inf, -inf, nan, 0.0f, 1.0f, -1.0f, 200.0f, -200.0f};
+  float exp[8];
+  iree_math_expf_x8(x, exp);
+  EXPECT_EQ(inf, exp[0]);
+  EXPECT_EQ(0.0f, exp[1]);
+  EXPECT_TRUE(std::isnan(exp[2]));
+  EXPECT_EQ(1.0f, exp[3]);
+  EXPECT_EQ(inf, exp[6]);
+  EXPECT_EQ(0.0f, exp[7]);
+  float log[8];
+  iree_math_logf_x8(x, log);
+  EXPECT_EQ(inf, log[0]);
+  EXPECT_TRUE(std::isnan(log[1]));
+  EXPECT_EQ(-inf, log[3]);
+  EXPECT_EQ(0.0f, log[4]);
+  EXPECT_TRUE(std::isnan(log[5]));
+  float tanh[8];
+  iree_math_tanhf_x8(x, tanh);
+  EXPECT_EQ(1.0f, tanh[0]);
+  EXPECT_EQ(-1.0f, tanh[1]);
+  float sigmoid[8];
+  iree_math_sigmoidf_x8(x, sigmoid);
+  EXPECT_EQ(1.0f, sigmoid[0]);
+  EXPECT_EQ(0.0f, sigmoid[1]);
+  EXPECT_EQ(0.5f, sigmoid[3]);
+}
+
+#endif  // IREE_DEVICE_HAVE_VECTOR_TYPES
@@ -7,6 +7,7 @@
 #include "iree/compiler/Codegen/LLVMCPU/KernelDispatch.h"
 
 #include "iree-dialects/Dialect/LinalgExt/IR/LinalgExtOps.h"
+#include "iree/compiler/Codegen/LLVMCPU/TuningDatabase.h"
 #include "iree/compiler/Codegen/Transforms/Transforms.h"
 #include "iree/compiler/Codegen/Utils/MarkerUtils.h"
 #include "iree/compiler/Codegen/Utils/Utils.h"
@@ -63,6 +64,18 @@ static llvm::cl::opt<int> defaultWorkgroupTileSize(
         "linalg.generic and linalg.indexed_generic workgroup tile size"),
     llvm::cl::init(64));
 
+static llvm::cl::opt<std::string> clTuningDatabase(
+    "iree-codegen-llvm-tuning-database",
+    llvm::cl::desc("JSON tuning database with the compilation info to use for "
+                   "the dispatches it has entries for"),
+    llvm::cl::init(""));
+
+static llvm::cl::opt<std::string> clTuningReport(
+    "iree-codegen-llvm-tuning-report",
+    llvm::cl::desc("JSON lines file to append the configuration selected for "
+                   "each dispatch to, for use by offline tuning"),
+    llvm::cl::init(""));
+
 static llvm::cl::opt<bool> useLinalgTransformInterp(
     "iree-codegen-use-linalg-transform-interp",
     llvm::cl::desc(
@@ -71,9 +84,10 @@ static llvm::cl::opt<bool> useLinalgTransformInterp(
 
 using IREE::Codegen::DispatchLoweringPassPipeline;
 
-/// Looks for the `native_vector_size` attribute in the hal.executable.variant
-/// op.
-static Optional<int64_t> getNativeVectorSizeInBytes(func::FuncOp entryPointFn) {
+/// Looks for the integer attribute `name` in the configuration of the
+/// hal.executable.variant op. Returns llvm::None if it is missing or zero.
+static Optional<int64_t> getTargetConfigInt(func::FuncOp entryPointFn,
+                                            StringRef name) {
   auto variantOp =
       entryPointFn->getParentOfType<IREE::HAL::ExecutableVariantOp>();
   if (!variantOp) return llvm::None;
@@ -81,11 +95,62 @@ static Optional<int64_t> getNativeVectorSizeInBytes(func::FuncOp entryPointFn) {
   if (!targetAttr) return llvm::None;
   auto config = targetAttr.getConfiguration();
   if (!config) return llvm::None;
-  auto nativeVectorSizeAttr = config.getAs<IntegerAttr>("native_vector_size");
-  if (!nativeVectorSizeAttr) return llvm::None;
-  int64_t nativeVectorSizeVal = nativeVectorSizeAttr.getInt();
-  if (!nativeVectorSizeVal) return llvm::None;
-  return nativeVectorSizeVal;
+  auto attr = config.getAs<IntegerAttr>(name);
+  if (!attr) return llvm::None;
+  int64_t value = attr.getInt();
+  if (!value) return llvm::None;
+  return value;
+}
+
+/// Looks for the `native_vector_size` attribute in the hal.executable.variant
+/// op.
+static Optional<int64_t> getNativeVectorSizeInBytes(func::FuncOp entryPointFn) {
+  return getTargetConfigInt(entryPointFn, "native_vector_size");
+}
+
+namespace {
+/// Memory hierarchy and parallelism of the target CPU as described by the
+/// `l1_cache_size`, `l2_cache_size`, `l3_cache_size` and `num_cores` entries of
+/// the hal.executable.target configuration. Sizes are in bytes and 0 means the
+/// target did not describe the value.
+struct CPUTargetInfo {
+  int64_t l1CacheSize = 0;
+  int64_t l2CacheSize = 0;
+  int64_t l3CacheSize = 0;
+  int64_t numCores = 0;
+
+  /// Returns the number of workers that workgroups are distributed across.
+  int64_t getNumWorkers() const {
+    return numCores ? numCores : clNumberOfRuntimeThreads;
+  }
+
+  // Only half of a cache level is budgeted for the operands of a tile; the
+  // rest is left to fused producers/consumers, the stack, and conflict misses.
+
+  /// Returns the number of bytes the L1 tile of a single core may touch, or 0
+  /// if unknown.
+  int64_t getL1TileBudget() const { return l1CacheSize / 2; }
+
+  /// Returns the number of bytes the workgroup tile of a single core may
+  /// touch, using its share of the L3 when the L2 size is unknown. Returns 0
+  /// if unknown.
+  int64_t getL2TileBudget() const {
+    if (l2CacheSize) return l2CacheSize / 2;
+    return l3CacheSize / (2 * getNumWorkers());
+  }
+};
+}  // namespace
+
+static CPUTargetInfo getCPUTargetInfo(func::FuncOp entryPointFn) {
+  CPUTargetInfo info;
+  info.l1CacheSize =
+      getTargetConfigInt(entryPointFn, "l1_cache_size").getValueOr(0);
+  info.l2CacheSize =
+      getTargetConfigInt(entryPointFn, "l2_cache_size").getValueOr(0);
+  info.l3CacheSize =
+      getTargetConfigInt(entryPointFn, "l3_cache_size").getValueOr(0);
+  info.numCores = getTargetConfigInt(entryPointFn, "num_cores").getValueOr(0);
+  return info;
 }
 
 /// For a given `shapedType` or (`byteWidth` of element type) return the number
@@ -160,10 +225,12 @@ static unsigned getReferenceTypeLengthInBytes(func::FuncOp entryPointFn) {
 }
 
 /// Returns the default tile sizes to use for the loops that are distributed at
-/// Flow level.
+/// Flow level. The number of workgroups is balanced against the number of
+/// workers of the target.
 static SmallVector<int64_t> getDefaultDistributedLoopTileSizes(
     ArrayRef<int64_t> lbs, ArrayRef<int64_t> ubs,
-    ArrayRef<int64_t> minTileSizes, ArrayRef<int64_t> maxTileSizes) {
+    ArrayRef<int64_t> minTileSizes, ArrayRef<int64_t> maxTileSizes,
+    const CPUTargetInfo &targetInfo) {
   assert(lbs.size() == ubs.size() && lbs.size() == minTileSizes.size() &&
          lbs.size() == maxTileSizes.size() &&
          "expected all vectors to be of equal size");
@@ -201,7 +268,7 @@ static SmallVector<int64_t> getDefaultDistributedLoopTileSizes(
   // Reduce the number of workgroups in cases where we are dividing the work too
   // much. Over-provision the number of workgroups to twice the number of
   // threads.
-  int64_t numWorkgroupsLimit = 2 * clNumberOfRuntimeThreads;
+  int64_t numWorkgroupsLimit = 2 * targetInfo.getNumWorkers();
   int64_t numWorkgroups = 1;
   for (auto ng : numWorkgroupsPerDim) {
     numWorkgroups *= ng;
@@ -225,6 +292,32 @@ static SmallVector<int64_t> getDefaultDistributedLoopTileSizes(
       currDim--;
     }
   }
+
+  // When the target describes its core count, split the largest tiles (never
+  // going below their minimum) until every core has at least one workgroup.
+  if (targetInfo.numCores) {
+    while (numWorkgroups < targetInfo.numCores) {
+      Optional<size_t> splitDim;
+      for (auto i : llvm::seq<size_t>(0, numDims)) {
+        if (workload[i] == ShapedType::kDynamicSize ||
+            distributedTileSizes[i] / 2 < minTileSizes[i] ||
+            ceilFn(workload[i], distributedTileSizes[i] / 2) ==
+                numWorkgroupsPerDim[i]) {
+          continue;
+        }
+        if (!splitDim ||
+            distributedTileSizes[i] > distributedTileSizes[*splitDim]) {
+          splitDim = i;
+        }
+      }
+      if (!splitDim) break;
+      size_t i = *splitDim;
+      distributedTileSizes[i] /= 2;
+      numWorkgroups /= numWorkgroupsPerDim[i];
+      numWorkgroupsPerDim[i] = ceilFn(workload[i], distributedTileSizes[i]);
+      numWorkgroups *= numWorkgroupsPerDim[i];
+    }
+  }
   return distributedTileSizes;
 }
 
@@ -254,12 +347,51 @@ static int64_t getMaxTileSize(int64_t lb, int64_t ub, int64_t maxSize,
   return 1;
 }
 
+/// Halves the entries of `tileSizes` at `dims`, largest first, until
+/// `getFootprint` reports at most `budget` bytes. Entries are never reduced
+/// below the matching `minTileSizes`.
+static void shrinkTileSizesToFit(
+    MutableArrayRef<int64_t> tileSizes, ArrayRef<int64_t> minTileSizes,
+    ArrayRef<unsigned> dims, int64_t budget,
+    function_ref<int64_t(ArrayRef<int64_t>)> getFootprint) {
+  while (getFootprint(tileSizes) > budget) {
+    Optional<unsigned> shrinkDim;
+    for (unsigned dim : dims) {
+      if (tileSizes[dim] / 2 < minTileSizes[dim]) continue;
+      if (!shrinkDim || tileSizes[dim] > tileSizes[*shrinkDim]) {
+        shrinkDim = dim;
+      }
+    }
+    if (!shrinkDim) return;
+    tileSizes[*shrinkDim] /= 2;
+  }
+}
+
+/// Returns the byte width of the elements of `v`, assuming 4 bytes for
+/// non-numeric element types.
+static int64_t getElementByteWidth(Value v) {
+  Type elementType = getElementTypeOrSelf(v.getType());
+  if (!elementType.isIntOrFloat()) return 4;
+  return IREE::Util::getRoundedElementByteWidth(elementType);
+}
+
+/// Returns the number of bytes touched by an `m`x`n`x`k` tile of `op`: the LHS
+/// and RHS panels and the accumulator.
+static int64_t getContractionFootprintInBytes(
+    linalg::ContractionOpInterface op, int64_t m, int64_t n, int64_t k) {
+  auto linalgOp = cast<linalg::LinalgOp>(op.getOperation());
+  return m * k * getElementByteWidth(op.lhs()) +
+         k * n * getElementByteWidth(op.rhs()) +
+         m * n * getElementByteWidth(linalgOp.getOutputOperand(0)->get());
+}
+
 /// Returns the tile size to use for the Flow level of an operation that
 /// implements the `PartitionableLoopsInterface`.
 static SmallVector<int64_t> getDefaultDistributedLevelTileSizes(
     ArrayRef<Range> iterationDomain,
     IREE::Flow::PartitionableLoopsInterface partitionableLoopInterfaceOp,
-    ArrayRef<int64_t> minTileSizes, ArrayRef<int64_t> maxTileSizes) {
+    ArrayRef<int64_t> minTileSizes, ArrayRef<int64_t> maxTileSizes,
+    const CPUTargetInfo &targetInfo) {
   assert(iterationDomain.size() == minTileSizes.size() &&
          "expected as many min tile sizes as number of loops");
   auto getStaticValue = [](Value v) -> int64_t {
@@ -298,9 +430,9 @@ static SmallVector<int64_t> getDefaultDistributedLevelTileSizes(
   }
 
   SmallVector<int64_t> distributedTileSizes =
-      getDefaultDistributedLoopTileSizes(distributedLoopLbs, distributedLoopUbs,
-                                         minDistributedLoopTileSizes,
-                                         maxDistributedLoopTileSizes);
+      getDefaultDistributedLoopTileSizes(
+          distributedLoopLbs, distributedLoopUbs, minDistributedLoopTileSizes,
+          maxDistributedLoopTileSizes, targetInfo);
   SmallVector<int64_t> distributedLevelTileSizes(iterationDomain.size(), 0);
   for (auto loopID : llvm::enumerate(partitionableLoops)) {
     distributedLevelTileSizes[loopID.value()] =
@@ -364,7 +496,7 @@ static LogicalResult setDefaultRootConfig(
 
   SmallVector<int64_t> flowTileSizes = getDefaultDistributedLevelTileSizes(
       iterationDomain, partitionableLoopsInterfaceOp, minTileSizes,
-      maxTileSizes);
+      maxTileSizes, getCPUTargetInfo(entryPointFn));
   TileSizesListType tileSizes;
   tileSizes.emplace_back(std::move(flowTileSizes));
   return setOpConfigAndEntryPointFnTranslation(
@@ -372,26 +504,47 @@ static LogicalResult setDefaultRootConfig(
       DispatchLoweringPassPipeline::CPUDefault);
 }
 
+/// Shrinks the {m, n, k} L1 tile sizes in `mnkTileSizes` of `op` so that its
+/// operands fit in the L1 budget of the target. Tile sizes are not reduced
+/// below `vectorSize`.
+static void fitContractionTileSizesToL1(func::FuncOp entryPointFn,
+                                        linalg::ContractionOpInterface op,
+                                        MutableArrayRef<int64_t> mnkTileSizes,
+                                        int64_t vectorSize) {
+  int64_t budget = getCPUTargetInfo(entryPointFn).getL1TileBudget();
+  if (!budget) return;
+  SmallVector<int64_t> minTileSizes(mnkTileSizes.size(), vectorSize);
+  shrinkTileSizesToFit(mnkTileSizes, minTileSizes, {0, 1, 2}, budget,
+                       [&](ArrayRef<int64_t> sizes) {
+                         return getContractionFootprintInBytes(
+                             op, sizes[0], sizes[1], sizes[2]);
+                       });
+}
+
 static LogicalResult setX86SandboxRootConfig(func::FuncOp entryPointFn,
                                              linalg::ContractionOpInterface op,
                                              ArrayRef<int64_t> flowTileSizes,
                                              int vectorSize) {
-  // Hardcoded tiling sizes {1, 1, ..., 8, 32, 16}.
+  // Default tiling sizes {1, 1, ..., 8, 32, 16}, shrunk to fit the L1 cache
+  // when the target describes it.
   // The tiling for parallel dims and reduction dims should be separated.
+  SmallVector<int64_t> l1TileSizes = {8, 32, 16};
+  fitContractionTileSizesToL1(entryPointFn, op, l1TileSizes, vectorSize);
   SmallVector<int64_t> parallelTileSizes;
   int64_t nLoops = cast<linalg::LinalgOp>(op.getOperation()).getNumLoops();
   parallelTileSizes.append(nLoops - 3, 1);
-  parallelTileSizes.push_back(
-      getMaxTileSize(0, flowTileSizes[nLoops - 3], 8, vectorSize));
-  parallelTileSizes.push_back(
-      getMaxTileSize(0, flowTileSizes[nLoops - 2], 32, vectorSize));
+  parallelTileSizes.push_back(getMaxTileSize(0, flowTileSizes[nLoops - 3],
+                                             l1TileSizes[0], vectorSize));
+  parallelTileSizes.push_back(getMaxTileSize(0, flowTileSizes[nLoops - 2],
+                                             l1TileSizes[1], vectorSize));
   parallelTileSizes.push_back(0);
 
   auto lhsShapedType = op.lhs().getType().cast<ShapedType>();
   int64_t K = lhsShapedType.getShape().back();
   SmallVector<int64_t> reductionTileSizes;
   reductionTileSizes.append(nLoops - 1, 0);
-  reductionTileSizes.push_back(getMaxTileSize(0, K, 16, vectorSize));
+  reductionTileSizes.push_back(
+      getMaxTileSize(0, K, l1TileSizes[2], vectorSize));
 
   TileSizesListType tileSizes;
   tileSizes.emplace_back(flowTileSizes.begin(), flowTileSizes.end());
@@ -407,16 +560,20 @@ static LogicalResult setARMRootConfig(func::FuncOp entryPointFn,
                                       linalg::ContractionOpInterface op,
                                       ArrayRef<int64_t> flowTileSizes,
                                       int vectorSize) {
-  // Hardcoded tile sizes, where v is the native vector size.
-  // L1 tile sizes are {1, ..., 5v, v, 16v}.
+  // Default tile sizes, where v is the native vector size.
+  // L1 tile sizes are {1, ..., 5v, v, 16v}, shrunk to fit the L1 cache when
+  // the target describes it.
   // Vector tile sizes are {1, ..., v, v, v}
+  SmallVector<int64_t> mnkTileSizes = {5 * vectorSize, vectorSize,
+                                       16 * vectorSize};
+  fitContractionTileSizesToL1(entryPointFn, op, mnkTileSizes, vectorSize);
   SmallVector<int64_t> l1TileSizes, vectorTileSizes;
   int64_t nLoops = cast<linalg::LinalgOp>(op.getOperation()).getNumLoops();
   l1TileSizes.append(nLoops - 3, 1);
-  l1TileSizes.push_back(
-      getMaxTileSize(0, flowTileSizes[nLoops - 3], 5 * vectorSize, vectorSize));
-  l1TileSizes.push_back(
-      getMaxTileSize(0, flowTileSizes[nLoops - 2], vectorSize, vectorSize));
+  l1TileSizes.push_back(getMaxTileSize(0, flowTileSizes[nLoops - 3],
+                                       mnkTileSizes[0], vectorSize));
+  l1TileSizes.push_back(getMaxTileSize(0, flowTileSizes[nLoops - 2],
+                                       mnkTileSizes[1], vectorSize));
   vectorTileSizes.append(nLoops - 3, 1);
   vectorTileSizes.push_back(vectorSize);
   vectorTileSizes.push_back(vectorSize);
@@ -424,7 +581,7 @@ static LogicalResult setARMRootConfig(func::FuncOp entryPointFn,
   // L1/vector tile size for k dimensions.
   auto lhsShapedType = op.lhs().getType().cast<ShapedType>();
   int64_t K = lhsShapedType.getShape().back();
-  l1TileSizes.push_back(getMaxTileSize(0, K, 16 * vectorSize, vectorSize));
+  l1TileSizes.push_back(getMaxTileSize(0, K, mnkTileSizes[2], vectorSize));
   vectorTileSizes.push_back(vectorSize);
   TileSizesListType tileSizes;
   tileSizes.emplace_back(flowTileSizes.begin(), flowTileSizes.end());
@@ -462,6 +619,37 @@ static LogicalResult setRootConfig(
     maxTileSizes[0] = 1;
   }
 
+  // Bound the M and N tiles of a workgroup so that its LHS and RHS panels and
+  // accumulator stay resident in the L2 cache of the core running it.
+  CPUTargetInfo targetInfo = getCPUTargetInfo(entryPointFn);
+  Optional<SmallVector<int64_t, 4>> staticLoopRanges =
+      linalgOp.getStaticLoopRanges();
+  if (int64_t budget = targetInfo.getL2TileBudget()) {
+    if (numLoops >= 3 && staticLoopRanges) {
+      unsigned mDim = numLoops - 3, nDim = numLoops - 2, kDim = numLoops - 1;
+      ArrayRef<int64_t> ranges = staticLoopRanges.getValue();
+      for (unsigned dim : {mDim, nDim}) {
+        if (!ShapedType::isDynamic(ranges[dim])) {
+          maxTileSizes[dim] = std::max(
+              minTileSizes[dim], std::min(maxTileSizes[dim], ranges[dim]));
+        }
+      }
+      // A dynamic K only contributes the accumulator to the footprint.
+      int64_t K = ShapedType::isDynamic(ranges[kDim]) ? 0 : ranges[kDim];
+      SmallVector<int64_t> mnkTileSizes = {maxTileSizes[mDim],
+                                           maxTileSizes[nDim], K};
+      SmallVector<int64_t> mnkMinTileSizes = {minTileSizes[mDim],
+                                              minTileSizes[nDim], K};
+      shrinkTileSizesToFit(mnkTileSizes, mnkMinTileSizes, {0, 1}, budget,
+                           [&](ArrayRef<int64_t> sizes) {
+                             return getContractionFootprintInBytes(
+                                 contractionOp, sizes[0], sizes[1], sizes[2]);
+                           });
+      maxTileSizes[mDim] = mnkTileSizes[0];
+      maxTileSizes[nDim] = mnkTileSizes[1];
+    }
+  }
+
   OpBuilder builder(entryPointFn.getContext());
   builder.setInsertionPoint(contractionOp);
   SmallVector<Range> iterationDomain =
@@ -470,7 +658,7 @@ static LogicalResult setRootConfig(
       iterationDomain,
       cast<IREE::Flow::PartitionableLoopsInterface>(
           contractionOp.getOperation()),
-      minTileSizes, maxTileSizes);
+      minTileSizes, maxTileSizes, targetInfo);
 
   // TODO(dcaballe): Find better configurations for RISC-V backends.
   if (isX86(entryPointFn) || isRISCV(entryPointFn)) {
@@ -600,7 +788,7 @@ static LogicalResult setRootConfig(
       cast<IREE::Flow::PartitionableLoopsInterface>(genericOp.getOperation());
   SmallVector<int64_t> flowTileSizes = getDefaultDistributedLevelTileSizes(
       iterationDomain, partitionableLoopsInterfaceOp, minTileSizes,
-      maxTileSizes);
+      maxTileSizes, getCPUTargetInfo(entryPointFn));
 
   // Set the Next level tile sizes.
   SmallVector<int64_t> parallelTileSizes(numLoops, 0);
@@ -638,6 +826,48 @@ static LogicalResult setRootConfig(
                                                tileSizes, passPipeline);
 }
 
+/// Shrinks the OH, OW and OC (or C) entries of `tileSizes` for the
+/// linalg.conv_2d_nhwc_hwcf or linalg.depthwise_conv_2d_nhwc_hwc `convOp` with
+/// static loop ranges `shapes` until the input window, filter slice and output
+/// tile of a workgroup fit in `budget` bytes.
+static void fitConvTileSizesToCache(linalg::LinalgOp convOp,
+                                    ArrayRef<int64_t> shapes,
+                                    MutableArrayRef<int64_t> tileSizes,
+                                    ArrayRef<int64_t> minTileSizes,
+                                    int64_t budget) {
+  bool isDepthwise =
+      isa<linalg::DepthwiseConv2DNhwcHwcOp>(convOp.getOperation());
+  auto getAttrValues = [&](StringRef name) -> SmallVector<int64_t> {
+    SmallVector<int64_t> values(2, 1);
+    if (auto attr = convOp->getAttrOfType<DenseIntElementsAttr>(name)) {
+      values = llvm::to_vector(attr.getValues<int64_t>());
+    }
+    return values;
+  };
+  SmallVector<int64_t> strides = getAttrValues("strides");
+  SmallVector<int64_t> dilations = getAttrValues("dilations");
+  int64_t inputBytes = getElementByteWidth(convOp.getInputOperand(0)->get());
+  int64_t filterBytes = getElementByteWidth(convOp.getInputOperand(1)->get());
+  int64_t outputBytes = getElementByteWidth(convOp.getOutputOperand(0)->get());
+
+  // Loops are N, OH, OW, OC/C, KH, KW, (IC). The N loop is not distributed.
+  int64_t n = shapes[0], kh = shapes[4], kw = shapes[5];
+  int64_t ic = isDepthwise ? 1 : shapes[6];
+  for (unsigned dim : {1u, 2u, 3u}) {
+    tileSizes[dim] = std::max(minTileSizes[dim],
+                              std::min(tileSizes[dim], shapes[dim]));
+  }
+  shrinkTileSizesToFit(
+      tileSizes, minTileSizes, {1, 2, 3}, budget, [&](ArrayRef<int64_t> t) {
+        int64_t ih = (t[1] - 1) * strides[0] + (kh - 1) * dilations[0] + 1;
+        int64_t iw = (t[2] - 1) * strides[1] + (kw - 1) * dilations[1] + 1;
+        int64_t inputChannels = isDepthwise ? t[3] : ic;
+        return n * ih * iw * inputChannels * inputBytes +
+               kh * kw * ic * t[3] * filterBytes +
+               n * t[1] * t[2] * t[3] * outputBytes;
+      });
+}
+
 /// Sets the lowering configuration for linalg.conv_2d_nhwc_hwcf and
 /// linalg.depthwise_conv_2d_nhwc_hwc operations.
 static LogicalResult setConvRootConfig(
@@ -654,6 +884,20 @@ static LogicalResult setConvRootConfig(
   SmallVector<int64_t> minTileSizes(numLoops, 1);
   SmallVector<int64_t> maxTileSizes(numLoops, defaultWorkgroupTileSize);
 
+  // Shapes of N, OH, OW, OC, KH, KW, (IC)
+  Optional<SmallVector<int64_t, 4>> shapes = convOp.getStaticLoopRanges();
+
+  // Bound the OH, OW and OC tiles of a workgroup so that its input window,
+  // filter slice and output tile stay resident in the L2 cache of the core
+  // running it.
+  CPUTargetInfo targetInfo = getCPUTargetInfo(entryPointFn);
+  if (int64_t budget = targetInfo.getL2TileBudget()) {
+    if (shapes && llvm::none_of(shapes.getValue(), ShapedType::isDynamic)) {
+      fitConvTileSizesToCache(convOp, shapes.getValue(), maxTileSizes,
+                              minTileSizes, budget);
+    }
+  }
+
   // Set the flow level tiling to the default.
   OpBuilder builder(convOp.getContext());
   builder.setInsertionPoint(convOp);
@@ -663,10 +907,7 @@ static LogicalResult setConvRootConfig(
       cast<IREE::Flow::PartitionableLoopsInterface>(convOp.getOperation());
   SmallVector<int64_t> flowTileSizes = getDefaultDistributedLevelTileSizes(
       iterationDomain, partitionableLoopsInterfaceOp, minTileSizes,
-      maxTileSizes);
-
-  // Shapes of N, OH, OW, OC, KH, KW, (IC)
-  Optional<SmallVector<int64_t, 4>> shapes = convOp.getStaticLoopRanges();
+      maxTileSizes, targetInfo);
   SmallVector<int64_t> parallelTileSizes(targetTileSizes.begin(),
                                          targetTileSizes.end());
   for (auto i : llvm::seq<unsigned>(0, parallelTileSizes.size())) {
@@ -910,6 +1151,11 @@ static LogicalResult setTranslationInfoAndRootConfig(
 LogicalResult initCPULaunchConfig(ModuleOp moduleOp) {
   llvm::StringMap<IREE::HAL::ExecutableEntryPointOp> entryPointOps =
       getAllEntryPoints(moduleOp);
+  // The key must be computed before any configuration is attached.
+  std::string tuningKey;
+  if (!clTuningDatabase.empty() || !clTuningReport.empty()) {
+    tuningKey = getTuningKey(moduleOp);
+  }
   for (auto funcOp : moduleOp.getOps<func::FuncOp>()) {
     auto entryPointOp = entryPointOps.lookup(funcOp.getName());
     if (!entryPointOp) continue;
@@ -933,10 +1179,33 @@ LogicalResult initCPULaunchConfig(ModuleOp moduleOp) {
       return failure();
     }
 
+    // Use the configuration found by offline tuning, unless the root op
+    // already has a preset one.
+    if (!clTuningDatabase.empty()) {
+      FailureOr<IREE::Codegen::CompilationInfoAttr> tunedInfo =
+          lookupTunedCompilationInfo(clTuningDatabase, tuningKey, funcOp);
+      if (failed(tunedInfo)) return failure();
+      FailureOr<Operation *> rootOp = getRootOperation(computeOps);
+      if (failed(rootOp)) return failure();
+      if (tunedInfo.getValue() && rootOp.getValue() &&
+          !getCompilationInfo(rootOp.getValue())) {
+        setCompilationInfo(rootOp.getValue(), tunedInfo.getValue());
+      }
+    }
+
     if (failed(
             setTranslationInfoAndRootConfig(funcOp, computeOps, tiledLoops))) {
       return failure();
     }
+
+    if (!clTuningReport.empty()) {
+      FailureOr<Operation *> rootOp = getRootOperation(computeOps);
+      if (succeeded(rootOp) && rootOp.getValue() &&
+          failed(appendTuningReportRecord(clTuningReport, tuningKey, funcOp,
+                                          rootOp.getValue()))) {
+        return failure();
+      }
+    }
   }
 
   // The root confguration setting introduces `tensor.dim` operations. Resolve
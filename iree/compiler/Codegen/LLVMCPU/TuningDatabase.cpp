@@ -0,0 +1,237 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/compiler/Codegen/LLVMCPU/TuningDatabase.h"
+
+#include <memory>
+#include <mutex>
+
+#include "iree/compiler/Codegen/Utils/Utils.h"
+#include "iree/compiler/Dialect/HAL/IR/HALOps.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+#include "mlir/Dialect/Linalg/IR/Linalg.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/Parser/Parser.h"
+
+namespace mlir {
+namespace iree_compiler {
+
+// Version of the tuning database format understood by the compiler.
+static const int64_t kTuningDatabaseVersion = 1;
+
+std::string getTuningKey(ModuleOp moduleOp) {
+  std::string contents;
+  llvm::raw_string_ostream os(contents);
+  if (auto variantOp =
+          moduleOp->getParentOfType<IREE::HAL::ExecutableVariantOp>()) {
+    variantOp.target().print(os);
+    os << "\n";
+  }
+  OpPrintingFlags flags;
+  flags.useLocalScope();
+  moduleOp->print(os, flags);
+  os.flush();
+
+  llvm::MD5 hasher;
+  hasher.update(contents);
+  llvm::MD5::MD5Result result;
+  hasher.final(result);
+  return result.digest().str().str();
+}
+
+//===----------------------------------------------------------------------===//
+// Tuning database
+//===----------------------------------------------------------------------===//
+
+namespace {
+/// Printed `#iree_codegen.compilation_info` attributes keyed by
+/// `<key>:<entry point>`. Attributes are kept as strings as databases are
+/// shared across contexts.
+using TuningDatabase = llvm::StringMap<std::string>;
+}  // namespace
+
+namespace {
+/// A tuning database loaded from a file along with the file status it was
+/// loaded from.
+struct CachedTuningDatabase {
+  llvm::sys::TimePoint<> modificationTime;
+  uint64_t size = 0;
+  std::shared_ptr<const TuningDatabase> database;
+};
+}  // namespace
+
+/// Loads the tuning database at `path`. Every executable looks up the same
+/// database so it is only parsed again when the file changes (such as between
+/// tuning iterations in a long-running process). Translation runs on multiple
+/// threads so all accesses are guarded by a mutex.
+static FailureOr<std::shared_ptr<const TuningDatabase>> loadTuningDatabase(
+    StringRef path, Operation *op) {
+  static std::mutex mutex;
+  static llvm::StringMap<CachedTuningDatabase> databases;
+  std::lock_guard<std::mutex> lock(mutex);
+  llvm::sys::fs::file_status status;
+  if (std::error_code ec = llvm::sys::fs::status(path, status)) {
+    op->emitError() << "failed to open tuning database " << path << ": "
+                    << ec.message();
+    return failure();
+  }
+  CachedTuningDatabase &cached = databases[path];
+  if (cached.database &&
+      cached.modificationTime == status.getLastModificationTime() &&
+      cached.size == status.getSize()) {
+    return cached.database;
+  }
+
+  auto fileOr = llvm::MemoryBuffer::getFile(path);
+  if (!fileOr) {
+    op->emitError() << "failed to open tuning database " << path << ": "
+                    << fileOr.getError().message();
+    return failure();
+  }
+  llvm::Expected<llvm::json::Value> json =
+      llvm::json::parse((*fileOr)->getBuffer());
+  if (!json) {
+    op->emitError() << "failed to parse tuning database " << path << ": "
+                    << llvm::toString(json.takeError());
+    return failure();
+  }
+  const llvm::json::Object *root = json->getAsObject();
+  const llvm::json::Array *entries = root ? root->getArray("entries") : nullptr;
+  if (!entries) {
+    op->emitError() << "expected tuning database " << path
+                    << " to be an object with an `entries` list";
+    return failure();
+  }
+  Optional<int64_t> version = root->getInteger("version");
+  if (version && *version != kTuningDatabaseVersion) {
+    op->emitError() << "unsupported tuning database version " << *version
+                    << " in " << path;
+    return failure();
+  }
+
+  auto database = std::make_shared<TuningDatabase>();
+  for (const llvm::json::Value &entry : *entries) {
+    const llvm::json::Object *object = entry.getAsObject();
+    Optional<StringRef> key, entryPoint, compilationInfo;
+    if (object) {
+      key = object->getString("key");
+      entryPoint = object->getString("entry_point");
+      compilationInfo = object->getString("compilation_info");
+    }
+    if (!key || !entryPoint || !compilationInfo) {
+      op->emitError() << "expected every entry of tuning database " << path
+                      << " to have `key`, `entry_point` and "
+                         "`compilation_info` strings";
+      return failure();
+    }
+    (*database)[(*key + ":" + *entryPoint).str()] = compilationInfo->str();
+  }
+  cached.modificationTime = status.getLastModificationTime();
+  cached.size = status.getSize();
+  cached.database = std::move(database);
+  return cached.database;
+}
+
+FailureOr<IREE::Codegen::CompilationInfoAttr> lookupTunedCompilationInfo(
+    StringRef path, StringRef key, func::FuncOp entryPointFn) {
+  FailureOr<std::shared_ptr<const TuningDatabase>> database =
+      loadTuningDatabase(path, entryPointFn);
+  if (failed(database)) return failure();
+  auto it = database.getValue()->find(
+      (key + ":" + entryPointFn.getName()).str());
+  if (it == database.getValue()->end()) {
+    return IREE::Codegen::CompilationInfoAttr();
+  }
+
+  Attribute attr = parseAttribute(it->second, entryPointFn.getContext());
+  auto compilationInfo =
+      attr.dyn_cast_or_null<IREE::Codegen::CompilationInfoAttr>();
+  if (!compilationInfo) {
+    entryPointFn.emitError()
+        << "expected #iree_codegen.compilation_info in tuning database "
+        << path << ", got: " << it->second;
+    return failure();
+  }
+  return compilationInfo;
+}
+
+//===----------------------------------------------------------------------===//
+// Tuning report
+//===----------------------------------------------------------------------===//
+
+static llvm::json::Array getJSONArray(ArrayRef<int64_t> values) {
+  llvm::json::Array array;
+  for (int64_t value : values) array.push_back(value);
+  return array;
+}
+
+LogicalResult appendTuningReportRecord(StringRef path, StringRef key,
+                                       func::FuncOp entryPointFn,
+                                       Operation *rootOp) {
+  IREE::HAL::ExecutableEntryPointOp entryPointOp = getEntryPoint(entryPointFn);
+  IREE::Codegen::TranslationInfoAttr translationInfo =
+      getTranslationInfo(entryPointOp);
+  IREE::Codegen::LoweringConfigAttr loweringConfig =
+      getLoweringConfig(rootOp);
+  if (!translationInfo || !loweringConfig) return success();
+  SmallVector<int64_t> workgroupSize = getWorkgroupSize(entryPointOp);
+
+  llvm::json::Object record;
+  record["key"] = key;
+  record["entry_point"] = entryPointFn.getName();
+  record["root_op"] = rootOp->getName().getStringRef();
+  if (auto linalgOp = dyn_cast<linalg::LinalgOp>(rootOp)) {
+    // Dynamic loop ranges are reported as -1.
+    if (Optional<SmallVector<int64_t, 4>> loopRanges =
+            linalgOp.getStaticLoopRanges()) {
+      record["loop_ranges"] = getJSONArray(loopRanges.getValue());
+    }
+    llvm::json::Array iteratorTypes;
+    for (Attribute iteratorType : linalgOp.iterator_types()) {
+      iteratorTypes.push_back(iteratorType.cast<StringAttr>().getValue());
+    }
+    record["iterator_types"] = std::move(iteratorTypes);
+  }
+  record["pipeline"] = IREE::Codegen::stringifyEnum(
+      translationInfo.getDispatchLoweringPassPipeline());
+  llvm::json::Array tileSizes;
+  for (ArrayRef<int64_t> levelTileSizes : loweringConfig.getTileSizeVals()) {
+    tileSizes.push_back(getJSONArray(levelTileSizes));
+  }
+  record["tile_sizes"] = std::move(tileSizes);
+  record["native_vector_size"] =
+      getJSONArray(loweringConfig.getNativeVectorSizeVals());
+  record["workgroup_size"] = getJSONArray(workgroupSize);
+
+  Builder builder(entryPointFn.getContext());
+  auto compilationInfo = IREE::Codegen::CompilationInfoAttr::get(
+      builder.getContext(), loweringConfig, translationInfo,
+      builder.getI64ArrayAttr(workgroupSize));
+  std::string compilationInfoStr;
+  llvm::raw_string_ostream compilationInfoOs(compilationInfoStr);
+  compilationInfo.print(compilationInfoOs);
+  record["compilation_info"] = compilationInfoOs.str();
+
+  // Translation runs on multiple threads; serialize the appends.
+  static std::mutex mutex;
+  std::lock_guard<std::mutex> lock(mutex);
+  std::error_code ec;
+  llvm::raw_fd_ostream os(path, ec, llvm::sys::fs::OF_Append);
+  if (ec) {
+    return entryPointFn.emitError()
+           << "failed to open tuning report " << path << ": " << ec.message();
+  }
+  os << llvm::json::Value(std::move(record)) << "\n";
+  return success();
+}
+
+}  // namespace iree_compiler
+}  // namespace mlir
@@ -0,0 +1,66 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+//===- TuningDatabase.h - Offline tuned CPU dispatch configurations -------===//
+//
+// Configurations found by offline autotuning (see
+// scripts/tune_cpu_dispatches.py) are stored in a JSON tuning database keyed by
+// a hash of the executable variant they were tuned for:
+//
+//   {
+//     "version": 1,
+//     "entries": [
+//       {
+//         "key": "<hash of the hal.executable.variant contents>",
+//         "entry_point": "<entry point name>",
+//         "compilation_info": "#iree_codegen.compilation_info<...>"
+//       }
+//     ]
+//   }
+//
+// Additional fields (such as measured times) are ignored by the compiler.
+//
+// To find the dispatches worth tuning the compiler can also append a JSON lines
+// report describing the default configuration selected for each entry point.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef IREE_COMPILER_CODEGEN_LLVMCPU_TUNINGDATABASE_H_
+#define IREE_COMPILER_CODEGEN_LLVMCPU_TUNINGDATABASE_H_
+
+#include <string>
+
+#include "iree/compiler/Codegen/Dialect/LoweringConfig.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/IR/BuiltinOps.h"
+
+namespace mlir {
+namespace iree_compiler {
+
+/// Returns the key identifying `moduleOp`, the module nested in a
+/// hal.executable.variant, in a tuning database. The key hashes the variant
+/// target and the printed module so it is stable across compiler invocations
+/// with the same input and flags.
+std::string getTuningKey(ModuleOp moduleOp);
+
+/// Returns the `#iree_codegen.compilation_info` stored for `entryPointFn` of
+/// the executable with `key` in the tuning database at `path`, or nullptr if
+/// there is none. Fails if the database cannot be read or the stored attribute
+/// cannot be parsed.
+FailureOr<IREE::Codegen::CompilationInfoAttr> lookupTunedCompilationInfo(
+    StringRef path, StringRef key, func::FuncOp entryPointFn);
+
+/// Appends a record describing the configuration selected for `rootOp` in
+/// `entryPointFn` of the executable with `key` to the JSON lines report at
+/// `path`.
+LogicalResult appendTuningReportRecord(StringRef path, StringRef key,
+                                       func::FuncOp entryPointFn,
+                                       Operation *rootOp);
+
+}  // namespace iree_compiler
+}  // namespace mlir
+
+#endif  // IREE_COMPILER_CODEGEN_LLVMCPU_TUNINGDATABASE_H_
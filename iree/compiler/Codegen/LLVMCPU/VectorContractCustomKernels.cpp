@@ -4,6 +4,8 @@
 // See https://llvm.org/LICENSE.txt for license information.
 // SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
 
+#include <algorithm>
+
 #include "iree/compiler/Codegen/PassDetail.h"
 #include "iree/compiler/Codegen/Passes.h"
 #include "iree/compiler/Utils/CustomKernelsTargetInfo.h"
@@ -586,9 +588,9 @@ MMTKernel MMTKernel_8x8x8_i8i8i32_Aarch64I8mm_InlineAsm() {
 // register is faster than reading 32bits twice. That's a shallow advantage that
 // might vanish once the vector.contract abstraction layer above kernels is
 // improved. Another reason why it's not implemented yet is it would have shape
-// 8x8x1, same as the aarch64 baseline matrix*vector i8 kernel, so we would need
-// a "kernel benefit" system to cleanly express the preference for the i8mm
-// kernel.
+// 8x8x1, same as the aarch64 baseline matrix*vector i8 kernel, so it would
+// need to be added with a higher benefit than that kernel (see
+// populateVectorContractCustomKernelsPatterns).
 
 // f32*f32->f32 kernel for Aarch64 NEON
 //
@@ -682,6 +684,269 @@ MMTKernel MMTKernel_8x1x1_f32f32f32_Aarch64_Baseline_InlineAsm() {
   return kernel;
 }
 
+// f32*f32->f32 kernel for x86-64 AVX+FMA
+//
+// The accumulator tile is row-major with one 8-float row per ymm register, so
+// each step needs one LHS value broadcast to all lanes. AVX has no
+// lane-crossing broadcast from a register, so we broadcast within 128-bit
+// lanes with vshufps and then across lanes with vperm2f128, handling rows i
+// and i+4 together.
+//
+// This kernel is needed because: at the moment, the codegen broadcasts LHS
+// values by reloading them from memory one scalar at a time and does not keep
+// the whole 8x8 accumulator tile in registers.
+MMTKernel MMTKernel_8x1x8_f32f32f32_X86_64Fma_InlineAsm() {
+  MMTKernel kernel;
+  kernel.arch = CustomKernelTargetArch::X86_64;
+  kernel.lhsType = MMTKernel::ScalarType::F32;
+  kernel.rhsType = MMTKernel::ScalarType::F32;
+  kernel.accType = MMTKernel::ScalarType::F32;
+  kernel.m0 = 8;
+  kernel.k0 = 1;
+  kernel.n0 = 8;
+  kernel.lhsRegSize = 8;  // LHS AVX register type: float32x8 (ymm)
+  kernel.rhsRegSize = 8;  // RHS AVX register type: float32x8 (ymm)
+  kernel.accRegSize = 8;  // Accum AVX register type: float32x8 (ymm)
+  kernel.lhsRegs = 1;
+  kernel.rhsRegs = 1;
+  kernel.accRegs = 8;  // = 8x8/8 for 8x8 Accum elems, 8 per register
+  kernel.asmImpl = R"ASM(
+      vshufps $$0x00, $(lhs:0), $(lhs:0), %ymm14
+      vperm2f128 $$0x00, %ymm14, %ymm14, %ymm15
+      vfmadd231ps $(rhs:0), %ymm15, $(acc:0)
+      vperm2f128 $$0x11, %ymm14, %ymm14, %ymm15
+      vfmadd231ps $(rhs:0), %ymm15, $(acc:4)
+      vshufps $$0x55, $(lhs:0), $(lhs:0), %ymm14
+      vperm2f128 $$0x00, %ymm14, %ymm14, %ymm15
+      vfmadd231ps $(rhs:0), %ymm15, $(acc:1)
+      vperm2f128 $$0x11, %ymm14, %ymm14, %ymm15
+      vfmadd231ps $(rhs:0), %ymm15, $(acc:5)
+      vshufps $$0xAA, $(lhs:0), $(lhs:0), %ymm14
+      vperm2f128 $$0x00, %ymm14, %ymm14, %ymm15
+      vfmadd231ps $(rhs:0), %ymm15, $(acc:2)
+      vperm2f128 $$0x11, %ymm14, %ymm14, %ymm15
+      vfmadd231ps $(rhs:0), %ymm15, $(acc:6)
+      vshufps $$0xFF, $(lhs:0), $(lhs:0), %ymm14
+      vperm2f128 $$0x00, %ymm14, %ymm14, %ymm15
+      vfmadd231ps $(rhs:0), %ymm15, $(acc:3)
+      vperm2f128 $$0x11, %ymm14, %ymm14, %ymm15
+      vfmadd231ps $(rhs:0), %ymm15, $(acc:7)
+    )ASM";
+  kernel.asmClobbers = "ymm14,ymm15";
+  return kernel;
+}
+
+// f32*f32->f32 kernel for x86-64 AVX-512
+//
+// Same approach as the AVX+FMA kernel above, but with 16x16 tiles: vshufps
+// broadcasts within each 128-bit lane and vshuff32x4 then broadcasts one of
+// the four lanes to the whole zmm register. With 32 zmm registers the 16
+// accumulator rows fit comfortably alongside the operands.
+MMTKernel MMTKernel_16x1x16_f32f32f32_X86_64Avx512f_InlineAsm() {
+  MMTKernel kernel;
+  kernel.arch = CustomKernelTargetArch::X86_64;
+  kernel.lhsType = MMTKernel::ScalarType::F32;
+  kernel.rhsType = MMTKernel::ScalarType::F32;
+  kernel.accType = MMTKernel::ScalarType::F32;
+  kernel.m0 = 16;
+  kernel.k0 = 1;
+  kernel.n0 = 16;
+  kernel.lhsRegSize = 16;  // LHS AVX-512 register type: float32x16 (zmm)
+  kernel.rhsRegSize = 16;  // RHS AVX-512 register type: float32x16 (zmm)
+  kernel.accRegSize = 16;  // Accum AVX-512 register type: float32x16 (zmm)
+  kernel.lhsRegs = 1;
+  kernel.rhsRegs = 1;
+  kernel.accRegs = 16;  // = 16x16/16 for 16x16 Accum elems, 16 per register
+  kernel.asmImpl = R"ASM(
+      vshufps $$0x00, $(lhs:0), $(lhs:0), %zmm30
+      vshuff32x4 $$0x00, %zmm30, %zmm30, %zmm31
+      vfmadd231ps $(rhs:0), %zmm31, $(acc:0)
+      vshuff32x4 $$0x55, %zmm30, %zmm30, %zmm31
+      vfmadd231ps $(rhs:0), %zmm31, $(acc:4)
+      vshuff32x4 $$0xAA, %zmm30, %zmm30, %zmm31
+      vfmadd231ps $(rhs:0), %zmm31, $(acc:8)
+      vshuff32x4 $$0xFF, %zmm30, %zmm30, %zmm31
+      vfmadd231ps $(rhs:0), %zmm31, $(acc:12)
+      vshufps $$0x55, $(lhs:0), $(lhs:0), %zmm30
+      vshuff32x4 $$0x00, %zmm30, %zmm30, %zmm31
+      vfmadd231ps $(rhs:0), %zmm31, $(acc:1)
+      vshuff32x4 $$0x55, %zmm30, %zmm30, %zmm31
+      vfmadd231ps $(rhs:0), %zmm31, $(acc:5)
+      vshuff32x4 $$0xAA, %zmm30, %zmm30, %zmm31
+      vfmadd231ps $(rhs:0), %zmm31, $(acc:9)
+      vshuff32x4 $$0xFF, %zmm30, %zmm30, %zmm31
+      vfmadd231ps $(rhs:0), %zmm31, $(acc:13)
+      vshufps $$0xAA, $(lhs:0), $(lhs:0), %zmm30
+      vshuff32x4 $$0x00, %zmm30, %zmm30, %zmm31
+      vfmadd231ps $(rhs:0), %zmm31, $(acc:2)
+      vshuff32x4 $$0x55, %zmm30, %zmm30, %zmm31
+      vfmadd231ps $(rhs:0), %zmm31, $(acc:6)
+      vshuff32x4 $$0xAA, %zmm30, %zmm30, %zmm31
+      vfmadd231ps $(rhs:0), %zmm31, $(acc:10)
+      vshuff32x4 $$0xFF, %zmm30, %zmm30, %zmm31
+      vfmadd231ps $(rhs:0), %zmm31, $(acc:14)
+      vshufps $$0xFF, $(lhs:0), $(lhs:0), %zmm30
+      vshuff32x4 $$0x00, %zmm30, %zmm30, %zmm31
+      vfmadd231ps $(rhs:0), %zmm31, $(acc:3)
+      vshuff32x4 $$0x55, %zmm30, %zmm30, %zmm31
+      vfmadd231ps $(rhs:0), %zmm31, $(acc:7)
+      vshuff32x4 $$0xAA, %zmm30, %zmm30, %zmm31
+      vfmadd231ps $(rhs:0), %zmm31, $(acc:11)
+      vshuff32x4 $$0xFF, %zmm30, %zmm30, %zmm31
+      vfmadd231ps $(rhs:0), %zmm31, $(acc:15)
+    )ASM";
+  kernel.asmClobbers = "zmm30,zmm31";
+  return kernel;
+}
+
+// i8*i8->i32 kernel for x86-64 AVX-VNNI
+//
+// vpdpbusd multiplies *unsigned* int8 values from its first source by signed
+// int8 values from its second source, accumulating groups of 4 products into
+// int32 lanes. To support arbitrary signed LHS values we flip their sign bit,
+// which adds 128 to each value when interpreted as unsigned, and subtract the
+// resulting 128*sum(RHS) term from the accumulators at the end. That
+// correction term is itself computed with vpdpbusd against a vector of 128s.
+//
+// As in the f32 kernels, each 4-byte LHS row is broadcast with a vpshufd and
+// vperm2i128 pair before being multiplied against the whole 8x4 RHS tile.
+MMTKernel MMTKernel_8x4x8_i8i8i32_X86_64AvxVnni_InlineAsm() {
+  MMTKernel kernel;
+  kernel.arch = CustomKernelTargetArch::X86_64;
+  kernel.lhsType = MMTKernel::ScalarType::I8;
+  kernel.rhsType = MMTKernel::ScalarType::I8;
+  kernel.accType = MMTKernel::ScalarType::I32;
+  kernel.m0 = 8;
+  kernel.k0 = 4;
+  kernel.n0 = 8;
+  kernel.lhsRegSize = 32;  // LHS AVX register type: int8x32 (ymm)
+  kernel.rhsRegSize = 32;  // RHS AVX register type: int8x32 (ymm)
+  kernel.accRegSize = 8;   // Accum AVX register type: int32x8 (ymm)
+  kernel.lhsRegs = 1;      // = 8x4/32 for 8x4 LHS elems, 32 per register
+  kernel.rhsRegs = 1;      // = 8x4/32 for 8x4 RHS elems, 32 per register
+  kernel.accRegs = 8;      // = 8x8/8 for 8x8 Accum elems, 8 per register
+  kernel.asmImpl = R"ASM(
+      movl $$0x80808080, %eax
+      vmovd %eax, %xmm12
+      vpbroadcastd %xmm12, %ymm12  # ymm12 = 128 in each (unsigned) int8 lane
+      vpxor %ymm13, %ymm13, %ymm13
+      {vex} vpdpbusd $(rhs:0), %ymm12, %ymm13  # ymm13 = 128 * sum(RHS rows)
+      vpxor $(lhs:0), %ymm12, %ymm12  # ymm12 = LHS + 128, as unsigned
+      vpshufd $$0x00, %ymm12, %ymm14
+      vperm2i128 $$0x00, %ymm14, %ymm14, %ymm15
+      {vex} vpdpbusd $(rhs:0), %ymm15, $(acc:0)
+      vperm2i128 $$0x11, %ymm14, %ymm14, %ymm15
+      {vex} vpdpbusd $(rhs:0), %ymm15, $(acc:4)
+      vpshufd $$0x55, %ymm12, %ymm14
+      vperm2i128 $$0x00, %ymm14, %ymm14, %ymm15
+      {vex} vpdpbusd $(rhs:0), %ymm15, $(acc:1)
+      vperm2i128 $$0x11, %ymm14, %ymm14, %ymm15
+      {vex} vpdpbusd $(rhs:0), %ymm15, $(acc:5)
+      vpshufd $$0xAA, %ymm12, %ymm14
+      vperm2i128 $$0x00, %ymm14, %ymm14, %ymm15
+      {vex} vpdpbusd $(rhs:0), %ymm15, $(acc:2)
+      vperm2i128 $$0x11, %ymm14, %ymm14, %ymm15
+      {vex} vpdpbusd $(rhs:0), %ymm15, $(acc:6)
+      vpshufd $$0xFF, %ymm12, %ymm14
+      vperm2i128 $$0x00, %ymm14, %ymm14, %ymm15
+      {vex} vpdpbusd $(rhs:0), %ymm15, $(acc:3)
+      vperm2i128 $$0x11, %ymm14, %ymm14, %ymm15
+      {vex} vpdpbusd $(rhs:0), %ymm15, $(acc:7)
+      vpsubd %ymm13, $(acc:0), $(acc:0)
+      vpsubd %ymm13, $(acc:1), $(acc:1)
+      vpsubd %ymm13, $(acc:2), $(acc:2)
+      vpsubd %ymm13, $(acc:3), $(acc:3)
+      vpsubd %ymm13, $(acc:4), $(acc:4)
+      vpsubd %ymm13, $(acc:5), $(acc:5)
+      vpsubd %ymm13, $(acc:6), $(acc:6)
+      vpsubd %ymm13, $(acc:7), $(acc:7)
+    )ASM";
+  kernel.asmClobbers = "eax,ymm12,ymm13,ymm14,ymm15";
+  return kernel;
+}
+
+// i8*i8->i32 kernel for x86-64 AVX-512 VNNI
+//
+// Same approach as the AVX-VNNI kernel above, but with 16x16 tiles and zmm
+// registers; vshufi32x4 broadcasts one 128-bit lane across the zmm register.
+MMTKernel MMTKernel_16x4x16_i8i8i32_X86_64Avx512Vnni_InlineAsm() {
+  MMTKernel kernel;
+  kernel.arch = CustomKernelTargetArch::X86_64;
+  kernel.lhsType = MMTKernel::ScalarType::I8;
+  kernel.rhsType = MMTKernel::ScalarType::I8;
+  kernel.accType = MMTKernel::ScalarType::I32;
+  kernel.m0 = 16;
+  kernel.k0 = 4;
+  kernel.n0 = 16;
+  kernel.lhsRegSize = 64;  // LHS AVX-512 register type: int8x64 (zmm)
+  kernel.rhsRegSize = 64;  // RHS AVX-512 register type: int8x64 (zmm)
+  kernel.accRegSize = 16;  // Accum AVX-512 register type: int32x16 (zmm)
+  kernel.lhsRegs = 1;      // = 16x4/64 for 16x4 LHS elems, 64 per register
+  kernel.rhsRegs = 1;      // = 16x4/64 for 16x4 RHS elems, 64 per register
+  kernel.accRegs = 16;     // = 16x16/16 for 16x16 Accum elems, 16 per register
+  kernel.asmImpl = R"ASM(
+      movl $$0x80808080, %eax
+      vpbroadcastd %eax, %zmm28  # zmm28 = 128 in each (unsigned) int8 lane
+      vpxord %zmm29, %zmm29, %zmm29
+      vpdpbusd $(rhs:0), %zmm28, %zmm29  # zmm29 = 128 * sum(RHS rows)
+      vpxord $(lhs:0), %zmm28, %zmm28  # zmm28 = LHS + 128, as unsigned
+      vpshufd $$0x00, %zmm28, %zmm30
+      vshufi32x4 $$0x00, %zmm30, %zmm30, %zmm31
+      vpdpbusd $(rhs:0), %zmm31, $(acc:0)
+      vshufi32x4 $$0x55, %zmm30, %zmm30, %zmm31
+      vpdpbusd $(rhs:0), %zmm31, $(acc:4)
+      vshufi32x4 $$0xAA, %zmm30, %zmm30, %zmm31
+      vpdpbusd $(rhs:0), %zmm31, $(acc:8)
+      vshufi32x4 $$0xFF, %zmm30, %zmm30, %zmm31
+      vpdpbusd $(rhs:0), %zmm31, $(acc:12)
+      vpshufd $$0x55, %zmm28, %zmm30
+      vshufi32x4 $$0x00, %zmm30, %zmm30, %zmm31
+      vpdpbusd $(rhs:0), %zmm31, $(acc:1)
+      vshufi32x4 $$0x55, %zmm30, %zmm30, %zmm31
+      vpdpbusd $(rhs:0), %zmm31, $(acc:5)
+      vshufi32x4 $$0xAA, %zmm30, %zmm30, %zmm31
+      vpdpbusd $(rhs:0), %zmm31, $(acc:9)
+      vshufi32x4 $$0xFF, %zmm30, %zmm30, %zmm31
+      vpdpbusd $(rhs:0), %zmm31, $(acc:13)
+      vpshufd $$0xAA, %zmm28, %zmm30
+      vshufi32x4 $$0x00, %zmm30, %zmm30, %zmm31
+      vpdpbusd $(rhs:0), %zmm31, $(acc:2)
+      vshufi32x4 $$0x55, %zmm30, %zmm30, %zmm31
+      vpdpbusd $(rhs:0), %zmm31, $(acc:6)
+      vshufi32x4 $$0xAA, %zmm30, %zmm30, %zmm31
+      vpdpbusd $(rhs:0), %zmm31, $(acc:10)
+      vshufi32x4 $$0xFF, %zmm30, %zmm30, %zmm31
+      vpdpbusd $(rhs:0), %zmm31, $(acc:14)
+      vpshufd $$0xFF, %zmm28, %zmm30
+      vshufi32x4 $$0x00, %zmm30, %zmm30, %zmm31
+      vpdpbusd $(rhs:0), %zmm31, $(acc:3)
+      vshufi32x4 $$0x55, %zmm30, %zmm30, %zmm31
+      vpdpbusd $(rhs:0), %zmm31, $(acc:7)
+      vshufi32x4 $$0xAA, %zmm30, %zmm30, %zmm31
+      vpdpbusd $(rhs:0), %zmm31, $(acc:11)
+      vshufi32x4 $$0xFF, %zmm30, %zmm30, %zmm31
+      vpdpbusd $(rhs:0), %zmm31, $(acc:15)
+      vpsubd %zmm29, $(acc:0), $(acc:0)
+      vpsubd %zmm29, $(acc:1), $(acc:1)
+      vpsubd %zmm29, $(acc:2), $(acc:2)
+      vpsubd %zmm29, $(acc:3), $(acc:3)
+      vpsubd %zmm29, $(acc:4), $(acc:4)
+      vpsubd %zmm29, $(acc:5), $(acc:5)
+      vpsubd %zmm29, $(acc:6), $(acc:6)
+      vpsubd %zmm29, $(acc:7), $(acc:7)
+      vpsubd %zmm29, $(acc:8), $(acc:8)
+      vpsubd %zmm29, $(acc:9), $(acc:9)
+      vpsubd %zmm29, $(acc:10), $(acc:10)
+      vpsubd %zmm29, $(acc:11), $(acc:11)
+      vpsubd %zmm29, $(acc:12), $(acc:12)
+      vpsubd %zmm29, $(acc:13), $(acc:13)
+      vpsubd %zmm29, $(acc:14), $(acc:14)
+      vpsubd %zmm29, $(acc:15), $(acc:15)
+    )ASM";
+  kernel.asmClobbers = "eax,zmm28,zmm29,zmm30,zmm31";
+  return kernel;
+}
+
 // Constructs the mlir::Type corresponding to a scalar type.
 Type mlirType(MLIRContext *context, MMTKernel::ScalarType t) {
   switch (t) {
@@ -698,6 +963,21 @@ Type mlirType(MLIRContext *context, MMTKernel::ScalarType t) {
   return Type();
 }
 
+// Returns the bit width of a scalar type.
+int bitWidth(MMTKernel::ScalarType t) {
+  switch (t) {
+    case MMTKernel::ScalarType::None:
+      break;
+    case MMTKernel::ScalarType::I8:
+      return 8;
+    case MMTKernel::ScalarType::I32:
+    case MMTKernel::ScalarType::F32:
+      return 32;
+  }
+  assert(false);
+  return 0;
+}
+
 // This class is a helper for patterns generating custom kernels based on
 // MMTKernel structs.
 class MMTKernelGenerator {
@@ -760,11 +1040,21 @@ class MMTKernelGenerator {
     validate(rhs, kernel.rhsRegs, getRhsRegVectorType());
     validate(acc, kernel.accRegs, getAccRegVectorType());
   }
+  // Returns the width in bits of the widest register used by the kernel.
+  int getMaxRegBitWidth() const {
+    return std::max({kernel.lhsRegSize * bitWidth(kernel.lhsType),
+                     kernel.rhsRegSize * bitWidth(kernel.rhsType),
+                     kernel.accRegSize * bitWidth(kernel.accType)});
+  }
   // Helper for generateAsmCodeAndConstraints
   std::string getConstraintCode() const {
     switch (kernel.arch) {
       case CustomKernelTargetArch::Aarch64:
         return "w";
+      case CustomKernelTargetArch::X86_64:
+        // "x" only allows the 16 registers available without AVX-512, while
+        // "v" allows all 32, which 512-bit kernels rely on.
+        return getMaxRegBitWidth() > 256 ? "v" : "x";
       case CustomKernelTargetArch::None:
         break;
     }
@@ -915,8 +1205,10 @@ class MMTCustomKernelPattern : public OpRewritePattern<vector::ContractionOp> {
   MMTKernel kernel;
 
  public:
-  MMTCustomKernelPattern(MLIRContext *context, MMTKernel kernel)
-      : OpRewritePattern<vector::ContractionOp>(context), kernel(kernel) {}
+  MMTCustomKernelPattern(MLIRContext *context, MMTKernel kernel,
+                         PatternBenefit benefit = 1)
+      : OpRewritePattern<vector::ContractionOp>(context, benefit),
+        kernel(kernel) {}
 
   LogicalResult matchAndRewrite(vector::ContractionOp contractionOp,
                                 PatternRewriter &rewriter) const override {
@@ -1159,38 +1451,78 @@ class VectorContractCustomKernelsPass
   CustomKernelsTargetInfo targetInfo;
 };
 
+// Pattern benefits of the kernels. When kernels for the same shape and data
+// types are available for several feature levels of a target the one using
+// the most powerful SIMD instructions is selected. This only matters when
+// shapes collide; most kernels of different feature levels have different
+// shapes as they are chosen to match the mmt4d tile sizes for that level.
+namespace KernelBenefit {
+// Aarch64.
+static constexpr unsigned kBaseline = 1;
+static constexpr unsigned kDotprod = 2;
+static constexpr unsigned kI8mm = 3;
+// X86_64.
+static constexpr unsigned kAvx2 = 1;
+static constexpr unsigned kAvx512 = 2;
+}  // namespace KernelBenefit
+
 }  // namespace
 
 void populateVectorContractCustomKernelsPatterns(
     const CustomKernelsTargetInfo &targetInfo, RewritePatternSet &patterns) {
   MLIRContext *context = patterns.getContext();
   if (targetInfo.is(CustomKernelTargetArch::Aarch64)) {
-    // TODO: add a "kernel benefit" system whereby if two kernels are available
-    // for the same shape and same data types, the fastest one (ie the one
-    // using the most powerful available SIMD instructions) is selected.
-    // This is incidentally not needed at the moment because currently no two
-    // kernels share the exact same shape and data types.
     patterns.add<MMTCustomKernelPattern>(
-        context, MMTKernel_8x1x8_f32f32f32_Aarch64_Baseline_InlineAsm());
+        context, MMTKernel_8x1x8_f32f32f32_Aarch64_Baseline_InlineAsm(),
+        KernelBenefit::kBaseline);
     patterns.add<MMTCustomKernelPattern>(
-        context, MMTKernel_8x1x1_f32f32f32_Aarch64_Baseline_InlineAsm());
+        context, MMTKernel_8x1x1_f32f32f32_Aarch64_Baseline_InlineAsm(),
+        KernelBenefit::kBaseline);
     patterns.add<MMTCustomKernelPattern>(
-        context, MMTKernel_8x1x8_i8i8i32_Aarch64_Baseline_InlineAsm());
+        context, MMTKernel_8x1x8_i8i8i32_Aarch64_Baseline_InlineAsm(),
+        KernelBenefit::kBaseline);
     patterns.add<MMTCustomKernelPattern>(
-        context, MMTKernel_8x8x1_i8i8i32_Aarch64_Baseline_InlineAsm());
+        context, MMTKernel_8x8x1_i8i8i32_Aarch64_Baseline_InlineAsm(),
+        KernelBenefit::kBaseline);
     if (targetInfo.has(CustomKernelTargetFeature::Aarch64Dotprod)) {
       if (targetInfo.has(CustomKernelTargetFeature::Intrinsics)) {
-        patterns.add<MMT_8x4x8_i8i8i32_Aarch64Dotprod_Intrinsics>(context);
+        patterns.add<MMT_8x4x8_i8i8i32_Aarch64Dotprod_Intrinsics>(
+            context, KernelBenefit::kDotprod);
       } else {
         patterns.add<MMTCustomKernelPattern>(
-            context, MMTKernel_8x4x8_i8i8i32_Aarch64Dotprod_InlineAsm());
+            context, MMTKernel_8x4x8_i8i8i32_Aarch64Dotprod_InlineAsm(),
+            KernelBenefit::kDotprod);
         patterns.add<MMTCustomKernelPattern>(
-            context, MMTKernel_8x4x1_i8i8i32_Aarch64Dotprod_InlineAsm());
+            context, MMTKernel_8x4x1_i8i8i32_Aarch64Dotprod_InlineAsm(),
+            KernelBenefit::kDotprod);
       }
     }
     if (targetInfo.has(CustomKernelTargetFeature::Aarch64I8mm)) {
       patterns.add<MMTCustomKernelPattern>(
-          context, MMTKernel_8x8x8_i8i8i32_Aarch64I8mm_InlineAsm());
+          context, MMTKernel_8x8x8_i8i8i32_Aarch64I8mm_InlineAsm(),
+          KernelBenefit::kI8mm);
+    }
+  }
+  if (targetInfo.is(CustomKernelTargetArch::X86_64)) {
+    if (targetInfo.has(CustomKernelTargetFeature::X86_64Fma)) {
+      patterns.add<MMTCustomKernelPattern>(
+          context, MMTKernel_8x1x8_f32f32f32_X86_64Fma_InlineAsm(),
+          KernelBenefit::kAvx2);
+    }
+    if (targetInfo.has(CustomKernelTargetFeature::X86_64AvxVnni)) {
+      patterns.add<MMTCustomKernelPattern>(
+          context, MMTKernel_8x4x8_i8i8i32_X86_64AvxVnni_InlineAsm(),
+          KernelBenefit::kAvx2);
+    }
+    if (targetInfo.has(CustomKernelTargetFeature::X86_64Avx512f)) {
+      patterns.add<MMTCustomKernelPattern>(
+          context, MMTKernel_16x1x16_f32f32f32_X86_64Avx512f_InlineAsm(),
+          KernelBenefit::kAvx512);
+    }
+    if (targetInfo.has(CustomKernelTargetFeature::X86_64Avx512Vnni)) {
+      patterns.add<MMTCustomKernelPattern>(
+          context, MMTKernel_16x4x16_i8i8i32_X86_64Avx512Vnni_InlineAsm(),
+          KernelBenefit::kAvx512);
     }
   }
 }
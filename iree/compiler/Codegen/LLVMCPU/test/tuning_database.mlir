@@ -0,0 +1,64 @@
+// RUN: rm -f %t && iree-opt -pass-pipeline='hal.executable(hal.executable.variant(iree-llvmcpu-lower-executable-target{test-lowering-configuration=true}))' --iree-codegen-llvm-tuning-report=%t %s -o /dev/null && FileCheck %s --input-file=%t
+// RUN: iree-opt -pass-pipeline='hal.executable(hal.executable.variant(iree-llvmcpu-lower-executable-target{test-lowering-configuration=true}))' --iree-codegen-llvm-tuning-database=%t.missing -verify-diagnostics %s
+// RUN: (echo '{"version": 1, "entries": ['; sed -e 's/tile_sizes = \[\[64, 64, 0\]/tile_sizes = [[32, 32, 0]/' %t; echo ']}') > %t.db
+// RUN: iree-opt -pass-pipeline='hal.executable(hal.executable.variant(iree-llvmcpu-lower-executable-target{test-lowering-configuration=true}))' --iree-codegen-llvm-tuning-database=%t.db %s | FileCheck %s --check-prefix=TUNED
+
+#executable_layout = #hal.executable.layout<push_constants = 0, sets = [
+  #hal.descriptor_set.layout<0, bindings = [
+    #hal.descriptor_set.binding<0, storage_buffer>,
+    #hal.descriptor_set.binding<1, storage_buffer>,
+    #hal.descriptor_set.binding<2, storage_buffer>
+  ]>
+]>
+hal.executable private @matmul_x86  {
+  hal.executable.variant public @embedded_elf_x86_64, target = #hal.executable.target<
+    "llvm",
+    "embedded-elf-x86_64", {
+      data_layout = "e-m:e-p270:32:32-p271:32:32-p272:64:64-i64:64-f80:128-n8:16:32:64-S128",
+      native_vector_size = 16 : index,
+      target_triple = "x86_64-unknown-unknown-eabi-elf"
+    }> {
+    hal.executable.entry_point public @matmul_x86 layout(#executable_layout)
+    builtin.module {
+      // expected-error @+1 {{failed to open tuning database}}
+      func.func @matmul_x86() {
+        %cst = arith.constant 0.0 : f32
+        %lhs_binding = hal.interface.binding.subspan set(0) binding(0) type(storage_buffer) : !flow.dispatch.tensor<readonly:384x512xf32>
+        %rhs_binding = hal.interface.binding.subspan set(0) binding(1) type(storage_buffer) : !flow.dispatch.tensor<readonly:512x128xf32>
+        %result_binding = hal.interface.binding.subspan set(0) binding(2) type(storage_buffer) : !flow.dispatch.tensor<writeonly:384x128xf32>
+        %lhs = flow.dispatch.tensor.load %lhs_binding, offsets = [0, 0], sizes = [384, 512], strides = [1, 1]
+            : !flow.dispatch.tensor<readonly:384x512xf32> -> tensor<384x512xf32>
+        %rhs = flow.dispatch.tensor.load %rhs_binding, offsets = [0, 0], sizes = [512, 128], strides = [1, 1]
+            : !flow.dispatch.tensor<readonly:512x128xf32> -> tensor<512x128xf32>
+        %init = linalg.init_tensor [384, 128] : tensor<384x128xf32>
+        %fill = linalg.fill ins(%cst : f32) outs(%init : tensor<384x128xf32>) -> tensor<384x128xf32>
+        %gemm = linalg.matmul ins(%lhs, %rhs : tensor<384x512xf32>, tensor<512x128xf32>)
+            outs(%fill : tensor<384x128xf32>) -> tensor<384x128xf32>
+        flow.dispatch.tensor.store %gemm, %result_binding, offsets = [0, 0], sizes = [384, 128], strides = [1, 1]
+            : tensor<384x128xf32> -> !flow.dispatch.tensor<writeonly:384x128xf32>
+        return
+      }
+    }
+  }
+}
+
+// The report records the default configuration of the root op along with the
+// key the tuning database uses for the executable.
+//      CHECK: {"compilation_info":"#iree_codegen.compilation_info<
+// CHECK-SAME: "entry_point":"matmul_x86"
+// CHECK-SAME: "iterator_types":["parallel","parallel","reduction"]
+// CHECK-SAME: "key":"{{[0-9a-f]+}}"
+// CHECK-SAME: "loop_ranges":[384,128,512]
+// CHECK-SAME: "pipeline":"CPUDoubleTilingExpert"
+// CHECK-SAME: "root_op":"linalg.matmul"
+// CHECK-SAME: "tile_sizes":{{\[}}[64,64,0],[8,32,0],[0,0,16]]
+// CHECK-SAME: "workgroup_size":[]
+
+// The tuning database built from the report above, with the first level tile
+// sizes changed, overrides the default configuration.
+//  TUNED-DAG: #[[CONFIG:.+]] = #iree_codegen.lowering_config<tile_sizes = {{\[}}[32, 32, 0], [8, 32, 0], [0, 0, 16]]>
+//  TUNED-DAG: #[[TRANSLATION:.+]] = #iree_codegen.translation_info<CPUDoubleTilingExpert>
+//      TUNED: hal.executable.entry_point public @matmul_x86
+// TUNED-SAME:     translation_info = #[[TRANSLATION]]
+//      TUNED: linalg.matmul
+// TUNED-SAME:     lowering_config = #[[CONFIG]]
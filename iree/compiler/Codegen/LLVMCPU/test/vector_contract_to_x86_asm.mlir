@@ -0,0 +1,104 @@
+// RUN: iree-opt -iree-llvmcpu-vector-contract-custom-kernels='arch=x86_64' %s | FileCheck %s -check-prefix=X86_64-BASELINE
+// RUN: iree-opt -iree-llvmcpu-vector-contract-custom-kernels='arch=x86_64 features=+fma,+avxvnni' %s | FileCheck %s -check-prefix=X86_64-AVX2
+// RUN: iree-opt -iree-llvmcpu-vector-contract-custom-kernels='arch=x86_64 features=+avx512vnni' %s | FileCheck %s -check-prefix=X86_64-AVX512
+
+// Test that every case picks up the intended asm kernel, and some basic checks
+// on the inline_asm, in particular checking the generated constraints/clobbers
+// string: 256-bit kernels must only use the "x" constraint (16 registers)
+// while 512-bit kernels use "v" (32 registers).
+
+// -----
+func.func @mmt_8x1x8_f32f32f32(
+    %lhs: vector<8x1xf32>,
+    %rhs: vector<8x1xf32>,
+    %acc: vector<8x8xf32>) -> vector<8x8xf32> {
+  %res = vector.contract {
+      indexing_maps = [
+          affine_map<(d0, d1, d2) -> (d0, d2)>,
+          affine_map<(d0, d1, d2) -> (d1, d2)>,
+          affine_map<(d0, d1, d2) -> (d0, d1)>
+      ], iterator_types = ["parallel", "parallel", "reduction"], kind = #vector.kind<add>
+  } %lhs, %rhs, %acc : vector<8x1xf32>, vector<8x1xf32> into vector<8x8xf32>
+  return %res : vector<8x8xf32>
+}
+// X86_64-BASELINE-LABEL:  @mmt_8x1x8_f32f32f32(
+// X86_64-BASELINE-NOT:     llvm.inline_asm
+// X86_64-BASELINE:         vector.contract
+// X86_64-AVX2-LABEL:  @mmt_8x1x8_f32f32f32(
+// X86_64-AVX2:     llvm.inline_asm
+// X86_64-AVX2-SAME:      {{((.*vfmadd231ps){8})}}
+// X86_64-AVX2-SAME:      "{{(\=x,){8}(x,){2}0,1,.*,7}},~{ymm14},~{ymm15}"
+// X86_64-AVX2-SAME:      {{\((vector<8xf32>(, )?){10}\)}}
+// X86_64-AVX512-LABEL:  @mmt_8x1x8_f32f32f32(
+// X86_64-AVX512:     llvm.inline_asm
+// X86_64-AVX512-SAME:      {{((.*vfmadd231ps){8})}}
+
+// -----
+func.func @mmt_16x1x16_f32f32f32(
+    %lhs: vector<16x1xf32>,
+    %rhs: vector<16x1xf32>,
+    %acc: vector<16x16xf32>) -> vector<16x16xf32> {
+  %res = vector.contract {
+      indexing_maps = [
+          affine_map<(d0, d1, d2) -> (d0, d2)>,
+          affine_map<(d0, d1, d2) -> (d1, d2)>,
+          affine_map<(d0, d1, d2) -> (d0, d1)>
+      ], iterator_types = ["parallel", "parallel", "reduction"], kind = #vector.kind<add>
+  } %lhs, %rhs, %acc : vector<16x1xf32>, vector<16x1xf32> into vector<16x16xf32>
+  return %res : vector<16x16xf32>
+}
+// X86_64-AVX2-LABEL:  @mmt_16x1x16_f32f32f32(
+// X86_64-AVX2-NOT:     llvm.inline_asm
+// X86_64-AVX2:         vector.contract
+// X86_64-AVX512-LABEL:  @mmt_16x1x16_f32f32f32(
+// X86_64-AVX512:     llvm.inline_asm
+// X86_64-AVX512-SAME:      {{((.*vfmadd231ps %zmm){16})}}
+// X86_64-AVX512-SAME:      "{{(\=v,){16}(v,){2}0,1,.*,15}},~{zmm30},~{zmm31}"
+// X86_64-AVX512-SAME:      {{\((vector<16xf32>(, )?){18}\)}}
+
+// -----
+func.func @mmt_8x4x8_i8i8i32(
+    %lhs: vector<8x4xi8>,
+    %rhs: vector<8x4xi8>,
+    %acc: vector<8x8xi32>) -> vector<8x8xi32> {
+  %lhs_wide = arith.extsi %lhs : vector<8x4xi8> to vector<8x4xi32>
+  %rhs_wide = arith.extsi %rhs : vector<8x4xi8> to vector<8x4xi32>
+  %res = vector.contract {
+      indexing_maps = [
+          affine_map<(d0, d1, d2) -> (d0, d2)>,
+          affine_map<(d0, d1, d2) -> (d1, d2)>,
+          affine_map<(d0, d1, d2) -> (d0, d1)>
+      ], iterator_types = ["parallel", "parallel", "reduction"], kind = #vector.kind<add>
+  } %lhs_wide, %rhs_wide, %acc : vector<8x4xi32>, vector<8x4xi32> into vector<8x8xi32>
+  return %res : vector<8x8xi32>
+}
+// X86_64-AVX2-LABEL:  @mmt_8x4x8_i8i8i32(
+// X86_64-AVX2:     llvm.inline_asm
+// X86_64-AVX2-SAME:      {{((.*vpdpbusd){9})}}
+// X86_64-AVX2-SAME:      "{{(\=x,){8}(x,){2}0,1,.*,7}},~{eax},~{ymm12},~{ymm13},~{ymm14},~{ymm15}"
+// X86_64-AVX2-SAME:      {{\((vector<32xi8>, ){2}(vector<8xi32>(, )?){8}\)}}
+
+// -----
+func.func @mmt_16x4x16_i8i8i32(
+    %lhs: vector<16x4xi8>,
+    %rhs: vector<16x4xi8>,
+    %acc: vector<16x16xi32>) -> vector<16x16xi32> {
+  %lhs_wide = arith.extsi %lhs : vector<16x4xi8> to vector<16x4xi32>
+  %rhs_wide = arith.extsi %rhs : vector<16x4xi8> to vector<16x4xi32>
+  %res = vector.contract {
+      indexing_maps = [
+          affine_map<(d0, d1, d2) -> (d0, d2)>,
+          affine_map<(d0, d1, d2) -> (d1, d2)>,
+          affine_map<(d0, d1, d2) -> (d0, d1)>
+      ], iterator_types = ["parallel", "parallel", "reduction"], kind = #vector.kind<add>
+  } %lhs_wide, %rhs_wide, %acc : vector<16x4xi32>, vector<16x4xi32> into vector<16x16xi32>
+  return %res : vector<16x16xi32>
+}
+// X86_64-AVX2-LABEL:  @mmt_16x4x16_i8i8i32(
+// X86_64-AVX2-NOT:     llvm.inline_asm
+// X86_64-AVX2:         vector.contract
+// X86_64-AVX512-LABEL:  @mmt_16x4x16_i8i8i32(
+// X86_64-AVX512:     llvm.inline_asm
+// X86_64-AVX512-SAME:      {{((.*vpdpbusd){17})}}
+// X86_64-AVX512-SAME:      "{{(\=v,){16}(v,){2}0,1,.*,15}},~{eax},~{zmm28},~{zmm29},~{zmm30},~{zmm31}"
+// X86_64-AVX512-SAME:      {{\((vector<64xi8>, ){2}(vector<16xi32>(, )?){16}\)}}
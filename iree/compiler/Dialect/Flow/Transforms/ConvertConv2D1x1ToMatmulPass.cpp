@@ -7,6 +7,7 @@
 #include "iree/compiler/Dialect/Flow/Transforms/PassDetail.h"
 #include "iree/compiler/Dialect/Flow/Transforms/Passes.h"
 #include "mlir/Dialect/Linalg/IR/Linalg.h"
+#include "mlir/Dialect/Tensor/IR/Tensor.h"
 #include "mlir/IR/PatternMatch.h"
 #include "mlir/Pass/Pass.h"
 #include "mlir/Transforms/GreedyPatternRewriteDriver.h"
@@ -18,7 +19,11 @@ namespace Flow {
 
 namespace {
 
-// Converts linalg.conv_2d_input_nhwc_filter_nhwc op to linalg.matmul
+// Converts linalg.conv_2d_nhwc_hwcf op with a 1x1 filter to linalg.matmul. The
+// filter is shared by all the inputs of the batch so the batch is folded into
+// the rows of the matmul along with the spatial dimensions. Dilations have no
+// effect on a 1x1 filter, and strides are applied by taking a strided slice of
+// the input first.
 class Convert1x1ConvolutionMatmulOp
     : public OpRewritePattern<linalg::Conv2DNhwcHwcfOp> {
  public:
@@ -37,39 +42,48 @@ class Convert1x1ConvolutionMatmulOp
     auto filterShape = filterShapeType.getShape();
     auto outputShape = outputShapeType.getShape();
 
-    if (filterShape[0] != 1 || filterShape[1] != 1) return failure();
-
-    // TODO(ataei): Support conversion to linalg.batch_matmul.
-    if (inputShape[0] != 1) return failure();
-
-    if (!llvm::all_of(convOp.strides(), [](APInt element) {
-          return element.getSExtValue() == 1;
-        }))
-      return failure();
-    if (!llvm::all_of(convOp.dilations(), [](APInt element) {
-          return element.getSExtValue() == 1;
-        }))
+    if (!inputShapeType.hasStaticShape() || !filterShapeType.hasStaticShape() ||
+        !outputShapeType.hasStaticShape())
       return failure();
 
+    if (filterShape[0] != 1 || filterShape[1] != 1) return failure();
+
     SmallVector<ReassociationIndices, 4> reassociationIndices = {{0, 1, 2},
                                                                  {3}};
 
-    auto reshapedInputType =
-        RankedTensorType::get({inputShape[1] * inputShape[2], inputShape[3]},
-                              inputShapeType.getElementType());
+    auto reshapedInputType = RankedTensorType::get(
+        {outputShape[0] * outputShape[1] * outputShape[2], inputShape[3]},
+        inputShapeType.getElementType());
 
     auto reshapedFilterType = RankedTensorType::get(
         {filterShape[2], filterShape[3]}, filterShapeType.getElementType());
 
-    auto reshapedOutputType =
-        RankedTensorType::get({outputShape[1] * outputShape[2], outputShape[3]},
-                              outputShapeType.getElementType());
+    auto reshapedOutputType = RankedTensorType::get(
+        {outputShape[0] * outputShape[1] * outputShape[2], outputShape[3]},
+        outputShapeType.getElementType());
 
     Value input = convOp.getInputOperand(0)->get();
     Value filter = convOp.getInputOperand(1)->get();
     Value output = convOp.getOutputOperand(0)->get();
     auto loc = convOp.getLoc();
 
+    // Only every stride-th input pixel contributes to the output.
+    SmallVector<int64_t, 2> strides =
+        llvm::to_vector<2>(convOp.strides().getValues<int64_t>());
+    if (llvm::any_of(strides, [](int64_t stride) { return stride != 1; })) {
+      SmallVector<OpFoldResult> offsets(4, rewriter.getIndexAttr(0));
+      SmallVector<OpFoldResult> sizes = {
+          rewriter.getIndexAttr(outputShape[0]),
+          rewriter.getIndexAttr(outputShape[1]),
+          rewriter.getIndexAttr(outputShape[2]),
+          rewriter.getIndexAttr(inputShape[3])};
+      SmallVector<OpFoldResult> sliceStrides = {
+          rewriter.getIndexAttr(1), rewriter.getIndexAttr(strides[0]),
+          rewriter.getIndexAttr(strides[1]), rewriter.getIndexAttr(1)};
+      input = rewriter.create<tensor::ExtractSliceOp>(loc, input, offsets,
+                                                      sizes, sliceStrides);
+    }
+
     Value reshapedInput = rewriter.create<tensor::CollapseShapeOp>(
         loc, reshapedInputType, input, reassociationIndices);
     Value reshapedFilter = rewriter.create<tensor::CollapseShapeOp>(
@@ -45,7 +45,12 @@ namespace {
 // In general for 2D case with (N, H, W, C) input and (Kh, Kw, C, D) filter
 // and output (N, Ho, Wo, D) the convolutin is the following matrix-matrix multiplication
 // (Ho x Wo, Kh x Kw x C) * (Kh x Kw x C, D) for each input in the N input.
-// For the case where N > 1 its a batched matrxi-matrix multplication.
+// As the filter is shared by all the inputs, for the case where N > 1 the batch
+// is folded into the rows: (N x Ho x Wo, Kh x Kw x C) * (Kh x Kw x C, D).
+// Strides and dilations only change which input element the img2col packing
+// reads: x(n, ho * Sh + kh * Dh, wo * Sw + kw * Dw, c). Padding is expressed by
+// a tensor.pad producing the input, which the packing reads from like any
+// other tensor.
 //
 // clang-format on
 class Conv2DImg2ColMatmulConversion
@@ -63,7 +68,8 @@ class Conv2DImg2ColMatmulConversion
         convOp.getOutputOperand(0)->get().getType().cast<ShapedType>();
 
     if (!filterShapeType || !inputShapeType) return failure();
-    if (!filterShapeType.hasStaticShape() || !inputShapeType.hasStaticShape())
+    if (!filterShapeType.hasStaticShape() || !inputShapeType.hasStaticShape() ||
+        !outputShapeType.hasStaticShape())
       return failure();
 
     Value input = convOp.getInputOperand(0)->get();
@@ -72,15 +78,6 @@ class Conv2DImg2ColMatmulConversion
     auto filterShape = filterShapeType.getShape();
     auto outputShape = outputShapeType.getShape();
 
-    // TODO(ataei): Support for batched version.
-    if (inputShapeType.getShape()[0] > 1) return failure();
-
-    // TODO(ataei) : Support padding & dilation.
-    if (!llvm::all_of(convOp.dilations(), [](APInt element) {
-          return element.getSExtValue() == 1;
-        }))
-      return failure();
-
     auto loc = convOp.getLoc();
 
     // col tensor shape (n, d1, d1, k1, k2, ci)
@@ -100,9 +97,13 @@ class Conv2DImg2ColMatmulConversion
       return rewriter.getAffineConstantExpr(
           convOp.strides().getValues<int64_t>()[i]);
     };
+    auto dil = [&](unsigned i) {
+      return rewriter.getAffineConstantExpr(
+          convOp.dilations().getValues<int64_t>()[i]);
+    };
 
-    SmallVector<AffineExpr, 4> inputExprs = {n, d(1) * s(0) + k(1),
-                                             d(2) * s(1) + k(2), ci};
+    SmallVector<AffineExpr, 4> inputExprs = {n, d(1) * s(0) + k(1) * dil(0),
+                                             d(2) * s(1) + k(2) * dil(1), ci};
 
     auto nloops = colTensorShape.size();
 
@@ -127,7 +128,7 @@ class Conv2DImg2ColMatmulConversion
         {0, 1, 2}, {3}};
 
     auto reshapedImg2ColTensorType = RankedTensorType::get(
-        {outputShape[1] * outputShape[2],
+        {outputShape[0] * outputShape[1] * outputShape[2],
          filterShape[0] * filterShape[1] * filterShape[2]},
         inputShapeType.getElementType());
 
@@ -135,9 +136,9 @@ class Conv2DImg2ColMatmulConversion
         {filterShape[0] * filterShape[1] * filterShape[2], filterShape[3]},
         inputShapeType.getElementType());
 
-    auto reshapedOutputType =
-        RankedTensorType::get({outputShape[1] * outputShape[2], outputShape[3]},
-                              outputShapeType.getElementType());
+    auto reshapedOutputType = RankedTensorType::get(
+        {outputShape[0] * outputShape[1] * outputShape[2], outputShape[3]},
+        outputShapeType.getElementType());
 
     Value reshapedImg2ColTensor = rewriter.create<tensor::CollapseShapeOp>(
         loc, reshapedImg2ColTensorType, img2ColTensor.getResult(0),
@@ -167,7 +168,9 @@ class Conv2DImg2ColMatmulConversion
 // Similar to the conv pattern above except there is no reduction among the
 // input channles so each convolution can be a matrix-vector product and
 // by transposing both input filter so channles are outer most the computation
-// is a batched matrix-vector product.
+// is a batched matrix-vector product. The N inputs share the filter of each
+// channel, so they are folded into the rows of the matrix of each channel:
+// (C, N x Ho x Wo, Kh x Kw) * (C, Kh x Kw).
 class DepthwiseConv2DNHWCHWCImg2ColMatmulConversion
     : public OpRewritePattern<linalg::DepthwiseConv2DNhwcHwcOp> {
  public:
@@ -184,14 +187,10 @@ class DepthwiseConv2DNHWCHWCImg2ColMatmulConversion
                                             .getType()
                                             .dyn_cast<RankedTensorType>();
 
-    if (!filterTensorType || !inputTensorType) return failure();
-    if (!filterTensorType.hasStaticShape() || !inputTensorType.hasStaticShape())
+    if (!filterTensorType || !inputTensorType || !outputTensorType)
       return failure();
-
-    // TODO(ataei) : Support padding & dilation.
-    if (!llvm::all_of(convOp.dilations(), [](APInt element) {
-          return element.getSExtValue() == 1;
-        }))
+    if (!filterTensorType.hasStaticShape() ||
+        !inputTensorType.hasStaticShape() || !outputTensorType.hasStaticShape())
       return failure();
 
     auto loc = convOp.getLoc();
@@ -238,25 +237,26 @@ class DepthwiseConv2DNHWCHWCImg2ColMatmulConversion
     Value output = convOp.getOutputOperand(0)->get();
 
     // Transpose input, filter so channels are outermost
-    auto transposedInput = transposeOperand(input, {0, 3, 1, 2});
+    auto transposedInput = transposeOperand(input, {3, 0, 1, 2});
     auto transposedFilter = transposeOperand(filter, {2, 0, 1});
     auto transposedFilterShape =
         transposedFilter.getType().cast<RankedTensorType>().getShape();
     auto outputShape = output.getType().cast<RankedTensorType>().getShape();
 
-    // Transposed output tensor shape (n, ci, d1, d2)
+    // Transposed output tensor shape (ci, n, d1, d2)
     SmallVector<int64_t, 4> transposedOutputTensorShape = {
-        outputShape[0], transposedFilterShape[0], outputShape[1],
+        transposedFilterShape[0], outputShape[0], outputShape[1],
         outputShape[2]};
 
-    // col tensor shape (n, ci, d1, d2, k1, k2)
+    // col tensor shape (ci, n, d1, d2, k1, k2)
     SmallVector<int64_t, 4> colTensorShape = {
-        outputShape[0], transposedFilterShape[0], outputShape[1],
-        outputShape[2], transposedFilterShape[1], transposedFilterShape[2]};
-    Value transposedOutputTensor = transposeOperand(output, {0, 3, 1, 2});
+        transposedFilterShape[0], outputShape[0],
+        outputShape[1],           outputShape[2],
+        transposedFilterShape[1], transposedFilterShape[2]};
+    Value transposedOutputTensor = transposeOperand(output, {3, 0, 1, 2});
 
-    auto n = rewriter.getAffineDimExpr(0);
-    auto ci = rewriter.getAffineDimExpr(1);
+    auto ci = rewriter.getAffineDimExpr(0);
+    auto n = rewriter.getAffineDimExpr(1);
     auto d = [&](int i) { return rewriter.getAffineDimExpr(i + 1); };
     auto k = [&](int i) { return rewriter.getAffineDimExpr(i + 3); };
 
@@ -264,9 +264,13 @@ class DepthwiseConv2DNHWCHWCImg2ColMatmulConversion
       return rewriter.getAffineConstantExpr(
           convOp.strides().getValues<int64_t>()[i]);
     };
+    auto dil = [&](unsigned i) {
+      return rewriter.getAffineConstantExpr(
+          convOp.dilations().getValues<int64_t>()[i]);
+    };
 
-    SmallVector<AffineExpr> inputExprs = {n, ci, d(1) * s(0) + k(1),
-                                          d(2) * s(1) + k(2)};
+    SmallVector<AffineExpr> inputExprs = {ci, n, d(1) * s(0) + k(1) * dil(0),
+                                          d(2) * s(1) + k(2) * dil(1)};
 
     auto nloops = colTensorShape.size();
 
@@ -288,14 +292,14 @@ class DepthwiseConv2DNHWCHWCImg2ColMatmulConversion
         });
 
     SmallVector<ReassociationIndices> img2ColTensorReassociationIndices = {
-        {0, 1}, {2, 3}, {4, 5}};
+        {0}, {1, 2, 3}, {4, 5}};
     SmallVector<ReassociationIndices> filterReassociationIndice = {{0}, {1, 2}};
-    SmallVector<ReassociationIndices> outputReassociationIndice = {{0, 1},
-                                                                   {2, 3}};
+    SmallVector<ReassociationIndices> outputReassociationIndice = {{0},
+                                                                   {1, 2, 3}};
 
     auto reshapedImg2ColTensorType = RankedTensorType::get(
-        {outputShape[0] * transposedFilterShape[0],
-         outputShape[1] * outputShape[2],
+        {transposedFilterShape[0],
+         outputShape[0] * outputShape[1] * outputShape[2],
          transposedFilterShape[1] * transposedFilterShape[2]},
         inputTensorType.getElementType());
     auto reshapedFilterTensorType = RankedTensorType::get(
@@ -303,8 +307,9 @@ class DepthwiseConv2DNHWCHWCImg2ColMatmulConversion
          transposedFilterShape[1] * transposedFilterShape[2]},
         filterTensorType.getElementType());
     auto reshapedOutputTensorType = RankedTensorType::get(
-        {transposedOutputTensorShape[0] * transposedOutputTensorShape[1],
-         transposedOutputTensorShape[2] * transposedOutputTensorShape[3]},
+        {transposedOutputTensorShape[0],
+         transposedOutputTensorShape[1] * transposedOutputTensorShape[2] *
+             transposedOutputTensorShape[3]},
         outputTensorType.getElementType());
 
     Value reshapedImg2ColTensor = rewriter.create<tensor::CollapseShapeOp>(
@@ -322,15 +327,15 @@ class DepthwiseConv2DNHWCHWCImg2ColMatmulConversion
         ValueRange{reshapedImg2ColTensor, reshapedFilterTensor},
         ValueRange{reshapedoutputTensor});
 
-    SmallVector<ReassociationIndices> batchMatVecReassociationIndice = {{0, 1},
-                                                                        {2, 3}};
+    SmallVector<ReassociationIndices> batchMatVecReassociationIndice = {
+        {0}, {1, 2, 3}};
 
     Value batchMatVecResultReshaped = rewriter.create<tensor::ExpandShapeOp>(
         loc, transposedOutputTensor.getType(), batchMatVecResult.getResult(0),
         batchMatVecReassociationIndice);
 
     auto transposedResult =
-        transposeOperand(batchMatVecResultReshaped, {0, 2, 3, 1});
+        transposeOperand(batchMatVecResultReshaped, {1, 2, 3, 0});
 
     rewriter.replaceOp(convOp, ArrayRef<Value>{transposedResult});
     return success();
@@ -0,0 +1,435 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/compiler/Dialect/Flow/Transforms/PassDetail.h"
+#include "iree/compiler/Dialect/Flow/Transforms/Passes.h"
+#include "iree/compiler/Dialect/HAL/IR/HALOps.h"
+#include "mlir/Dialect/Arithmetic/IR/Arithmetic.h"
+#include "mlir/Dialect/Linalg/IR/Linalg.h"
+#include "mlir/Dialect/Tensor/IR/Tensor.h"
+#include "mlir/Dialect/Tensor/Utils/Utils.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/Matchers.h"
+#include "mlir/Pass/Pass.h"
+#include "mlir/Transforms/GreedyPatternRewriteDriver.h"
+
+namespace mlir {
+namespace iree_compiler {
+namespace IREE {
+namespace Flow {
+
+namespace {
+
+// Transform matrices of the Winograd F(2x2, 3x3) and F(4x4, 3x3) algorithms
+// (Lavin and Gray, "Fast Algorithms for Convolutional Neural Networks"), in
+// row-major order. B^T is (m + 2) x (m + 2), G is (m + 2) x 3 and A^T is
+// m x (m + 2).
+// clang-format off
+static const float kBT2x2[] = {
+    1,  0, -1,  0,
+    0,  1,  1,  0,
+    0, -1,  1,  0,
+    0,  1,  0, -1};
+static const float kG2x2[] = {
+    1.0f,  0.0f, 0.0f,
+    0.5f,  0.5f, 0.5f,
+    0.5f, -0.5f, 0.5f,
+    0.0f,  0.0f, 1.0f};
+static const float kAT2x2[] = {
+    1, 1,  1,  0,
+    0, 1, -1, -1};
+static const float kBT4x4[] = {
+    4,  0, -5,  0, 1, 0,
+    0, -4, -4,  1, 1, 0,
+    0,  4, -4, -1, 1, 0,
+    0, -2, -1,  2, 1, 0,
+    0,  2, -1, -2, 1, 0,
+    0,  4,  0, -5, 0, 1};
+static const float kG4x4[] = {
+     1.0f / 4,   0.0f,        0.0f,
+    -1.0f / 6,  -1.0f / 6,   -1.0f / 6,
+    -1.0f / 6,   1.0f / 6,   -1.0f / 6,
+     1.0f / 24,  1.0f / 12,   1.0f / 6,
+     1.0f / 24, -1.0f / 12,   1.0f / 6,
+     0.0f,       0.0f,        1.0f};
+static const float kAT4x4[] = {
+    1, 1,  1, 1,  1, 0,
+    0, 1, -1, 2, -2, 0,
+    0, 1,  1, 4,  4, 0,
+    0, 1, -1, 8, -8, 1};
+// clang-format on
+
+/// Returns the number of multiply-accumulates of the ops created below to
+/// compute a n x `outputHeight` x `outputWidth` x f convolution of c input
+/// channels with the Winograd F(m x m, 3 x 3) algorithm. The transforms are
+/// dense contractions with the transform matrices, so they are counted as
+/// such: the filter transform, the input transform along the rows and the
+/// columns of the tiles, the batch matmul and the output transform along the
+/// rows and the columns of the tiles.
+static int64_t getWinogradCost(int64_t m, int64_t n, int64_t outputHeight,
+                               int64_t outputWidth, int64_t c, int64_t f) {
+  int64_t alpha = m + 2;
+  int64_t numTiles = n * llvm::divideCeil(outputHeight, m) *
+                     llvm::divideCeil(outputWidth, m);
+  int64_t filterTransformCost = alpha * alpha * c * f * 3 * 3;
+  int64_t inputTransformCost = 2 * numTiles * c * alpha * alpha * alpha;
+  int64_t batchMatmulCost = alpha * alpha * numTiles * c * f;
+  int64_t outputTransformCost =
+      numTiles * f * m * alpha * alpha + numTiles * f * m * m * alpha;
+  return filterTransformCost + inputTransformCost + batchMatmulCost +
+         outputTransformCost;
+}
+
+/// Returns the output tile size m of the Winograd F(m x m, 3 x 3) algorithm
+/// to compute the convolution with, or None if neither F(2x2, 3x3) nor
+/// F(4x4, 3x3) needs fewer multiply-accumulates than the convolution itself.
+/// F(2x2, 3x3) is picked on ties as it is more accurate.
+static Optional<int64_t> getWinogradOutputTileSize(int64_t n,
+                                                   int64_t outputHeight,
+                                                   int64_t outputWidth,
+                                                   int64_t c, int64_t f) {
+  int64_t bestCost = n * outputHeight * outputWidth * c * f * 3 * 3;
+  Optional<int64_t> bestTileSize;
+  for (int64_t m : {2, 4}) {
+    int64_t cost = getWinogradCost(m, n, outputHeight, outputWidth, c, f);
+    if (cost < bestCost) {
+      bestCost = cost;
+      bestTileSize = m;
+    }
+  }
+  return bestTileSize;
+}
+
+static Value createConstantMatrix(OpBuilder &builder, Location loc,
+                                  int64_t rows, int64_t cols,
+                                  ArrayRef<float> values) {
+  auto type = RankedTensorType::get({rows, cols}, builder.getF32Type());
+  return builder.create<arith::ConstantOp>(
+      loc, DenseElementsAttr::get(type, values));
+}
+
+static Value createZeroTensor(OpBuilder &builder, Location loc,
+                              ArrayRef<int64_t> shape, Type elementType) {
+  Value init = builder.create<linalg::InitTensorOp>(loc, shape, elementType);
+  Value zero = builder.create<arith::ConstantOp>(
+      loc, builder.getZeroAttr(elementType));
+  return builder.create<linalg::FillOp>(loc, zero, init).getResult(0);
+}
+
+/// Creates a linalg.generic accumulating the product of `inputs` into `init`.
+/// The last `numReductionLoops` of the loops of `indexingMaps` are reductions.
+static Value createMultiplyAccumulate(OpBuilder &builder, Location loc,
+                                      ValueRange inputs, Value init,
+                                      ArrayRef<AffineMap> indexingMaps,
+                                      unsigned numReductionLoops) {
+  unsigned nloops = indexingMaps.front().getNumDims();
+  SmallVector<StringRef> loopAttributeTypes(nloops - numReductionLoops,
+                                            "parallel");
+  loopAttributeTypes.append(numReductionLoops, "reduction");
+  auto genericOp = builder.create<linalg::GenericOp>(
+      loc, init.getType(), inputs, init, indexingMaps, loopAttributeTypes,
+      [&](OpBuilder &nestedBuilder, Location nestedLoc, ValueRange args) {
+        Value product = args.front();
+        for (Value arg : args.drop_front().drop_back()) {
+          product =
+              nestedBuilder.create<arith::MulFOp>(nestedLoc, product, arg);
+        }
+        Value sum = nestedBuilder.create<arith::AddFOp>(
+            nestedLoc, args.back(), product);
+        nestedBuilder.create<linalg::YieldOp>(nestedLoc, sum);
+      });
+  return genericOp.getResult(0);
+}
+
+// clang-format off
+//
+// Convert linalg.conv_2d_nhwc_hwcf ops with 3x3 filters, unit strides and unit
+// dilations into the Winograd F(m x m, 3 x 3) algorithm, which computes each
+// m x m output tile of each channel pair from an (m + 2) x (m + 2) input tile d
+// and the 3x3 filter g as:
+//   Y = A^T [(G g G^T) .* (B^T d B)] A
+// The elementwise products are summed over the input channels, so with the
+// alpha = m + 2 tile positions as batch dimension the convolution becomes:
+//   U = G g G^T (filter transform)      : (alpha^2, C, F)
+//   V = B^T d B (input transform)       : (alpha^2, N x tilesH x tilesW, C)
+//   M = batch_matmul(V, U)              : (alpha^2, N x tilesH x tilesW, F)
+//   Y = A^T M A (output transform)      : (N, tilesH x m, tilesW x m, F)
+// F(2x2, 3x3) and F(4x4, 3x3) need 2.25x and 4x fewer multiplications than
+// the direct convolution. The filter transform only depends on the filter, so
+// it is folded into a constant by ConstEval for constant weights.
+//
+// The input is padded with zeros so that the tiles cover it and the output is
+// sliced out of the transformed tiles. The transforms are linalg.generic ops
+// multiplying by the constant transform matrices, applied one dimension at a
+// time; the input tiles are gathered by the indexing map of the first one.
+//
+// clang-format on
+class Conv2DWinogradConversion
+    : public OpRewritePattern<linalg::Conv2DNhwcHwcfOp> {
+ public:
+  using OpRewritePattern<linalg::Conv2DNhwcHwcfOp>::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(linalg::Conv2DNhwcHwcfOp convOp,
+                                PatternRewriter &rewriter) const override {
+    Value input = convOp.getInputOperand(0)->get();
+    Value filter = convOp.getInputOperand(1)->get();
+    Value output = convOp.getOutputOperand(0)->get();
+    auto inputType = input.getType().dyn_cast<RankedTensorType>();
+    auto filterType = filter.getType().dyn_cast<RankedTensorType>();
+    auto outputType = output.getType().dyn_cast<RankedTensorType>();
+    if (!inputType || !filterType || !outputType) return failure();
+    if (!inputType.hasStaticShape() || !filterType.hasStaticShape() ||
+        !outputType.hasStaticShape()) {
+      return failure();
+    }
+    // The transform matrices are only exact enough for f32.
+    Type elementType = outputType.getElementType();
+    if (!elementType.isF32() || inputType.getElementType() != elementType ||
+        filterType.getElementType() != elementType) {
+      return failure();
+    }
+    if (!llvm::all_of(convOp.strides().getValues<int64_t>(),
+                      [](int64_t stride) { return stride == 1; }) ||
+        !llvm::all_of(convOp.dilations().getValues<int64_t>(),
+                      [](int64_t dilation) { return dilation == 1; })) {
+      return failure();
+    }
+
+    auto inputShape = inputType.getShape();
+    auto filterShape = filterType.getShape();
+    auto outputShape = outputType.getShape();
+    if (filterShape[0] != 3 || filterShape[1] != 3) return failure();
+
+    int64_t n = outputShape[0];
+    int64_t c = filterShape[2];
+    int64_t f = filterShape[3];
+    Optional<int64_t> tileSize =
+        getWinogradOutputTileSize(n, outputShape[1], outputShape[2], c, f);
+    if (!tileSize) return failure();
+    int64_t m = *tileSize;
+    int64_t alpha = m + 2;
+    int64_t tilesH = llvm::divideCeil(outputShape[1], m);
+    int64_t tilesW = llvm::divideCeil(outputShape[2], m);
+    int64_t numTiles = n * tilesH * tilesW;
+
+    auto loc = convOp.getLoc();
+    MLIRContext *context = rewriter.getContext();
+    auto d = [&](unsigned i) { return rewriter.getAffineDimExpr(i); };
+    auto getMap = [&](unsigned nloops, ArrayRef<AffineExpr> exprs) {
+      return AffineMap::get(nloops, 0, exprs, context);
+    };
+    auto getIdentityMap = [&](unsigned nloops) {
+      return AffineMap::getMultiDimIdentityMap(nloops, context);
+    };
+
+    Value bt = createConstantMatrix(rewriter, loc, alpha, alpha,
+                                    m == 2 ? makeArrayRef(kBT2x2)
+                                           : makeArrayRef(kBT4x4));
+    Value g = createConstantMatrix(
+        rewriter, loc, alpha, 3,
+        m == 2 ? makeArrayRef(kG2x2) : makeArrayRef(kG4x4));
+    Value at = createConstantMatrix(rewriter, loc, m, alpha,
+                                    m == 2 ? makeArrayRef(kAT2x2)
+                                           : makeArrayRef(kAT4x4));
+
+    // Filter transform:
+    //   U(x, y, c, f) = sum_{i, j} G(x, i) g(i, j, c, f) G(y, j)
+    // with loops (x, y, c, f, i, j).
+    Value transformedFilter = createMultiplyAccumulate(
+        rewriter, loc, ValueRange{g, filter, g},
+        createZeroTensor(rewriter, loc, {alpha, alpha, c, f}, elementType),
+        {getMap(6, {d(0), d(4)}), getMap(6, {d(4), d(5), d(2), d(3)}),
+         getMap(6, {d(1), d(5)}), getIdentityMap(6)},
+        /*numReductionLoops=*/2);
+
+    // Drop the rows and columns of the input that no output element reads,
+    // then pad it with zeros so that the input tiles cover it.
+    int64_t usedHeight = outputShape[1] + 2;
+    int64_t usedWidth = outputShape[2] + 2;
+    if (inputShape[1] != usedHeight || inputShape[2] != usedWidth) {
+      SmallVector<OpFoldResult> offsets(4, rewriter.getIndexAttr(0));
+      SmallVector<OpFoldResult> sizes = {
+          rewriter.getIndexAttr(n), rewriter.getIndexAttr(usedHeight),
+          rewriter.getIndexAttr(usedWidth), rewriter.getIndexAttr(c)};
+      SmallVector<OpFoldResult> strides(4, rewriter.getIndexAttr(1));
+      input = rewriter.create<tensor::ExtractSliceOp>(loc, input, offsets,
+                                                      sizes, strides);
+    }
+    int64_t paddedHeight = tilesH * m + 2;
+    int64_t paddedWidth = tilesW * m + 2;
+    if (paddedHeight != usedHeight || paddedWidth != usedWidth) {
+      auto paddedInputType =
+          RankedTensorType::get({n, paddedHeight, paddedWidth, c}, elementType);
+      Value zero = rewriter.create<arith::ConstantOp>(
+          loc, rewriter.getZeroAttr(elementType));
+      SmallVector<OpFoldResult> lowPadding(4, rewriter.getIndexAttr(0));
+      SmallVector<OpFoldResult> highPadding = {
+          rewriter.getIndexAttr(0),
+          rewriter.getIndexAttr(paddedHeight - usedHeight),
+          rewriter.getIndexAttr(paddedWidth - usedWidth),
+          rewriter.getIndexAttr(0)};
+      input = tensor::createPadScalarOp(paddedInputType, input, zero,
+                                        lowPadding, highPadding,
+                                        /*nofold=*/false, loc, rewriter);
+    }
+
+    // Input transform, first along the rows of the tiles:
+    //   T(x, n, th, tw, j, c) = sum_i B^T(x, i) d(n, th * m + i, tw * m + j, c)
+    // with loops (x, n, th, tw, j, c, i), then along their columns:
+    //   V(x, y, n, th, tw, c) = sum_j T(x, n, th, tw, j, c) B^T(y, j)
+    // with loops (x, y, n, th, tw, c, j).
+    Value inputRowsTransform = createMultiplyAccumulate(
+        rewriter, loc, ValueRange{bt, input},
+        createZeroTensor(rewriter, loc, {alpha, n, tilesH, tilesW, alpha, c},
+                         elementType),
+        {getMap(7, {d(0), d(6)}),
+         getMap(7, {d(1), d(2) * m + d(6), d(3) * m + d(4), d(5)}),
+         getIdentityMap(7).getMajorSubMap(6)},
+        /*numReductionLoops=*/1);
+    Value transformedInput = createMultiplyAccumulate(
+        rewriter, loc, ValueRange{inputRowsTransform, bt},
+        createZeroTensor(rewriter, loc, {alpha, alpha, n, tilesH, tilesW, c},
+                         elementType),
+        {getMap(7, {d(0), d(2), d(3), d(4), d(6), d(5)}),
+         getMap(7, {d(1), d(6)}), getIdentityMap(7).getMajorSubMap(6)},
+        /*numReductionLoops=*/1);
+
+    // Batched matmul of the transformed tiles and filters over the alpha^2 tile
+    // positions.
+    SmallVector<ReassociationIndices> tilesReassociationIndices = {
+        {0, 1}, {2, 3, 4}, {5}};
+    Value reshapedInput = rewriter.create<tensor::CollapseShapeOp>(
+        loc, RankedTensorType::get({alpha * alpha, numTiles, c}, elementType),
+        transformedInput, tilesReassociationIndices);
+    Value reshapedFilter = rewriter.create<tensor::CollapseShapeOp>(
+        loc, RankedTensorType::get({alpha * alpha, c, f}, elementType),
+        transformedFilter, SmallVector<ReassociationIndices>{{0, 1}, {2}, {3}});
+    Value batchMatmulInit = createZeroTensor(
+        rewriter, loc, {alpha * alpha, numTiles, f}, elementType);
+    auto batchMatmulOp = rewriter.create<linalg::BatchMatmulOp>(
+        loc, TypeRange{batchMatmulInit.getType()},
+        ValueRange{reshapedInput, reshapedFilter}, ValueRange{batchMatmulInit});
+    Value product = rewriter.create<tensor::ExpandShapeOp>(
+        loc,
+        RankedTensorType::get({alpha, alpha, n, tilesH, tilesW, f},
+                              elementType),
+        batchMatmulOp.getResult(0), tilesReassociationIndices);
+
+    // The output transform accumulates into the output of the convolution,
+    // padded to whole tiles and split into them. Zero filled outputs are
+    // recreated with the tiled shape instead.
+    SmallVector<int64_t> tiledOutputShape = {n, tilesH, m, tilesW, m, f};
+    SmallVector<ReassociationIndices> outputReassociationIndices = {
+        {0}, {1, 2}, {3, 4}, {5}};
+    auto paddedOutputType = RankedTensorType::get(
+        {n, tilesH * m, tilesW * m, f}, elementType);
+    bool isPaddedOutput = paddedOutputType != outputType;
+    Value outputTransformInit;
+    auto fillOp = output.getDefiningOp<linalg::FillOp>();
+    if (fillOp && matchPattern(fillOp.value(), m_AnyZeroFloat())) {
+      outputTransformInit =
+          createZeroTensor(rewriter, loc, tiledOutputShape, elementType);
+    } else {
+      Value paddedOutput = output;
+      if (isPaddedOutput) {
+        Value zero = rewriter.create<arith::ConstantOp>(
+            loc, rewriter.getZeroAttr(elementType));
+        SmallVector<OpFoldResult> lowPadding(4, rewriter.getIndexAttr(0));
+        SmallVector<OpFoldResult> highPadding = {
+            rewriter.getIndexAttr(0),
+            rewriter.getIndexAttr(tilesH * m - outputShape[1]),
+            rewriter.getIndexAttr(tilesW * m - outputShape[2]),
+            rewriter.getIndexAttr(0)};
+        paddedOutput = tensor::createPadScalarOp(
+            paddedOutputType, output, zero, lowPadding, highPadding,
+            /*nofold=*/false, loc, rewriter);
+      }
+      outputTransformInit = rewriter.create<tensor::ExpandShapeOp>(
+          loc, RankedTensorType::get(tiledOutputShape, elementType),
+          paddedOutput, outputReassociationIndices);
+    }
+
+    // Output transform, first along the rows of the tiles:
+    //   S(a, y, n, th, tw, f) = sum_x A^T(a, x) M(x, y, n, th, tw, f)
+    // with loops (a, y, n, th, tw, f, x), then along their columns:
+    //   Y(n, th, a, tw, b, f) += sum_y S(a, y, n, th, tw, f) A^T(b, y)
+    // with loops (n, th, a, tw, b, f, y).
+    Value outputRowsTransform = createMultiplyAccumulate(
+        rewriter, loc, ValueRange{at, product},
+        createZeroTensor(rewriter, loc, {m, alpha, n, tilesH, tilesW, f},
+                         elementType),
+        {getMap(7, {d(0), d(6)}),
+         getMap(7, {d(6), d(1), d(2), d(3), d(4), d(5)}),
+         getIdentityMap(7).getMajorSubMap(6)},
+        /*numReductionLoops=*/1);
+    Value tiledResult = createMultiplyAccumulate(
+        rewriter, loc, ValueRange{outputRowsTransform, at}, outputTransformInit,
+        {getMap(7, {d(2), d(6), d(0), d(1), d(3), d(5)}),
+         getMap(7, {d(4), d(6)}), getIdentityMap(7).getMajorSubMap(6)},
+        /*numReductionLoops=*/1);
+
+    Value result = rewriter.create<tensor::CollapseShapeOp>(
+        loc, paddedOutputType, tiledResult, outputReassociationIndices);
+    if (isPaddedOutput) {
+      SmallVector<OpFoldResult> offsets(4, rewriter.getIndexAttr(0));
+      SmallVector<OpFoldResult> sizes = llvm::to_vector(
+          llvm::map_range(outputShape, [&](int64_t size) -> OpFoldResult {
+            return rewriter.getIndexAttr(size);
+          }));
+      SmallVector<OpFoldResult> strides(4, rewriter.getIndexAttr(1));
+      result = rewriter.create<tensor::ExtractSliceOp>(loc, result, offsets,
+                                                       sizes, strides);
+    }
+
+    rewriter.replaceOp(convOp, ArrayRef<Value>{result});
+    return success();
+  }
+};
+
+/// Returns true if dispatches may only be compiled for CPU targets. Winograd
+/// trades multiplications for additions and transform memory traffic, which
+/// pays off on CPUs but is left to the convolution pipelines of the other
+/// backends. Without hal.device.targets there is nothing to check against and
+/// `assumeCPUTargets` is returned.
+static bool isCPUOnlyTarget(Operation *op, bool assumeCPUTargets) {
+  auto deviceTargetAttrs = IREE::HAL::DeviceTargetAttr::lookup(op);
+  if (deviceTargetAttrs.empty()) return assumeCPUTargets;
+  for (auto deviceTargetAttr : deviceTargetAttrs) {
+    for (auto executableTargetAttr : deviceTargetAttr.getExecutableTargets()) {
+      if (executableTargetAttr.getBackend().getValue() != "llvm") return false;
+    }
+  }
+  return true;
+}
+
+struct ConvertConv2DToWinogradPass
+    : ConvertConv2DToWinogradBase<ConvertConv2DToWinogradPass> {
+  void getDependentDialects(DialectRegistry &registry) const override {
+    registry.insert<arith::ArithmeticDialect, linalg::LinalgDialect,
+                    tensor::TensorDialect>();
+  }
+  void runOnOperation() override {
+    if (!isCPUOnlyTarget(getOperation(), assumeCPUTargets)) return;
+    MLIRContext *context = &getContext();
+    RewritePatternSet patterns(&getContext());
+    patterns.insert<Conv2DWinogradConversion>(context);
+    if (failed(applyPatternsAndFoldGreedily(getOperation(),
+                                            std::move(patterns)))) {
+      return signalPassFailure();
+    }
+  }
+};
+
+}  // namespace
+
+std::unique_ptr<Pass> createConvertConv2DToWinogradPass() {
+  return std::make_unique<ConvertConv2DToWinogradPass>();
+}
+
+}  // namespace Flow
+}  // namespace IREE
+}  // namespace iree_compiler
+}  // namespace mlir
@@ -8,6 +8,7 @@
 
 #include "iree/compiler/Dialect/Flow/Transforms/PassDetail.h"
 #include "iree/compiler/Dialect/Flow/Transforms/Passes.h"
+#include "iree/compiler/Dialect/HAL/Utils/InferCustomKernelsTargetInfoFromParent.h"
 #include "iree/compiler/Utils/CustomKernelsTargetInfo.h"
 #include "llvm/ADT/Optional.h"
 #include "mlir/Dialect/Linalg/IR/Linalg.h"
@@ -364,6 +365,27 @@ LinalgMatmulOpToLinalgMmt4DOpPattern::chooseTileParams(Value lhs, Value rhs,
                                   "f32*f32->f32, aarch64");
     }
   }
+  if (targetInfo.is(CustomKernelTargetArch::X86_64)) {
+    if (lhsElemType.isSignlessInteger(8) && rhsElemType.isSignlessInteger(8) &&
+        accElemType.isSignlessInteger(32)) {
+      if (targetInfo.has(CustomKernelTargetFeature::X86_64Avx512Vnni)) {
+        return chooseMatMulOrMatVec({16, 4, 16}, {16, 4, 1},
+                                    "i8*i8->i32, x86_64 +avx512vnni");
+      } else if (targetInfo.has(CustomKernelTargetFeature::X86_64AvxVnni)) {
+        return chooseMatMulOrMatVec({8, 4, 8}, {8, 4, 1},
+                                    "i8*i8->i32, x86_64 +avxvnni");
+      }
+    }
+    if (lhsElemType.isF32() && rhsElemType.isF32() && accElemType.isF32()) {
+      if (targetInfo.has(CustomKernelTargetFeature::X86_64Avx512f)) {
+        return chooseMatMulOrMatVec({16, 1, 16}, {16, 1, 1},
+                                    "f32*f32->f32, x86_64 +avx512f");
+      } else if (targetInfo.has(CustomKernelTargetFeature::X86_64Fma)) {
+        return chooseMatMulOrMatVec({8, 1, 8}, {8, 1, 1},
+                                    "f32*f32->f32, x86_64 +fma");
+      }
+    }
+  }
   // enableGenericSlow is meant for tests only. It's just a way to get some
   // test coverage for Mmt4d where we do not currently have kernels.
   if (enableGenericSlow) {
@@ -398,21 +420,16 @@ struct FoldFillGenericOpPattern : public OpRewritePattern<linalg::GenericOp> {
 
     auto input = genericOp.inputs()[0];
 
-    auto outputType =
-        genericOp.outputs()[0].getType().dyn_cast<RankedTensorType>();
-
-    // TODO: To enable dynamic shapes we need to apply the same permutation on
-    // init tensor sizes.
-    if (!outputType || !outputType.hasStaticShape()) return failure();
-
-    auto fillOp = dyn_cast<linalg::FillOp>(input.getDefiningOp());
+    auto fillOp = input.getDefiningOp<linalg::FillOp>();
     if (!fillOp) return failure();
 
-    auto loc = genericOp.getLoc();
-    Value newInitTensor = rewriter.create<linalg::InitTensorOp>(
-        loc, outputType.getShape(), outputType.getElementType());
+    // The output of the copy already has the (possibly dynamic, transposed)
+    // shape we want, so it can directly be the destination of the fill. Its
+    // contents are overwritten by the copy so they don't matter.
+    Value output = genericOp.outputs()[0];
+    if (!output.getDefiningOp<linalg::InitTensorOp>()) return failure();
     rewriter.replaceOpWithNewOp<linalg::FillOp>(genericOp, fillOp.value(),
-                                                newInitTensor);
+                                                output);
 
     return success();
   }
@@ -435,11 +452,18 @@ class ConvertLinalgMatmulToMmt4DPass final
 
   void runOnOperation() override {
     MLIRContext *context = &getContext();
+    // When no target was explicitly given, choose tile sizes for the CPU
+    // targets the module is being compiled for, if known.
+    CustomKernelsTargetInfo effectiveTargetInfo = targetInfo;
+    if (targetInfo == CustomKernelsTargetInfo()) {
+      (void)InferCustomKernelsTargetInfoFromDeviceTargets(getOperation(),
+                                                          effectiveTargetInfo);
+    }
     // Main pattern.
     {
       RewritePatternSet patterns(&getContext());
-      patterns.insert<LinalgMatmulOpToLinalgMmt4DOpPattern>(context, targetInfo,
-                                                            enableGenericSlow);
+      patterns.insert<LinalgMatmulOpToLinalgMmt4DOpPattern>(
+          context, effectiveTargetInfo, enableGenericSlow);
       if (failed(applyPatternsAndFoldGreedily(getOperation(),
                                               std::move(patterns)))) {
         return signalPassFailure();
@@ -887,6 +887,25 @@ static bool isFusableWithConsumer(OpOperand &use) {
   return areFusableLinalgOps(use);
 }
 
+/// Returns the consumer of `op` that it can be fused with, or nullptr if there
+/// is none. All uses of the result of `op` must be in the same consumer, which
+/// may use it more than once (e.g. `x * sigmoid(x)` after elementwise fusion)
+/// as long as every use is fusable. `tensor.dim` users are ignored since they
+/// are resolved to the shapes of the operands of `op` once the dispatch region
+/// is formed.
+static Operation *getFusableConsumer(Operation *op) {
+  if (op->getNumResults() != 1) return nullptr;
+  Operation *consumer = nullptr;
+  for (OpOperand &use : op->getResult(0).getUses()) {
+    Operation *user = use.getOwner();
+    if (isa<tensor::DimOp>(user)) continue;
+    if (consumer && consumer != user) return nullptr;
+    if (!isFusableWithConsumer(use)) return nullptr;
+    consumer = user;
+  }
+  return consumer;
+}
+
 /// Fuses roots with its consumers. If a root is fused with its consumer, it is
 /// no more tagged as a root to aid with the dispatch region formation.
 static void fuseRootsWithConsumers(MLIRContext *context,
@@ -897,7 +916,6 @@ static void fuseRootsWithConsumers(MLIRContext *context,
     Operation *currRoot = workList.pop_back_val();
     assert(hasRootOpAttribute(currRoot) &&
            "unexpected non-root op in worklist");
-    if (!currRoot->hasOneUse()) continue;
 
     // Helper function to make the consumer the root instead of the producer
     // when they are to be fused.
@@ -908,17 +926,14 @@ static void fuseRootsWithConsumers(MLIRContext *context,
       appendToFusionGroup(currRoot, rootNumber);
     };
 
-    // Analyse the use to see if it is fusable.
-    OpOperand &use = *currRoot->use_begin();
-    Operation *user = use.getOwner();
-    if (hasRootOpAttribute(user) || hasFusionGroupsAttribute(user)) {
+    // Analyse the uses to see if they are fusable.
+    Operation *user = getFusableConsumer(currRoot);
+    if (!user || hasRootOpAttribute(user) || hasFusionGroupsAttribute(user)) {
       continue;
     }
 
-    if (isFusableWithConsumer(use)) {
-      updateRootTo(user);
-      workList.push_back(user);
-    }
+    updateRootTo(user);
+    workList.push_back(user);
   }
 }
 
@@ -959,11 +974,14 @@ static unsigned decideFusableLinalgOps(FunctionOpInterface funcOp) {
         auto producer = operand->get().getDefiningOp<linalg::LinalgOp>();
         if (!producer) continue;
 
-        // For now only fuse producers that have a single use.
-        // TODO(ravishankarm): Producer can be fused if all users are dominated
-        // by the consumer. But that requires changing the dispatch region
-        // formation in this pass. Do that as a follow up.
-        if (!producer->hasOneUse()) continue;
+        // Fuse producers that have a single use. `linalg.fill` ops are cheap
+        // to recompute, so they are duplicated into every dispatch region that
+        // uses them as an output instead of being read back from memory; uses
+        // left outside of dispatch regions are converted to splats.
+        // TODO(ravishankarm): Other producers can be fused if all users are
+        // dominated by the consumer. But that requires changing the dispatch
+        // region formation in this pass. Do that as a follow up.
+        if (!producer->hasOneUse() && !isa<linalg::FillOp>(producer)) continue;
 
         if (producer.getNumLoops() != producer.getNumParallelLoops()) continue;
         appendToFusionGroup(producer, newGroup);
@@ -14,12 +14,20 @@
 
 #include "iree/compiler/Dialect/Flow/Transforms/PassDetail.h"
 #include "iree/compiler/Dialect/Flow/Transforms/Passes.h"
+#include "llvm/Support/CommandLine.h"
 #include "mlir/Dialect/Affine/IR/AffineOps.h"
 #include "mlir/Dialect/Linalg/IR/Linalg.h"
 #include "mlir/Dialect/Linalg/Transforms/Transforms.h"
 #include "mlir/Dialect/MemRef/Transforms/Passes.h"
 #include "mlir/Transforms/GreedyPatternRewriteDriver.h"
 
+static llvm::cl::opt<int> clMaxDuplicatedElementwiseOps(
+    "iree-flow-fusion-max-duplicated-elementwise-ops",
+    llvm::cl::desc("Maximum number of arith operations in the body of an "
+                   "elementwise op with multiple uses for it to be duplicated "
+                   "into each of its consumers; 0 disables duplication"),
+    llvm::cl::init(4));
+
 namespace mlir {
 namespace iree_compiler {
 namespace IREE {
@@ -29,6 +37,34 @@ namespace {
 
 using linalg::LinalgOp;
 
+/// Returns true if `producer` is an elementwise operation that is cheap enough
+/// to be recomputed in each of its consumers instead of having its result
+/// materialized in memory. The producer must not read the result of a
+/// contraction or a reduction: duplicating it would leave that op with
+/// multiple uses and stop its epilogue from being fused into its dispatch
+/// region.
+static bool isCheapToDuplicate(Operation *producer) {
+  if (clMaxDuplicatedElementwiseOps <= 0) return false;
+  auto genericOp = dyn_cast<linalg::GenericOp>(producer);
+  if (!genericOp || genericOp.getNumParallelLoops() != genericOp.getNumLoops())
+    return false;
+  for (OpOperand *opOperand : genericOp.getInputOperands()) {
+    auto inputProducer = opOperand->get().getDefiningOp<LinalgOp>();
+    if (inputProducer &&
+        (inputProducer.getNumReductionLoops() != 0 ||
+         !isa<linalg::GenericOp, linalg::FillOp>(inputProducer.getOperation())))
+      return false;
+  }
+  // Only count arith ops as cheap; everything else (e.g. math ops) is assumed
+  // expensive enough to be worth materializing.
+  int64_t numOps = 0;
+  for (Operation &op : genericOp.getBody()->without_terminator()) {
+    if (!isa<arith::ArithmeticDialect>(op.getDialect())) return false;
+    if (++numOps > clMaxDuplicatedElementwiseOps) return false;
+  }
+  return true;
+}
+
 /// Pass to fuse linalg on tensor operations as well as fusion of hal.interface*
 /// operations with linalg.tensor_reshape operation.
 struct FusionOfTensorOpsPass
@@ -81,10 +117,8 @@ struct FusionOfTensorOpsPass
               }
             }
           }
-          // Only fuse if it has a single linalg generic user. It is a
-          // simplistic heuristic to avoid duplicating ops that may be
-          // expensive.
-          // TODO: Add a cost model to allow ops to be duplicated.
+          // Only fuse if it has a single linalg generic user, unless the
+          // producer is cheap enough to be duplicated into each of its users.
           bool hasI1ReturnType =
               llvm::any_of(producer->getResultTypes(), [](Type t) {
                 if (t.isInteger(1)) return true;
@@ -95,7 +129,8 @@ struct FusionOfTensorOpsPass
               });
           if (!isBroadcast && !isa<arith::ConstantOp>(producer) &&
               !hasI1ReturnType &&
-              !llvm::hasSingleElement(producerResult.getUsers())) {
+              !llvm::hasSingleElement(producerResult.getUsers()) &&
+              !isCheapToDuplicate(producer)) {
             return false;
           }
           return llvm::all_of(producerResult.getUsers(), [](Operation *user) {
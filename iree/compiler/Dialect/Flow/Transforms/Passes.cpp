@@ -43,6 +43,13 @@ static llvm::cl::opt<bool> clEnableConvToImg2Col(
     llvm::cl::desc("Enable converting convolution ops to img2col form."),
     llvm::cl::init(false));
 
+static llvm::cl::opt<bool> clEnableConvToWinograd(
+    "iree-flow-enable-conv-winograd-transform",
+    llvm::cl::desc("Enable converting 3x3 convolution ops to the Winograd "
+                   "algorithm when only compiling for CPU targets and it is "
+                   "estimated to be cheaper than the convolution."),
+    llvm::cl::init(false));
+
 static llvm::cl::opt<bool> clEnablePaddingLinalgOps(
     "iree-flow-enable-padding-linalg-ops",
     llvm::cl::desc("Enable padding linalg ops to an integer multiple of "
@@ -73,6 +80,13 @@ static llvm::cl::opt<std::string> clMmt4dTargetOptions(
                    "given architecture"),
     llvm::cl::init(""));
 
+static llvm::cl::opt<bool> clEnableMmt4dForDeviceTargets(
+    "iree-flow-enable-mmt4d",
+    llvm::cl::desc("Convert linalg.matmul ops to MMT4D ops with tile sizes "
+                   "chosen for the CPU targets in hal.device.targets. Ignored "
+                   "if -iree-flow-mmt4d-target-options is specified"),
+    llvm::cl::init(false));
+
 namespace mlir {
 namespace iree_compiler {
 namespace IREE {
@@ -129,13 +143,15 @@ void buildFlowTransformPassPipeline(OpPassManager &passManager,
   // Special case peephole optimizations.
   FunctionLikeNest(passManager)
       .addPass(IREE::Flow::createConvertConv2D1x1ToMatmulPass)
+      .addPredicatedPass(clEnableConvToWinograd,
+                         IREE::Flow::createConvertConv2DToWinogradPass)
       .addPredicatedPass(clEnableConvToImg2Col,
                          IREE::Flow::createConvertConv2DToImg2ColPass)
       // Input should now be legal.
       .addPass(IREE::Flow::createVerifyInputLegalityPass)
       // Catch matmul ops before we do anything else with them.
       .addPredicatedPass(
-          !clMmt4dTargetOptions.empty(),
+          !clMmt4dTargetOptions.empty() || clEnableMmt4dForDeviceTargets,
           []() {
             return IREE::Flow::createConvertLinalgMatmulToMmt4DPass(
                 clMmt4dTargetOptions);
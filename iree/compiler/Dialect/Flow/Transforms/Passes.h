@@ -79,6 +79,12 @@ std::unique_ptr<Pass> createConvertConv2D1x1ToMatmulPass();
 // using im2col tranformation.
 std::unique_ptr<Pass> createConvertConv2DToImg2ColPass();
 
+// Creates a pass to convert linalg convolution ops with 3x3 filters into
+// Winograd input/filter/output transforms around a linalg.batch_matmul when
+// only compiling for CPU targets and the transforms are estimated to be
+// cheaper than the convolution.
+std::unique_ptr<Pass> createConvertConv2DToWinogradPass();
+
 // Pass to convert a linalg.pad_tensor operation into a linalg.fill +
 // subtensor_insert. This allows lowering the operation into a single kernel.
 std::unique_ptr<Pass> createPadTensorToSubTensorInsertPass();
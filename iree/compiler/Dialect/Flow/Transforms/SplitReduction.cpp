@@ -12,6 +12,9 @@
 
 #include "iree/compiler/Dialect/Flow/Transforms/PassDetail.h"
 #include "iree/compiler/Dialect/Flow/Transforms/Passes.h"
+#include "iree/compiler/Dialect/HAL/IR/HALOps.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/MathExtras.h"
 #include "mlir/Dialect/Affine/IR/AffineOps.h"
 #include "mlir/Dialect/Linalg/IR/Linalg.h"
 #include "mlir/Dialect/Linalg/Transforms/Transforms.h"
@@ -27,6 +30,86 @@ static llvm::cl::opt<int64_t> splitReductionRatio(
     "iree-flow-split-matmul-reduction", llvm::cl::desc("split ratio"),
     llvm::cl::init(1));
 
+static llvm::cl::opt<int64_t> clSplitReductionMinSize(
+    "iree-flow-split-reduction-min-size",
+    llvm::cl::desc("Minimum static size of the reduction dimension of a "
+                   "linalg.generic reduction for it to be split across "
+                   "workers when it has fewer parallel iterations than there "
+                   "are workers; 0 disables splitting generic reductions"),
+    llvm::cl::init(8192));
+
+static llvm::cl::opt<int64_t> clSplitReductionNumWorkers(
+    "iree-flow-split-reduction-num-workers",
+    llvm::cl::desc("Number of workers generic reductions are split across. "
+                   "If unspecified, the num_cores of the CPU executable "
+                   "targets in hal.device.targets is used, if known"),
+    llvm::cl::init(0));
+
+/// Minimum number of elements reduced by each partial reduction of a split
+/// generic reduction, so that the partial reductions amortize their dispatch
+/// overhead and still vectorize.
+static const int64_t kMinSplitReductionChunkSize = 1024;
+
+/// Returns the number of workers dispatches are distributed across, as given by
+/// the `num_cores` of the executable targets in hal.device.targets. Reductions
+/// are split before executables get specialized per target, so this is only
+/// known if all targets are CPU targets describing their core count; the
+/// smallest one is used. Returns 0 if unknown.
+static int64_t getNumWorkersFromDeviceTargets(Operation *op) {
+  int64_t numWorkers = 0;
+  for (auto deviceTargetAttr : IREE::HAL::DeviceTargetAttr::lookup(op)) {
+    for (auto executableTargetAttr : deviceTargetAttr.getExecutableTargets()) {
+      if (executableTargetAttr.getBackend().getValue() != "llvm") return 0;
+      DictionaryAttr config = executableTargetAttr.getConfiguration();
+      auto numCoresAttr =
+          config ? config.getAs<IntegerAttr>("num_cores") : IntegerAttr();
+      if (!numCoresAttr || numCoresAttr.getInt() <= 0) return 0;
+      int64_t numCores = numCoresAttr.getInt();
+      numWorkers = numWorkers ? std::min(numWorkers, numCores) : numCores;
+    }
+  }
+  return numWorkers;
+}
+
+/// Returns the ratio to split the reduction of the linalg.generic `op` by so
+/// that its partial reductions keep `numWorkers` workers busy, or 0 if it
+/// should not be split. Only static reductions over a single dimension that is
+/// at least `clSplitReductionMinSize` long and that have fewer parallel
+/// iterations than workers are split. The ratio has to divide the reduction
+/// size, and each partial reduction covers at least
+/// `kMinSplitReductionChunkSize` elements.
+static int64_t getGenericReductionSplitRatio(linalg::LinalgOp op,
+                                             int64_t numWorkers) {
+  if (!isa<linalg::GenericOp>(op) || op.getNumReductionLoops() != 1 ||
+      op.getNumOutputs() != 1) {
+    return 0;
+  }
+  Optional<SmallVector<int64_t, 4>> loopRanges = op.getStaticLoopRanges();
+  if (!loopRanges) return 0;
+  int64_t numParallelIterations = 1;
+  int64_t reductionSize = 0;
+  for (auto it : llvm::zip(loopRanges.getValue(), op.iterator_types())) {
+    int64_t range = std::get<0>(it);
+    if (ShapedType::isDynamic(range)) return 0;
+    if (isParallelIterator(std::get<1>(it))) {
+      numParallelIterations *= range;
+    } else {
+      reductionSize = range;
+    }
+  }
+  if (reductionSize < clSplitReductionMinSize ||
+      numParallelIterations >= numWorkers) {
+    return 0;
+  }
+  int64_t maxRatio =
+      std::min(llvm::divideCeil(numWorkers, numParallelIterations),
+               reductionSize / kMinSplitReductionChunkSize);
+  for (int64_t ratio = maxRatio; ratio > 1; --ratio) {
+    if (reductionSize % ratio == 0) return ratio;
+  }
+  return 0;
+}
+
 namespace {
 /// Pattern to wrap splitReduction transformation. This also propagates
 /// attributes to allow compilation info attribute to not be lost.
@@ -75,18 +158,31 @@ struct SplitReductionPass : public SplitReductionBase<SplitReductionPass> {
   }
 
   void runOnOperation() override {
-    if (splitReductionRatio <= 1) return;
+    int64_t numWorkers = clSplitReductionNumWorkers;
+    if (numWorkers <= 0) {
+      numWorkers = getNumWorkersFromDeviceTargets(getOperation());
+    }
+    bool splitGenericReductions = clSplitReductionMinSize > 0 && numWorkers > 1;
+    if (splitReductionRatio <= 1 && !splitGenericReductions) return;
 
     RewritePatternSet patterns(&getContext());
     patterns.add<LinalgSplitReduction>(
         &getContext(),
-        [&](linalg::LinalgOp op) {
+        [&](linalg::LinalgOp op) -> std::pair<int64_t, unsigned> {
           // For matmul make the new parallel dimension first so that it looks
           // like a batch_matmul and can follow the same codegen.
           if (isa<linalg::MatmulOp>(op))
             return std::make_pair(int64_t(splitReductionRatio), 0);
-          // Currently disable spliting reduction for non-matmul op. This will
-          // get enabled after once tests are ready.
+          // Split generic reductions that don't have enough parallel
+          // iterations to keep all workers busy into a parallel partial
+          // reduction and a final combine. The new parallel dimension is
+          // inserted last so that the combine reduces contiguous elements.
+          if (splitGenericReductions) {
+            int64_t ratio = getGenericReductionSplitRatio(op, numWorkers);
+            if (ratio > 1) {
+              return std::make_pair(ratio, op.getRank(op.getOutputOperand(0)));
+            }
+          }
           return std::make_pair(int64_t(0), 0);
         },
         linalg::LinalgTransformationFilter(
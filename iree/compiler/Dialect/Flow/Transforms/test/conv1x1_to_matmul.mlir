@@ -18,3 +18,25 @@ func.func @conv_2d_1x1(%input: tensor<1x4x5x2xf32>, %filter: tensor<1x1x2x7xf32>
 // CHECK: %[[MATMUL_RESULT:.+]] = linalg.matmul ins(%[[RESHAPED_INPUT]], %[[RESHAPED_FILTER]] : tensor<20x2xf32>, tensor<2x7xf32>) outs(%[[RESHAPED_OUTPUT]] : tensor<20x7xf32>)
 // CHECK: %[[RESULT:.+]] = tensor.expand_shape %[[MATMUL_RESULT]] {{\[}}[0, 1, 2], [3]] : tensor<20x7xf32> into tensor<1x4x5x7xf32>
 // CHECK: return %[[RESULT]]
+
+// -----
+
+func.func @batch_conv_2d_1x1_strided(%input: tensor<2x8x8x4xf32>, %filter: tensor<1x1x4x16xf32>) -> tensor<2x4x4x16xf32> {
+    %0 = linalg.init_tensor [2, 4, 4, 16] : tensor<2x4x4x16xf32>
+    %1 = linalg.conv_2d_nhwc_hwcf {
+        dilations = dense<2> : tensor<2xi64>,
+        strides = dense<2> : tensor<2xi64>
+    } ins(%input, %filter : tensor<2x8x8x4xf32>, tensor<1x1x4x16xf32>) outs(%0 : tensor<2x4x4x16xf32>) -> tensor<2x4x4x16xf32>
+    return %1 : tensor<2x4x4x16xf32>
+}
+// CHECK: @batch_conv_2d_1x1_strided
+// CHECK: %[[INPUT:.+]]: tensor<2x8x8x4xf32>
+// CHECK: %[[FILTER:.+]]: tensor<1x1x4x16xf32>
+// CHECK: %[[OUTPUT:.+]] = linalg.init_tensor [2, 4, 4, 16] : tensor<2x4x4x16xf32>
+// CHECK: %[[STRIDED_INPUT:.+]] = tensor.extract_slice %[[INPUT]][0, 0, 0, 0] [2, 4, 4, 4] [1, 2, 2, 1] : tensor<2x8x8x4xf32> to tensor<2x4x4x4xf32>
+// CHECK: %[[RESHAPED_INPUT:.+]] = tensor.collapse_shape %[[STRIDED_INPUT]] {{\[}}[0, 1, 2], [3]] : tensor<2x4x4x4xf32> into tensor<32x4xf32>
+// CHECK: %[[RESHAPED_FILTER:.+]] = tensor.collapse_shape %[[FILTER]] {{\[}}[0, 1, 2], [3]] : tensor<1x1x4x16xf32> into tensor<4x16xf32>
+// CHECK: %[[RESHAPED_OUTPUT:.+]] = tensor.collapse_shape %[[OUTPUT]] {{\[}}[0, 1, 2], [3]] : tensor<2x4x4x16xf32> into tensor<32x16xf32>
+// CHECK: %[[MATMUL_RESULT:.+]] = linalg.matmul ins(%[[RESHAPED_INPUT]], %[[RESHAPED_FILTER]] : tensor<32x4xf32>, tensor<4x16xf32>) outs(%[[RESHAPED_OUTPUT]] : tensor<32x16xf32>)
+// CHECK: %[[RESULT:.+]] = tensor.expand_shape %[[MATMUL_RESULT]] {{\[}}[0, 1, 2], [3]] : tensor<32x16xf32> into tensor<2x4x4x16xf32>
+// CHECK: return %[[RESULT]]
@@ -41,25 +41,25 @@ func.func @depthwise_conv_hwc_114x16x3(%input: tensor<1x114x114x16xf32>, %filter
     return %0 : tensor<1x112x112x16xf32>
 }
 
-// CHECK-DAG: #[[MAP0:.+]] = affine_map<(d0, d1, d2, d3) -> (d0, d2, d3, d1)>
+// CHECK-DAG: #[[MAP0:.+]] = affine_map<(d0, d1, d2, d3) -> (d1, d2, d3, d0)>
 // CHECK-DAG: #[[MAP1:.+]] = affine_map<(d0, d1, d2, d3) -> (d0, d1, d2, d3)>
 // CHECK-DAG: #[[MAP2:.+]] = affine_map<(d0, d1, d2) -> (d1, d2, d0)>
 // CHECK-DAG: #[[MAP3:.+]] = affine_map<(d0, d1, d2) -> (d0, d1, d2)>
 // CHECK-DAG: #[[MAP4:.+]] = affine_map<(d0, d1, d2, d3, d4, d5) -> (d0, d1, d2 + d4, d3 + d5)>
 // CHECK-DAG: #[[MAP5:.+]] = affine_map<(d0, d1, d2, d3, d4, d5) -> (d0, d1, d2, d3, d4, d5)>
-// CHECK-DAG: #[[MAP6:.+]] = affine_map<(d0, d1, d2, d3) -> (d0, d3, d1, d2)>
+// CHECK-DAG: #[[MAP6:.+]] = affine_map<(d0, d1, d2, d3) -> (d3, d0, d1, d2)>
 // CHECK: @depthwise_conv_hwc_114x16x3
 // CHECK-SAME: %[[INPUT:.+]]: tensor<1x114x114x16xf32>
 // CHECK-SAME: %[[FILTER:.+]]: tensor<3x3x16xf32>
 // CHECK-SAME: %[[OUTPUT:.+]]: tensor<1x112x112x16xf32>
-//      CHECK: %[[INPUT_T_INIT:.+]] = linalg.init_tensor [1, 16, 114, 114] : tensor<1x16x114x114xf32>
+//      CHECK: %[[INPUT_T_INIT:.+]] = linalg.init_tensor [16, 1, 114, 114] : tensor<16x1x114x114xf32>
 //      CHECK: %[[INPUT_T:.+]] = linalg.generic
 // CHECK-SAME: indexing_maps = [#[[MAP0]], #[[MAP1]]]
 // CHECK-SAME: iterator_types = ["parallel", "parallel", "parallel", "parallel"]
-// CHECK-SAME: ins(%[[INPUT]] : tensor<1x114x114x16xf32>) outs(%[[INPUT_T_INIT]] : tensor<1x16x114x114xf32>) {
+// CHECK-SAME: ins(%[[INPUT]] : tensor<1x114x114x16xf32>) outs(%[[INPUT_T_INIT]] : tensor<16x1x114x114xf32>) {
 // CHECK-NEXT: ^bb0(%arg3: f32, %arg4: f32):
 // CHECK-NEXT:     linalg.yield %arg3 : f32
-// CHECK-NEXT:  } -> tensor<1x16x114x114xf32>
+// CHECK-NEXT:  } -> tensor<16x1x114x114xf32>
 //      CHECK: %[[FILTER_T_INIT:.+]] = linalg.init_tensor [16, 3, 3] : tensor<16x3x3xf32>
 //      CHECK: %[[FILTER_T:.+]] = linalg.generic
 // CHECK-SAME: indexing_maps = [#[[MAP2]], #[[MAP3]]
@@ -68,37 +68,117 @@ func.func @depthwise_conv_hwc_114x16x3(%input: tensor<1x114x114x16xf32>, %filter
 // CHECK-NEXT:      ^bb0(%{{.*}}: f32, %{{.*}}: f32):
 //      CHECK:      linalg.yield
 //      CHECK:    } -> tensor<16x3x3xf32>
-//      CHECK: %[[INIT_OUTPUT_TENSOR:.+]] = linalg.init_tensor [1, 16, 112, 112] : tensor<1x16x112x112xf32>
+//      CHECK: %[[INIT_OUTPUT_TENSOR:.+]] = linalg.init_tensor [16, 1, 112, 112] : tensor<16x1x112x112xf32>
 //      CHECK: %[[OUTPUT_T:.+]] = linalg.generic
 // CHECK-SAME: indexing_maps = [#[[MAP0]], #[[MAP1]]]
 // CHECK-SAME: iterator_types = ["parallel", "parallel", "parallel", "parallel"]
-// CHECK-SAME: ins(%[[OUTPUT]] : tensor<1x112x112x16xf32>) outs(%[[INIT_OUTPUT_TENSOR]] : tensor<1x16x112x112xf32>) {
+// CHECK-SAME: ins(%[[OUTPUT]] : tensor<1x112x112x16xf32>) outs(%[[INIT_OUTPUT_TENSOR]] : tensor<16x1x112x112xf32>) {
 // CHECK-NEXT:  ^bb0(%{{.*}}: f32, %{{.*}}: f32):
 // CHECK-NEXT:     linalg.yield
-// CHECK-NEXT:  } -> tensor<1x16x112x112xf32>
-//      CHECK:  %[[INIT_COL_TENSOR:.+]] = linalg.init_tensor [1, 16, 112, 112, 3, 3] : tensor<1x16x112x112x3x3xf32>
+// CHECK-NEXT:  } -> tensor<16x1x112x112xf32>
+//      CHECK:  %[[INIT_COL_TENSOR:.+]] = linalg.init_tensor [16, 1, 112, 112, 3, 3] : tensor<16x1x112x112x3x3xf32>
 //      CHECK: %[[COL_TENSOR:.+]] = linalg.generic
 // CHECK-SAME: indexing_maps = [#[[MAP4]], #[[MAP5]]]
 // CHECK-SAME: iterator_types = ["parallel", "parallel", "parallel", "parallel", "parallel", "parallel"]
-// CHECK-SAME:   ins(%[[INPUT_T]] : tensor<1x16x114x114xf32>) outs(%[[INIT_COL_TENSOR]] : tensor<1x16x112x112x3x3xf32>) {
+// CHECK-SAME:   ins(%[[INPUT_T]] : tensor<16x1x114x114xf32>) outs(%[[INIT_COL_TENSOR]] : tensor<16x1x112x112x3x3xf32>) {
 // CHECK-NEXT:      ^bb0(%{{.*}}: f32, %{{.*}}: f32):
 // CHECK-NEXT:         linalg.yield
-// CHECK-NEXT:    } -> tensor<1x16x112x112x3x3xf32>
+// CHECK-NEXT:    } -> tensor<16x1x112x112x3x3xf32>
 //      CHECK: %[[COL_TENSOR_R:.+]] = tensor.collapse_shape %[[COL_TENSOR]]
-// CHECK-SAME:    tensor<1x16x112x112x3x3xf32> into tensor<16x12544x9xf32>
+// CHECK-SAME:    tensor<16x1x112x112x3x3xf32> into tensor<16x12544x9xf32>
 //      CHECK: %[[FILTER_T_R:.+]] = tensor.collapse_shape %[[FILTER_T]]
 // CHECK-SAME:    tensor<16x3x3xf32> into tensor<16x9xf32>
 //      CHECK: %[[OUTPUT_T_R:.+]] = tensor.collapse_shape %[[OUTPUT_T]]
-// CHECK-SAME:    tensor<1x16x112x112xf32> into tensor<16x12544xf32>
+// CHECK-SAME:    tensor<16x1x112x112xf32> into tensor<16x12544xf32>
 //      CHECK: %[[BMV_RESULT:.+]] = linalg.batch_matvec ins(%[[COL_TENSOR_R]], %[[FILTER_T_R]] : tensor<16x12544x9xf32>, tensor<16x9xf32>) outs(%[[OUTPUT_T_R]] : tensor<16x12544xf32>) -> tensor<16x12544xf32>
 //      CHECK: %[[RESULT_R:.+]] = tensor.expand_shape %[[BMV_RESULT]]
-// CHECK-SAME:    tensor<16x12544xf32> into tensor<1x16x112x112xf32>
+// CHECK-SAME:    tensor<16x12544xf32> into tensor<16x1x112x112xf32>
 //      CHECK: %[[RESULT_INIT:.+]] = linalg.init_tensor [1, 112, 112, 16] : tensor<1x112x112x16xf32>
 //      CHECK: %[[RESULT:.+]] = linalg.generic
 // CHECK-SAME: indexing_maps = [#[[MAP6]], #[[MAP1]]]
 // CHECK-SAME: iterator_types = ["parallel", "parallel", "parallel", "parallel"]
-// CHECK-SAME: ins(%[[RESULT_R]] : tensor<1x16x112x112xf32>) outs(%[[RESULT_INIT]] : tensor<1x112x112x16xf32>) {
+// CHECK-SAME: ins(%[[RESULT_R]] : tensor<16x1x112x112xf32>) outs(%[[RESULT_INIT]] : tensor<1x112x112x16xf32>) {
 // CHECK-NEXT:      ^bb0(%{{.*}}: f32, %{{.*}}: f32):
 // CHECK-NEXT:      linalg.yield
 // CHECK-NEXT:    } -> tensor<1x112x112x16xf32>
 //      CHECK: return %[[RESULT]] : tensor<1x112x112x16xf32>
+
+// -----
+
+func.func @batch_conv_strided_dilated(%arg0: tensor<2x16x16x4xf32>, %arg1: tensor<3x3x4x16xf32>, %arg2: tensor<2x6x6x16xf32>) -> tensor<2x6x6x16xf32> {
+    %0 = linalg.conv_2d_nhwc_hwcf
+      {dilations = dense<2> : tensor<2xi64>, strides = dense<2> : tensor<2xi64> }
+       ins(%arg0, %arg1: tensor<2x16x16x4xf32>, tensor<3x3x4x16xf32>)
+      outs(%arg2: tensor<2x6x6x16xf32>) -> tensor<2x6x6x16xf32>
+    return %0 : tensor<2x6x6x16xf32>
+}
+// The batch is folded into the rows of the matmul as the filter is shared.
+//  CHECK-DAG: #[[MAP0:.+]] = affine_map<(d0, d1, d2, d3, d4, d5) -> (d0, d1 * 2 + d3 * 2, d2 * 2 + d4 * 2, d5)>
+//      CHECK: @batch_conv_strided_dilated
+// CHECK-SAME:   %[[INPUT:.+]]: tensor<2x16x16x4xf32>
+//      CHECK:   %[[INIT_COL_TENSOR:.+]] = linalg.init_tensor [2, 6, 6, 3, 3, 4] : tensor<2x6x6x3x3x4xf32>
+//      CHECK:   %[[COL_TENSOR:.+]] = linalg.generic
+// CHECK-SAME:     indexing_maps = [#[[MAP0]]
+// CHECK-SAME:     ins(%[[INPUT]] : tensor<2x16x16x4xf32>)
+//      CHECK:   %[[RESHAPED_COL_TENSOR:.+]] = tensor.collapse_shape %[[COL_TENSOR]]
+// CHECK-SAME:     tensor<2x6x6x3x3x4xf32> into tensor<72x36xf32>
+//      CHECK:   %[[MATMUL_RESULT:.+]] = linalg.matmul
+// CHECK-SAME:     ins(%[[RESHAPED_COL_TENSOR]], %{{.+}} : tensor<72x36xf32>, tensor<36x16xf32>)
+// CHECK-SAME:     outs(%{{.+}} : tensor<72x16xf32>)
+//      CHECK:   %[[RESULT:.+]] = tensor.expand_shape %[[MATMUL_RESULT]]
+// CHECK-SAME:     tensor<72x16xf32> into tensor<2x6x6x16xf32>
+//      CHECK:   return %[[RESULT]]
+
+// -----
+
+func.func @padded_conv(%arg0: tensor<1x14x14x4xf32>, %arg1: tensor<3x3x4x16xf32>, %arg2: tensor<1x14x14x16xf32>) -> tensor<1x14x14x16xf32> {
+    %cst = arith.constant 0.000000e+00 : f32
+    %padded = tensor.pad %arg0 low[0, 1, 1, 0] high[0, 1, 1, 0] {
+    ^bb0(%arg3: index, %arg4: index, %arg5: index, %arg6: index):
+      tensor.yield %cst : f32
+    } : tensor<1x14x14x4xf32> to tensor<1x16x16x4xf32>
+    %0 = linalg.conv_2d_nhwc_hwcf
+      {dilations = dense<1> : tensor<2xi64>, strides = dense<1> : tensor<2xi64> }
+       ins(%padded, %arg1: tensor<1x16x16x4xf32>, tensor<3x3x4x16xf32>)
+      outs(%arg2: tensor<1x14x14x16xf32>) -> tensor<1x14x14x16xf32>
+    return %0 : tensor<1x14x14x16xf32>
+}
+// The img2col packing reads the padded input.
+//      CHECK: @padded_conv
+//      CHECK:   %[[PADDED:.+]] = tensor.pad
+//      CHECK:   %[[COL_TENSOR:.+]] = linalg.generic
+// CHECK-SAME:     ins(%[[PADDED]] : tensor<1x16x16x4xf32>)
+//      CHECK:   tensor.collapse_shape %[[COL_TENSOR]]
+// CHECK-SAME:     tensor<1x14x14x3x3x4xf32> into tensor<196x36xf32>
+//      CHECK:   linalg.matmul
+
+// -----
+
+func.func @batch_depthwise_conv_dilated(%input: tensor<2x20x20x8xf32>, %filter: tensor<3x3x8xf32>, %output: tensor<2x16x16x8xf32>) -> tensor<2x16x16x8xf32> {
+    %0 = linalg.depthwise_conv_2d_nhwc_hwc {
+      dilations = dense<2> : tensor<2xi64>,
+      strides = dense<1> : tensor<2xi64>
+    } ins(%input, %filter : tensor<2x20x20x8xf32>, tensor<3x3x8xf32>) outs(%output : tensor<2x16x16x8xf32>) -> tensor<2x16x16x8xf32>
+    return %0 : tensor<2x16x16x8xf32>
+}
+// Channels are outermost so that the batch is folded into the rows of each
+// channel's matrix.
+//  CHECK-DAG: #[[MAP:.+]] = affine_map<(d0, d1, d2, d3, d4, d5) -> (d0, d1, d2 + d4 * 2, d3 + d5 * 2)>
+//      CHECK: @batch_depthwise_conv_dilated
+//      CHECK:   %[[INPUT_T:.+]] = linalg.generic
+// CHECK-SAME:     -> tensor<8x2x20x20xf32>
+//      CHECK:   %[[INIT_COL_TENSOR:.+]] = linalg.init_tensor [8, 2, 16, 16, 3, 3] : tensor<8x2x16x16x3x3xf32>
+//      CHECK:   %[[COL_TENSOR:.+]] = linalg.generic
+// CHECK-SAME:     indexing_maps = [#[[MAP]]
+// CHECK-SAME:     ins(%[[INPUT_T]] : tensor<8x2x20x20xf32>)
+//      CHECK:   %[[COL_TENSOR_R:.+]] = tensor.collapse_shape %[[COL_TENSOR]]
+// CHECK-SAME:     tensor<8x2x16x16x3x3xf32> into tensor<8x512x9xf32>
+//      CHECK:   %[[BMV_RESULT:.+]] = linalg.batch_matvec
+// CHECK-SAME:     ins(%[[COL_TENSOR_R]], %{{.+}} : tensor<8x512x9xf32>, tensor<8x9xf32>)
+// CHECK-SAME:     outs(%{{.+}} : tensor<8x512xf32>)
+//      CHECK:   %[[RESULT_R:.+]] = tensor.expand_shape %[[BMV_RESULT]]
+// CHECK-SAME:     tensor<8x512xf32> into tensor<8x2x16x16xf32>
+//      CHECK:   %[[RESULT:.+]] = linalg.generic
+// CHECK-SAME:     ins(%[[RESULT_R]] : tensor<8x2x16x16xf32>)
+// CHECK-SAME:     -> tensor<2x16x16x8xf32>
+//      CHECK:   return %[[RESULT]]
@@ -0,0 +1,241 @@
+// RUN: iree-opt -split-input-file --iree-flow-convert-conv2d-to-winograd=assume-cpu-targets %s | FileCheck %s
+// RUN: iree-opt -split-input-file --iree-flow-convert-conv2d-to-winograd %s | FileCheck %s -check-prefix=NO-TARGETS
+
+func.func @conv_winograd_2x2(%arg0: tensor<4x4x8x16xf32>, %arg1: tensor<3x3x16x32xf32>, %arg2: tensor<4x2x6x32xf32>) -> tensor<4x2x6x32xf32> {
+    %0 = linalg.conv_2d_nhwc_hwcf
+      {dilations = dense<1> : tensor<2xi64>, strides = dense<1> : tensor<2xi64> }
+       ins(%arg0, %arg1: tensor<4x4x8x16xf32>, tensor<3x3x16x32xf32>)
+      outs(%arg2: tensor<4x2x6x32xf32>) -> tensor<4x2x6x32xf32>
+    return %0 : tensor<4x2x6x32xf32>
+}
+// CHECK-DAG: #[[FILTER_MAP0:.+]] = affine_map<(d0, d1, d2, d3, d4, d5) -> (d0, d4)>
+// CHECK-DAG: #[[FILTER_MAP1:.+]] = affine_map<(d0, d1, d2, d3, d4, d5) -> (d4, d5, d2, d3)>
+// CHECK-DAG: #[[FILTER_MAP2:.+]] = affine_map<(d0, d1, d2, d3, d4, d5) -> (d1, d5)>
+// CHECK-DAG: #[[FILTER_MAP3:.+]] = affine_map<(d0, d1, d2, d3, d4, d5) -> (d0, d1, d2, d3, d4, d5)>
+// CHECK-DAG: #[[MAP0:.+]] = affine_map<(d0, d1, d2, d3, d4, d5, d6) -> (d0, d6)>
+// CHECK-DAG: #[[INPUT_MAP:.+]] = affine_map<(d0, d1, d2, d3, d4, d5, d6) -> (d1, d2 * 2 + d6, d3 * 2 + d4, d5)>
+// CHECK-DAG: #[[MAP1:.+]] = affine_map<(d0, d1, d2, d3, d4, d5, d6) -> (d0, d1, d2, d3, d4, d5)>
+// CHECK-DAG: #[[MAP2:.+]] = affine_map<(d0, d1, d2, d3, d4, d5, d6) -> (d0, d2, d3, d4, d6, d5)>
+// CHECK-DAG: #[[MAP3:.+]] = affine_map<(d0, d1, d2, d3, d4, d5, d6) -> (d1, d6)>
+// CHECK-DAG: #[[MAP4:.+]] = affine_map<(d0, d1, d2, d3, d4, d5, d6) -> (d6, d1, d2, d3, d4, d5)>
+// CHECK-DAG: #[[MAP5:.+]] = affine_map<(d0, d1, d2, d3, d4, d5, d6) -> (d2, d6, d0, d1, d3, d5)>
+// CHECK-DAG: #[[MAP6:.+]] = affine_map<(d0, d1, d2, d3, d4, d5, d6) -> (d4, d6)>
+// NO-TARGETS-LABEL: @conv_winograd_2x2
+//       NO-TARGETS:   linalg.conv_2d_nhwc_hwcf
+//   NO-TARGETS-NOT:   linalg.batch_matmul
+
+//      CHECK: @conv_winograd_2x2
+// CHECK-SAME: %[[INPUT:.+]]: tensor<4x4x8x16xf32>
+// CHECK-SAME: %[[FILTER:.+]]: tensor<3x3x16x32xf32>
+// CHECK-SAME: %[[OUTPUT:.+]]: tensor<4x2x6x32xf32>
+//  CHECK-DAG: %[[BT:.+]] = arith.constant dense<{{.+}}> : tensor<4x4xf32>
+//  CHECK-DAG: %[[G:.+]] = arith.constant dense<{{.+}}> : tensor<4x3xf32>
+//  CHECK-DAG: %[[AT:.+]] = arith.constant dense<{{.+}}> : tensor<2x4xf32>
+//      CHECK: %[[FILTER_INIT:.+]] = linalg.fill
+// CHECK-SAME:   -> tensor<4x4x16x32xf32>
+//      CHECK: %[[U:.+]] = linalg.generic
+// CHECK-SAME:   indexing_maps = [#[[FILTER_MAP0]], #[[FILTER_MAP1]], #[[FILTER_MAP2]], #[[FILTER_MAP3]]]
+// CHECK-SAME:   iterator_types = ["parallel", "parallel", "parallel", "parallel", "reduction", "reduction"]
+// CHECK-SAME:   ins(%[[G]], %[[FILTER]], %[[G]] : tensor<4x3xf32>, tensor<3x3x16x32xf32>, tensor<4x3xf32>)
+// CHECK-SAME:   outs(%[[FILTER_INIT]] : tensor<4x4x16x32xf32>)
+//      CHECK:   arith.mulf
+//      CHECK:   arith.mulf
+//      CHECK:   arith.addf
+//      CHECK: %[[T:.+]] = linalg.generic
+// CHECK-SAME:   indexing_maps = [#[[MAP0]], #[[INPUT_MAP]], #[[MAP1]]]
+// CHECK-SAME:   iterator_types = ["parallel", "parallel", "parallel", "parallel", "parallel", "parallel", "reduction"]
+// CHECK-SAME:   ins(%[[BT]], %[[INPUT]] : tensor<4x4xf32>, tensor<4x4x8x16xf32>)
+// CHECK-SAME:   -> tensor<4x4x1x3x4x16xf32>
+//      CHECK: %[[V:.+]] = linalg.generic
+// CHECK-SAME:   indexing_maps = [#[[MAP2]], #[[MAP3]], #[[MAP1]]]
+// CHECK-SAME:   ins(%[[T]], %[[BT]] : tensor<4x4x1x3x4x16xf32>, tensor<4x4xf32>)
+// CHECK-SAME:   -> tensor<4x4x4x1x3x16xf32>
+//      CHECK: %[[V_RESHAPED:.+]] = tensor.collapse_shape %[[V]]
+// CHECK-SAME:   [0, 1], [2, 3, 4], [5]
+// CHECK-SAME:   tensor<4x4x4x1x3x16xf32> into tensor<16x12x16xf32>
+//      CHECK: %[[U_RESHAPED:.+]] = tensor.collapse_shape %[[U]]
+// CHECK-SAME:   [0, 1], [2], [3]
+// CHECK-SAME:   tensor<4x4x16x32xf32> into tensor<16x16x32xf32>
+//      CHECK: %[[M_INIT:.+]] = linalg.fill
+//      CHECK: %[[M:.+]] = linalg.batch_matmul
+// CHECK-SAME:   ins(%[[V_RESHAPED]], %[[U_RESHAPED]] : tensor<16x12x16xf32>, tensor<16x16x32xf32>)
+// CHECK-SAME:   outs(%[[M_INIT]] : tensor<16x12x32xf32>)
+//      CHECK: %[[M_EXPANDED:.+]] = tensor.expand_shape %[[M]]
+// CHECK-SAME:   tensor<16x12x32xf32> into tensor<4x4x4x1x3x32xf32>
+//      CHECK: %[[Y_INIT:.+]] = tensor.expand_shape %[[OUTPUT]]
+// CHECK-SAME:   [0], [1, 2], [3, 4], [5]
+// CHECK-SAME:   tensor<4x2x6x32xf32> into tensor<4x1x2x3x2x32xf32>
+//      CHECK: %[[S:.+]] = linalg.generic
+// CHECK-SAME:   indexing_maps = [#[[MAP0]], #[[MAP4]], #[[MAP1]]]
+// CHECK-SAME:   ins(%[[AT]], %[[M_EXPANDED]] : tensor<2x4xf32>, tensor<4x4x4x1x3x32xf32>)
+// CHECK-SAME:   -> tensor<2x4x4x1x3x32xf32>
+//      CHECK: %[[Y:.+]] = linalg.generic
+// CHECK-SAME:   indexing_maps = [#[[MAP5]], #[[MAP6]], #[[MAP1]]]
+// CHECK-SAME:   ins(%[[S]], %[[AT]] : tensor<2x4x4x1x3x32xf32>, tensor<2x4xf32>)
+// CHECK-SAME:   outs(%[[Y_INIT]] : tensor<4x1x2x3x2x32xf32>)
+//      CHECK: %[[RESULT:.+]] = tensor.collapse_shape %[[Y]]
+// CHECK-SAME:   [0], [1, 2], [3, 4], [5]
+// CHECK-SAME:   tensor<4x1x2x3x2x32xf32> into tensor<4x2x6x32xf32>
+//      CHECK: return %[[RESULT]]
+
+// -----
+
+func.func @conv_winograd_4x4_padded(%arg0: tensor<4x11x9x16xf32>, %arg1: tensor<3x3x16x32xf32>) -> tensor<4x9x7x32xf32> {
+    %cst = arith.constant 0.0 : f32
+    %init = linalg.init_tensor [4, 9, 7, 32] : tensor<4x9x7x32xf32>
+    %fill = linalg.fill ins(%cst : f32) outs(%init : tensor<4x9x7x32xf32>) -> tensor<4x9x7x32xf32>
+    %0 = linalg.conv_2d_nhwc_hwcf
+      {dilations = dense<1> : tensor<2xi64>, strides = dense<1> : tensor<2xi64> }
+       ins(%arg0, %arg1: tensor<4x11x9x16xf32>, tensor<3x3x16x32xf32>)
+      outs(%fill: tensor<4x9x7x32xf32>) -> tensor<4x9x7x32xf32>
+    return %0 : tensor<4x9x7x32xf32>
+}
+// CHECK-DAG: #[[INPUT_MAP:.+]] = affine_map<(d0, d1, d2, d3, d4, d5, d6) -> (d1, d2 * 4 + d6, d3 * 4 + d4, d5)>
+//      CHECK: @conv_winograd_4x4_padded
+// CHECK-SAME: %[[INPUT:.+]]: tensor<4x11x9x16xf32>
+// CHECK-SAME: %[[FILTER:.+]]: tensor<3x3x16x32xf32>
+//  CHECK-DAG: %[[BT:.+]] = arith.constant dense<{{.+}}> : tensor<6x6xf32>
+//  CHECK-DAG: %[[G:.+]] = arith.constant dense<{{.+}}> : tensor<6x3xf32>
+//  CHECK-DAG: %[[AT:.+]] = arith.constant dense<{{.+}}> : tensor<4x6xf32>
+//      CHECK: %[[U:.+]] = linalg.generic
+// CHECK-SAME:   ins(%[[G]], %[[FILTER]], %[[G]] : tensor<6x3xf32>, tensor<3x3x16x32xf32>, tensor<6x3xf32>)
+// CHECK-SAME:   -> tensor<6x6x16x32xf32>
+//      CHECK: %[[PADDED_INPUT:.+]] = tensor.pad %[[INPUT]] low[0, 0, 0, 0] high[0, 3, 1, 0]
+//      CHECK:   tensor<4x11x9x16xf32> to tensor<4x14x10x16xf32>
+//      CHECK: %[[T:.+]] = linalg.generic
+// CHECK-SAME:   #[[INPUT_MAP]]
+// CHECK-SAME:   ins(%[[BT]], %[[PADDED_INPUT]] : tensor<6x6xf32>, tensor<4x14x10x16xf32>)
+// CHECK-SAME:   -> tensor<6x4x3x2x6x16xf32>
+//      CHECK: %[[V:.+]] = linalg.generic
+// CHECK-SAME:   -> tensor<6x6x4x3x2x16xf32>
+//      CHECK: %[[V_RESHAPED:.+]] = tensor.collapse_shape %[[V]]
+// CHECK-SAME:   tensor<6x6x4x3x2x16xf32> into tensor<36x24x16xf32>
+//      CHECK: %[[U_RESHAPED:.+]] = tensor.collapse_shape %[[U]]
+// CHECK-SAME:   tensor<6x6x16x32xf32> into tensor<36x16x32xf32>
+//      CHECK: %[[M:.+]] = linalg.batch_matmul
+// CHECK-SAME:   ins(%[[V_RESHAPED]], %[[U_RESHAPED]] : tensor<36x24x16xf32>, tensor<36x16x32xf32>)
+//      CHECK: %[[M_EXPANDED:.+]] = tensor.expand_shape %[[M]]
+// CHECK-SAME:   tensor<36x24x32xf32> into tensor<6x6x4x3x2x32xf32>
+//      CHECK: %[[Y_INIT:.+]] = linalg.fill
+// CHECK-SAME:   -> tensor<4x3x4x2x4x32xf32>
+//      CHECK: %[[S:.+]] = linalg.generic
+// CHECK-SAME:   ins(%[[AT]], %[[M_EXPANDED]] : tensor<4x6xf32>, tensor<6x6x4x3x2x32xf32>)
+// CHECK-SAME:   -> tensor<4x6x4x3x2x32xf32>
+//      CHECK: %[[Y:.+]] = linalg.generic
+// CHECK-SAME:   ins(%[[S]], %[[AT]] : tensor<4x6x4x3x2x32xf32>, tensor<4x6xf32>)
+// CHECK-SAME:   outs(%[[Y_INIT]] : tensor<4x3x4x2x4x32xf32>)
+//      CHECK: %[[Y_RESHAPED:.+]] = tensor.collapse_shape %[[Y]]
+// CHECK-SAME:   tensor<4x3x4x2x4x32xf32> into tensor<4x12x8x32xf32>
+//      CHECK: %[[RESULT:.+]] = tensor.extract_slice %[[Y_RESHAPED]][0, 0, 0, 0] [4, 9, 7, 32] [1, 1, 1, 1]
+// CHECK-SAME:   tensor<4x12x8x32xf32> to tensor<4x9x7x32xf32>
+//      CHECK: return %[[RESULT]]
+
+// -----
+
+func.func @conv_winograd_nonzero_output_padded(%arg0: tensor<4x9x9x16xf32>, %arg1: tensor<3x3x16x16xf32>, %arg2: tensor<4x7x7x16xf32>) -> tensor<4x7x7x16xf32> {
+    %0 = linalg.conv_2d_nhwc_hwcf
+      {dilations = dense<1> : tensor<2xi64>, strides = dense<1> : tensor<2xi64> }
+       ins(%arg0, %arg1: tensor<4x9x9x16xf32>, tensor<3x3x16x16xf32>)
+      outs(%arg2: tensor<4x7x7x16xf32>) -> tensor<4x7x7x16xf32>
+    return %0 : tensor<4x7x7x16xf32>
+}
+//      CHECK: @conv_winograd_nonzero_output_padded
+// CHECK-SAME: %[[OUTPUT:[a-zA-Z0-9_]+]]: tensor<4x7x7x16xf32>
+//      CHECK: linalg.batch_matmul
+// CHECK-SAME:   outs(%{{.+}} : tensor<36x16x16xf32>)
+//      CHECK: %[[PADDED_OUTPUT:.+]] = tensor.pad %[[OUTPUT]] low[0, 0, 0, 0] high[0, 1, 1, 0]
+//      CHECK:   tensor<4x7x7x16xf32> to tensor<4x8x8x16xf32>
+//      CHECK: %[[Y_INIT:.+]] = tensor.expand_shape %[[PADDED_OUTPUT]]
+// CHECK-SAME:   tensor<4x8x8x16xf32> into tensor<4x2x4x2x4x16xf32>
+//      CHECK: linalg.generic
+//      CHECK: %[[Y:.+]] = linalg.generic
+// CHECK-SAME:   outs(%[[Y_INIT]] : tensor<4x2x4x2x4x16xf32>)
+//      CHECK: %[[Y_RESHAPED:.+]] = tensor.collapse_shape %[[Y]]
+//      CHECK: tensor.extract_slice %[[Y_RESHAPED]][0, 0, 0, 0] [4, 7, 7, 16] [1, 1, 1, 1]
+
+// -----
+
+func.func @conv_winograd_input_sliced(%arg0: tensor<4x11x11x16xf32>, %arg1: tensor<3x3x16x32xf32>, %arg2: tensor<4x8x8x32xf32>) -> tensor<4x8x8x32xf32> {
+    %0 = linalg.conv_2d_nhwc_hwcf
+      {dilations = dense<1> : tensor<2xi64>, strides = dense<1> : tensor<2xi64> }
+       ins(%arg0, %arg1: tensor<4x11x11x16xf32>, tensor<3x3x16x32xf32>)
+      outs(%arg2: tensor<4x8x8x32xf32>) -> tensor<4x8x8x32xf32>
+    return %0 : tensor<4x8x8x32xf32>
+}
+//      CHECK: @conv_winograd_input_sliced
+// CHECK-SAME: %[[INPUT:[a-zA-Z0-9_]+]]: tensor<4x11x11x16xf32>
+//      CHECK: %[[SLICED_INPUT:.+]] = tensor.extract_slice %[[INPUT]][0, 0, 0, 0] [4, 10, 10, 16] [1, 1, 1, 1]
+// CHECK-SAME:   tensor<4x11x11x16xf32> to tensor<4x10x10x16xf32>
+//  CHECK-NOT: tensor.pad
+//      CHECK: linalg.generic
+// CHECK-SAME:   ins(%{{.+}}, %[[SLICED_INPUT]] : tensor<6x6xf32>, tensor<4x10x10x16xf32>)
+// CHECK-SAME:   -> tensor<6x4x2x2x6x16xf32>
+//      CHECK: linalg.batch_matmul
+// CHECK-SAME:   outs(%{{.+}} : tensor<36x16x32xf32>)
+
+// -----
+
+func.func @conv_strided_not_converted(%arg0: tensor<1x9x9x8xf32>, %arg1: tensor<3x3x8x16xf32>, %arg2: tensor<1x4x4x16xf32>) -> tensor<1x4x4x16xf32> {
+    %0 = linalg.conv_2d_nhwc_hwcf
+      {dilations = dense<1> : tensor<2xi64>, strides = dense<2> : tensor<2xi64> }
+       ins(%arg0, %arg1: tensor<1x9x9x8xf32>, tensor<3x3x8x16xf32>)
+      outs(%arg2: tensor<1x4x4x16xf32>) -> tensor<1x4x4x16xf32>
+    return %0 : tensor<1x4x4x16xf32>
+}
+//      CHECK: @conv_strided_not_converted
+//      CHECK:   linalg.conv_2d_nhwc_hwcf
+//  CHECK-NOT:   linalg.batch_matmul
+
+// -----
+
+func.func @conv_few_channels_not_converted(%arg0: tensor<1x10x10x3xf32>, %arg1: tensor<3x3x3x16xf32>, %arg2: tensor<1x8x8x16xf32>) -> tensor<1x8x8x16xf32> {
+    %0 = linalg.conv_2d_nhwc_hwcf
+      {dilations = dense<1> : tensor<2xi64>, strides = dense<1> : tensor<2xi64> }
+       ins(%arg0, %arg1: tensor<1x10x10x3xf32>, tensor<3x3x3x16xf32>)
+      outs(%arg2: tensor<1x8x8x16xf32>) -> tensor<1x8x8x16xf32>
+    return %0 : tensor<1x8x8x16xf32>
+}
+//      CHECK: @conv_few_channels_not_converted
+//      CHECK:   linalg.conv_2d_nhwc_hwcf
+//  CHECK-NOT:   linalg.batch_matmul
+
+// -----
+
+module attributes {
+  hal.device.targets = [#hal.device.target<"vulkan", {
+    executable_targets = [#hal.executable.target<"vulkan", "vulkan-spirv-fb">]
+  }>]
+} {
+  func.func @conv_gpu_target_not_converted(%arg0: tensor<4x10x10x16xf32>, %arg1: tensor<3x3x16x32xf32>, %arg2: tensor<4x8x8x32xf32>) -> tensor<4x8x8x32xf32> {
+      %0 = linalg.conv_2d_nhwc_hwcf
+        {dilations = dense<1> : tensor<2xi64>, strides = dense<1> : tensor<2xi64> }
+         ins(%arg0, %arg1: tensor<4x10x10x16xf32>, tensor<3x3x16x32xf32>)
+        outs(%arg2: tensor<4x8x8x32xf32>) -> tensor<4x8x8x32xf32>
+      return %0 : tensor<4x8x8x32xf32>
+  }
+}
+//      CHECK: @conv_gpu_target_not_converted
+//      CHECK:   linalg.conv_2d_nhwc_hwcf
+//  CHECK-NOT:   linalg.batch_matmul
+
+// -----
+
+module attributes {
+  hal.device.targets = [#hal.device.target<"cpu", {
+    executable_targets = [#hal.executable.target<"llvm", "embedded-elf-x86_64">]
+  }>]
+} {
+  func.func @conv_cpu_target_converted(%arg0: tensor<4x10x10x16xf32>, %arg1: tensor<3x3x16x32xf32>, %arg2: tensor<4x8x8x32xf32>) -> tensor<4x8x8x32xf32> {
+      %0 = linalg.conv_2d_nhwc_hwcf
+        {dilations = dense<1> : tensor<2xi64>, strides = dense<1> : tensor<2xi64> }
+         ins(%arg0, %arg1: tensor<4x10x10x16xf32>, tensor<3x3x16x32xf32>)
+        outs(%arg2: tensor<4x8x8x32xf32>) -> tensor<4x8x8x32xf32>
+      return %0 : tensor<4x8x8x32xf32>
+  }
+}
+//           CHECK: @conv_cpu_target_converted
+//       CHECK-NOT:   linalg.conv_2d_nhwc_hwcf
+//           CHECK:   linalg.batch_matmul
+// NO-TARGETS-LABEL: @conv_cpu_target_converted
+//   NO-TARGETS-NOT:   linalg.conv_2d_nhwc_hwcf
+//       NO-TARGETS:   linalg.batch_matmul
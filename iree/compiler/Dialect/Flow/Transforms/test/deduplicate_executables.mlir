@@ -331,3 +331,66 @@ flow.executable @block_successors_ex_with_swapped_cond_br {
     }
   }
 }
+
+// -----
+
+// Executables that differ only in the names of the symbols they define are
+// equivalent so long as all references to those symbols correspond.
+
+// CHECK-LABEL: flow.executable public @symbol_names_ex_0
+flow.executable @symbol_names_ex_0 {
+  flow.dispatch.entry @symbol_names_entry_0
+  builtin.module {
+    func.func @symbol_names_entry_0(%arg0: tensor<4xf32>) -> tensor<4xf32> {
+      %0 = call @symbol_names_helper_0(%arg0) : (tensor<4xf32>) -> tensor<4xf32>
+      return %0 : tensor<4xf32>
+    }
+    func.func private @symbol_names_helper_0(%arg0: tensor<4xf32>) -> tensor<4xf32> {
+      %0 = mhlo.add %arg0, %arg0 : tensor<4xf32>
+      return %0 : tensor<4xf32>
+    }
+  }
+}
+// CHECK-NOT: flow.executable public @symbol_names_ex_1
+flow.executable @symbol_names_ex_1 {
+  flow.dispatch.entry @symbol_names_entry_1
+  builtin.module {
+    func.func @symbol_names_entry_1(%arg0: tensor<4xf32>) -> tensor<4xf32> {
+      %0 = call @symbol_names_helper_1(%arg0) : (tensor<4xf32>) -> tensor<4xf32>
+      return %0 : tensor<4xf32>
+    }
+    func.func private @symbol_names_helper_1(%arg0: tensor<4xf32>) -> tensor<4xf32> {
+      %0 = mhlo.add %arg0, %arg0 : tensor<4xf32>
+      return %0 : tensor<4xf32>
+    }
+  }
+}
+// CHECK-LABEL: flow.executable public @symbol_names_ex_2
+flow.executable @symbol_names_ex_2 {
+  flow.dispatch.entry @symbol_names_entry_2
+  builtin.module {
+    func.func @symbol_names_entry_2(%arg0: tensor<4xf32>) -> tensor<4xf32> {
+      %0 = call @symbol_names_helper_2b(%arg0) : (tensor<4xf32>) -> tensor<4xf32>
+      return %0 : tensor<4xf32>
+    }
+    func.func private @symbol_names_helper_2a(%arg0: tensor<4xf32>) -> tensor<4xf32> {
+      %0 = mhlo.add %arg0, %arg0 : tensor<4xf32>
+      return %0 : tensor<4xf32>
+    }
+    func.func private @symbol_names_helper_2b(%arg0: tensor<4xf32>) -> tensor<4xf32> {
+      %0 = mhlo.add %arg0, %arg0 : tensor<4xf32>
+      return %0 : tensor<4xf32>
+    }
+  }
+}
+// CHECK-LABEL: func @symbol_names
+func.func @symbol_names(%arg0: tensor<4xf32>) -> tensor<4xf32> {
+  %c4 = arith.constant 4 : index
+  // CHECK: %0 = flow.dispatch @symbol_names_ex_0::@symbol_names_entry_0[%c4](%arg0) : (tensor<4xf32>) -> tensor<4xf32>
+  %0 = flow.dispatch @symbol_names_ex_0::@symbol_names_entry_0[%c4] (%arg0) : (tensor<4xf32>) -> tensor<4xf32>
+  // CHECK: %1 = flow.dispatch @symbol_names_ex_0::@symbol_names_entry_0[%c4](%arg0) : (tensor<4xf32>) -> tensor<4xf32>
+  %1 = flow.dispatch @symbol_names_ex_1::@symbol_names_entry_1[%c4] (%arg0) : (tensor<4xf32>) -> tensor<4xf32>
+  // CHECK: %2 = flow.dispatch @symbol_names_ex_2::@symbol_names_entry_2[%c4](%arg0) : (tensor<4xf32>) -> tensor<4xf32>
+  %2 = flow.dispatch @symbol_names_ex_2::@symbol_names_entry_2[%c4] (%arg0) : (tensor<4xf32>) -> tensor<4xf32>
+  return %0 : tensor<4xf32>
+}
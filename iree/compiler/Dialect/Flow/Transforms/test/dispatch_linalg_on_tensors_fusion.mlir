@@ -109,3 +109,63 @@ func.func @dont_fuse_conv2d_with_non_identity_map(%input: tensor<1x225x225x16xf3
 
 // CHECK: flow.dispatch.workgroups
 // CHECK:   linalg.generic
+
+// -----
+
+func.func @fuse_matmul_with_multi_use_consumer(%lhs: tensor<128x256xf32>, %rhs: tensor<256x64xf32>) -> tensor<128x64xf32> {
+  %cst = arith.constant 0.000000e+00 : f32
+  %0 = linalg.init_tensor [128, 64] : tensor<128x64xf32>
+  %1 = linalg.fill ins(%cst : f32) outs(%0 : tensor<128x64xf32>) -> tensor<128x64xf32>
+  %2 = linalg.matmul ins(%lhs, %rhs : tensor<128x256xf32>, tensor<256x64xf32>)
+         outs(%1 : tensor<128x64xf32>) -> tensor<128x64xf32>
+  %3 = linalg.generic {
+         indexing_maps = [
+           affine_map<(d0, d1) -> (d0, d1)>,
+           affine_map<(d0, d1) -> (d0, d1)>,
+           affine_map<(d0, d1) -> (d0, d1)>],
+         iterator_types = ["parallel", "parallel"]}
+         ins(%2, %2 : tensor<128x64xf32>, tensor<128x64xf32>)
+         outs(%0 : tensor<128x64xf32>) {
+         ^bb0(%a: f32, %b: f32, %c: f32):
+            %mul = arith.mulf %a, %b : f32
+            linalg.yield %mul : f32
+         } -> tensor<128x64xf32>
+  return %3 : tensor<128x64xf32>
+}
+
+// Check that the matmul is fused with a consumer that uses its result twice.
+
+// CHECK-LABEL: func @fuse_matmul_with_multi_use_consumer
+//       CHECK:   flow.dispatch.workgroups
+//       CHECK:     %[[MATMUL:.+]] = linalg.matmul
+//       CHECK:     linalg.generic
+//  CHECK-SAME:       ins(%[[MATMUL]], %[[MATMUL]] :
+//   CHECK-NOT:   flow.dispatch.workgroups
+
+// -----
+
+func.func @duplicate_fill_into_dispatches(%lhs: tensor<128x256xf32>, %rhs0: tensor<256x64xf32>, %rhs1: tensor<256x64xf32>)
+  -> (tensor<128x64xf32>, tensor<128x64xf32>) {
+  %cst = arith.constant 0.000000e+00 : f32
+  %0 = linalg.init_tensor [128, 64] : tensor<128x64xf32>
+  %1 = linalg.fill ins(%cst : f32) outs(%0 : tensor<128x64xf32>) -> tensor<128x64xf32>
+  %2 = linalg.matmul ins(%lhs, %rhs0 : tensor<128x256xf32>, tensor<256x64xf32>)
+         outs(%1 : tensor<128x64xf32>) -> tensor<128x64xf32>
+  %3 = linalg.matmul ins(%lhs, %rhs1 : tensor<128x256xf32>, tensor<256x64xf32>)
+         outs(%1 : tensor<128x64xf32>) -> tensor<128x64xf32>
+  return %2, %3 : tensor<128x64xf32>, tensor<128x64xf32>
+}
+
+// Check that a linalg.fill shared by two matmuls is duplicated into both
+// dispatches instead of being materialized as a splat.
+
+// CHECK-LABEL: func @duplicate_fill_into_dispatches
+//   CHECK-NOT:   flow.tensor.splat
+//       CHECK:   flow.dispatch.workgroups
+//       CHECK:     %[[FILL0:.+]] = linalg.fill
+//       CHECK:     linalg.matmul
+//  CHECK-SAME:       outs(%[[FILL0]] :
+//       CHECK:   flow.dispatch.workgroups
+//       CHECK:     %[[FILL1:.+]] = linalg.fill
+//       CHECK:     linalg.matmul
+//  CHECK-SAME:       outs(%[[FILL1]] :
@@ -0,0 +1,82 @@
+// RUN: iree-opt -split-input-file -pass-pipeline="func.func(iree-flow-fusion-of-tensor-ops)" %s | FileCheck %s
+
+#map = affine_map<(d0, d1) -> (d0, d1)>
+func.func @duplicate_cheap_elementwise(%arg0: tensor<128x64xf32>, %arg1: tensor<128x64xf32>, %arg2: tensor<128x64xf32>)
+  -> (tensor<128x64xf32>, tensor<128x64xf32>) {
+  %0 = linalg.init_tensor [128, 64] : tensor<128x64xf32>
+  %1 = linalg.generic {indexing_maps = [#map, #map, #map], iterator_types = ["parallel", "parallel"]}
+      ins(%arg0, %arg1 : tensor<128x64xf32>, tensor<128x64xf32>) outs(%0 : tensor<128x64xf32>) {
+  ^bb0(%a: f32, %b: f32, %c: f32):
+    %add = arith.addf %a, %b : f32
+    linalg.yield %add : f32
+  } -> tensor<128x64xf32>
+  %2 = linalg.generic {indexing_maps = [#map, #map], iterator_types = ["parallel", "parallel"]}
+      ins(%1 : tensor<128x64xf32>) outs(%0 : tensor<128x64xf32>) {
+  ^bb0(%a: f32, %b: f32):
+    %exp = math.exp %a : f32
+    linalg.yield %exp : f32
+  } -> tensor<128x64xf32>
+  %3 = linalg.generic {indexing_maps = [#map, #map, #map], iterator_types = ["parallel", "parallel"]}
+      ins(%1, %arg2 : tensor<128x64xf32>, tensor<128x64xf32>) outs(%0 : tensor<128x64xf32>) {
+  ^bb0(%a: f32, %b: f32, %c: f32):
+    %mul = arith.mulf %a, %b : f32
+    linalg.yield %mul : f32
+  } -> tensor<128x64xf32>
+  return %2, %3 : tensor<128x64xf32>, tensor<128x64xf32>
+}
+
+// The add has two uses but is cheap enough to be recomputed in each of them.
+
+// CHECK-LABEL: func @duplicate_cheap_elementwise
+//       CHECK:   linalg.generic
+//       CHECK:     arith.addf
+//       CHECK:     math.exp
+//       CHECK:   linalg.generic
+//       CHECK:     arith.addf
+//       CHECK:     arith.mulf
+//   CHECK-NOT:   linalg.generic
+
+// -----
+
+#map = affine_map<(d0, d1) -> (d0, d1)>
+#map1 = affine_map<(d0, d1) -> (d1)>
+func.func @dont_duplicate_matmul_epilogue(%lhs: tensor<128x256xf32>, %rhs: tensor<256x64xf32>, %bias: tensor<64xf32>)
+  -> (tensor<128x64xf32>, tensor<128x64xf32>) {
+  %cst = arith.constant 0.000000e+00 : f32
+  %0 = linalg.init_tensor [128, 64] : tensor<128x64xf32>
+  %1 = linalg.fill ins(%cst : f32) outs(%0 : tensor<128x64xf32>) -> tensor<128x64xf32>
+  %2 = linalg.matmul ins(%lhs, %rhs : tensor<128x256xf32>, tensor<256x64xf32>)
+      outs(%1 : tensor<128x64xf32>) -> tensor<128x64xf32>
+  %3 = linalg.generic {indexing_maps = [#map, #map1, #map], iterator_types = ["parallel", "parallel"]}
+      ins(%2, %bias : tensor<128x64xf32>, tensor<64xf32>) outs(%0 : tensor<128x64xf32>) {
+  ^bb0(%a: f32, %b: f32, %c: f32):
+    %add = arith.addf %a, %b : f32
+    linalg.yield %add : f32
+  } -> tensor<128x64xf32>
+  %4 = linalg.generic {indexing_maps = [#map, #map], iterator_types = ["parallel", "parallel"]}
+      ins(%3 : tensor<128x64xf32>) outs(%0 : tensor<128x64xf32>) {
+  ^bb0(%a: f32, %b: f32):
+    %max = arith.maxf %a, %cst : f32
+    linalg.yield %max : f32
+  } -> tensor<128x64xf32>
+  %5 = linalg.generic {indexing_maps = [#map, #map], iterator_types = ["parallel", "parallel"]}
+      ins(%3 : tensor<128x64xf32>) outs(%0 : tensor<128x64xf32>) {
+  ^bb0(%a: f32, %b: f32):
+    %neg = arith.negf %a : f32
+    linalg.yield %neg : f32
+  } -> tensor<128x64xf32>
+  return %4, %5 : tensor<128x64xf32>, tensor<128x64xf32>
+}
+
+// The bias-add reads the result of the matmul. Duplicating it would give the
+// matmul two uses and prevent the bias-add from being fused into the dispatch
+// region of the matmul.
+
+// CHECK-LABEL: func @dont_duplicate_matmul_epilogue
+//       CHECK:   %[[MATMUL:.+]] = linalg.matmul
+//       CHECK:   %[[BIAS_ADD:.+]] = linalg.generic
+//  CHECK-SAME:     ins(%[[MATMUL]], %{{.+}} :
+//       CHECK:   linalg.generic
+//  CHECK-SAME:     ins(%[[BIAS_ADD]] :
+//       CHECK:   linalg.generic
+//  CHECK-SAME:     ins(%[[BIAS_ADD]] :
@@ -2,6 +2,8 @@
 // RUN: iree-opt -split-input-file --iree-flow-convert-linalg-matmul-to-mmt4d='arch=aarch64' %s | FileCheck %s -check-prefix=AARCH64-BASELINE
 // RUN: iree-opt -split-input-file --iree-flow-convert-linalg-matmul-to-mmt4d='arch=aarch64 features=+dotprod' %s | FileCheck %s -check-prefix=AARCH64-DOTPROD
 // RUN: iree-opt -split-input-file --iree-flow-convert-linalg-matmul-to-mmt4d='arch=aarch64 features=+i8mm' %s | FileCheck %s -check-prefix=AARCH64-I8MM
+// RUN: iree-opt -split-input-file --iree-flow-convert-linalg-matmul-to-mmt4d='arch=x86_64 features=+fma,+avxvnni' %s | FileCheck %s -check-prefix=X86_64-AVX2
+// RUN: iree-opt -split-input-file --iree-flow-convert-linalg-matmul-to-mmt4d='arch=x86_64 features=+avx512vnni' %s | FileCheck %s -check-prefix=X86_64-AVX512
 
 // There are two parts to this test: the "deep" part and the "wide part".
 
@@ -88,6 +90,26 @@ func.func @check_mmt4d_with_init_tensor_and_fill(%arg0: tensor<24x8xf32>, %arg1:
 //      CHECK: [[DST:.+]] linalg.fill
 // CHECK-SAME:   outs(%[[DST_INIT]] :
 
+// -----
+func.func @check_mmt4d_with_dynamic_init_tensor_and_fill(%arg0: tensor<?x8xf32>, %arg1: tensor<8x32xf32>) -> tensor<?x32xf32> {
+    %c0 = arith.constant 0 : index
+    %cst = arith.constant 0.0 : f32
+    %d0 = tensor.dim %arg0, %c0 : tensor<?x8xf32>
+    %0 = linalg.init_tensor [%d0, 32] : tensor<?x32xf32>
+    %1 = linalg.fill ins(%cst : f32) outs(%0 : tensor<?x32xf32>) -> tensor<?x32xf32>
+    %2 = linalg.matmul ins(%arg0, %arg1 : tensor<?x8xf32>, tensor<8x32xf32>) outs(%1 : tensor<?x32xf32>) -> tensor<?x32xf32>
+    return %2 : tensor<?x32xf32>
+}
+// The fill of the accumulator is propagated through the padding, reshape and
+// transpose all the way to the mmt4d even though its shape is dynamic.
+// CHECK-LABEL: @check_mmt4d_with_dynamic_init_tensor_and_fill(
+//      CHECK: %[[DST_INIT:.+]] = linalg.init_tensor [{{.+}}] : tensor<?x8x8x4xf32>
+//      CHECK: %[[DST:.+]] = linalg.fill
+// CHECK-SAME:   outs(%[[DST_INIT]] :
+//  CHECK-NOT: linalg.generic
+//      CHECK: linalg.mmt4d
+// CHECK-SAME:   outs(%[[DST]] :
+
 // -----
 func.func @check_mmt4d_i8_static_pad(%arg0: tensor<3x5xi8>, %arg1: tensor<5x2xi8>, %arg2: tensor<3x2xi32>) -> tensor<3x2xi32> {
     %0 = linalg.matmul ins(%arg0, %arg1 : tensor<3x5xi8>, tensor<5x2xi8>) outs(%arg2 : tensor<3x2xi32>) -> tensor<3x2xi32>
@@ -160,6 +182,16 @@ func.func @check_target_specific_mmt4d_f32_dynamic(%arg0: tensor<?x?xf32>, %arg1
 // AARCH64-BASELINE-SAME:     {comment = "f32*f32->f32, aarch64"}
 // AARCH64-BASELINE-SAME:     ins({{.*}} : tensor<?x?x8x1xf32>, tensor<?x?x8x1xf32>) outs({{.*}} : tensor<?x?x8x8xf32>) -> tensor<?x?x8x8xf32>
 
+// X86_64-AVX2-LABEL:  @check_target_specific_mmt4d_f32_dynamic(
+// X86_64-AVX2:        linalg.mmt4d
+// X86_64-AVX2-SAME:     {comment = "f32*f32->f32, x86_64 +fma"}
+// X86_64-AVX2-SAME:     ins({{.*}} : tensor<?x?x8x1xf32>, tensor<?x?x8x1xf32>) outs({{.*}} : tensor<?x?x8x8xf32>) -> tensor<?x?x8x8xf32>
+
+// X86_64-AVX512-LABEL:  @check_target_specific_mmt4d_f32_dynamic(
+// X86_64-AVX512:        linalg.mmt4d
+// X86_64-AVX512-SAME:     {comment = "f32*f32->f32, x86_64 +avx512f"}
+// X86_64-AVX512-SAME:     ins({{.*}} : tensor<?x?x16x1xf32>, tensor<?x?x16x1xf32>) outs({{.*}} : tensor<?x?x16x16xf32>) -> tensor<?x?x16x16xf32>
+
 // -----
 func.func @check_target_specific_mmt4d_f32_dynamic_matvec(%arg0: tensor<?x?xf32>, %arg1: tensor<?x1xf32>, %arg2: tensor<?x1xf32>) -> tensor<?x1xf32> {
     %0 = linalg.matmul ins(%arg0, %arg1 : tensor<?x?xf32>, tensor<?x1xf32>) outs(%arg2 : tensor<?x1xf32>) -> tensor<?x1xf32>
@@ -200,6 +232,16 @@ func.func @check_target_specific_mmt4d_i8_dynamic(%arg0: tensor<?x?xi8>, %arg1:
 // AARCH64-I8MM-SAME:     {comment = "i8*i8->i32, aarch64 +i8mm"}
 // AARCH64-I8MM-SAME:     ins({{.*}} : tensor<?x?x8x8xi8>, tensor<?x?x8x8xi8>) outs({{.*}} : tensor<?x?x8x8xi32>) -> tensor<?x?x8x8xi32>
 
+// X86_64-AVX2-LABEL:  @check_target_specific_mmt4d_i8_dynamic(
+// X86_64-AVX2:        linalg.mmt4d
+// X86_64-AVX2-SAME:     {comment = "i8*i8->i32, x86_64 +avxvnni"}
+// X86_64-AVX2-SAME:     ins({{.*}} : tensor<?x?x8x4xi8>, tensor<?x?x8x4xi8>) outs({{.*}} : tensor<?x?x8x8xi32>) -> tensor<?x?x8x8xi32>
+
+// X86_64-AVX512-LABEL:  @check_target_specific_mmt4d_i8_dynamic(
+// X86_64-AVX512:        linalg.mmt4d
+// X86_64-AVX512-SAME:     {comment = "i8*i8->i32, x86_64 +avx512vnni"}
+// X86_64-AVX512-SAME:     ins({{.*}} : tensor<?x?x16x4xi8>, tensor<?x?x16x4xi8>) outs({{.*}} : tensor<?x?x16x16xi32>) -> tensor<?x?x16x16xi32>
+
 // -----
 func.func @check_target_specific_mmt4d_i8_dynamic_matvec(%arg0: tensor<?x?xi8>, %arg1: tensor<?x1xi8>, %arg2: tensor<?x1xi32>) -> tensor<?x1xi32> {
     %0 = linalg.matmul ins(%arg0, %arg1 : tensor<?x?xi8>, tensor<?x1xi8>) outs(%arg2 : tensor<?x1xi32>) -> tensor<?x1xi32>
@@ -229,3 +271,28 @@ func.func @check_target_specific_mmt4d_i8_dynamic_vecmat(%arg0: tensor<1x?xi8>,
 // AARCH64-DOTPROD:        linalg.mmt4d
 // AARCH64-DOTPROD-SAME:     {comment = "i8*i8->i32, aarch64 +dotprod, vector*matrix"}
 // AARCH64-DOTPROD-SAME:     ins({{.*}} : tensor<1x?x1x4xi8>, tensor<?x?x8x4xi8>) outs({{.*}} : tensor<1x?x1x8xi32>) -> tensor<1x?x1x8xi32>
+
+// -----
+// Without explicit target options, the tile sizes are chosen for the CPU
+// targets the module is compiled for.
+module attributes {
+  hal.device.targets = [
+    #hal.device.target<"cpu", {
+      executable_targets = [
+        #hal.executable.target<"llvm", "embedded-elf-x86_64", {
+          cpu_features = "+avx,+avx2,+fma,+avx512f",
+          target_triple = "x86_64-unknown-unknown-eabi-elf"
+        }>
+      ]
+    }>
+  ]
+} {
+  func.func @check_mmt4d_f32_from_device_targets(%arg0: tensor<?x?xf32>, %arg1: tensor<?x?xf32>, %arg2: tensor<?x?xf32>) -> tensor<?x?xf32> {
+      %0 = linalg.matmul ins(%arg0, %arg1 : tensor<?x?xf32>, tensor<?x?xf32>) outs(%arg2 : tensor<?x?xf32>) -> tensor<?x?xf32>
+      return %0 : tensor<?x?xf32>
+  }
+}
+// CHECK-LABEL:  @check_mmt4d_f32_from_device_targets(
+// CHECK:        linalg.mmt4d
+// CHECK-SAME:     {comment = "f32*f32->f32, x86_64 +avx512f"}
+// CHECK-SAME:     ins({{.*}} : tensor<?x?x16x1xf32>, tensor<?x?x16x1xf32>) outs({{.*}} : tensor<?x?x16x16xf32>) -> tensor<?x?x16x16xf32>
@@ -0,0 +1,96 @@
+// RUN: iree-opt -split-input-file -pass-pipeline="func.func(iree-flow-split-reduction-ops)" %s | FileCheck %s
+
+module attributes {
+  hal.device.targets = [
+    #hal.device.target<"cpu", {
+      executable_targets = [
+        #hal.executable.target<"llvm", "embedded-elf-x86_64", {
+          num_cores = 8 : i64,
+          target_triple = "x86_64-unknown-unknown-eabi-elf"
+        }>
+      ]
+    }>
+  ]
+} {
+  func.func @split_row_reduction(%arg0: tensor<1x32768xf32>) -> tensor<1xf32> {
+    %cst = arith.constant 0.000000e+00 : f32
+    %0 = linalg.init_tensor [1] : tensor<1xf32>
+    %1 = linalg.fill ins(%cst : f32) outs(%0 : tensor<1xf32>) -> tensor<1xf32>
+    %2 = linalg.generic {
+        indexing_maps = [affine_map<(d0, d1) -> (d0, d1)>, affine_map<(d0, d1) -> (d0)>],
+        iterator_types = ["parallel", "reduction"]}
+        ins(%arg0 : tensor<1x32768xf32>) outs(%1 : tensor<1xf32>) {
+    ^bb0(%in: f32, %out: f32):
+      %3 = arith.addf %in, %out : f32
+      linalg.yield %3 : f32
+    } -> tensor<1xf32>
+    return %2 : tensor<1xf32>
+  }
+}
+
+// The single row is reduced in 8 parallel chunks followed by a final combine.
+
+// CHECK-LABEL: func @split_row_reduction
+//  CHECK-SAME:     %[[ARG0:.+]]: tensor<1x32768xf32>
+//       CHECK:   %[[EXPANDED:.+]] = tensor.expand_shape %[[ARG0]]
+//  CHECK-SAME:       tensor<1x32768xf32> into tensor<1x8x4096xf32>
+//       CHECK:   %[[PARTIAL:.+]] = linalg.generic
+//  CHECK-SAME:       iterator_types = ["parallel", "parallel", "reduction"]
+//  CHECK-SAME:       ins(%[[EXPANDED]] : tensor<1x8x4096xf32>)
+//  CHECK-SAME:       -> tensor<1x8xf32>
+//       CHECK:   %[[RESULT:.+]] = linalg.generic
+//  CHECK-SAME:       iterator_types = ["parallel", "reduction"]
+//  CHECK-SAME:       ins(%[[PARTIAL]] : tensor<1x8xf32>)
+//  CHECK-SAME:       -> tensor<1xf32>
+//       CHECK:   return %[[RESULT]]
+
+// -----
+
+module attributes {
+  hal.device.targets = [
+    #hal.device.target<"cpu", {
+      executable_targets = [
+        #hal.executable.target<"llvm", "embedded-elf-x86_64", {
+          num_cores = 8 : i64,
+          target_triple = "x86_64-unknown-unknown-eabi-elf"
+        }>
+      ]
+    }>
+  ]
+} {
+  func.func @dont_split_parallel_reductions(%arg0: tensor<64x32768xf32>, %arg1: tensor<1x1024xf32>)
+      -> (tensor<64xf32>, tensor<1xf32>) {
+    %cst = arith.constant 0.000000e+00 : f32
+    %0 = linalg.init_tensor [64] : tensor<64xf32>
+    %1 = linalg.fill ins(%cst : f32) outs(%0 : tensor<64xf32>) -> tensor<64xf32>
+    %2 = linalg.generic {
+        indexing_maps = [affine_map<(d0, d1) -> (d0, d1)>, affine_map<(d0, d1) -> (d0)>],
+        iterator_types = ["parallel", "reduction"]}
+        ins(%arg0 : tensor<64x32768xf32>) outs(%1 : tensor<64xf32>) {
+    ^bb0(%in: f32, %out: f32):
+      %3 = arith.addf %in, %out : f32
+      linalg.yield %3 : f32
+    } -> tensor<64xf32>
+    %4 = linalg.init_tensor [1] : tensor<1xf32>
+    %5 = linalg.fill ins(%cst : f32) outs(%4 : tensor<1xf32>) -> tensor<1xf32>
+    %6 = linalg.generic {
+        indexing_maps = [affine_map<(d0, d1) -> (d0, d1)>, affine_map<(d0, d1) -> (d0)>],
+        iterator_types = ["parallel", "reduction"]}
+        ins(%arg1 : tensor<1x1024xf32>) outs(%5 : tensor<1xf32>) {
+    ^bb0(%in: f32, %out: f32):
+      %7 = arith.addf %in, %out : f32
+      linalg.yield %7 : f32
+    } -> tensor<1xf32>
+    return %2, %6 : tensor<64xf32>, tensor<1xf32>
+  }
+}
+
+// Reductions with enough parallel rows or short reduction dimensions are kept.
+
+// CHECK-LABEL: func @dont_split_parallel_reductions
+//   CHECK-NOT:   tensor.expand_shape
+//       CHECK:   linalg.generic
+//  CHECK-SAME:       ins(%{{.+}} : tensor<64x32768xf32>)
+//       CHECK:   linalg.generic
+//  CHECK-SAME:       ins(%{{.+}} : tensor<1x1024xf32>)
+//   CHECK-NOT:   linalg.generic
@@ -19,14 +19,17 @@
 #include "iree/compiler/Dialect/HAL/Target/LLVM/LinkerTool.h"
 #include "iree/compiler/Dialect/HAL/Target/LLVM/StaticLibraryGenerator.h"
 #include "iree/compiler/Dialect/HAL/Target/TargetRegistry.h"
+#include "iree/hal/local/executable_library.h"
 #include "llvm/Analysis/TargetTransformInfo.h"
 #include "llvm/Bitcode/BitcodeReader.h"
 #include "llvm/Bitcode/BitcodeWriter.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Module.h"
 #include "llvm/Linker/Linker.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/FormatVariadic.h"
 #include "llvm/Support/TargetSelect.h"
+#include "llvm/Transforms/Utils/Cloning.h"
 #include "mlir/Dialect/ArmNeon/ArmNeonDialect.h"
 #include "mlir/Dialect/LLVMIR/LLVMDialect.h"
 #include "mlir/Dialect/PDL/IR/PDL.h"
@@ -44,6 +47,11 @@ namespace HAL {
 static constexpr char kQueryFunctionName[] =
     "iree_hal_executable_library_query";
 
+static llvm::cl::opt<bool> clDumpLibraryIR(
+    "iree-llvm-dump-library-ir", llvm::cl::init(false),
+    llvm::cl::desc("Dump the LLVM IR of each executable library (including "
+                   "its query function) before builtins are linked in"));
+
 static llvm::Optional<FileLineColLoc> findFirstFileLoc(Location baseLoc) {
   if (auto loc = baseLoc.dyn_cast<FusedLoc>()) {
     for (auto &childLoc : loc.getLocations()) {
@@ -106,6 +114,59 @@ static LogicalResult appendDebugDatabase(std::vector<int8_t> &baseFile,
   return success();
 }
 
+// A CPU feature level that dispatch function variants may be specialized for.
+struct CPUVariantLevel {
+  // Name as specified with -iree-llvm-target-cpu-variants.
+  StringRef name;
+  // LLVM target features enabled in addition to the baseline target features.
+  StringRef features;
+  // IREE_HAL_PROCESSOR_DATA0_* bits required in
+  // iree_hal_processor_v0_t::data[0].
+  uint64_t processorBits;
+};
+
+// Returns the CPU feature level with the given |name| for |targetTriple|.
+static Optional<CPUVariantLevel> lookupCPUVariantLevel(
+    const llvm::Triple &targetTriple, StringRef name) {
+  static const uint64_t kX86_64AVX2 = IREE_HAL_PROCESSOR_DATA0_X86_64_AVX |
+                                     IREE_HAL_PROCESSOR_DATA0_X86_64_AVX2 |
+                                     IREE_HAL_PROCESSOR_DATA0_X86_64_FMA |
+                                     IREE_HAL_PROCESSOR_DATA0_X86_64_F16C;
+  static const uint64_t kX86_64AVX512 =
+      kX86_64AVX2 | IREE_HAL_PROCESSOR_DATA0_X86_64_AVX512F |
+      IREE_HAL_PROCESSOR_DATA0_X86_64_AVX512CD |
+      IREE_HAL_PROCESSOR_DATA0_X86_64_AVX512BW |
+      IREE_HAL_PROCESSOR_DATA0_X86_64_AVX512DQ |
+      IREE_HAL_PROCESSOR_DATA0_X86_64_AVX512VL;
+  static const CPUVariantLevel kX86_64Levels[] = {
+      {"avx2", "+avx,+avx2,+fma,+f16c", kX86_64AVX2},
+      {"avx512",
+       "+avx,+avx2,+fma,+f16c,+avx512f,+avx512cd,+avx512bw,+avx512dq,"
+       "+avx512vl",
+       kX86_64AVX512},
+      {"avx512vnni",
+       "+avx,+avx2,+fma,+f16c,+avx512f,+avx512cd,+avx512bw,+avx512dq,"
+       "+avx512vl,+avx512vnni",
+       kX86_64AVX512 | IREE_HAL_PROCESSOR_DATA0_X86_64_AVX512VNNI},
+  };
+  static const CPUVariantLevel kARM_64Levels[] = {
+      {"dotprod", "+dotprod", IREE_HAL_PROCESSOR_DATA0_ARM_64_DOTPROD},
+      {"i8mm", "+dotprod,+i8mm",
+       IREE_HAL_PROCESSOR_DATA0_ARM_64_DOTPROD |
+           IREE_HAL_PROCESSOR_DATA0_ARM_64_I8MM},
+  };
+  ArrayRef<CPUVariantLevel> levels;
+  if (targetTriple.getArch() == llvm::Triple::x86_64) {
+    levels = kX86_64Levels;
+  } else if (targetTriple.isAArch64()) {
+    levels = kARM_64Levels;
+  }
+  for (auto &level : levels) {
+    if (level.name == name) return level;
+  }
+  return llvm::None;
+}
+
 // Verifies builtin bitcode is loaded correctly and appends it to |linker|.
 //
 // Example:
@@ -318,6 +379,34 @@ class LLVMAOTTargetBackend final : public TargetBackend {
                                llvmFunc);
     }
 
+    // Clone each entry point for each requested CPU feature level. The
+    // variants share the code generated for the baseline target and only
+    // differ in the features LLVM may use when lowering them; the query
+    // function picks the best variant the processor supports at load time.
+    for (auto &variantName : options_.targetCPUVariants) {
+      auto level = lookupCPUVariantLevel(targetTriple, variantName);
+      if (!level) {
+        return variantOp.emitError()
+               << "unsupported CPU variant '" << variantName
+               << "' for target triple '" << options_.targetTriple << "'";
+      }
+      std::string features = level->features.str();
+      if (!options_.targetCPUFeatures.empty()) {
+        features = options_.targetCPUFeatures + "," + features;
+      }
+      for (auto entryPointOp :
+           variantOp.getBlock().getOps<ExecutableEntryPointOp>()) {
+        auto *baseFunc = llvmModule->getFunction(entryPointOp.getName());
+        llvm::ValueToValueMapTy valueMap;
+        auto *variantFunc = llvm::CloneFunction(baseFunc, valueMap);
+        variantFunc->setName(baseFunc->getName() + "_" + variantName);
+        variantFunc->setDSOLocal(true);
+        variantFunc->addFnAttr("target-features", features);
+        libraryBuilder.addExportVariant(entryPointOp.getName(),
+                                        level->processorBits, variantFunc);
+      }
+    }
+
     auto queryFunctionName = std::string(kQueryFunctionName);
     if (options_.linkStatic) {
       // Static library query functions must be unique to support multiple
@@ -333,6 +422,10 @@ class LLVMAOTTargetBackend final : public TargetBackend {
         llvm::GlobalValue::LinkageTypes::ExternalLinkage);
     queryLibraryFunc->setDSOLocal(false);
 
+    if (clDumpLibraryIR) {
+      llvmModule->print(llvm::dbgs(), nullptr);
+    }
+
     // If linking dynamically, find a suitable linker tool and configure the
     // module with any options that tool requires.
     std::unique_ptr<LinkerTool> linkerTool;
@@ -701,6 +794,16 @@ class LLVMAOTTargetBackend final : public TargetBackend {
     addConfig("cpu_features",
               StringAttr::get(context, options_.targetCPUFeatures));
 
+    // Set the memory hierarchy and core count used to size tiles, if known.
+    auto addSizeConfig = [&](StringRef name, int64_t value) {
+      if (value <= 0) return;
+      addConfig(name, IntegerAttr::get(IndexType::get(context), value));
+    };
+    addSizeConfig("l1_cache_size", options_.l1CacheSize);
+    addSizeConfig("l2_cache_size", options_.l2CacheSize);
+    addSizeConfig("l3_cache_size", options_.l3CacheSize);
+    addSizeConfig("num_cores", options_.numCores);
+
     return IREE::HAL::ExecutableTargetAttr::get(
         context, StringAttr::get(context, "llvm"),
         StringAttr::get(context, format), DictionaryAttr::get(context, config));
@@ -77,6 +77,14 @@ LLVMTargetOptions getLLVMTargetOptionsFromFlags() {
                      "host native CPU"),
       llvm::cl::init(""));
 
+  static llvm::cl::list<std::string> clTargetCPUVariants(
+      "iree-llvm-target-cpu-variants",
+      llvm::cl::desc("Additional CPU feature levels to emit dispatch function "
+                     "variants for that are selected at runtime based on the "
+                     "processor features available (x86_64: avx2, avx512, "
+                     "avx512vnni; aarch64: dotprod, i8mm)"),
+      llvm::cl::CommaSeparated);
+
   static llvm::cl::opt<bool> llvmLoopInterleaving(
       "iree-llvm-loop-interleaving", llvm::cl::init(false),
       llvm::cl::desc("Enable LLVM loop interleaving opt"));
@@ -98,6 +106,33 @@ LLVMTargetOptions getLLVMTargetOptionsFromFlags() {
   if (clTargetCPUFeatures != "host") {
     targetOptions.targetCPUFeatures = clTargetCPUFeatures;
   }
+  targetOptions.targetCPUVariants.assign(clTargetCPUVariants.begin(),
+                                         clTargetCPUVariants.end());
+
+  static llvm::cl::opt<int64_t> clTargetL1CacheSize(
+      "iree-llvm-target-l1-cache-size",
+      llvm::cl::desc("Per-core L1 data cache size of the target CPU in bytes "
+                     "used to size tiles; 0 if unknown"),
+      llvm::cl::init(targetOptions.l1CacheSize));
+  static llvm::cl::opt<int64_t> clTargetL2CacheSize(
+      "iree-llvm-target-l2-cache-size",
+      llvm::cl::desc("Per-core L2 cache size of the target CPU in bytes used "
+                     "to size tiles; 0 if unknown"),
+      llvm::cl::init(targetOptions.l2CacheSize));
+  static llvm::cl::opt<int64_t> clTargetL3CacheSize(
+      "iree-llvm-target-l3-cache-size",
+      llvm::cl::desc("Shared L3 cache size of the target CPU in bytes used to "
+                     "size tiles; 0 if unknown"),
+      llvm::cl::init(targetOptions.l3CacheSize));
+  static llvm::cl::opt<int64_t> clTargetNumCores(
+      "iree-llvm-target-num-cores",
+      llvm::cl::desc("Number of cores dispatches are distributed across on the "
+                     "target CPU; 0 if unknown"),
+      llvm::cl::init(targetOptions.numCores));
+  targetOptions.l1CacheSize = clTargetL1CacheSize;
+  targetOptions.l2CacheSize = clTargetL2CacheSize;
+  targetOptions.l3CacheSize = clTargetL3CacheSize;
+  targetOptions.numCores = clTargetNumCores;
 
   // LLVM opt options.
   targetOptions.pipelineTuningOptions.LoopInterleaving = llvmLoopInterleaving;
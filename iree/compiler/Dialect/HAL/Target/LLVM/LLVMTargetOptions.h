@@ -7,6 +7,9 @@
 #ifndef IREE_COMPILER_DIALECT_HAL_TARGET_LLVM_LLVMTARGETOPTIONS_H_
 #define IREE_COMPILER_DIALECT_HAL_TARGET_LLVM_LLVMTARGETOPTIONS_H_
 
+#include <string>
+#include <vector>
+
 #include "llvm/Passes/PassBuilder.h"
 #include "llvm/Target/TargetOptions.h"
 
@@ -28,6 +31,20 @@ struct LLVMTargetOptions {
   std::string targetCPU;
   std::string targetCPUFeatures;
 
+  // Additional CPU feature levels (such as `avx2` or `avx512`) to emit
+  // specialized variants of each dispatch function for. The runtime selects
+  // the most specialized variant supported by the processor when loading the
+  // executable and falls back to the baseline targetCPUFeatures otherwise.
+  std::vector<std::string> targetCPUVariants;
+
+  // Memory hierarchy and parallelism of the target processor used by codegen
+  // to size tiles. Cache sizes are in bytes (per core for L1/L2 and shared for
+  // L3) and 0 indicates the value is unknown.
+  int64_t l1CacheSize = 0;
+  int64_t l2CacheSize = 0;
+  int64_t l3CacheSize = 0;
+  int64_t numCores = 0;
+
   llvm::PipelineTuningOptions pipelineTuningOptions;
   llvm::OptimizationLevel optLevel;
   llvm::TargetOptions options;
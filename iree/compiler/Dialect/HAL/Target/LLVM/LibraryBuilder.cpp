@@ -6,7 +6,9 @@
 
 #include "iree/compiler/Dialect/HAL/Target/LLVM/LibraryBuilder.h"
 
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/IR/IRBuilder.h"
+#include "llvm/Support/MathExtras.h"
 
 // =============================================================================
 //
@@ -279,11 +281,65 @@ llvm::Function *LibraryBuilder::build(StringRef queryFuncName) {
   // NOTE: today there is just one version so this is rather simple:
   //   return max_version == 0 ? &library : NULL;
   auto *v0 = buildLibraryV0((queryFuncName + "_v0").str());
+  llvm::Value *library =
+      builder.CreatePointerCast(v0, libraryHeaderType->getPointerTo());
+
+  // Select the most specialized library variant supported by the processor
+  // the library is being loaded on:
+  //   data0 = environment ? environment->processor.data[0] : 0;
+  //   library = (data0 & bits) == bits ? &variant : library;
+  // Variants are checked in order of increasing specialization such that the
+  // last one matching wins.
+  if (!variants.empty()) {
+    auto *i64Type = llvm::IntegerType::getInt64Ty(context);
+    auto *environment = func->getArg(1);
+    auto *hasEnvironmentBlock =
+        llvm::BasicBlock::Create(context, "has_environment", func);
+    auto *selectBlock = llvm::BasicBlock::Create(context, "select", func);
+    builder.CreateCondBr(builder.CreateIsNull(environment), selectBlock,
+                         hasEnvironmentBlock);
+    builder.SetInsertPoint(hasEnvironmentBlock);
+    // &environment->processor.data[0]
+    auto *data0Ptr = builder.CreateInBoundsGEP(
+        makeEnvironmentType(context), environment,
+        ArrayRef<llvm::Value *>{
+            builder.getInt32(0),
+            builder.getInt32(3),  // processor
+            builder.getInt32(0),  // data
+            builder.getInt32(0),
+        });
+    auto *loadedData0 = builder.CreateLoad(i64Type, data0Ptr);
+    builder.CreateBr(selectBlock);
+    builder.SetInsertPoint(selectBlock);
+    auto *data0 = builder.CreatePHI(i64Type, 2);
+    data0->addIncoming(llvm::ConstantInt::get(i64Type, 0), entryBlock);
+    data0->addIncoming(loadedData0, hasEnvironmentBlock);
+
+    SmallVector<const Variant *> sortedVariants;
+    for (auto &variant : variants) sortedVariants.push_back(&variant);
+    llvm::stable_sort(sortedVariants, [](const Variant *a, const Variant *b) {
+      return llvm::countPopulation(a->processorBits) <
+             llvm::countPopulation(b->processorBits);
+    });
+    for (auto *variant : sortedVariants) {
+      auto *variantLibrary = buildLibraryV0(
+          (queryFuncName + "_v0_" + llvm::utohexstr(variant->processorBits))
+              .str(),
+          variant);
+      auto *bits = llvm::ConstantInt::get(i64Type, variant->processorBits);
+      library = builder.CreateSelect(
+          builder.CreateICmpEQ(builder.CreateAnd(data0, bits), bits),
+          builder.CreatePointerCast(variantLibrary,
+                                    libraryHeaderType->getPointerTo()),
+          library);
+    }
+  }
+
   builder.CreateRet(builder.CreateSelect(
       builder.CreateICmpEQ(func->getArg(0),
                            llvm::ConstantInt::get(
                                i32Type, static_cast<int64_t>(Version::V_0_1))),
-      builder.CreatePointerCast(v0, libraryHeaderType->getPointerTo()),
+      library,
       llvm::ConstantPointerNull::get(libraryHeaderType->getPointerTo())));
 
   return func;
@@ -329,7 +385,7 @@ llvm::Constant *LibraryBuilder::buildLibraryV0ImportTable(
 }
 
 llvm::Constant *LibraryBuilder::buildLibraryV0ExportTable(
-    std::string libraryName) {
+    std::string libraryName, const Variant *variant) {
   auto &context = module->getContext();
   auto *exportTableType = makeExportTableType(context);
   auto *dispatchFunctionType = makeDispatchFunctionType(context);
@@ -342,7 +398,12 @@ llvm::Constant *LibraryBuilder::buildLibraryV0ExportTable(
   // iree_hal_executable_export_table_v0_t::ptrs
   SmallVector<llvm::Constant *, 4> exportPtrValues;
   for (auto dispatch : exports) {
-    exportPtrValues.push_back(dispatch.func);
+    llvm::Function *func = dispatch.func;
+    if (variant) {
+      auto it = variant->funcs.find(dispatch.name);
+      if (it != variant->funcs.end()) func = it->second;
+    }
+    exportPtrValues.push_back(func);
   }
   auto *exportPtrsType = llvm::ArrayType::get(
       dispatchFunctionType->getPointerTo(), exportPtrValues.size());
@@ -457,7 +518,8 @@ llvm::Constant *LibraryBuilder::buildLibraryV0ConstantTable(
                          });
 }
 
-llvm::Constant *LibraryBuilder::buildLibraryV0(std::string libraryName) {
+llvm::Constant *LibraryBuilder::buildLibraryV0(std::string libraryName,
+                                               const Variant *variant) {
   auto &context = module->getContext();
   auto *libraryHeaderType = makeLibraryHeaderType(context);
   auto *libraryType = makeLibraryType(libraryHeaderType);
@@ -490,17 +552,18 @@ llvm::Constant *LibraryBuilder::buildLibraryV0(std::string libraryName) {
   auto *library = new llvm::GlobalVariable(
       *module, libraryType, /*isConstant=*/true,
       llvm::GlobalVariable::PrivateLinkage,
-      llvm::ConstantStruct::get(libraryType,
-                                {
-                                    // header=
-                                    libraryHeader,
-                                    // imports=
-                                    buildLibraryV0ImportTable(libraryName),
-                                    // exports=
-                                    buildLibraryV0ExportTable(libraryName),
-                                    // constants=
-                                    buildLibraryV0ConstantTable(libraryName),
-                                }),
+      llvm::ConstantStruct::get(
+          libraryType,
+          {
+              // header=
+              libraryHeader,
+              // imports=
+              buildLibraryV0ImportTable(libraryName),
+              // exports=
+              buildLibraryV0ExportTable(libraryName, variant),
+              // constants=
+              buildLibraryV0ConstantTable(libraryName),
+          }),
       /*Name=*/libraryName);
   // TODO(benvanik): force alignment (8? natural pointer width?)
 
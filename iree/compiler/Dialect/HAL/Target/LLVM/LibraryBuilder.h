@@ -11,6 +11,8 @@
 #include <string>
 
 #include "iree/compiler/Dialect/HAL/Target/LLVM/LLVMTargetOptions.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/Triple.h"
 #include "llvm/IR/Module.h"
 #include "mlir/Support/LogicalResult.h"
@@ -117,6 +119,24 @@ class LibraryBuilder {
     exports.push_back({name.str(), tag.str(), attrs, func});
   }
 
+  // Defines a variant of the entry point named |name| implemented by |func|
+  // that requires all |processorBits| to be set in the runtime
+  // `iree_hal_processor_v0_t::data[0]` field. One library is emitted per unique
+  // set of bits and the query function selects the most specialized library
+  // supported by the processor. Exports without a variant for a given set of
+  // bits use their base implementation from addExport.
+  void addExportVariant(StringRef name, uint64_t processorBits,
+                        llvm::Function *func) {
+    auto it = llvm::find_if(variants, [&](const Variant &variant) {
+      return variant.processorBits == processorBits;
+    });
+    if (it == variants.end()) {
+      variants.push_back({processorBits, {}});
+      it = std::prev(variants.end());
+    }
+    it->funcs[name] = func;
+  }
+
   // TODO(benvanik): addConstant for registering constant values.
 
   // Builds a `iree_hal_executable_library_query_fn_t` with the given
@@ -130,10 +150,15 @@ class LibraryBuilder {
   llvm::Function *build(StringRef queryFuncName);
 
  private:
+  struct Variant;
+
   // Builds and returns an iree_hal_executable_library_v0_t global constant.
-  llvm::Constant *buildLibraryV0(std::string libraryName);
+  // When |variant| is provided its exports replace the base exports.
+  llvm::Constant *buildLibraryV0(std::string libraryName,
+                                 const Variant *variant = nullptr);
   llvm::Constant *buildLibraryV0ImportTable(std::string libraryName);
-  llvm::Constant *buildLibraryV0ExportTable(std::string libraryName);
+  llvm::Constant *buildLibraryV0ExportTable(std::string libraryName,
+                                            const Variant *variant);
   llvm::Constant *buildLibraryV0ConstantTable(std::string libraryName);
 
   llvm::Module *module = nullptr;
@@ -156,6 +181,14 @@ class LibraryBuilder {
   };
   SmallVector<Dispatch> exports;
 
+  struct Variant {
+    // Bits required in iree_hal_processor_v0_t::data[0].
+    uint64_t processorBits = 0;
+    // Export name to the specialized function implementing it.
+    llvm::StringMap<llvm::Function *> funcs;
+  };
+  SmallVector<Variant> variants;
+
   size_t constantCount = 0;
 };
 
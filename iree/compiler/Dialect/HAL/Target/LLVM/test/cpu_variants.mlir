@@ -0,0 +1,72 @@
+// RUN: iree-opt -iree-stream-transformation-pipeline -iree-hal-transformation-pipeline -iree-llvm-target-triple=x86_64-unknown-unknown-eabi-elf -iree-llvm-target-cpu-variants=avx512,avx2 -iree-llvm-dump-library-ir %s 2>&1 | FileCheck %s
+
+// Tests that each requested CPU variant gets its own library with the entry
+// points retargeted to the variant features and that the query function
+// selects the most specialized library the processor supports.
+
+module attributes {
+  hal.device.targets = [
+    #hal.device.target<"dylib", {
+      executable_targets = [
+        #hal.executable.target<"llvm", "embedded-elf-x86_64">
+      ]
+    }>
+  ]
+} {
+
+stream.executable public @add_dispatch_0 {
+  stream.executable.export @add_dispatch_0
+  builtin.module  {
+    func.func @add_dispatch_0(%arg0_binding: !stream.binding, %arg1_binding: !stream.binding, %arg2_binding: !stream.binding) {
+      %c0 = arith.constant 0 : index
+      %arg0 = stream.binding.subspan %arg0_binding[%c0] : !stream.binding -> !flow.dispatch.tensor<readonly:16xf32>
+      %arg1 = stream.binding.subspan %arg1_binding[%c0] : !stream.binding -> !flow.dispatch.tensor<readonly:16xf32>
+      %arg2 = stream.binding.subspan %arg2_binding[%c0] : !stream.binding -> !flow.dispatch.tensor<writeonly:16xf32>
+      %0 = linalg.init_tensor [16] : tensor<16xf32>
+      %1 = flow.dispatch.tensor.load %arg0, offsets=[0], sizes=[16], strides=[1] : !flow.dispatch.tensor<readonly:16xf32> -> tensor<16xf32>
+      %2 = flow.dispatch.tensor.load %arg1, offsets=[0], sizes=[16], strides=[1] : !flow.dispatch.tensor<readonly:16xf32> -> tensor<16xf32>
+      %3 = linalg.generic {indexing_maps = [affine_map<(d0) -> (d0)>, affine_map<(d0) -> (d0)>, affine_map<(d0) -> (d0)>], iterator_types = ["parallel"]} ins(%1, %2 : tensor<16xf32>, tensor<16xf32>) outs(%0 : tensor<16xf32>) {
+      ^bb0(%arg3: f32, %arg4: f32, %arg5: f32):  // no predecessors
+        %4 = arith.addf %arg3, %arg4 : f32
+        linalg.yield %4 : f32
+      } -> tensor<16xf32>
+      flow.dispatch.tensor.store %3, %arg2, offsets=[0], sizes=[16], strides=[1] : tensor<16xf32> -> !flow.dispatch.tensor<writeonly:16xf32>
+      return
+    }
+  }
+}
+
+}
+
+// The baseline library exports the original entry point and each variant
+// library (named after its IREE_HAL_PROCESSOR_DATA0_* bits) exports its clone.
+// CHECK-DAG: @iree_hal_executable_library_query_v0_funcs = private constant {{.+}} @add_dispatch_0]
+// CHECK-DAG: @iree_hal_executable_library_query_v0_1E_funcs = private constant {{.+}} @add_dispatch_0_avx2]
+// CHECK-DAG: @iree_hal_executable_library_query_v0_3FE_funcs = private constant {{.+}} @add_dispatch_0_avx512]
+
+// CHECK: define {{.*}}@add_dispatch_0_avx512({{.+}}) #[[AVX512_ATTRS:[0-9]+]]
+// CHECK: define {{.*}}@add_dispatch_0_avx2({{.+}}) #[[AVX2_ATTRS:[0-9]+]]
+
+// Variants are tested from least to most specialized so the last match wins:
+// AVX|AVX2|FMA|F16C = 0x1E and AVX2 bits|AVX512F|CD|BW|DQ|VL = 0x3FE.
+// CHECK: define {{.*}}@iree_hal_executable_library_query(i32 %[[VERSION:[0-9]+]], %iree_hal_executable_environment_v0_t* %[[ENV:[0-9]+]])
+// CHECK: entry:
+// CHECK:   %[[NO_ENV:.+]] = icmp eq %iree_hal_executable_environment_v0_t* %[[ENV]], null
+// CHECK:   br i1 %[[NO_ENV]], label %select, label %has_environment
+// CHECK: has_environment:
+// CHECK:   %[[DATA0_PTR:.+]] = getelementptr inbounds %iree_hal_executable_environment_v0_t, %iree_hal_executable_environment_v0_t* %[[ENV]], i32 0, i32 3, i32 0, i32 0
+// CHECK:   %[[LOADED_DATA0:.+]] = load i64, i64* %[[DATA0_PTR]]
+// CHECK: select:
+// CHECK:   %[[DATA0:.+]] = phi i64 [ 0, %entry ], [ %[[LOADED_DATA0]], %has_environment ]
+// CHECK:   %[[AVX2_MASKED:.+]] = and i64 %[[DATA0]], 30
+// CHECK:   %[[HAS_AVX2:.+]] = icmp eq i64 %[[AVX2_MASKED]], 30
+// CHECK:   %[[AVX2_LIBRARY:.+]] = select i1 %[[HAS_AVX2]], {{.+}}@iree_hal_executable_library_query_v0_1E{{.+}}@iree_hal_executable_library_query_v0 to
+// CHECK:   %[[AVX512_MASKED:.+]] = and i64 %[[DATA0]], 1022
+// CHECK:   %[[HAS_AVX512:.+]] = icmp eq i64 %[[AVX512_MASKED]], 1022
+// CHECK:   %[[LIBRARY:.+]] = select i1 %[[HAS_AVX512]], {{.+}}@iree_hal_executable_library_query_v0_3FE{{.+}}, {{.+}} %[[AVX2_LIBRARY]]
+// CHECK:   %[[IS_V0:.+]] = icmp eq i32 %[[VERSION]], 1
+// CHECK:   %[[RESULT:.+]] = select i1 %[[IS_V0]], {{.+}} %[[LIBRARY]], {{.+}} null
+// CHECK:   ret {{.+}} %[[RESULT]]
+
+// CHECK-DAG: attributes #[[AVX512_ATTRS]] = {{.+}}"target-features"="{{.*}}+avx512f,+avx512cd,+avx512bw,+avx512dq,+avx512vl"
+// CHECK-DAG: attributes #[[AVX2_ATTRS]] = {{.+}}"target-features"="{{.*}}+avx,+avx2,+fma,+f16c"
@@ -0,0 +1,161 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/compiler/Dialect/HAL/IR/HALDialect.h"
+#include "iree/compiler/Dialect/HAL/IR/HALOps.h"
+#include "iree/compiler/Dialect/HAL/Transforms/Passes.h"
+#include "iree/compiler/Utils/EquivalenceUtils.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/Hashing.h"
+#include "llvm/Support/Debug.h"
+#include "mlir/IR/Attributes.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/BuiltinTypes.h"
+#include "mlir/Pass/Pass.h"
+
+#define DEBUG_TYPE "iree-hal-deduplicate-executables"
+
+namespace mlir {
+namespace iree_compiler {
+namespace IREE {
+namespace HAL {
+namespace {
+
+// Replaces all host references to executables and their entry points using
+// the given symbol |replacements|.
+static void replaceExecutableUses(
+    mlir::ModuleOp moduleOp,
+    const DenseMap<Attribute, Attribute> &replacements) {
+  for (auto funcLikeOp : moduleOp.getOps<FunctionOpInterface>()) {
+    funcLikeOp.walk([&](Operation *op) {
+      if (auto dispatchOp =
+              dyn_cast<IREE::HAL::CommandBufferDispatchSymbolOp>(op)) {
+        auto it = replacements.find(dispatchOp.entry_point());
+        if (it != replacements.end()) {
+          dispatchOp.entry_pointAttr(it->second.cast<SymbolRefAttr>());
+        }
+      } else if (auto dispatchOp = dyn_cast<
+                     IREE::HAL::CommandBufferDispatchIndirectSymbolOp>(op)) {
+        auto it = replacements.find(dispatchOp.entry_point());
+        if (it != replacements.end()) {
+          dispatchOp.entry_pointAttr(it->second.cast<SymbolRefAttr>());
+        }
+      } else if (auto lookupOp = dyn_cast<IREE::HAL::ExecutableLookupOp>(op)) {
+        auto it = replacements.find(lookupOp.executableAttr());
+        if (it != replacements.end()) {
+          lookupOp.executableAttr(it->second.cast<FlatSymbolRefAttr>());
+        }
+      }
+    });
+  }
+}
+
+// Records the replacements required to redirect all uses of
+// |duplicateExecutableOp| to the equivalent |referenceExecutableOp|.
+// Equivalent executables define their variants and entry points in the same
+// order.
+static void recordReplacements(
+    IREE::HAL::ExecutableOp duplicateExecutableOp,
+    IREE::HAL::ExecutableOp referenceExecutableOp,
+    DenseMap<Attribute, Attribute> &replacements) {
+  auto *context = duplicateExecutableOp.getContext();
+  replacements[FlatSymbolRefAttr::get(duplicateExecutableOp)] =
+      FlatSymbolRefAttr::get(referenceExecutableOp);
+  for (auto variantOpPair : llvm::zip(
+           duplicateExecutableOp.getOps<IREE::HAL::ExecutableVariantOp>(),
+           referenceExecutableOp.getOps<IREE::HAL::ExecutableVariantOp>())) {
+    auto duplicateVariantOp = std::get<0>(variantOpPair);
+    auto referenceVariantOp = std::get<1>(variantOpPair);
+    for (auto entryPointOpPair : llvm::zip(
+             duplicateVariantOp.getOps<IREE::HAL::ExecutableEntryPointOp>(),
+             referenceVariantOp.getOps<IREE::HAL::ExecutableEntryPointOp>())) {
+      auto oldSymbolRefAttr = SymbolRefAttr::get(
+          context, duplicateExecutableOp.getName(),
+          {SymbolRefAttr::get(duplicateVariantOp),
+           SymbolRefAttr::get(std::get<0>(entryPointOpPair))});
+      auto newSymbolRefAttr = SymbolRefAttr::get(
+          context, referenceExecutableOp.getName(),
+          {SymbolRefAttr::get(referenceVariantOp),
+           SymbolRefAttr::get(std::get<1>(entryPointOpPair))});
+      replacements[oldSymbolRefAttr] = newSymbolRefAttr;
+    }
+  }
+}
+
+}  // namespace
+
+// Deduplicates hal.executables after translation. Distinct flow executables
+// (differing in constants, fusion decisions, or the shapes that were
+// specialized away) often converge once lowered to a particular target and this
+// catches what the flow-level deduplication cannot see. Executables are only
+// merged if all of their variants are equivalent.
+class DeduplicateExecutablesPass
+    : public PassWrapper<DeduplicateExecutablesPass, OperationPass<ModuleOp>> {
+ public:
+  StringRef getArgument() const override {
+    return "iree-hal-deduplicate-executables";
+  }
+
+  StringRef getDescription() const override {
+    return "Deduplicates hal.executable ops with equivalent variants";
+  }
+
+  void getDependentDialects(DialectRegistry &registry) const override {
+    registry.insert<IREE::HAL::HALDialect>();
+  }
+
+  void runOnOperation() override {
+    auto moduleOp = getOperation();
+    auto executableOps =
+        llvm::to_vector<8>(moduleOp.getOps<IREE::HAL::ExecutableOp>());
+    if (executableOps.size() <= 1) return;
+
+    // For each executable, find the first executable which it is equivalent to.
+    // Executables are bucketed by their structural hash so that we only need
+    // to perform the full comparison against those that may be equivalent.
+    SmallVector<IREE::HAL::ExecutableOp> duplicateExecutableOps;
+    DenseMap<Attribute, Attribute> replacements;
+    DenseMap<llvm::hash_code, SmallVector<IREE::HAL::ExecutableOp>>
+        uniqueExecutableOps;
+    for (auto executableOp : executableOps) {
+      auto &bucket = uniqueExecutableOps[computeStructuralHash(
+          *executableOp.getOperation())];
+      auto referenceIt =
+          llvm::find_if(bucket, [&](IREE::HAL::ExecutableOp referenceOp) {
+            return isStructurallyEquivalentTo(*executableOp.getOperation(),
+                                              *referenceOp.getOperation());
+          });
+      if (referenceIt == bucket.end()) {
+        bucket.push_back(executableOp);
+        continue;
+      }
+      LLVM_DEBUG(llvm::dbgs() << "Deduplicating " << executableOp.getName()
+                              << " into " << referenceIt->getName() << "\n");
+      recordReplacements(executableOp, *referenceIt, replacements);
+      duplicateExecutableOps.push_back(executableOp);
+    }
+    if (duplicateExecutableOps.empty()) return;
+
+    replaceExecutableUses(moduleOp, replacements);
+
+    // Remove the duplicate executables now that they are no longer referenced.
+    for (auto executableOp : duplicateExecutableOps) {
+      executableOp.erase();
+    }
+  }
+};
+
+std::unique_ptr<OperationPass<mlir::ModuleOp>>
+createDeduplicateExecutablesPass() {
+  return std::make_unique<DeduplicateExecutablesPass>();
+}
+
+static PassRegistration<DeduplicateExecutablesPass> pass;
+
+}  // namespace HAL
+}  // namespace IREE
+}  // namespace iree_compiler
+}  // namespace mlir
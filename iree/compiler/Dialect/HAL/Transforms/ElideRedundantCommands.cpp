@@ -4,18 +4,23 @@
 // See https://llvm.org/LICENSE.txt for license information.
 // SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
 
+#include <algorithm>
 #include <utility>
 
 #include "iree/compiler/Dialect/HAL/IR/HALDialect.h"
 #include "iree/compiler/Dialect/HAL/IR/HALOps.h"
 #include "iree/compiler/Dialect/HAL/Transforms/Passes.h"
 #include "llvm/ADT/BitVector.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/PostOrderIterator.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
 #include "mlir/IR/Attributes.h"
 #include "mlir/IR/Builders.h"
 #include "mlir/IR/BuiltinTypes.h"
 #include "mlir/IR/Diagnostics.h"
 #include "mlir/IR/Matchers.h"
+#include "mlir/IR/RegionGraphTraits.h"
+#include "mlir/Interfaces/ControlFlowInterfaces.h"
 #include "mlir/Pass/Pass.h"
 
 namespace mlir {
@@ -28,12 +33,25 @@ struct DescriptorState {
   Value buffer;
   Value offset;
   Value length;
+
+  bool operator==(const DescriptorState &other) const {
+    return buffer == other.buffer && offset == other.offset &&
+           length == other.length;
+  }
+  bool operator!=(const DescriptorState &other) const {
+    return !(*this == other);
+  }
 };
 
 struct DescriptorSetState {
   Value executableLayout;
   SmallVector<DescriptorState, 32> descriptors;
 
+  // Descriptor set and dynamic offsets bound with bind_descriptor_set, if any.
+  // Mutually exclusive with pushed descriptors.
+  Value boundDescriptorSet;
+  SmallVector<Value, 4> boundDynamicOffsets;
+
   DescriptorState &getDescriptor(int64_t index) {
     if (index >= descriptors.size()) {
       descriptors.resize(index + 1);
@@ -44,6 +62,18 @@ struct DescriptorSetState {
   void clear() {
     executableLayout = {};
     descriptors.clear();
+    boundDescriptorSet = {};
+    boundDynamicOffsets.clear();
+  }
+
+  bool operator==(const DescriptorSetState &other) const {
+    return executableLayout == other.executableLayout &&
+           descriptors == other.descriptors &&
+           boundDescriptorSet == other.boundDescriptorSet &&
+           boundDynamicOffsets == other.boundDynamicOffsets;
+  }
+  bool operator!=(const DescriptorSetState &other) const {
+    return !(*this == other);
   }
 };
 
@@ -60,7 +90,7 @@ struct CommandBufferState {
   // Note that we assume no barriers by default, as the command buffer may have
   // been passed as a function/branch argument and we don't have visibility.
   // We need to use IPO to track that.
-  IREE::HAL::CommandBufferExecutionBarrierOp previousFullBarrier;
+  bool hasFullBarrier = false;
 
   Value &getPushConstant(int64_t index) {
     if (index >= pushConstants.size()) {
@@ -81,39 +111,127 @@ struct CommandBufferState {
     }
     return &descriptorSets[index];
   }
+
+  bool operator==(const CommandBufferState &other) const {
+    return pushConstantLayout == other.pushConstantLayout &&
+           pushConstants == other.pushConstants &&
+           descriptorSets == other.descriptorSets &&
+           hasFullBarrier == other.hasFullBarrier;
+  }
+  bool operator!=(const CommandBufferState &other) const {
+    return !(*this == other);
+  }
 };
 
+// State is keyed by the SSA value of each command buffer. Values not in the map
+// (or with a default state) have an unknown state and nothing is elided on
+// them. A command buffer passed as a successor operand is aliased by the block
+// argument it is passed to and must be invalidated whenever the alias is used.
 using CommandBufferStateMap = DenseMap<Value, CommandBufferState>;
 
 }  // namespace
 
+//===----------------------------------------------------------------------===//
+// State merging at control flow joins
+//===----------------------------------------------------------------------===//
+
+// Each intersection retains only the state in |lhs| that is identical in |rhs|
+// such that the result is valid along both control flow paths.
+
+static void intersectState(DescriptorSetState &lhs,
+                           const DescriptorSetState &rhs) {
+  if (lhs.executableLayout != rhs.executableLayout) {
+    lhs.clear();
+    return;
+  }
+  if (lhs.boundDescriptorSet != rhs.boundDescriptorSet ||
+      lhs.boundDynamicOffsets != rhs.boundDynamicOffsets) {
+    lhs.boundDescriptorSet = {};
+    lhs.boundDynamicOffsets.clear();
+  }
+  lhs.descriptors.resize(std::min(lhs.descriptors.size(),
+                                  rhs.descriptors.size()));
+  for (auto it : llvm::zip(lhs.descriptors, rhs.descriptors)) {
+    if (std::get<0>(it) != std::get<1>(it)) std::get<0>(it) = {};
+  }
+}
+
+static void intersectState(CommandBufferState &lhs,
+                           const CommandBufferState &rhs) {
+  if (lhs.pushConstantLayout != rhs.pushConstantLayout) {
+    lhs.pushConstantLayout = {};
+    lhs.pushConstants.clear();
+  } else {
+    lhs.pushConstants.resize(std::min(lhs.pushConstants.size(),
+                                      rhs.pushConstants.size()));
+    for (auto it : llvm::zip(lhs.pushConstants, rhs.pushConstants)) {
+      if (std::get<0>(it) != std::get<1>(it)) std::get<0>(it) = {};
+    }
+  }
+  lhs.descriptorSets.resize(std::min(lhs.descriptorSets.size(),
+                                     rhs.descriptorSets.size()));
+  for (auto it : llvm::zip(lhs.descriptorSets, rhs.descriptorSets)) {
+    intersectState(std::get<0>(it), std::get<1>(it));
+  }
+  lhs.hasFullBarrier = lhs.hasFullBarrier && rhs.hasFullBarrier;
+}
+
+static void intersectState(CommandBufferStateMap &lhs,
+                           const CommandBufferStateMap &rhs) {
+  SmallVector<Value> droppedCommandBuffers;
+  for (auto &it : lhs) {
+    auto rhsIt = rhs.find(it.first);
+    if (rhsIt == rhs.end()) {
+      droppedCommandBuffers.push_back(it.first);
+    } else {
+      intersectState(it.second, rhsIt->second);
+    }
+  }
+  for (auto commandBuffer : droppedCommandBuffers) lhs.erase(commandBuffer);
+}
+
+static bool isEqualState(const CommandBufferStateMap &lhs,
+                         const CommandBufferStateMap &rhs) {
+  if (lhs.size() != rhs.size()) return false;
+  for (auto &it : lhs) {
+    auto rhsIt = rhs.find(it.first);
+    if (rhsIt == rhs.end() || rhsIt->second != it.second) return false;
+  }
+  return true;
+}
+
+//===----------------------------------------------------------------------===//
+// Command processing
+//===----------------------------------------------------------------------===//
+
+// Each processOp updates |state| with the effects of |op| and, if |elide| is
+// set, removes the redundant portions of |op|. Analysis runs with |elide|
+// unset until the state at all block boundaries is known.
+
 static void processOp(IREE::HAL::CommandBufferExecutionBarrierOp op,
-                      CommandBufferState &state) {
-  if (state.previousFullBarrier) {
+                      CommandBufferState &state, bool elide) {
+  if (state.hasFullBarrier) {
     // We are following a full barrier - this is a no-op (issuing two barriers
     // doesn't make the device barrier any harder).
-    op.erase();
+    if (elide) op.erase();
     return;
   }
 
   // See if this is a full barrier. These are all we emit today so this simple
   // analysis can remain simple by pattern matching.
-  if (bitEnumContains(op.source_stage_mask(),
+  state.hasFullBarrier =
+      bitEnumContains(op.source_stage_mask(),
                       IREE::HAL::ExecutionStageBitfield::CommandRetire |
                           IREE::HAL::ExecutionStageBitfield::Transfer |
                           IREE::HAL::ExecutionStageBitfield::Dispatch) &&
       bitEnumContains(op.target_stage_mask(),
                       IREE::HAL::ExecutionStageBitfield::CommandRetire |
                           IREE::HAL::ExecutionStageBitfield::Transfer |
-                          IREE::HAL::ExecutionStageBitfield::Dispatch)) {
-    state.previousFullBarrier = op;
-  } else {
-    state.previousFullBarrier = {};
-  }
+                          IREE::HAL::ExecutionStageBitfield::Dispatch);
 }
 
 static LogicalResult processOp(IREE::HAL::CommandBufferPushConstantsOp op,
-                               CommandBufferState &state) {
+                               CommandBufferState &state, bool elide) {
   // Push constant state is only shared with the same layout.
   if (state.pushConstantLayout != op.executable_layout()) {
     state.pushConstantLayout = op.executable_layout();
@@ -133,7 +251,7 @@ static LogicalResult processOp(IREE::HAL::CommandBufferPushConstantsOp op,
       stateValue = value.value();
     }
   }
-  if (redundantIndices.none()) return success();  // no-op
+  if (!elide || redundantIndices.none()) return success();  // no-op
 
   // If all bits are set we can just kill the op.
   if (redundantIndices.all()) {
@@ -163,11 +281,14 @@ static LogicalResult processOp(IREE::HAL::CommandBufferPushConstantsOp op,
 }
 
 static LogicalResult processOp(IREE::HAL::CommandBufferPushDescriptorSetOp op,
-                               CommandBufferState &state) {
+                               CommandBufferState &state, bool elide) {
   auto *setState = state.getDescriptorSet(op.set());
   if (!setState) return failure();
 
-  bool isLayoutEqual = setState->executableLayout == op.executable_layout();
+  // Pushing replaces any previously bound descriptor set.
+  bool isLayoutEqual = setState->executableLayout == op.executable_layout() &&
+                       !setState->boundDescriptorSet;
+  if (!isLayoutEqual) setState->clear();
   setState->executableLayout = op.executable_layout();
 
   int64_t descriptorCount = op.binding_buffers().size();
@@ -194,7 +315,7 @@ static LogicalResult processOp(IREE::HAL::CommandBufferPushDescriptorSetOp op,
   }
 
   // If all bits are set we can just kill the op.
-  if (isLayoutEqual && redundantIndices.all()) {
+  if (elide && isLayoutEqual && redundantIndices.all()) {
     op.erase();
     return success();
   }
@@ -203,15 +324,206 @@ static LogicalResult processOp(IREE::HAL::CommandBufferPushDescriptorSetOp op,
 }
 
 static LogicalResult processOp(IREE::HAL::CommandBufferBindDescriptorSetOp op,
-                               CommandBufferState &state) {
-  // TODO(benvanik): descriptor set binding.
-  // For now we just nuke the state.
+                               CommandBufferState &state, bool elide) {
   auto *setState = state.getDescriptorSet(op.set());
   if (!setState) return failure();
+
+  // Rebinding the same descriptor set with the same offsets is a no-op.
+  if (setState->executableLayout == op.executable_layout() &&
+      setState->boundDescriptorSet == op.descriptor_set() &&
+      llvm::equal(setState->boundDynamicOffsets, op.dynamic_offsets())) {
+    if (elide) op.erase();
+    return success();
+  }
+
+  // Binding replaces any previously pushed descriptors.
   setState->clear();
+  setState->executableLayout = op.executable_layout();
+  setState->boundDescriptorSet = op.descriptor_set();
+  setState->boundDynamicOffsets = llvm::to_vector<4>(op.dynamic_offsets());
   return success();
 }
 
+// Processes all ops in |block| starting with the command buffer state in
+// |stateMap| and leaves |stateMap| with the state at the end of the block.
+// |aliasedCommandBuffers| are the command buffers in the region that may
+// refer to the same command buffer as another value: successor operands and
+// the block arguments they are passed to.
+static void processBlock(Block &block, CommandBufferStateMap &stateMap,
+                         const DenseSet<Value> &aliasedCommandBuffers,
+                         bool elide) {
+  auto invalidateState = [&](Value commandBuffer) {
+    stateMap[commandBuffer] = {};
+  };
+  auto invalidateAliases = [&](Value commandBuffer) {
+    for (auto aliasedCommandBuffer : aliasedCommandBuffers) {
+      if (aliasedCommandBuffer != commandBuffer) {
+        invalidateState(aliasedCommandBuffer);
+      }
+    }
+  };
+
+  // Block arguments may be a different command buffer on each entry and we
+  // don't track the state of the values passed to them.
+  for (auto arg : block.getArguments()) {
+    if (arg.getType().isa<IREE::HAL::CommandBufferType>()) {
+      invalidateState(arg);
+    }
+  }
+
+  auto resetCommandBufferBarrierBit = [&](Operation *op) {
+    assert(op->getNumOperands() > 0 && "must be a command buffer op");
+    auto commandBuffer = op->getOperand(0);
+    assert(commandBuffer.getType().isa<IREE::HAL::CommandBufferType>() &&
+           "operand 0 must be a command buffer");
+    stateMap[commandBuffer].hasFullBarrier = false;
+  };
+  for (auto &op : llvm::make_early_inc_range(block.getOperations())) {
+    if (!op.getDialect()) continue;
+    if (!aliasedCommandBuffers.empty()) {
+      // Any use of a command buffer may change the state of its aliases.
+      for (auto operand : op.getOperands()) {
+        if (aliasedCommandBuffers.contains(operand)) invalidateAliases(operand);
+      }
+    }
+    TypeSwitch<Operation *>(&op)
+        .Case([&](IREE::HAL::CommandBufferBeginOp op) {
+          invalidateState(op.command_buffer());
+        })
+        .Case([&](IREE::HAL::CommandBufferEndOp op) {
+          invalidateState(op.command_buffer());
+        })
+        .Case([&](IREE::HAL::CommandBufferExecutionBarrierOp op) {
+          processOp(op, stateMap[op.command_buffer()], elide);
+        })
+        .Case([&](IREE::HAL::CommandBufferPushConstantsOp op) {
+          resetCommandBufferBarrierBit(op);
+          if (failed(processOp(op, stateMap[op.command_buffer()], elide))) {
+            invalidateState(op.command_buffer());
+          }
+        })
+        .Case([&](IREE::HAL::CommandBufferPushDescriptorSetOp op) {
+          resetCommandBufferBarrierBit(op);
+          if (failed(processOp(op, stateMap[op.command_buffer()], elide))) {
+            invalidateState(op.command_buffer());
+          }
+        })
+        .Case([&](IREE::HAL::CommandBufferBindDescriptorSetOp op) {
+          resetCommandBufferBarrierBit(op);
+          if (failed(processOp(op, stateMap[op.command_buffer()], elide))) {
+            invalidateState(op.command_buffer());
+          }
+        })
+        .Case<IREE::HAL::CommandBufferDeviceOp,
+              IREE::HAL::CommandBufferBeginDebugGroupOp,
+              IREE::HAL::CommandBufferEndDebugGroupOp,
+              IREE::HAL::CommandBufferFillBufferOp,
+              IREE::HAL::CommandBufferCopyBufferOp,
+              IREE::HAL::CommandBufferDispatchSymbolOp,
+              IREE::HAL::CommandBufferDispatchOp,
+              IREE::HAL::CommandBufferDispatchIndirectSymbolOp,
+              IREE::HAL::CommandBufferDispatchIndirectOp>([&](Operation *op) {
+          // Ok - don't impact state.
+          resetCommandBufferBarrierBit(op);
+        })
+        .Case([&](BranchOpInterface op) {
+          // Command buffers passed to successors are aliased by the block
+          // arguments there and may be recorded into through them.
+          for (auto operand : op->getOperands()) {
+            if (operand.getType().isa<IREE::HAL::CommandBufferType>()) {
+              invalidateState(operand);
+            }
+          }
+        })
+        .Default([&](Operation *op) {
+          // Unknown op - discard the state of any command buffer it (or any
+          // op nested within it) uses. Calls and region ops (like scf.if)
+          // may record commands we don't analyze here while ops that don't
+          // reference a command buffer can't change its state.
+          op->walk([&](Operation *nestedOp) {
+            for (auto operand : nestedOp->getOperands()) {
+              if (operand.getType().isa<IREE::HAL::CommandBufferType>()) {
+                invalidateState(operand);
+              }
+            }
+          });
+        });
+  }
+}
+
+// Elides redundant commands in the CFG of |region| by propagating command
+// buffer state along all control flow edges. Blocks are iterated in reverse
+// post-order until the state at each block boundary reaches a fixed point
+// and only then are the redundant commands elided.
+static void elideRedundantCommands(Region &region) {
+  if (region.empty()) return;
+  SmallVector<Block *> blocks;
+  for (auto *block :
+       llvm::ReversePostOrderTraversal<Block *>(&region.front())) {
+    blocks.push_back(block);
+  }
+
+  DenseSet<Value> aliasedCommandBuffers;
+  for (auto branchOp : region.getOps<BranchOpInterface>()) {
+    for (unsigned successorIndex = 0;
+         successorIndex < branchOp->getNumSuccessors(); ++successorIndex) {
+      auto operandsOr = branchOp.getSuccessorOperands(successorIndex);
+      if (!operandsOr.hasValue()) continue;
+      auto *successor = branchOp->getSuccessor(successorIndex);
+      for (auto it :
+           llvm::zip(operandsOr.getValue(), successor->getArguments())) {
+        if (std::get<0>(it).getType().isa<IREE::HAL::CommandBufferType>()) {
+          aliasedCommandBuffers.insert(std::get<0>(it));
+          aliasedCommandBuffers.insert(std::get<1>(it));
+        }
+      }
+    }
+  }
+
+  // Returns the state on entry to |block| as the intersection of the states
+  // at the end of all predecessors. Predecessors not yet processed (along
+  // loop back edges) are optimistically skipped until the next iteration.
+  DenseMap<Block *, CommandBufferStateMap> exitStates;
+  auto computeEntryState = [&](Block *block) {
+    CommandBufferStateMap entryState;
+    bool hasState = false;
+    for (auto *predecessor : block->getPredecessors()) {
+      auto it = exitStates.find(predecessor);
+      if (it == exitStates.end()) continue;
+      if (!hasState) {
+        entryState = it->second;
+        hasState = true;
+      } else {
+        intersectState(entryState, it->second);
+      }
+    }
+    return entryState;
+  };
+
+  bool didChange = true;
+  while (didChange) {
+    didChange = false;
+    for (auto *block : blocks) {
+      auto stateMap = computeEntryState(block);
+      processBlock(*block, stateMap, aliasedCommandBuffers, /*elide=*/false);
+      auto it = exitStates.find(block);
+      if (it == exitStates.end() || !isEqualState(it->second, stateMap)) {
+        exitStates[block] = std::move(stateMap);
+        didChange = true;
+      }
+    }
+  }
+
+  // Elide using the final entry states. The states computed here match those
+  // from the analysis as elision never changes the command buffer state.
+  SmallVector<CommandBufferStateMap> entryStates;
+  for (auto *block : blocks) entryStates.push_back(computeEntryState(block));
+  for (auto it : llvm::zip(blocks, entryStates)) {
+    processBlock(*std::get<0>(it), std::get<1>(it), aliasedCommandBuffers,
+                 /*elide=*/true);
+  }
+}
+
 class ElideRedundantCommandsPass
     : public PassWrapper<ElideRedundantCommandsPass, OperationPass<void>> {
  public:
@@ -228,81 +540,16 @@ class ElideRedundantCommandsPass
   }
 
   void runOnOperation() override {
-    auto parentOp = getOperation();
-
-    // TODO(benvanik): intraprocedural at least; keep track of state at block
-    // boundaries. IPO would be nice but it (today) rarely happens that we
+    // Each region is analyzed independently starting from an unknown state.
+    // Command buffers passed across calls or into nested regions we don't
+    // analyze have their state discarded when used there.
+    // TODO(benvanik): IPO would be nice but it (today) rarely happens that we
     // pass command buffers across calls.
-    for (auto &region : parentOp->getRegions()) {
-      for (auto &block : region.getBlocks()) {
-        // State tracking for each command buffer found.
-        // Discard state on ops we don't currently analyze (because this is
-        // super basic - we really need to analyze them).
-        CommandBufferStateMap stateMap;
-        auto invalidateState = [&](Value commandBuffer) {
-          stateMap[commandBuffer] = {};
-        };
-        auto resetCommandBufferBarrierBit = [&](Operation *op) {
-          assert(op->getNumOperands() > 0 && "must be a command buffer op");
-          auto commandBuffer = op->getOperand(0);
-          assert(commandBuffer.getType().isa<IREE::HAL::CommandBufferType>() &&
-                 "operand 0 must be a command buffer");
-          stateMap[commandBuffer].previousFullBarrier = {};
-        };
-        for (auto &op : llvm::make_early_inc_range(block.getOperations())) {
-          if (!op.getDialect()) continue;
-          TypeSwitch<Operation *>(&op)
-              .Case([&](IREE::HAL::CommandBufferBeginOp op) {
-                invalidateState(op.command_buffer());
-              })
-              .Case([&](IREE::HAL::CommandBufferEndOp op) {
-                invalidateState(op.command_buffer());
-              })
-              .Case([&](IREE::HAL::CommandBufferExecutionBarrierOp op) {
-                processOp(op, stateMap[op.command_buffer()]);
-              })
-              .Case([&](IREE::HAL::CommandBufferPushConstantsOp op) {
-                resetCommandBufferBarrierBit(op);
-                if (failed(processOp(op, stateMap[op.command_buffer()]))) {
-                  invalidateState(op.command_buffer());
-                }
-              })
-              .Case([&](IREE::HAL::CommandBufferPushDescriptorSetOp op) {
-                resetCommandBufferBarrierBit(op);
-                if (failed(processOp(op, stateMap[op.command_buffer()]))) {
-                  invalidateState(op.command_buffer());
-                }
-              })
-              .Case([&](IREE::HAL::CommandBufferBindDescriptorSetOp op) {
-                resetCommandBufferBarrierBit(op);
-                if (failed(processOp(op, stateMap[op.command_buffer()]))) {
-                  invalidateState(op.command_buffer());
-                }
-              })
-              .Case<IREE::HAL::CommandBufferDeviceOp,
-                    IREE::HAL::CommandBufferBeginDebugGroupOp,
-                    IREE::HAL::CommandBufferEndDebugGroupOp,
-                    IREE::HAL::CommandBufferFillBufferOp,
-                    IREE::HAL::CommandBufferCopyBufferOp,
-                    IREE::HAL::CommandBufferDispatchSymbolOp,
-                    IREE::HAL::CommandBufferDispatchOp,
-                    IREE::HAL::CommandBufferDispatchIndirectSymbolOp,
-                    IREE::HAL::CommandBufferDispatchIndirectOp>(
-                  [&](Operation *op) {
-                    // Ok - don't impact state.
-                    resetCommandBufferBarrierBit(op);
-                  })
-              .Default([&](Operation *op) {
-                // Unknown op - discard state cache.
-                // This is to avoid correctness issues with region ops (like
-                // scf.if) that we don't analyze properly here. We could
-                // restrict this a bit by only discarding on use of the
-                // command buffer.
-                stateMap.clear();
-              });
-        }
+    getOperation()->walk([&](Operation *op) {
+      for (auto &region : op->getRegions()) {
+        elideRedundantCommands(region);
       }
-    }
+    });
   }
 };
 
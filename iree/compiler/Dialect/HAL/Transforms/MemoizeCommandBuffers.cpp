@@ -0,0 +1,351 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <string>
+#include <utility>
+
+#include "iree/compiler/Dialect/HAL/IR/HALDialect.h"
+#include "iree/compiler/Dialect/HAL/IR/HALOps.h"
+#include "iree/compiler/Dialect/HAL/Transforms/Passes.h"
+#include "iree/compiler/Dialect/Util/IR/UtilDialect.h"
+#include "iree/compiler/Dialect/Util/IR/UtilOps.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SetVector.h"
+#include "llvm/Support/Debug.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/IR/Attributes.h"
+#include "mlir/IR/BlockAndValueMapping.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/BuiltinTypes.h"
+#include "mlir/IR/SymbolTable.h"
+#include "mlir/Interfaces/SideEffectInterfaces.h"
+#include "mlir/Pass/Pass.h"
+
+#define DEBUG_TYPE "iree-hal-memoize-command-buffers"
+
+namespace mlir {
+namespace iree_compiler {
+namespace IREE {
+namespace HAL {
+namespace {
+
+//===----------------------------------------------------------------------===//
+// Recording analysis
+//===----------------------------------------------------------------------===//
+
+// A command buffer recording sequence from hal.command_buffer.create through
+// the matching hal.command_buffer.end within a single block.
+struct Recording {
+  IREE::HAL::CommandBufferCreateOp createOp;
+  // All ops in the block from the create through the end, inclusive.
+  SmallVector<Operation *> ops;
+  // Values used within the recording that are defined outside of it in the
+  // order they are first used.
+  SetVector<Value> capturedValues;
+};
+
+// Returns true if |value| has the same value on every invocation of the
+// function it is used in and can be rematerialized within an initializer.
+static bool isInvariantValue(Value value, SymbolTable &symbolTable) {
+  auto *definingOp = value.getDefiningOp();
+  if (!definingOp) return false;
+  if (definingOp->hasTrait<OpTrait::ConstantLike>()) return true;
+  if (isa<IREE::HAL::ExSharedDeviceOp>(definingOp)) return true;
+  if (auto loadOp = dyn_cast<IREE::Util::GlobalLoadOp>(definingOp)) {
+    auto globalOp = symbolTable.lookup<IREE::Util::GlobalOp>(loadOp.global());
+    return globalOp && !globalOp.isMutable();
+  }
+  return false;
+}
+
+// Returns true if |op| can be moved into the initializer recording
+// |commandBuffer|. Only command buffer ops and side-effect free ops are
+// allowed so that moving the recording doesn't change program behavior.
+static bool isRecordableOp(Operation *op, Value commandBuffer) {
+  if (llvm::is_contained(op->getOperands(), commandBuffer)) return true;
+  if (isa<IREE::HAL::DeviceSwitchOp>(op)) return true;
+  if (op->hasTrait<OpTrait::IsTerminator>()) return true;
+  return MemoryEffectOpInterface::hasNoEffect(op);
+}
+
+// Tries to form a memoizable recording starting at |createOp|.
+// Returns None if the recording uses any value that may change across
+// invocations or if any value besides the command buffer escapes.
+static Optional<Recording> tryFormRecording(
+    IREE::HAL::CommandBufferCreateOp createOp, SymbolTable &symbolTable) {
+  auto commandBuffer = createOp.result();
+  auto *block = createOp->getBlock();
+
+  // Scan forward for the end of the recording.
+  Recording recording;
+  recording.createOp = createOp;
+  bool foundEnd = false;
+  for (auto &op : llvm::make_range(createOp->getIterator(), block->end())) {
+    recording.ops.push_back(&op);
+    if (auto endOp = dyn_cast<IREE::HAL::CommandBufferEndOp>(op)) {
+      if (endOp.command_buffer() == commandBuffer) {
+        foundEnd = true;
+        break;
+      }
+    }
+  }
+  if (!foundEnd) return llvm::None;
+  llvm::SmallPtrSet<Operation *, 16> rangeOps(recording.ops.begin(),
+                                              recording.ops.end());
+  auto isInRange = [&](Operation *op) {
+    auto *ancestorOp = op ? block->findAncestorOpInBlock(*op) : nullptr;
+    return ancestorOp && rangeOps.contains(ancestorOp);
+  };
+
+  // Gather all captured values and ensure they are invariant.
+  for (auto *op : recording.ops) {
+    auto walkResult = op->walk([&](Operation *nestedOp) {
+      if (!isRecordableOp(nestedOp, commandBuffer)) {
+        return WalkResult::interrupt();
+      }
+      for (auto operand : nestedOp->getOperands()) {
+        auto *ownerOp = operand.isa<BlockArgument>()
+                            ? operand.getParentBlock()->getParentOp()
+                            : operand.getDefiningOp();
+        // Block arguments of regions nested within the range are internal
+        // but those of |block| itself are not.
+        bool isInternal = operand.isa<BlockArgument>()
+                              ? operand.getParentBlock() != block &&
+                                    isInRange(ownerOp)
+                              : isInRange(ownerOp);
+        if (isInternal) continue;
+        if (!isInvariantValue(operand, symbolTable)) {
+          return WalkResult::interrupt();
+        }
+        recording.capturedValues.insert(operand);
+      }
+      return WalkResult::advance();
+    });
+    if (walkResult.wasInterrupted()) return llvm::None;
+  }
+
+  // Ensure only the command buffer escapes and that it is only submitted.
+  for (auto *op : recording.ops) {
+    for (auto result : op->getResults()) {
+      for (auto *userOp : result.getUsers()) {
+        if (isInRange(userOp)) continue;
+        if (result == commandBuffer &&
+            isa<IREE::HAL::ExSubmitAndWaitOp>(userOp)) {
+          continue;
+        }
+        return llvm::None;
+      }
+    }
+  }
+
+  return recording;
+}
+
+//===----------------------------------------------------------------------===//
+// Recording deduplication
+//===----------------------------------------------------------------------===//
+
+// Returns true if |lhs| and |rhs| are structurally equivalent given the
+// existing value |mapping| from lhs to rhs. Locations are ignored.
+static bool isEquivalentOp(Operation *lhs, Operation *rhs,
+                           BlockAndValueMapping &mapping) {
+  if (lhs->getName() != rhs->getName() ||
+      lhs->getAttrDictionary() != rhs->getAttrDictionary() ||
+      lhs->getResultTypes() != rhs->getResultTypes() ||
+      lhs->getNumOperands() != rhs->getNumOperands() ||
+      lhs->getNumRegions() != rhs->getNumRegions()) {
+    return false;
+  }
+  for (auto it : llvm::zip(lhs->getOperands(), rhs->getOperands())) {
+    if (mapping.lookupOrNull(std::get<0>(it)) != std::get<1>(it)) return false;
+  }
+  mapping.map(lhs->getResults(), rhs->getResults());
+  for (auto regions : llvm::zip(lhs->getRegions(), rhs->getRegions())) {
+    auto &lhsRegion = std::get<0>(regions);
+    auto &rhsRegion = std::get<1>(regions);
+    if (lhsRegion.getBlocks().size() != rhsRegion.getBlocks().size()) {
+      return false;
+    }
+    for (auto blocks : llvm::zip(lhsRegion, rhsRegion)) {
+      auto &lhsBlock = std::get<0>(blocks);
+      auto &rhsBlock = std::get<1>(blocks);
+      if (lhsBlock.getArgumentTypes() != rhsBlock.getArgumentTypes() ||
+          lhsBlock.getOperations().size() != rhsBlock.getOperations().size()) {
+        return false;
+      }
+      mapping.map(lhsBlock.getArguments(), rhsBlock.getArguments());
+      mapping.map(&lhsBlock, &rhsBlock);
+    }
+    for (auto blocks : llvm::zip(lhsRegion, rhsRegion)) {
+      for (auto ops : llvm::zip(std::get<0>(blocks), std::get<1>(blocks))) {
+        if (!isEquivalentOp(&std::get<0>(ops), &std::get<1>(ops), mapping)) {
+          return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+// Returns true if |lhs| and |rhs| record the same commands and can share the
+// same memoized command buffer.
+static bool isEquivalentRecording(const Recording &lhs, const Recording &rhs) {
+  if (lhs.ops.size() != rhs.ops.size() ||
+      lhs.capturedValues.size() != rhs.capturedValues.size()) {
+    return false;
+  }
+  BlockAndValueMapping mapping;
+  for (auto it : llvm::zip(lhs.capturedValues, rhs.capturedValues)) {
+    // Invariant values are defined by operand-less ops (constants, global
+    // loads, etc) and are equivalent if the ops are.
+    auto *lhsOp = std::get<0>(it).getDefiningOp();
+    auto *rhsOp = std::get<1>(it).getDefiningOp();
+    if (std::get<0>(it).cast<OpResult>().getResultNumber() !=
+            std::get<1>(it).cast<OpResult>().getResultNumber() ||
+        !isEquivalentOp(lhsOp, rhsOp, mapping)) {
+      return false;
+    }
+  }
+  for (auto it : llvm::zip(lhs.ops, rhs.ops)) {
+    if (!isEquivalentOp(std::get<0>(it), std::get<1>(it), mapping)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+//===----------------------------------------------------------------------===//
+// Recording outlining
+//===----------------------------------------------------------------------===//
+
+// Outlines |recording| into a new initializer that records the commands once
+// into a reusable command buffer stored in a new immutable global.
+static IREE::Util::GlobalOp outlineRecording(const Recording &recording,
+                                             StringRef name,
+                                             OpBuilder &moduleBuilder) {
+  auto createOp = recording.createOp;
+  auto loc = createOp.getLoc();
+  auto globalOp = moduleBuilder.create<IREE::Util::GlobalOp>(
+      loc, name, /*isMutable=*/false, createOp.result().getType());
+  globalOp.setPrivate();
+
+  auto initializerOp = moduleBuilder.create<IREE::Util::InitializerOp>(loc);
+  auto initializerBuilder =
+      OpBuilder::atBlockBegin(initializerOp.addEntryBlock());
+  BlockAndValueMapping mapping;
+  for (auto value : recording.capturedValues) {
+    if (mapping.contains(value)) continue;
+    initializerBuilder.clone(*value.getDefiningOp(), mapping);
+  }
+
+  // The command buffer will be submitted many times and must not be
+  // executed inline with recording.
+  auto commandBuffer =
+      initializerBuilder
+          .create<IREE::HAL::CommandBufferCreateOp>(
+              loc, createOp.result().getType(),
+              mapping.lookup(createOp.device()),
+              IREE::HAL::CommandBufferModeBitfield::None,
+              createOp.command_categories())
+          .result();
+  mapping.map(createOp.result(), commandBuffer);
+  for (auto *op : llvm::drop_begin(recording.ops)) {
+    initializerBuilder.clone(*op, mapping);
+  }
+
+  initializerBuilder.create<IREE::Util::GlobalStoreOp>(loc, commandBuffer,
+                                                       globalOp.getName());
+  initializerBuilder.create<IREE::Util::InitializerReturnOp>(loc);
+  return globalOp;
+}
+
+// Replaces |recording| with a load of the memoized command buffer |globalOp|.
+static void replaceRecording(const Recording &recording,
+                             IREE::Util::GlobalOp globalOp) {
+  auto createOp = recording.createOp;
+  OpBuilder builder(createOp);
+  auto loadOp = builder.create<IREE::Util::GlobalLoadOp>(
+      createOp.getLoc(), globalOp.type(), globalOp.getName());
+  createOp.result().replaceAllUsesWith(loadOp.result());
+  for (auto *op : llvm::reverse(recording.ops)) op->erase();
+}
+
+//===----------------------------------------------------------------------===//
+// -iree-hal-memoize-command-buffers
+//===----------------------------------------------------------------------===//
+
+class MemoizeCommandBuffersPass
+    : public PassWrapper<MemoizeCommandBuffersPass, OperationPass<ModuleOp>> {
+ public:
+  StringRef getArgument() const override {
+    return "iree-hal-memoize-command-buffers";
+  }
+
+  StringRef getDescription() const override {
+    return "Records invariant command buffers once at initialization time";
+  }
+
+  void getDependentDialects(DialectRegistry &registry) const override {
+    registry.insert<IREE::HAL::HALDialect>();
+    registry.insert<IREE::Util::UtilDialect>();
+  }
+
+  void runOnOperation() override {
+    auto moduleOp = getOperation();
+    SymbolTable symbolTable(moduleOp);
+
+    // Find all recordings in functions that are invariant across invocations
+    // and group the equivalent ones together. Initializers only run once and
+    // gain nothing from memoization.
+    SmallVector<SmallVector<Recording>> recordingGroups;
+    for (auto funcOp : moduleOp.getOps<mlir::func::FuncOp>()) {
+      funcOp.walk([&](IREE::HAL::CommandBufferCreateOp createOp) {
+        auto recording = tryFormRecording(createOp, symbolTable);
+        if (!recording.hasValue()) return;
+        LLVM_DEBUG({
+          llvm::dbgs() << "Memoizing recording of " << recording->ops.size()
+                       << " ops in " << funcOp.getName() << "\n";
+        });
+        for (auto &recordingGroup : recordingGroups) {
+          if (isEquivalentRecording(recordingGroup.front(),
+                                    recording.getValue())) {
+            recordingGroup.push_back(std::move(recording.getValue()));
+            return;
+          }
+        }
+        recordingGroups.emplace_back();
+        recordingGroups.back().push_back(std::move(recording.getValue()));
+      });
+    }
+
+    // Outline each unique recording into an initializer at the end of the
+    // module so that it runs after the initializers of any resources it
+    // references, then replace all recordings with loads of the result.
+    auto moduleBuilder = OpBuilder::atBlockEnd(moduleOp.getBody());
+    for (auto recordingGroup : llvm::enumerate(recordingGroups)) {
+      std::string globalName =
+          "_command_buffer_" + std::to_string(recordingGroup.index());
+      auto globalOp = outlineRecording(recordingGroup.value().front(),
+                                       globalName, moduleBuilder);
+      for (auto &recording : recordingGroup.value()) {
+        replaceRecording(recording, globalOp);
+      }
+    }
+  }
+};
+
+}  // namespace
+
+std::unique_ptr<OperationPass<ModuleOp>> createMemoizeCommandBuffersPass() {
+  return std::make_unique<MemoizeCommandBuffersPass>();
+}
+
+static PassRegistration<MemoizeCommandBuffersPass> pass;
+
+}  // namespace HAL
+}  // namespace IREE
+}  // namespace iree_compiler
+}  // namespace mlir
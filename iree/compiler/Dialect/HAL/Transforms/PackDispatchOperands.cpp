@@ -6,6 +6,9 @@
 
 #include "iree/compiler/Dialect/Stream/IR/StreamDialect.h"
 #include "iree/compiler/Dialect/Stream/IR/StreamOps.h"
+#include "llvm/ADT/BitVector.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/Support/Debug.h"
 #include "mlir/Dialect/Arithmetic/IR/Arithmetic.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
@@ -13,6 +16,7 @@
 #include "mlir/IR/Builders.h"
 #include "mlir/IR/BuiltinTypes.h"
 #include "mlir/IR/Diagnostics.h"
+#include "mlir/IR/SymbolTable.h"
 #include "mlir/Pass/Pass.h"
 
 #define DEBUG_TYPE "iree-hal-pack-dispatch-operands"
@@ -24,65 +28,200 @@ namespace HAL {
 namespace {
 
 //===----------------------------------------------------------------------===//
-// Type conversion/expansion
+// Operand packing layout
 //===----------------------------------------------------------------------===//
 //
-// TODO(#8037): ┏༼ ◉╭╮◉༽┓ this "packing" is bad and needs to be reworked.
+// Dispatch operands are packed into a dense list of i32 push constants (which
+// are a very finite resource - think <= 32 total i32 values). A benefit of the
+// HAL interface being an implementation detail is that we can change the
+// layout at any time without runtime changes so long as the dispatch sites and
+// the exported function agree. The layout is derived solely from the exported
+// function signature and the stream annotations on its arguments so that both
+// sides can compute it independently:
 //
-// This could be dramatically improved and a benefit of the HAL interface being
-// an implementation detail is that we can do that at any time without runtime
-// changes. This currently optimizes for correctness for all types and not for
-// optimal layout for minimizing storage requirements (push constants are a
-// very finite resource - think <= 32 total i32 values) or access performance
-// (loading 64-bit values are not aligned and may require split loads).
+// - Operands with a single potential value (`stream.values = [N]`) are uniform
+//   across all dispatch sites and are elided entirely; the device function
+//   materializes the constant instead.
+// - Each remaining operand is assigned 8, 16, 32, or 64 bits of storage.
+//   Integer and index operands with known potential values are narrowed to the
+//   fewest bits that hold all of them (an i64 with values [0, 1, 2] only needs
+//   8 bits).
+// - Operands are placed in order of descending storage width so that 64-bit
+//   values occupy naturally aligned dword pairs and narrower values are packed
+//   together into shared dwords at naturally aligned bit offsets
+//   (i16 + i8 + i8 -> i32).
+//
+// index is always treated as 32-bit today. 'index' can mean different things on
+// the host and device as well as varying across devices. i64 uses 2x as much of
+// our limited push constant space and is much slower to work with on mobile
+// GPUs. In the future we will want to flag this as a global setting as well as
+// have some heuristics for deriving from target devices.
 //
 // If we wanted to support an open type conversion process we could have a
 // method on HALConversionDialectInterface for getting a TypeConverter (or
 // something). For now our verifiers on ops earlier in the compiler don't allow
 // anything but int-or-float-or-index so it's not possible.
 
-// TODO(benvanik): handle known zero/unused values; the stream annotations will
-// tell us the potential values for each operand (when knowable) and we could
-// for example take an i64 with values [0, 1, 2] and turn that into an i8.
-// There may be another round of cleanup we want to do for deduplication after
-// that but so far in most programs that's rare. Lots of dynamic shapes or
-// detensorized parameters may change that.
-
-// TODO(benvanik): rework this to actually pack. We could pack multiple operands
-// together (i16 + i8 + i8 -> i32). We'd probably also want to apply some struct
-// packing rules to ensure alignment. This current implementation just looks for
-// any i64 (or equivalent) operand and splits it in to two i32s that get
-// stitched back together.
-
-// TODO(benvanik): handle index types here based on target devices. For now
-// we assume 32-bit device sizes and cast all index operands to i32.
-
-// Converts stream.cmd.dispatch operands into their packed representation. This
-// will add/remove/reorder operands and must mirrored in a consistent manner
-// with argument changes in the executable function (handled below).
-static void updateDispatchOp(IREE::Stream::CmdDispatchOp dispatchOp) {
+// Placement of a single primitive dispatch operand in the packed dwords.
+struct PackedOperand {
+  // Original operand type (index, an integer, or a float).
+  Type type;
+  // Value of the operand at all dispatch sites, if uniform. Uniform operands
+  // are elided and have no storage assigned.
+  IntegerAttr uniformValue;
+  // Bits of storage used by the operand: 8, 16, 32, or 64.
+  unsigned storageBitWidth = 0;
+  // Index of the (first) dword the operand is stored in.
+  unsigned dwordIndex = 0;
+  // Offset of the operand within its dword when storageBitWidth < 32.
+  unsigned bitOffset = 0;
+  // True if other operands are packed above this one in the same dword and
+  // the value must be masked after it is shifted down.
+  bool needsMask = false;
+
+  bool isElided() const { return static_cast<bool>(uniformValue); }
+};
+
+// Packing layout for all primitive operands of an exported function.
+struct OperandPacking {
+  // One entry per dispatch operand in the original operand order.
+  SmallVector<PackedOperand> operands;
+  // Total number of i32 dwords the operands are packed into.
+  unsigned dwordCount = 0;
+};
+
+// Returns the number of bits required to store any value of |type| given the
+// potential values in |valuesAttr|, if known.
+static unsigned getStorageBitWidth(Type type, ArrayAttr valuesAttr) {
+  unsigned bitWidth = type.isIndex() ? 32 : type.getIntOrFloatBitWidth();
+  if (valuesAttr && !valuesAttr.empty() &&
+      (type.isIndex() || type.isa<IntegerType>())) {
+    // Negative values have all bits active and won't be narrowed.
+    unsigned activeBits = 1;
+    for (auto valueAttr : valuesAttr) {
+      auto intAttr = valueAttr.dyn_cast<IntegerAttr>();
+      if (!intAttr) {
+        activeBits = bitWidth;
+        break;
+      }
+      activeBits = std::max(activeBits, intAttr.getValue().getActiveBits());
+    }
+    bitWidth = std::min(bitWidth, activeBits);
+  }
+  if (bitWidth <= 8) return 8;
+  if (bitWidth <= 16) return 16;
+  if (bitWidth <= 32) return 32;
+  return 64;
+}
+
+// Computes the packing layout of the operands of |funcOp| based on its
+// signature and stream argument annotations.
+static OperandPacking computeOperandPacking(mlir::func::FuncOp funcOp) {
+  auto streamValuesAttr = StringAttr::get(funcOp.getContext(), "stream.values");
+
+  OperandPacking packing;
+  for (auto argIdx :
+       IREE::Stream::CmdDispatchOp::makeOperandToArgMap(funcOp)) {
+    PackedOperand operand;
+    operand.type = funcOp.getArgument(argIdx).getType();
+    auto valuesAttr =
+        funcOp.getArgAttrOfType<ArrayAttr>(argIdx, streamValuesAttr);
+    if (valuesAttr && valuesAttr.size() == 1) {
+      auto valueAttr = valuesAttr[0].dyn_cast<IntegerAttr>();
+      if (valueAttr && valueAttr.getType() == operand.type) {
+        operand.uniformValue = valueAttr;
+      }
+    }
+    if (!operand.isElided()) {
+      operand.storageBitWidth = getStorageBitWidth(operand.type, valuesAttr);
+    }
+    packing.operands.push_back(operand);
+  }
+
+  // Assign storage widest-first so that each operand lands at an offset that
+  // is a multiple of its own width. Wide operands all come first and take
+  // whole dwords; narrow operands are bump allocated within shared dwords.
+  SmallVector<unsigned> order;
+  for (auto it : llvm::enumerate(packing.operands)) {
+    if (!it.value().isElided()) order.push_back(it.index());
+  }
+  llvm::stable_sort(order, [&](unsigned lhs, unsigned rhs) {
+    return packing.operands[lhs].storageBitWidth >
+           packing.operands[rhs].storageBitWidth;
+  });
+  unsigned bitCursor = 0;
+  PackedOperand *previousOperand = nullptr;
+  for (unsigned operandIdx : order) {
+    auto &operand = packing.operands[operandIdx];
+    if (operand.storageBitWidth >= 32) {
+      operand.dwordIndex = packing.dwordCount;
+      packing.dwordCount += operand.storageBitWidth / 32;
+      continue;
+    }
+    if (bitCursor == 0) {
+      ++packing.dwordCount;
+    } else {
+      // Packed above the previous operand in the same dword.
+      previousOperand->needsMask = true;
+    }
+    operand.dwordIndex = packing.dwordCount - 1;
+    operand.bitOffset = bitCursor;
+    bitCursor = (bitCursor + operand.storageBitWidth) % 32;
+    previousOperand = &operand;
+  }
+
+  LLVM_DEBUG({
+    llvm::dbgs() << "Packed operands of " << funcOp.getName() << " into "
+                 << packing.dwordCount << " dwords:\n";
+    for (auto it : llvm::enumerate(packing.operands)) {
+      auto &operand = it.value();
+      llvm::dbgs() << "  operand " << it.index() << " (" << operand.type
+                   << "): ";
+      if (operand.isElided()) {
+        llvm::dbgs() << "elided as " << operand.uniformValue << "\n";
+      } else {
+        llvm::dbgs() << operand.storageBitWidth << " bits in dword "
+                     << operand.dwordIndex << " at bit " << operand.bitOffset
+                     << "\n";
+      }
+    }
+  });
+  return packing;
+}
+
+//===----------------------------------------------------------------------===//
+// Dispatch site and exported function updates
+//===----------------------------------------------------------------------===//
+
+// Converts stream.cmd.dispatch operands into their packed representation as
+// described by |packing|. This will add/remove/reorder operands and must be
+// mirrored in a consistent manner with argument changes in the executable
+// function (handled below).
+static void updateDispatchOp(IREE::Stream::CmdDispatchOp dispatchOp,
+                             const OperandPacking &packing) {
+  assert(dispatchOp.operands().size() == packing.operands.size() &&
+         "dispatch operands must match the exported function");
+
   // Insert ops outside of the execution region.
   auto parentOp = dispatchOp->getParentOfType<IREE::Stream::CmdExecuteOp>();
   assert(parentOp && "dispatch ops must be within an execution region");
   OpBuilder builder(parentOp);
 
   auto loc = dispatchOp.getLoc();
-  SmallVector<Value> newOperands;
-  for (auto operand : dispatchOp.operands()) {
+  auto i32Type = builder.getI32Type();
+  auto i64Type = builder.getI64Type();
+  SmallVector<Value> dwords(packing.dwordCount);
+  for (auto it : llvm::zip(dispatchOp.operands(), packing.operands)) {
+    Value operand = std::get<0>(it);
+    const auto &packedOperand = std::get<1>(it);
+    if (packedOperand.isElided()) continue;
+
     // NOTE: we do these in sequence so that we can reuse type expansion; we
     // want f64 to become i64 so that i64 can become i32+i32 etc.
 
-    // index -> i32 or i64
+    // index -> i32
     if (operand.getType().isIndex()) {
-      // Convert index types to a concrete bit width. 'index' can mean different
-      // things on the host and device as well as varying across devices.
-      // Today we just hardcode to i32 as we are working with smallish data and
-      // i64 uses 2x as much of our limited push constant space and is much
-      // slower to work with on mobile GPUs. In the future we will want to flag
-      // this as a global setting as well as have some heuristics for deriving
-      // from target devices.
-      operand = builder.createOrFold<arith::IndexCastOp>(
-          loc, builder.getI32Type(), operand);
+      operand = builder.createOrFold<arith::IndexCastOp>(loc, i32Type, operand);
     }
 
     // bf16 -> i16, f32 -> i32, f64 -> i64 ...
@@ -94,203 +233,197 @@ static void updateDispatchOp(IREE::Stream::CmdDispatchOp dispatchOp) {
           operand);
     }
 
-    // i1-i31 -> i32 and i33-i63 -> i64
-    // TODO(benvanik): don't extend here but instead pack as we can fit 4 i8's
-    // into a single i32 and save 4x our push constant capacity.
+    // Extend or truncate to the dword(s) holding the value. Truncation only
+    // happens when the potential values told us the upper bits are unused.
+    auto storageType = packedOperand.storageBitWidth == 64 ? i64Type : i32Type;
     unsigned bitWidth = operand.getType().getIntOrFloatBitWidth();
-    if (bitWidth < 31) {
-      operand = builder.createOrFold<arith::ExtUIOp>(loc, builder.getI32Type(),
-                                                     operand);
-    } else if (bitWidth > 32 && bitWidth < 64) {
-      operand = builder.createOrFold<arith::ExtUIOp>(loc, builder.getI64Type(),
-                                                     operand);
+    if (bitWidth < storageType.getWidth()) {
+      operand = builder.createOrFold<arith::ExtUIOp>(loc, storageType, operand);
+    } else if (bitWidth > storageType.getWidth()) {
+      operand =
+          builder.createOrFold<arith::TruncIOp>(loc, storageType, operand);
     }
 
     // i64 -> i32 + i32
-    if (operand.getType().isInteger(64)) {
-      // TODO(benvanik): reorder operands to preserve natural alignment; right
-      // now this can split i64 across 4 byte boundaries which sucks.
-      // TODO(benvanik): use something like IndexSet for the shift amount to
-      // reduce the amount of IR we emit when passing multiple operands.
+    if (packedOperand.storageBitWidth == 64) {
       // lo = i32(operand)
       // hi = i32(operand >> 32)
-      auto lo = builder.createOrFold<arith::TruncIOp>(loc, builder.getI32Type(),
-                                                      operand);
+      auto lo = builder.createOrFold<arith::TruncIOp>(loc, i32Type, operand);
       auto hi = builder.createOrFold<arith::TruncIOp>(
-          loc, builder.getI32Type(),
+          loc, i32Type,
           builder.createOrFold<arith::ShRUIOp>(
-              loc, builder.getI64Type(), operand,
+              loc, i64Type, operand,
               builder.create<arith::ConstantIntOp>(loc, 32, 64)));
-      newOperands.push_back(lo);
-      newOperands.push_back(hi);
-    } else {
-      newOperands.push_back(operand);
+      dwords[packedOperand.dwordIndex] = lo;
+      dwords[packedOperand.dwordIndex + 1] = hi;
+      continue;
+    }
+
+    // dword |= operand << offset
+    if (packedOperand.bitOffset) {
+      operand = builder.createOrFold<arith::ShLIOp>(
+          loc, i32Type, operand,
+          builder.create<arith::ConstantIntOp>(loc, packedOperand.bitOffset,
+                                               32));
+    }
+    auto &dword = dwords[packedOperand.dwordIndex];
+    dword = dword ? builder.createOrFold<arith::OrIOp>(loc, dword, operand)
+                  : operand;
+  }
+  dispatchOp.operandsMutable().assign(dwords);
+}
+
+// Reconstructs the value of |packedOperand| from the packed |dwords|.
+static Value unpackOperand(const PackedOperand &packedOperand,
+                           ArrayRef<Value> dwords, Location loc,
+                           OpBuilder &builder) {
+  auto i32Type = builder.getI32Type();
+  auto i64Type = builder.getI64Type();
+
+  Value value;
+  if (packedOperand.storageBitWidth == 64) {
+    // i64(lo) | (i64(hi) << 32)
+    auto lo = builder.create<arith::ExtUIOp>(
+        loc, i64Type, dwords[packedOperand.dwordIndex]);
+    auto hi = builder.create<arith::ExtUIOp>(
+        loc, i64Type, dwords[packedOperand.dwordIndex + 1]);
+    value = builder.create<arith::OrIOp>(
+        loc, lo,
+        builder.create<arith::ShLIOp>(
+            loc, hi, builder.create<arith::ConstantIntOp>(loc, 32, 64)));
+  } else {
+    // (dword >> offset) & mask
+    value = dwords[packedOperand.dwordIndex];
+    if (packedOperand.bitOffset) {
+      value = builder.create<arith::ShRUIOp>(
+          loc, value,
+          builder.create<arith::ConstantIntOp>(loc, packedOperand.bitOffset,
+                                               32));
+    }
+    if (packedOperand.needsMask) {
+      value = builder.create<arith::AndIOp>(
+          loc, value,
+          builder.create<arith::ConstantIntOp>(
+              loc, (1ll << packedOperand.storageBitWidth) - 1, 32));
     }
   }
-  dispatchOp.operandsMutable().assign(newOperands);
+
+  // i32 -> index
+  auto targetType = packedOperand.type;
+  if (targetType.isIndex()) {
+    return builder.create<arith::IndexCastOp>(loc, targetType, value);
+  }
+
+  // Truncate or extend back to the original bit width.
+  // i32 -> i16, i64 -> i48, i32 -> i64 (narrowed) ...
+  unsigned bitWidth = targetType.getIntOrFloatBitWidth();
+  unsigned storageBitWidth = value.getType().getIntOrFloatBitWidth();
+  if (bitWidth < storageBitWidth) {
+    value = builder.create<arith::TruncIOp>(
+        loc, builder.getIntegerType(bitWidth), value);
+  } else if (bitWidth > storageBitWidth) {
+    value = builder.create<arith::ExtUIOp>(
+        loc, builder.getIntegerType(bitWidth), value);
+  }
+
+  // i16 -> bf16, i32 -> f32, i64 -> f64 ...
+  if (targetType.isa<FloatType>()) {
+    value = builder.create<arith::BitcastOp>(loc, targetType, value);
+  }
+  return value;
 }
 
 // Updates an exported function in a stream.executable to match the packing
 // that was applied to dispatch ops above.
 //
 // This is a mirror of updateDispatchOp; see that for more information.
-static void updateExportFuncOp(mlir::func::FuncOp funcOp) {
+static void updateExportFuncOp(mlir::func::FuncOp funcOp,
+                               const OperandPacking &packing) {
   assert(!funcOp.empty() && "can't have empty exported functions");
+  if (packing.operands.empty()) return;
   auto &entryBlock = funcOp.getBody().front();
   auto builder = OpBuilder::atBlockBegin(&entryBlock);
+  auto loc = funcOp.getLoc();
   auto streamAlignmentAttr = builder.getStringAttr("stream.alignment");
   auto streamValuesAttr = builder.getStringAttr("stream.values");
 
   // NOTE: we have !stream.binding mixed in here; we only want to look at
-  // primitives.
-
-  // NOTE: we do the packing in a reverse sequence so that we can reuse type
-  // expansion; if we did f64->i64->i32+i32 above we need to do
-  // i32+i32->i64->f64 here.
-
-  // index is always i32 today - if it's i64 we need to expand it below.
-  bool isIndexI32 = true;
-
-  // i32+i32->i64 is the only case that adds arguments today so to keep things
-  // simple we do that first. This ensures we have single SSA values for arg
-  // to operand mapping.
-  SmallVector<Type> newArgTypes;
-  SmallVector<DictionaryAttr> newArgAttrs;
+  // primitives. Bindings retain their original relative order and attributes.
+  auto operandToArgMap =
+      IREE::Stream::CmdDispatchOp::makeOperandToArgMap(funcOp);
+  auto oldArgs = llvm::to_vector<8>(entryBlock.getArguments());
   auto oldArgAttrs = funcOp.getAllArgAttrs();
-  for (auto it :
-       llvm::enumerate(llvm::to_vector<4>(funcOp.getArgumentTypes()))) {
-    auto targetType = it.value();
-    if (!targetType.isIntOrIndexOrFloat() ||
-        (targetType.isIndex() && isIndexI32) ||
-        (targetType.isIntOrFloat() &&
-         targetType.getIntOrFloatBitWidth() <= 32)) {
-      // Pass through/no change.
-      if (oldArgAttrs) {
-        newArgAttrs.push_back(
-            oldArgAttrs[it.index()].dyn_cast_or_null<DictionaryAttr>());
-      } else {
-        newArgAttrs.push_back(nullptr);
-      }
-      newArgTypes.push_back(targetType);
+  auto getOldArgAttr = [&](unsigned argIdx) -> DictionaryAttr {
+    return oldArgAttrs ? oldArgAttrs[argIdx].dyn_cast_or_null<DictionaryAttr>()
+                       : nullptr;
+  };
+
+  // The packed dwords are inserted where the first operand was.
+  unsigned insertIdx = operandToArgMap.front();
+  SmallVector<Value> dwords;
+  for (unsigned i = 0; i < packing.dwordCount; ++i) {
+    dwords.push_back(
+        entryBlock.insertArgument(insertIdx + i, builder.getI32Type(), loc));
+  }
+  SmallVector<DictionaryAttr> dwordArgAttrs(packing.dwordCount);
+
+  for (auto it : llvm::enumerate(packing.operands)) {
+    const auto &packedOperand = it.value();
+    unsigned oldArgIdx = operandToArgMap[it.index()];
+    auto oldArg = oldArgs[oldArgIdx];
+    auto oldArgAttr = getOldArgAttr(oldArgIdx);
+
+    // Uniform values are materialized as constants.
+    if (packedOperand.isElided()) {
+      auto constantOp = builder.create<arith::ConstantOp>(
+          oldArg.getLoc(), packedOperand.uniformValue);
+      oldArg.replaceAllUsesWith(constantOp.getResult());
       continue;
     }
 
-    // The existing arg becomes the lo word and we need to insert the hi word.
-    auto loArg = entryBlock.getArgument(newArgTypes.size());
-    newArgTypes.push_back(builder.getI32Type());
-    loArg.setType(builder.getI32Type());
-    auto hiArg = entryBlock.insertArgument(
-        newArgTypes.size(), builder.getI32Type(), funcOp.getLoc());
-    newArgTypes.push_back(builder.getI32Type());
+    auto value = unpackOperand(packedOperand, dwords, oldArg.getLoc(), builder);
+    oldArg.replaceAllUsesWith(value);
+    if (!oldArgAttr) continue;
 
-    // i64(lo) | (i64(hi) << 32)
-    auto loc = loArg.getLoc();
-    auto loArgI64 =
-        builder.create<arith::ExtUIOp>(loc, builder.getI64Type(), loArg);
-    auto arg = builder.create<arith::OrIOp>(
-        loc, loArgI64,
-        builder.create<arith::ShLIOp>(
-            loc,
-            builder.create<arith::ExtUIOp>(loc, builder.getI64Type(), hiArg),
-            builder.create<arith::ConstantIntOp>(loc, 32, 64)));
-
-    // Replace all subsequent uses with the new reconstituted value.
-    loArg.replaceAllUsesExcept(arg, loArgI64);
-
-    // Take the existing potential values, if present, and fix them up.
-    // If we had a `stream.values = [0xAA...BB... : i64]` then we can
-    // put a `stream.values = [0xBB... : i32]` on the lo and `[0xAA... : i32]`
-    // on the hi.
-    //
-    // TODO(benvanik): find a nicer way/write some utilities - manipulating
-    // these attributes is really annoying.
-    if (oldArgAttrs) {
-      auto oldArgAttr =
-          oldArgAttrs[it.index()].dyn_cast_or_null<DictionaryAttr>();
+    // Set the original stream.values attribute on the op with the type in the
+    // original form. This allows subsequent analysis to easily find the value
+    // instead of having to reconstruct it from the packed dwords. If the
+    // operand is the dword itself then the attributes stay on the argument.
+    if (auto definingOp = value.getDefiningOp()) {
       if (auto alignmentAttr =
               oldArgAttr.getAs<IntegerAttr>(streamAlignmentAttr)) {
-        arg->setAttr(streamAlignmentAttr, alignmentAttr);
+        definingOp->setAttr(streamAlignmentAttr, alignmentAttr);
       }
       if (auto valuesAttr = oldArgAttr.getAs<ArrayAttr>(streamValuesAttr)) {
-        // Attach the original potential value set to the new arg value.
-        // This allows any further analysis walking the SSA values to find the
-        // easily understandable i64 types instead of having to reconstruct it
-        // from the i32 values and the combining operations (which MLIR doesn't
-        // do today).
-        arg->setAttr(streamValuesAttr, valuesAttr);
+        definingOp->setAttr(streamValuesAttr, valuesAttr);
       }
+    } else {
+      dwordArgAttrs[packedOperand.dwordIndex] = oldArgAttr;
     }
-    newArgAttrs.push_back(nullptr);
-    newArgAttrs.push_back(nullptr);
-  }
-  if (newArgTypes.size() != funcOp.getNumArguments()) {
-    // Changed argument count; update signature.
-    funcOp.setType(builder.getFunctionType(
-        newArgTypes, funcOp.getFunctionType().getResults()));
-    funcOp.setAllArgAttrs(newArgAttrs);
   }
 
-  // -- now the function has all <= 32-bit operands --
-
-  newArgTypes.clear();
+  // Drop the original operand arguments and rebuild the signature.
+  llvm::BitVector deadArgMap(entryBlock.getNumArguments());
+  for (auto oldArgIdx : operandToArgMap) {
+    deadArgMap.set(oldArgs[oldArgIdx].getArgNumber());
+  }
+  SmallVector<DictionaryAttr> newArgAttrs;
   for (auto arg : entryBlock.getArguments()) {
-    auto alignmentAttr = funcOp.getArgAttrOfType<IntegerAttr>(
-        arg.getArgNumber(), streamAlignmentAttr);
-    auto oldValuesAttr = funcOp.getArgAttrOfType<ArrayAttr>(arg.getArgNumber(),
-                                                            streamValuesAttr);
-    auto targetType = arg.getType();
-    if (!targetType.isIntOrIndexOrFloat()) {
-      // Pass-through !stream.bindings.
-      newArgTypes.push_back(targetType);
-      continue;
-    }
-
-    auto loc = arg.getLoc();
-    Value value = arg;
-    arg.setType(builder.getI32Type());
-
-    // i32 or i64 -> index
-    if (targetType.isIndex()) {
-      auto castOp = builder.create<arith::IndexCastOp>(
-          loc, builder.getIndexType(), value);
-      value.replaceAllUsesExcept(castOp.getResult(), castOp);
-      value = castOp.getResult();
-    }
-
-    // Truncate back to original bit width.
-    // i32 -> i16, i64 -> i48, ...
-    if (targetType.isIntOrFloat() && targetType.getIntOrFloatBitWidth() < 32) {
-      auto truncOp = builder.create<arith::TruncIOp>(
-          loc, builder.getIntegerType(targetType.getIntOrFloatBitWidth()),
-          value);
-      value.replaceAllUsesExcept(truncOp.getResult(), truncOp);
-      value = truncOp.getResult();
-    }
-
-    // i16 -> bf16, i32 -> f32, i64 -> f64 ...
-    if (auto floatType = targetType.dyn_cast<FloatType>()) {
-      auto bitcastOp = builder.create<arith::BitcastOp>(loc, targetType, value);
-      value.replaceAllUsesExcept(bitcastOp.getResult(), bitcastOp);
-      value = bitcastOp.getResult();
-    }
-
-    // Set the original streams.values attribute on the op with the type in the
-    // original form. This allows subsequent analysis to easily find the value.
-    if (auto definingOp = value.getDefiningOp()) {
-      if (alignmentAttr) {
-        definingOp->setAttr(streamAlignmentAttr, alignmentAttr);
-        funcOp.removeArgAttr(arg.getArgNumber(), streamAlignmentAttr);
-      }
-      if (oldValuesAttr) {
-        definingOp->setAttr(streamValuesAttr, oldValuesAttr);
-        funcOp.removeArgAttr(arg.getArgNumber(), streamValuesAttr);
-      }
+    unsigned argIdx = arg.getArgNumber();
+    if (deadArgMap.test(argIdx)) continue;
+    if (argIdx < insertIdx) {
+      newArgAttrs.push_back(getOldArgAttr(argIdx));
+    } else if (argIdx < insertIdx + packing.dwordCount) {
+      newArgAttrs.push_back(dwordArgAttrs[argIdx - insertIdx]);
+    } else {
+      newArgAttrs.push_back(getOldArgAttr(argIdx - packing.dwordCount));
     }
-
-    newArgTypes.push_back(builder.getI32Type());
   }
+  entryBlock.eraseArguments(
+      [&](BlockArgument arg) { return deadArgMap.test(arg.getArgNumber()); });
   funcOp.setType(builder.getFunctionType(
-      newArgTypes, funcOp.getFunctionType().getResults()));
+      entryBlock.getArgumentTypes(), funcOp.getFunctionType().getResults()));
+  funcOp.setAllArgAttrs(newArgAttrs);
 }
 
 //===----------------------------------------------------------------------===//
@@ -316,22 +449,35 @@ class PackDispatchOperandsPass
   }
 
   void runOnOperation() override {
-    // Convert all public function signatures and manipulate the arguments.
+    // Compute the packing of each exported function from its original
+    // signature before changing anything; dispatch sites and functions must
+    // agree on the layout.
+    DenseMap<Operation *, OperandPacking> funcPackings;
     for (auto executableOp :
          getOperation().getOps<IREE::Stream::ExecutableOp>()) {
-      for (auto funcOp :
-           executableOp.getInnerModule().getOps<mlir::func::FuncOp>()) {
-        if (funcOp.isPublic()) {
-          updateExportFuncOp(funcOp);
-        }
+      for (auto exportOp :
+           executableOp.getOps<IREE::Stream::ExecutableExportOp>()) {
+        auto funcOp = exportOp.getFunctionRef();
+        if (!funcOp || funcPackings.count(funcOp)) continue;
+        funcPackings[funcOp] = computeOperandPacking(funcOp);
       }
     }
 
     // Walk the module and update all dispatch operands.
     getOperation()->walk([&](IREE::Stream::CmdDispatchOp dispatchOp) {
-      updateDispatchOp(dispatchOp);
+      auto exportOp = SymbolTable::lookupNearestSymbolFrom<
+          IREE::Stream::ExecutableExportOp>(dispatchOp,
+                                            dispatchOp.entry_point());
+      assert(exportOp && "dispatch must reference a valid export");
+      updateDispatchOp(dispatchOp,
+                       funcPackings[exportOp.getFunctionRef().getOperation()]);
       return WalkResult::advance();
     });
+
+    // Convert all exported function signatures and manipulate the arguments.
+    for (auto &it : funcPackings) {
+      updateExportFuncOp(cast<mlir::func::FuncOp>(it.first), it.second);
+    }
   }
 };
 
@@ -48,6 +48,15 @@ static llvm::cl::opt<unsigned> benchmarkDispatchRepeatCount{
         "structures.)"),
     llvm::cl::init(1)};
 
+static llvm::cl::opt<bool> memoizeCommandBuffers{
+    "iree-hal-enable-command-buffer-memoization",
+    llvm::cl::desc(
+        "Records command buffers with contents that are invariant across "
+        "invocations once at initialization time and replays them. Requires "
+        "all HAL drivers the program runs on to support reusable "
+        "(non-one-shot) command buffers."),
+    llvm::cl::init(false)};
+
 }  // namespace
 
 static void addCleanupPatterns(OpPassManager &passManager) {
@@ -153,6 +162,11 @@ void buildHALTransformPassPipeline(OpPassManager &passManager,
 
   // TODO(benvanik): move translation down to here.
 
+  // Different source executables may have converged into the same target IR
+  // during translation; drop the duplicates so that we don't link, serialize,
+  // and load them multiple times.
+  passManager.addPass(createDeduplicateExecutablesPass());
+
   // After all executables are translated and before resolving entry point
   // ordinals, we allow the backends to link executables together. For example,
   // the LLVM AOT backend may combine all executable targets for the same
@@ -170,6 +184,15 @@ void buildHALTransformPassPipeline(OpPassManager &passManager,
   // cache them at initialization-time.
   passManager.addPass(createMaterializeResourceCachesPass(targetOptions));
 
+  // Record command buffers that only reference invariant resources (constants,
+  // executables, etc) once at initialization time so that invocations only
+  // need to submit them. This must run after resource caches are materialized
+  // so that the lookups are replaced with immutable globals and before device
+  // switches are inlined so that each recording remains in a single block.
+  if (memoizeCommandBuffers) {
+    passManager.addPass(createMemoizeCommandBuffersPass());
+  }
+
   //----------------------------------------------------------------------------
   // Device management and specialization
   //----------------------------------------------------------------------------
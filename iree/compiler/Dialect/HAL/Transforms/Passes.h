@@ -92,6 +92,11 @@ createTranslateExecutablesPass();
 std::unique_ptr<OperationPass<IREE::HAL::ExecutableVariantOp>>
 createTranslateTargetExecutableVariantsPass(StringRef target);
 
+// Deduplicates hal.executable ops whose variants are all equivalent after
+// translation.
+std::unique_ptr<OperationPass<mlir::ModuleOp>>
+createDeduplicateExecutablesPass();
+
 // Calls into each target backend to have it link multiple hal.executables
 // together (if that makes sense). For example, the LLVM AOT backend may combine
 // all executable targets for the same architecture into a single executable and
@@ -131,6 +136,11 @@ createMaterializeResourceCachesPass(TargetOptions targetOptions);
 // TODO(#1124): replace with memory side effects once supported upstream.
 std::unique_ptr<OperationPass<func::FuncOp>> createCSEVariableLoadsPass();
 
+// Records command buffers whose contents are invariant across invocations once
+// at initialization time and replaces their recording with a global load.
+std::unique_ptr<OperationPass<mlir::ModuleOp>>
+createMemoizeCommandBuffersPass();
+
 // Elides stateful command buffer ops that set redundant state.
 std::unique_ptr<OperationPass<void>> createElideRedundantCommandsPass();
 
@@ -149,6 +159,7 @@ inline void registerHALPasses() {
   createAssignTargetDevicesPass({});
   createBenchmarkBatchDispatchesPass(/*repeatCount=*/1);
   createConvertToHALPass();
+  createDeduplicateExecutablesPass();
   createDumpExecutableSourcesPass("");
   createElideRedundantCommandsPass();
   createInlineDeviceSwitchesPass();
@@ -156,6 +167,7 @@ inline void registerHALPasses() {
   createLinkTargetExecutablesPass("");
   createMaterializeInterfacesPass();
   createMaterializeResourceCachesPass(targetOptions);
+  createMemoizeCommandBuffersPass();
   createMemoizeDeviceQueriesPass();
   createPackDispatchOperandsPass();
   createResolveEntryPointOrdinalsPass();
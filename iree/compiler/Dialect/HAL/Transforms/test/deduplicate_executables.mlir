@@ -0,0 +1,122 @@
+// RUN: iree-opt -split-input-file -iree-hal-deduplicate-executables %s | FileCheck %s
+
+#executable_layout = #hal.executable.layout<push_constants = 1, sets = [
+  #hal.descriptor_set.layout<0, bindings = [
+    #hal.descriptor_set.binding<0, storage_buffer>
+  ]>
+]>
+
+// CHECK: hal.executable private @ex0
+hal.executable private @ex0 {
+  hal.executable.variant @vmvx, target = <"vmvx", "vmvx-bytecode-fb"> {
+    hal.executable.entry_point @entry0 ordinal(0) layout(#executable_layout)
+    builtin.module {
+      func.func @entry0(%arg0: i32) -> i32 {
+        %0 = call @helper0(%arg0) : (i32) -> i32
+        return %0 : i32
+      }
+      func.func private @helper0(%arg0: i32) -> i32 {
+        %0 = arith.addi %arg0, %arg0 : i32
+        return %0 : i32
+      }
+    }
+  }
+}
+
+// Equivalent to @ex0 except for symbol names.
+// CHECK-NOT: hal.executable private @ex1
+hal.executable private @ex1 {
+  hal.executable.variant @vmvx, target = <"vmvx", "vmvx-bytecode-fb"> {
+    hal.executable.entry_point @entry1 ordinal(0) layout(#executable_layout)
+    builtin.module {
+      func.func @entry1(%arg0: i32) -> i32 {
+        %0 = call @helper1(%arg0) : (i32) -> i32
+        return %0 : i32
+      }
+      func.func private @helper1(%arg0: i32) -> i32 {
+        %0 = arith.addi %arg0, %arg0 : i32
+        return %0 : i32
+      }
+    }
+  }
+}
+
+// Differs from @ex0 in its contents.
+// CHECK: hal.executable private @ex2
+hal.executable private @ex2 {
+  hal.executable.variant @vmvx, target = <"vmvx", "vmvx-bytecode-fb"> {
+    hal.executable.entry_point @entry2 ordinal(0) layout(#executable_layout)
+    builtin.module {
+      func.func @entry2(%arg0: i32) -> i32 {
+        %0 = call @helper2(%arg0) : (i32) -> i32
+        return %0 : i32
+      }
+      func.func private @helper2(%arg0: i32) -> i32 {
+        %0 = arith.muli %arg0, %arg0 : i32
+        return %0 : i32
+      }
+    }
+  }
+}
+
+// CHECK-LABEL: func @dispatches
+func.func @dispatches(%cmd: !hal.command_buffer, %device: !hal.device) -> !hal.executable {
+  %c1 = arith.constant 1 : index
+  // CHECK: target(@ex0::@vmvx::@entry0)
+  hal.command_buffer.dispatch.symbol<%cmd : !hal.command_buffer>
+      target(@ex0::@vmvx::@entry0)
+      workgroups([%c1, %c1, %c1])
+  // CHECK: target(@ex0::@vmvx::@entry0)
+  hal.command_buffer.dispatch.symbol<%cmd : !hal.command_buffer>
+      target(@ex1::@vmvx::@entry1)
+      workgroups([%c1, %c1, %c1])
+  // CHECK: target(@ex2::@vmvx::@entry2)
+  hal.command_buffer.dispatch.symbol<%cmd : !hal.command_buffer>
+      target(@ex2::@vmvx::@entry2)
+      workgroups([%c1, %c1, %c1])
+  // CHECK: hal.executable.lookup device(%{{.+}} : !hal.device) executable(@ex0)
+  %exe = hal.executable.lookup device(%device : !hal.device) executable(@ex1) : !hal.executable
+  return %exe : !hal.executable
+}
+
+// -----
+
+// Executables are only deduplicated if all of their variants are equivalent.
+
+#executable_layout = #hal.executable.layout<push_constants = 0, sets = [
+  #hal.descriptor_set.layout<0, bindings = [
+    #hal.descriptor_set.binding<0, storage_buffer>
+  ]>
+]>
+
+// CHECK: hal.executable private @ex0
+hal.executable private @ex0 {
+  hal.executable.variant @vmvx, target = <"vmvx", "vmvx-bytecode-fb"> {
+    hal.executable.entry_point @entry0 ordinal(0) layout(#executable_layout)
+    builtin.module {
+      func.func @entry0() {
+        return
+      }
+    }
+  }
+  hal.executable.variant @vmvx_alt, target = <"vmvx", "vmvx-bytecode-fb"> {
+    hal.executable.entry_point @entry0 ordinal(0) layout(#executable_layout)
+    builtin.module {
+      func.func @entry0() {
+        return
+      }
+    }
+  }
+}
+
+// CHECK: hal.executable private @ex1
+hal.executable private @ex1 {
+  hal.executable.variant @vmvx, target = <"vmvx", "vmvx-bytecode-fb"> {
+    hal.executable.entry_point @entry1 ordinal(0) layout(#executable_layout)
+    builtin.module {
+      func.func @entry1() {
+        return
+      }
+    }
+  }
+}
@@ -127,3 +127,233 @@ func.func @elidePushDescriptorSet(%cmd: !hal.command_buffer, %executable_layout:
   // CHECK: return
   return
 }
+
+// -----
+
+// CHECK-LABEL: @elideBindDescriptorSet
+// CHECK-SAME: (%[[CMD:.+]]: !hal.command_buffer, %[[LAYOUT:.+]]: !hal.executable_layout, %[[SET0:.+]]: !hal.descriptor_set, %[[SET1:.+]]: !hal.descriptor_set)
+func.func @elideBindDescriptorSet(%cmd: !hal.command_buffer, %executable_layout: !hal.executable_layout, %set0: !hal.descriptor_set, %set1: !hal.descriptor_set) {
+  %c0 = arith.constant 0 : index
+  // CHECK: hal.command_buffer.bind_descriptor_set<%[[CMD]] : !hal.command_buffer> layout(%[[LAYOUT]] : !hal.executable_layout)[%c0] set(%[[SET0]] : !hal.descriptor_set)
+  hal.command_buffer.bind_descriptor_set<%cmd : !hal.command_buffer> layout(%executable_layout : !hal.executable_layout)[%c0] set(%set0 : !hal.descriptor_set)
+  // CHECK-NOT: hal.command_buffer.bind_descriptor_set
+  hal.command_buffer.bind_descriptor_set<%cmd : !hal.command_buffer> layout(%executable_layout : !hal.executable_layout)[%c0] set(%set0 : !hal.descriptor_set)
+  // CHECK: hal.command_buffer.bind_descriptor_set<%[[CMD]] : !hal.command_buffer> layout(%[[LAYOUT]] : !hal.executable_layout)[%c0] set(%[[SET1]] : !hal.descriptor_set)
+  hal.command_buffer.bind_descriptor_set<%cmd : !hal.command_buffer> layout(%executable_layout : !hal.executable_layout)[%c0] set(%set1 : !hal.descriptor_set)
+  // CHECK: return
+  return
+}
+
+// -----
+
+// Tests that state is propagated across blocks and merged at joins.
+
+// CHECK-LABEL: @elideAcrossBlocks
+func.func @elideAcrossBlocks(%cmd: !hal.command_buffer, %executable_layout: !hal.executable_layout, %cond: i1) {
+  // CHECK-DAG: %[[C0:.+]] = arith.constant 0
+  %c0 = arith.constant 0 : i32
+  // CHECK-DAG: %[[C1:.+]] = arith.constant 1
+  %c1 = arith.constant 1 : i32
+  // CHECK: hal.command_buffer.push_constants{{.+}} offset(0) values([%[[C0]], %[[C1]]])
+  hal.command_buffer.push_constants<%cmd : !hal.command_buffer>
+      layout(%executable_layout : !hal.executable_layout)
+      offset(0)
+      values([%c0, %c1]) : i32, i32
+  // CHECK: hal.command_buffer.execution_barrier
+  hal.command_buffer.execution_barrier<%cmd : !hal.command_buffer> source("Dispatch|Transfer|CommandRetire") target("CommandIssue|Dispatch|Transfer") flags("None")
+  // CHECK: cf.cond_br
+  cf.cond_br %cond, ^bb1, ^bb2
+// CHECK: ^bb1:
+^bb1:
+  // CHECK-NOT: hal.command_buffer.execution_barrier
+  hal.command_buffer.execution_barrier<%cmd : !hal.command_buffer> source("Dispatch|Transfer|CommandRetire") target("CommandIssue|Dispatch|Transfer") flags("None")
+  // CHECK-NOT: hal.command_buffer.push_constants
+  hal.command_buffer.push_constants<%cmd : !hal.command_buffer>
+      layout(%executable_layout : !hal.executable_layout)
+      offset(0)
+      values([%c0, %c1]) : i32, i32
+  // CHECK: cf.br ^bb3
+  cf.br ^bb3
+// CHECK: ^bb2:
+^bb2:
+  // CHECK: hal.command_buffer.push_constants{{.+}} offset(1) values([%[[C0]]])
+  hal.command_buffer.push_constants<%cmd : !hal.command_buffer>
+      layout(%executable_layout : !hal.executable_layout)
+      offset(0)
+      values([%c0, %c0]) : i32, i32
+  // CHECK: cf.br ^bb3
+  cf.br ^bb3
+// CHECK: ^bb3:
+^bb3:
+  // Only the first constant is the same along both paths.
+  // CHECK: hal.command_buffer.push_constants{{.+}} offset(1) values([%[[C1]]])
+  hal.command_buffer.push_constants<%cmd : !hal.command_buffer>
+      layout(%executable_layout : !hal.executable_layout)
+      offset(0)
+      values([%c0, %c1]) : i32, i32
+  // CHECK: return
+  return
+}
+
+// -----
+
+// Tests that state is not carried around loop back edges when the loop body
+// changes it.
+
+// CHECK-LABEL: @loopCarriedState
+func.func @loopCarriedState(%cmd: !hal.command_buffer, %executable_layout: !hal.executable_layout, %cond: i1) {
+  // CHECK-DAG: %[[C0:.+]] = arith.constant 0
+  %c0 = arith.constant 0 : i32
+  // CHECK-DAG: %[[C1:.+]] = arith.constant 1
+  %c1 = arith.constant 1 : i32
+  // CHECK: hal.command_buffer.push_constants{{.+}} offset(0) values([%[[C0]]])
+  hal.command_buffer.push_constants<%cmd : !hal.command_buffer>
+      layout(%executable_layout : !hal.executable_layout)
+      offset(0)
+      values([%c0]) : i32
+  // CHECK: cf.br ^bb1
+  cf.br ^bb1
+// CHECK: ^bb1:
+^bb1:
+  // Redundant on entry but not after the first iteration.
+  // CHECK: hal.command_buffer.push_constants{{.+}} offset(0) values([%[[C0]]])
+  hal.command_buffer.push_constants<%cmd : !hal.command_buffer>
+      layout(%executable_layout : !hal.executable_layout)
+      offset(0)
+      values([%c0]) : i32
+  // CHECK: hal.command_buffer.push_constants{{.+}} offset(0) values([%[[C1]]])
+  hal.command_buffer.push_constants<%cmd : !hal.command_buffer>
+      layout(%executable_layout : !hal.executable_layout)
+      offset(0)
+      values([%c1]) : i32
+  // CHECK: cf.cond_br
+  cf.cond_br %cond, ^bb1, ^bb2
+^bb2:
+  // CHECK: return
+  return
+}
+
+// -----
+
+// Tests that calls only invalidate the state of the command buffers they use.
+
+func.func private @record(%cmd: !hal.command_buffer)
+func.func private @unrelated()
+
+// CHECK-LABEL: @callInvalidation
+func.func @callInvalidation(%cmd: !hal.command_buffer, %executable_layout: !hal.executable_layout) {
+  %c0 = arith.constant 0 : i32
+  // CHECK: hal.command_buffer.push_constants
+  hal.command_buffer.push_constants<%cmd : !hal.command_buffer>
+      layout(%executable_layout : !hal.executable_layout)
+      offset(0)
+      values([%c0]) : i32
+  // CHECK-NEXT: call @unrelated
+  call @unrelated() : () -> ()
+  // CHECK-NOT: hal.command_buffer.push_constants
+  hal.command_buffer.push_constants<%cmd : !hal.command_buffer>
+      layout(%executable_layout : !hal.executable_layout)
+      offset(0)
+      values([%c0]) : i32
+  // CHECK: call @record
+  call @record(%cmd) : (!hal.command_buffer) -> ()
+  // CHECK-NEXT: hal.command_buffer.push_constants
+  hal.command_buffer.push_constants<%cmd : !hal.command_buffer>
+      layout(%executable_layout : !hal.executable_layout)
+      offset(0)
+      values([%c0]) : i32
+  // CHECK: return
+  return
+}
+
+// -----
+
+// Tests that recording into a command buffer through the block argument it is
+// passed to invalidates the state of the command buffer.
+
+// CHECK-LABEL: @successorOperandAliasing
+// CHECK-SAME: (%[[CMD:[a-z0-9]+]]: !hal.command_buffer
+func.func @successorOperandAliasing(%cmd: !hal.command_buffer, %executable_layout: !hal.executable_layout) {
+  %c0 = arith.constant 0 : i32
+  %c1 = arith.constant 1 : i32
+  // CHECK: hal.command_buffer.push_constants
+  hal.command_buffer.push_constants<%cmd : !hal.command_buffer>
+      layout(%executable_layout : !hal.executable_layout)
+      offset(0)
+      values([%c0]) : i32
+  // CHECK: cf.br ^bb1
+  cf.br ^bb1(%cmd : !hal.command_buffer)
+// CHECK: ^bb1(%[[ALIAS:.+]]: !hal.command_buffer):
+^bb1(%alias: !hal.command_buffer):
+  // CHECK: hal.command_buffer.push_constants<%[[ALIAS]]
+  hal.command_buffer.push_constants<%alias : !hal.command_buffer>
+      layout(%executable_layout : !hal.executable_layout)
+      offset(0)
+      values([%c1]) : i32
+  // CHECK: hal.command_buffer.push_constants<%[[CMD]]
+  hal.command_buffer.push_constants<%cmd : !hal.command_buffer>
+      layout(%executable_layout : !hal.executable_layout)
+      offset(0)
+      values([%c0]) : i32
+  // CHECK: return
+  return
+}
+
+// -----
+
+// Tests that command buffer block arguments start with an unknown state as
+// they may be a different command buffer on each entry.
+
+// CHECK-LABEL: @blockArgumentState
+func.func @blockArgumentState(%cmd0: !hal.command_buffer, %cmd1: !hal.command_buffer, %executable_layout: !hal.executable_layout, %cond: i1) {
+  %c0 = arith.constant 0 : i32
+  // CHECK: hal.command_buffer.push_constants
+  hal.command_buffer.push_constants<%cmd0 : !hal.command_buffer>
+      layout(%executable_layout : !hal.executable_layout)
+      offset(0)
+      values([%c0]) : i32
+  // CHECK: cf.br ^bb1
+  cf.br ^bb1(%cmd0 : !hal.command_buffer)
+// CHECK: ^bb1(%[[CMD:.+]]: !hal.command_buffer):
+^bb1(%cmd: !hal.command_buffer):
+  // Unknown on entry.
+  // CHECK: hal.command_buffer.push_constants<%[[CMD]]
+  hal.command_buffer.push_constants<%cmd : !hal.command_buffer>
+      layout(%executable_layout : !hal.executable_layout)
+      offset(0)
+      values([%c0]) : i32
+  // Redundant with the previous push to the same value.
+  // CHECK-NOT: hal.command_buffer.push_constants
+  hal.command_buffer.push_constants<%cmd : !hal.command_buffer>
+      layout(%executable_layout : !hal.executable_layout)
+      offset(0)
+      values([%c0]) : i32
+  // CHECK: cf.cond_br
+  cf.cond_br %cond, ^bb1(%cmd1 : !hal.command_buffer), ^bb2
+^bb2:
+  // CHECK: return
+  return
+}
+
+// -----
+
+// Tests that unknown ops using a command buffer invalidate its state.
+
+// CHECK-LABEL: @unknownOpInvalidation
+func.func @unknownOpInvalidation(%cmd: !hal.command_buffer, %executable_layout: !hal.executable_layout) {
+  %c0 = arith.constant 0 : i32
+  // CHECK: hal.command_buffer.push_constants
+  hal.command_buffer.push_constants<%cmd : !hal.command_buffer>
+      layout(%executable_layout : !hal.executable_layout)
+      offset(0)
+      values([%c0]) : i32
+  // CHECK-NEXT: util.do_not_optimize
+  util.do_not_optimize(%cmd) : !hal.command_buffer
+  // CHECK-NEXT: hal.command_buffer.push_constants
+  hal.command_buffer.push_constants<%cmd : !hal.command_buffer>
+      layout(%executable_layout : !hal.executable_layout)
+      offset(0)
+      values([%c0]) : i32
+  // CHECK: return
+  return
+}
@@ -0,0 +1,111 @@
+// RUN: iree-opt -split-input-file -iree-hal-memoize-command-buffers %s | FileCheck %s
+
+util.global private @_executable_layout_0 : !hal.executable_layout
+util.global private @_executable_ex : !hal.executable
+util.global private @_constant : !hal.buffer
+
+// CHECK-LABEL: func @invariantRecordingA
+func.func @invariantRecordingA() {
+  %c0 = arith.constant 0 : index
+  %c1 = arith.constant 1 : index
+  %c128 = arith.constant 128 : index
+  %device = hal.ex.shared_device : !hal.device
+  %layout = util.global.load @_executable_layout_0 : !hal.executable_layout
+  %executable = util.global.load @_executable_ex : !hal.executable
+  %buffer = util.global.load @_constant : !hal.buffer
+  // CHECK: %[[CMD:.+]] = util.global.load @_command_buffer_0 : !hal.command_buffer
+  // CHECK-NOT: hal.command_buffer
+  %cmd = hal.command_buffer.create device(%device : !hal.device)
+                                     mode("OneShot|AllowInlineExecution")
+                               categories("Transfer|Dispatch") : !hal.command_buffer
+  hal.command_buffer.begin<%cmd : !hal.command_buffer>
+  hal.command_buffer.push_descriptor_set<%cmd : !hal.command_buffer>
+      layout(%layout : !hal.executable_layout)[%c0]
+      bindings([
+        %c0 = (%buffer : !hal.buffer)[%c0, %c128]
+      ])
+  hal.command_buffer.dispatch<%cmd : !hal.command_buffer> target(%executable : !hal.executable)[0] workgroups([%c1, %c1, %c1])
+  hal.command_buffer.execution_barrier<%cmd : !hal.command_buffer> source("Dispatch|CommandRetire") target("CommandIssue|Dispatch") flags("None")
+  hal.command_buffer.end<%cmd : !hal.command_buffer>
+  // CHECK: hal.ex.submit_and_wait %{{.+}}, %[[CMD]]
+  hal.ex.submit_and_wait %device, %cmd
+  return
+}
+
+// Equivalent recordings share the same memoized command buffer.
+
+// CHECK-LABEL: func @invariantRecordingB
+func.func @invariantRecordingB() {
+  %c1 = arith.constant 1 : index
+  %c128 = arith.constant 128 : index
+  %c0 = arith.constant 0 : index
+  %device = hal.ex.shared_device : !hal.device
+  %buffer = util.global.load @_constant : !hal.buffer
+  %layout = util.global.load @_executable_layout_0 : !hal.executable_layout
+  %executable = util.global.load @_executable_ex : !hal.executable
+  // CHECK: %[[CMD:.+]] = util.global.load @_command_buffer_0 : !hal.command_buffer
+  // CHECK-NOT: hal.command_buffer
+  %cmd = hal.command_buffer.create device(%device : !hal.device)
+                                     mode("OneShot|AllowInlineExecution")
+                               categories("Transfer|Dispatch") : !hal.command_buffer
+  hal.command_buffer.begin<%cmd : !hal.command_buffer>
+  hal.command_buffer.push_descriptor_set<%cmd : !hal.command_buffer>
+      layout(%layout : !hal.executable_layout)[%c0]
+      bindings([
+        %c0 = (%buffer : !hal.buffer)[%c0, %c128]
+      ])
+  hal.command_buffer.dispatch<%cmd : !hal.command_buffer> target(%executable : !hal.executable)[0] workgroups([%c1, %c1, %c1])
+  hal.command_buffer.execution_barrier<%cmd : !hal.command_buffer> source("Dispatch|CommandRetire") target("CommandIssue|Dispatch") flags("None")
+  hal.command_buffer.end<%cmd : !hal.command_buffer>
+  // CHECK: hal.ex.submit_and_wait %{{.+}}, %[[CMD]]
+  hal.ex.submit_and_wait %device, %cmd
+  return
+}
+
+// Recordings referencing per-invocation buffers are left as-is.
+
+// CHECK-LABEL: func @variantRecording
+func.func @variantRecording(%buffer: !hal.buffer) {
+  %c0 = arith.constant 0 : index
+  %c1 = arith.constant 1 : index
+  %c128 = arith.constant 128 : index
+  %device = hal.ex.shared_device : !hal.device
+  %layout = util.global.load @_executable_layout_0 : !hal.executable_layout
+  %executable = util.global.load @_executable_ex : !hal.executable
+  // CHECK: %[[CMD:.+]] = hal.command_buffer.create
+  // CHECK-SAME: mode("OneShot|AllowInlineExecution")
+  %cmd = hal.command_buffer.create device(%device : !hal.device)
+                                     mode("OneShot|AllowInlineExecution")
+                               categories("Transfer|Dispatch") : !hal.command_buffer
+  // CHECK: hal.command_buffer.begin<%[[CMD]] : !hal.command_buffer>
+  hal.command_buffer.begin<%cmd : !hal.command_buffer>
+  // CHECK: hal.command_buffer.push_descriptor_set<%[[CMD]] : !hal.command_buffer>
+  hal.command_buffer.push_descriptor_set<%cmd : !hal.command_buffer>
+      layout(%layout : !hal.executable_layout)[%c0]
+      bindings([
+        %c0 = (%buffer : !hal.buffer)[%c0, %c128]
+      ])
+  hal.command_buffer.dispatch<%cmd : !hal.command_buffer> target(%executable : !hal.executable)[0] workgroups([%c1, %c1, %c1])
+  // CHECK: hal.command_buffer.end<%[[CMD]] : !hal.command_buffer>
+  hal.command_buffer.end<%cmd : !hal.command_buffer>
+  hal.ex.submit_and_wait %device, %cmd
+  return
+}
+
+//      CHECK: util.global private @_command_buffer_0 : !hal.command_buffer
+// CHECK-NEXT: util.initializer {
+//  CHECK-DAG:   %[[DEVICE:.+]] = hal.ex.shared_device : !hal.device
+//  CHECK-DAG:   %[[LAYOUT:.+]] = util.global.load @_executable_layout_0 : !hal.executable_layout
+//  CHECK-DAG:   %[[BUFFER:.+]] = util.global.load @_constant : !hal.buffer
+//  CHECK-DAG:   %[[EXECUTABLE:.+]] = util.global.load @_executable_ex : !hal.executable
+//      CHECK:   %[[CMD:.+]] = hal.command_buffer.create device(%[[DEVICE]] : !hal.device) mode(None) categories("Transfer|Dispatch") : !hal.command_buffer
+// CHECK-NEXT:   hal.command_buffer.begin<%[[CMD]] : !hal.command_buffer>
+// CHECK-NEXT:   hal.command_buffer.push_descriptor_set<%[[CMD]] : !hal.command_buffer>
+// CHECK-SAME:       layout(%[[LAYOUT]] : !hal.executable_layout)
+//      CHECK:     = (%[[BUFFER]] : !hal.buffer)
+//      CHECK:   hal.command_buffer.dispatch<%[[CMD]] : !hal.command_buffer> target(%[[EXECUTABLE]] : !hal.executable)[0]
+// CHECK-NEXT:   hal.command_buffer.execution_barrier<%[[CMD]] : !hal.command_buffer>
+// CHECK-NEXT:   hal.command_buffer.end<%[[CMD]] : !hal.command_buffer>
+// CHECK-NEXT:   util.global.store %[[CMD]], @_command_buffer_0 : !hal.command_buffer
+// CHECK-NEXT:   util.initializer.return
+// CHECK-NOT: @_command_buffer_1
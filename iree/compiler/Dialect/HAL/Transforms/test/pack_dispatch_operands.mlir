@@ -128,3 +128,130 @@ func.func @host_index(%arg0: index) -> !stream.timepoint {
   } => !stream.timepoint
   return %1 : !stream.timepoint
 }
+
+// -----
+
+// Narrow operands are packed together widest-first so that every value is
+// naturally aligned. The i64 with known small values only needs 8 bits.
+
+stream.executable private @ex4 {
+  stream.executable.export public @device_packed
+  builtin.module {
+    // CHECK-LABEL: func @device_packed
+    // CHECK-SAME: (%arg0: i32, %arg1: i32, %arg2: !stream.binding)
+    func.func @device_packed(%arg0: i8, %arg1: f32, %arg2: i16, %arg3: i64 {stream.values = [0 : i64, 200 : i64]}, %arg4: !stream.binding) {
+      // CHECK-DAG: %[[DEV_I8_SHR:.+]] = arith.shrui %arg1, %c16
+      // CHECK-DAG: %[[DEV_I8_AND:.+]] = arith.andi %[[DEV_I8_SHR]], %c255
+      // CHECK-DAG: %[[DEV_I8:.+]] = arith.trunci %[[DEV_I8_AND]] : i32 to i8
+      // CHECK-DAG: %[[DEV_F32:.+]] = arith.bitcast %arg0 : i32 to f32
+      // CHECK-DAG: %[[DEV_I16_AND:.+]] = arith.andi %arg1, %c65535
+      // CHECK-DAG: %[[DEV_I16:.+]] = arith.trunci %[[DEV_I16_AND]] : i32 to i16
+      // CHECK-DAG: %[[DEV_I64_SHR:.+]] = arith.shrui %arg1, %c24
+      // CHECK-DAG: %[[DEV_I64:.+]] = arith.extui %[[DEV_I64_SHR]] {stream.values = [0, 200]} : i32 to i64
+      // CHECK: util.do_not_optimize(%[[DEV_I8]])
+      util.do_not_optimize(%arg0) : i8
+      // CHECK-NEXT: util.do_not_optimize(%[[DEV_F32]])
+      util.do_not_optimize(%arg1) : f32
+      // CHECK-NEXT: util.do_not_optimize(%[[DEV_I16]])
+      util.do_not_optimize(%arg2) : i16
+      // CHECK-NEXT: util.do_not_optimize(%[[DEV_I64]])
+      util.do_not_optimize(%arg3) : i64
+      return
+    }
+  }
+}
+func.func @host_packed(%arg0: i8, %arg1: f32, %arg2: i16, %arg3: i64) -> !stream.timepoint {
+  %c0 = arith.constant 0 : index
+  %c1 = arith.constant 1 : index
+  %c128 = arith.constant 128 : index
+  %0 = stream.resource.alloc uninitialized : !stream.resource<external>{%c128}
+  // CHECK-DAG: %[[HOST_I8:.+]] = arith.extui %arg0 : i8 to i32
+  // CHECK-DAG: %[[HOST_I8_SHL:.+]] = arith.shli %[[HOST_I8]], %c16
+  // CHECK-DAG: %[[HOST_F32:.+]] = arith.bitcast %arg1 : f32 to i32
+  // CHECK-DAG: %[[HOST_I16:.+]] = arith.extui %arg2 : i16 to i32
+  // CHECK-DAG: %[[HOST_OR0:.+]] = arith.ori %[[HOST_I8_SHL]], %[[HOST_I16]]
+  // CHECK-DAG: %[[HOST_I64:.+]] = arith.trunci %arg3 : i64 to i32
+  // CHECK-DAG: %[[HOST_I64_SHL:.+]] = arith.shli %[[HOST_I64]], %c24
+  // CHECK-DAG: %[[HOST_OR1:.+]] = arith.ori %[[HOST_OR0]], %[[HOST_I64_SHL]]
+  %1 = stream.cmd.execute with(%0 as %arg4: !stream.resource<external>{%c128}) {
+    // CHECK: stream.cmd.dispatch {{.+}}(%[[HOST_F32]], %[[HOST_OR1]] : i32, i32)
+    stream.cmd.dispatch @ex4::@device_packed[%c1, %c1, %c1](%arg0, %arg1, %arg2, %arg3 : i8, f32, i16, i64) {
+      wo %arg4[%c0 for %c128] : !stream.resource<external>{%c128}
+    }
+  } => !stream.timepoint
+  return %1 : !stream.timepoint
+}
+
+// -----
+
+// 64-bit operands are placed first so that they start on an even dword.
+
+stream.executable private @ex5 {
+  stream.executable.export public @device_aligned
+  builtin.module {
+    // CHECK-LABEL: func @device_aligned
+    // CHECK-SAME: (%arg0: i32, %arg1: i32, %arg2: i32, %arg3: !stream.binding)
+    func.func @device_aligned(%arg0: i32, %arg1: f64, %arg2: !stream.binding) {
+      // CHECK-DAG: %[[DEV_LO64:.+]] = arith.extui %arg0 : i32 to i64
+      // CHECK-DAG: %[[DEV_HI64:.+]] = arith.extui %arg1 : i32 to i64
+      // CHECK-DAG: %[[DEV_HISHL:.+]] = arith.shli %[[DEV_HI64]], %c32
+      // CHECK-DAG: %[[DEV_I64:.+]] = arith.ori %[[DEV_LO64]], %[[DEV_HISHL]]
+      // CHECK-DAG: %[[DEV_F64:.+]] = arith.bitcast %[[DEV_I64]] : i64 to f64
+      // CHECK: util.do_not_optimize(%arg2)
+      util.do_not_optimize(%arg0) : i32
+      // CHECK-NEXT: util.do_not_optimize(%[[DEV_F64]])
+      util.do_not_optimize(%arg1) : f64
+      return
+    }
+  }
+}
+func.func @host_aligned(%arg0: i32, %arg1: f64) -> !stream.timepoint {
+  %c0 = arith.constant 0 : index
+  %c1 = arith.constant 1 : index
+  %c128 = arith.constant 128 : index
+  %0 = stream.resource.alloc uninitialized : !stream.resource<external>{%c128}
+  // CHECK-DAG: %[[HOST_I64:.+]] = arith.bitcast %arg1 : f64 to i64
+  // CHECK-DAG: %[[HOST_LO32:.+]] = arith.trunci %[[HOST_I64]] : i64 to i32
+  // CHECK-DAG: %[[HOST_HISHR:.+]] = arith.shrui %[[HOST_I64]], %c32
+  // CHECK-DAG: %[[HOST_HI32:.+]] = arith.trunci %[[HOST_HISHR]] : i64 to i32
+  %1 = stream.cmd.execute with(%0 as %arg2: !stream.resource<external>{%c128}) {
+    // CHECK: stream.cmd.dispatch {{.+}}(%[[HOST_LO32]], %[[HOST_HI32]], %arg0 : i32, i32, i32)
+    stream.cmd.dispatch @ex5::@device_aligned[%c1, %c1, %c1](%arg0, %arg1 : i32, f64) {
+      wo %arg2[%c0 for %c128] : !stream.resource<external>{%c128}
+    }
+  } => !stream.timepoint
+  return %1 : !stream.timepoint
+}
+
+// -----
+
+// Operands with a single known value are elided and materialized as constants.
+
+stream.executable private @ex6 {
+  stream.executable.export public @device_uniform
+  builtin.module {
+    // CHECK-LABEL: func @device_uniform
+    // CHECK-SAME: (%arg0: i32 {stream.values = [4 : i32, 8 : i32]}, %arg1: !stream.binding)
+    func.func @device_uniform(%arg0: index {stream.values = [128 : index]}, %arg1: i32 {stream.values = [4 : i32, 8 : i32]}, %arg2: !stream.binding) {
+      // CHECK: %[[DEV_UNIFORM:.+]] = arith.constant 128 : index
+      // CHECK: util.do_not_optimize(%[[DEV_UNIFORM]])
+      util.do_not_optimize(%arg0) : index
+      // CHECK-NEXT: util.do_not_optimize(%arg0)
+      util.do_not_optimize(%arg1) : i32
+      return
+    }
+  }
+}
+func.func @host_uniform(%arg0: i32) -> !stream.timepoint {
+  %c0 = arith.constant 0 : index
+  %c1 = arith.constant 1 : index
+  %c128 = arith.constant 128 : index
+  %0 = stream.resource.alloc uninitialized : !stream.resource<external>{%c128}
+  %1 = stream.cmd.execute with(%0 as %arg1: !stream.resource<external>{%c128}) {
+    // CHECK: stream.cmd.dispatch {{.+}}(%arg0 : i32)
+    stream.cmd.dispatch @ex6::@device_uniform[%c1, %c1, %c1](%c128, %arg0 : index, i32) {
+      wo %arg1[%c0 for %c128] : !stream.resource<external>{%c128}
+    }
+  } => !stream.timepoint
+  return %1 : !stream.timepoint
+}
@@ -13,20 +13,11 @@
 namespace mlir {
 namespace iree_compiler {
 
-LogicalResult InferCustomKernelsTargetInfoFromParent(
-    func::FuncOp entryPointFn, CustomKernelsTargetInfo &targetInfo) {
-  // Set the out-value to defaults early so that early returns produce
-  // consistent results and so that we can write simpler code below
-  // (for loop OR-ing booleans, assuming initial 'false' value).
+// Parses the target information from the configuration of |targetAttr|.
+static LogicalResult InferCustomKernelsTargetInfoFromExecutableTarget(
+    IREE::HAL::ExecutableTargetAttr targetAttr,
+    CustomKernelsTargetInfo &targetInfo) {
   targetInfo = CustomKernelsTargetInfo();
-
-  // Try to find the parent ExecutableVariantOp and its relevant attributes.
-  auto variantOp =
-      entryPointFn->getParentOfType<IREE::HAL::ExecutableVariantOp>();
-  if (!variantOp) {
-    return failure();
-  }
-  IREE::HAL::ExecutableTargetAttr targetAttr = variantOp.target();
   if (!targetAttr) {
     return failure();
   }
@@ -50,5 +41,50 @@ LogicalResult InferCustomKernelsTargetInfoFromParent(
   return ParseCustomKernelsTargetInfo(archName, featuresStr, targetInfo);
 }
 
+LogicalResult InferCustomKernelsTargetInfoFromParent(
+    func::FuncOp entryPointFn, CustomKernelsTargetInfo &targetInfo) {
+  // Set the out-value to defaults early so that early returns produce
+  // consistent results and so that we can write simpler code below
+  // (for loop OR-ing booleans, assuming initial 'false' value).
+  targetInfo = CustomKernelsTargetInfo();
+
+  // Try to find the parent ExecutableVariantOp and its relevant attributes.
+  auto variantOp =
+      entryPointFn->getParentOfType<IREE::HAL::ExecutableVariantOp>();
+  if (!variantOp) {
+    return failure();
+  }
+  return InferCustomKernelsTargetInfoFromExecutableTarget(variantOp.target(),
+                                                          targetInfo);
+}
+
+LogicalResult InferCustomKernelsTargetInfoFromDeviceTargets(
+    Operation *op, CustomKernelsTargetInfo &targetInfo) {
+  targetInfo = CustomKernelsTargetInfo();
+  bool foundTarget = false;
+  for (auto deviceTargetAttr : IREE::HAL::DeviceTargetAttr::lookup(op)) {
+    for (auto executableTargetAttr :
+         deviceTargetAttr.getExecutableTargets()) {
+      CustomKernelsTargetInfo executableTargetInfo;
+      if (failed(InferCustomKernelsTargetInfoFromExecutableTarget(
+              executableTargetAttr, executableTargetInfo))) {
+        // Not a CPU target (or one without feature information); it won't
+        // be consuming the data layouts we are choosing.
+        continue;
+      }
+      // Data layouts are chosen before executables get specialized per target
+      // so they have to be shared by all targets. Rather than picking one that
+      // would be bad on some of them we give up if the targets disagree.
+      if (foundTarget && !(executableTargetInfo == targetInfo)) {
+        targetInfo = CustomKernelsTargetInfo();
+        return failure();
+      }
+      targetInfo = executableTargetInfo;
+      foundTarget = true;
+    }
+  }
+  return success(foundTarget);
+}
+
 }  // namespace iree_compiler
 }  // namespace mlir
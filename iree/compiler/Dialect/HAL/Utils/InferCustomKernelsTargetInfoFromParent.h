@@ -19,9 +19,17 @@
 namespace mlir {
 namespace iree_compiler {
 
+// Infers the target information from the hal.executable.target of the
+// executable variant containing |entryPointFn|.
 LogicalResult InferCustomKernelsTargetInfoFromParent(
     func::FuncOp entryPointFn, CustomKernelsTargetInfo &targetInfo);
 
+// Infers the target information from the hal.device.targets attribute on |op|
+// or its closest parent having one. Fails if there are no CPU executable
+// targets or if they don't all agree.
+LogicalResult InferCustomKernelsTargetInfoFromDeviceTargets(
+    Operation *op, CustomKernelsTargetInfo &targetInfo);
+
 }  // namespace iree_compiler
 }  // namespace mlir
 
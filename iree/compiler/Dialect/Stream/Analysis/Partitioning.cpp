@@ -155,14 +155,24 @@ void PartitionSet::topologicalSort() {
 
 PartitionSet partitionStreamableOps(IREE::Stream::PartitioningConfigAttr config,
                                     Block *block) {
-  // Only one algorithm today.
-  return partitionStreamableOpsReference(config, block);
+  switch (config.getAlgorithm().getValue()) {
+    default:
+    case IREE::Stream::PartitioningAlgorithm::Reference:
+      return partitionStreamableOpsReference(config, block);
+    case IREE::Stream::PartitioningAlgorithm::CostModel:
+      return partitionStreamableOpsCostModel(config, block);
+  }
 }
 
 PartitionSet partitionRegionConcurrency(
     IREE::Stream::PartitioningConfigAttr config, Block *block) {
-  // Only one algorithm today.
-  return partitionRegionConcurrencyReference(config, block);
+  switch (config.getAlgorithm().getValue()) {
+    default:
+    case IREE::Stream::PartitioningAlgorithm::Reference:
+      return partitionRegionConcurrencyReference(config, block);
+    case IREE::Stream::PartitioningAlgorithm::CostModel:
+      return partitionRegionConcurrencyCostModel(config, block);
+  }
 }
 
 }  // namespace Stream
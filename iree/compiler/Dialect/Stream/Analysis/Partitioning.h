@@ -34,6 +34,8 @@ struct Partition {
   // partitions in cases where the op is to be duplicated. Not all ops are
   // streamable (such as constants and arithmetic).
   SetVector<Operation *> ops;
+  // Affinity shared by all ops in the partition, if any.
+  IREE::Stream::AffinityAttr affinity;
 
   void dump(Operation *parentOp);
 
@@ -123,6 +125,25 @@ PartitionSet partitionStreamableOpsReference(
 PartitionSet partitionRegionConcurrencyReference(
     IREE::Stream::PartitioningConfigAttr config, Block *block);
 
+//===----------------------------------------------------------------------===//
+// Cost-model partitioning
+//===----------------------------------------------------------------------===//
+
+// Clustering based on partitionStreamableOpsReference that uses static
+// resource sizes to choose between legal placements: producers go into the
+// first of their consuming partitions to execute and partitions are split when
+// favoring memory before their transient footprint exceeds the max allocation
+// size. As with the reference algorithm any side-effecting op that is not
+// streamable flushes all partitions.
+PartitionSet partitionStreamableOpsCostModel(
+    IREE::Stream::PartitioningConfigAttr config, Block *block);
+
+// Wave formation that balances estimated execution cost (max-concurrency) or
+// transient memory (min-peak-memory) across the waves each op may legally be
+// placed in.
+PartitionSet partitionRegionConcurrencyCostModel(
+    IREE::Stream::PartitioningConfigAttr config, Block *block);
+
 }  // namespace Stream
 }  // namespace IREE
 }  // namespace iree_compiler
@@ -0,0 +1,543 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/compiler/Dialect/Stream/Analysis/Partitioning.h"
+#include "iree/compiler/Dialect/Stream/IR/StreamOps.h"
+#include "iree/compiler/Dialect/Util/IR/UtilTypes.h"
+#include "llvm/ADT/BitVector.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/Support/Debug.h"
+#include "mlir/IR/Matchers.h"
+#include "mlir/IR/PatternMatch.h"
+#include "mlir/IR/SymbolTable.h"
+#include "mlir/Interfaces/SideEffectInterfaces.h"
+
+#define DEBUG_TYPE "iree-stream-partitioning"
+
+namespace mlir {
+namespace iree_compiler {
+namespace IREE {
+namespace Stream {
+
+//===----------------------------------------------------------------------===//
+// Cost model
+//===----------------------------------------------------------------------===//
+
+// Workgroup count assumed for each dynamic workgroup count dimension.
+static constexpr int64_t kDynamicWorkgroupCount = 64;
+
+// Resource size, in bytes, assumed for dynamically-sized resources when
+// estimating transfer costs. Dynamic sizes never count against memory budgets.
+static constexpr int64_t kDynamicResourceSize = 64 * 1024;
+
+// Ops with an estimated cost below this are not worth rebalancing across
+// concurrency waves and are kept as close to their consumers as possible.
+static constexpr int64_t kMinBalancedOpCost = 4 * 1024;
+
+namespace {
+
+// Estimates the relative cost of streamable ops and the transient memory they
+// produce. Costs are in arbitrary units (roughly "bytes or element ops") and
+// only meaningful relative to each other.
+class PartitioningCostModel {
+ public:
+  // Returns the estimated execution cost of |op|.
+  int64_t getOpCost(Operation *op) {
+    auto it = opCosts.find(op);
+    if (it != opCosts.end()) return it->second;
+    int64_t cost = calculateOpCost(op);
+    opCosts[op] = cost;
+    return cost;
+  }
+
+  // Returns the total static size in bytes of all resources produced by |op|.
+  // Dynamically-sized results are not included.
+  int64_t getStaticResultBytes(Operation *op) {
+    int64_t totalBytes = 0;
+    for (auto result : op->getResults()) {
+      totalBytes += getStaticResourceSize(op, result).getValueOr(0);
+    }
+    return totalBytes;
+  }
+
+  // Returns the total size in bytes of |value| as consumed by |op|, using an
+  // estimate if the size is dynamic.
+  int64_t getValueBytes(Value value) {
+    auto *definingOp = value.getDefiningOp();
+    if (!definingOp) return kDynamicResourceSize;
+    return getStaticResourceSize(definingOp, value)
+        .getValueOr(kDynamicResourceSize);
+  }
+
+ private:
+  // Returns the constant size of |result| if it is a resource with a static
+  // size.
+  static Optional<int64_t> getStaticResourceSize(Operation *op, Value result) {
+    if (!result.getType().isa<IREE::Stream::ResourceType>()) return llvm::None;
+    auto sizeAwareOp = dyn_cast<IREE::Util::SizeAwareOpInterface>(op);
+    if (!sizeAwareOp) return llvm::None;
+    auto sizeValue = sizeAwareOp.getResultSizeFromValue(result);
+    APInt size;
+    if (!sizeValue || !matchPattern(sizeValue, m_ConstantInt(&size))) {
+      return llvm::None;
+    }
+    return size.getSExtValue();
+  }
+
+  int64_t calculateOpCost(Operation *op) {
+    if (auto dispatchOp = dyn_cast<IREE::Stream::AsyncDispatchOp>(op)) {
+      return calculateDispatchCost(dispatchOp);
+    }
+    // Transfer-like ops (copies, fills, splats, etc) scale with the bytes they
+    // touch.
+    int64_t cost = 0;
+    for (auto result : op->getResults()) {
+      if (result.getType().isa<IREE::Stream::ResourceType>()) {
+        cost += getValueBytes(result);
+      }
+    }
+    return std::max<int64_t>(cost, 1);
+  }
+
+  // Dispatch cost is the total workgroup count scaled by the amount of work
+  // performed per workgroup. As partitioning runs prior to codegen we
+  // approximate the work per workgroup by the number of compute ops in the
+  // dispatch function.
+  int64_t calculateDispatchCost(IREE::Stream::AsyncDispatchOp dispatchOp) {
+    int64_t workgroupCount = 1;
+    for (auto dim : dispatchOp.workgroup_count()) {
+      APInt dimValue;
+      if (matchPattern(dim, m_ConstantInt(&dimValue))) {
+        workgroupCount *= std::max<int64_t>(dimValue.getSExtValue(), 1);
+      } else {
+        workgroupCount *= kDynamicWorkgroupCount;
+      }
+    }
+    int64_t opsPerWorkgroup = 1;
+    auto exportOp =
+        SymbolTable::lookupNearestSymbolFrom<IREE::Stream::ExecutableExportOp>(
+            dispatchOp, dispatchOp.entry_point());
+    if (exportOp) {
+      opsPerWorkgroup = getComputeOpCount(exportOp);
+    }
+    return workgroupCount * opsPerWorkgroup;
+  }
+
+  int64_t getComputeOpCount(IREE::Stream::ExecutableExportOp exportOp) {
+    auto it = exportOpCounts.find(exportOp);
+    if (it != exportOpCounts.end()) return it->second;
+    int64_t count = 1;
+    if (auto funcOp = exportOp.getFunctionRef()) {
+      funcOp.walk([&](Operation *op) {
+        if (op->getNumRegions() == 0 &&
+            !op->hasTrait<OpTrait::ConstantLike>() &&
+            !op->hasTrait<OpTrait::IsTerminator>()) {
+          ++count;
+        }
+      });
+    }
+    exportOpCounts[exportOp] = count;
+    return count;
+  }
+
+  DenseMap<Operation *, int64_t> opCosts;
+  DenseMap<Operation *, int64_t> exportOpCounts;
+};
+
+}  // namespace
+
+// Builds a partition with the given |ops| (in reverse order) and computes the
+// values captured and escaping it.
+static Partition buildPartition(SetVector<Operation *> ops,
+                                IREE::Stream::AffinityAttr affinity = {}) {
+  Partition partition;
+  partition.affinity = affinity;
+  SetVector<Value> consumedValues;
+  SetVector<Value> producedValues;
+  SetVector<Value> escapingValues;
+  for (auto *op : llvm::reverse(ops)) {
+    for (auto operand : op->getOperands()) {
+      consumedValues.insert(operand);
+    }
+    for (auto result : op->getResults()) {
+      producedValues.insert(result);
+      for (auto user : result.getUsers()) {
+        if (!ops.contains(user)) {
+          escapingValues.insert(result);
+          break;
+        }
+      }
+    }
+  }
+  consumedValues.set_subtract(producedValues);
+  partition.ins = consumedValues;
+  partition.outs = escapingValues;
+  partition.ops = std::move(ops);
+  return partition;
+}
+
+//===----------------------------------------------------------------------===//
+// Execution partitioning
+//===----------------------------------------------------------------------===//
+
+// Structured the same as partitionStreamableOpsReference except that when
+// favoring min-peak-memory partitions are split before their statically-known
+// transient footprint exceeds the maximum allocation size as such partitions
+// cannot be packed into a single transient allocation. Ops never move into a
+// partition emitted after one of their consumers even when the consumers
+// nearer to them are over budget.
+PartitionSet partitionStreamableOpsCostModel(
+    IREE::Stream::PartitioningConfigAttr config, Block *block) {
+  PartitionSet partitionSet;
+  PartitioningCostModel costModel;
+
+  auto favor = config.getFavor().getValue();
+  int64_t maxTransientBytes = INT64_MAX;
+  if (favor == IREE::Stream::Favor::MinPeakMemory) {
+    auto resourceConfig =
+        IREE::Stream::ResourceConfigAttr::lookup(block->getParentOp());
+    maxTransientBytes = resourceConfig.getMaxAllocationSize();
+  }
+
+  struct PartitionBuilder {
+    unsigned ordinal;
+    // Affinity of the partition.
+    IREE::Stream::AffinityAttr affinity;
+    // Ops present in the partition; ops may be present in multiple partitions.
+    SetVector<Operation *> ops;
+    // Total static size of all resources produced within the partition.
+    int64_t transientBytes = 0;
+  };
+  SmallVector<std::unique_ptr<PartitionBuilder>> builders;
+  llvm::BitVector usableBuilders;
+
+  struct OpInfo {
+    // Which partitions the op is contained within.
+    llvm::BitVector membership;
+    // Which partitions transitively depend on this operation.
+    llvm::BitVector hazards;
+  };
+  DenseMap<Operation *, OpInfo> opInfos;
+
+  auto addToPartition = [&](Operation &op, OpInfo &opInfo, unsigned ordinal,
+                            int64_t resultBytes) {
+    builders[ordinal]->ops.insert(&op);
+    builders[ordinal]->transientBytes += resultBytes;
+    opInfo.membership.set(ordinal);
+    opInfo.hazards.reset(ordinal);
+  };
+
+  for (auto &op : llvm::reverse(*block)) {
+    // Skip constants; they just add noise (and since they are heavily CSE'd
+    // they have lots of users to test).
+    if (op.hasTrait<OpTrait::ConstantLike>()) {
+      LLVM_DEBUG(llvm::dbgs() << "(ignoring constant)\n");
+      continue;
+    } else if (!isa<IREE::Stream::StreamableOpInterface>(op)) {
+      // Not a streamable op. If it has side-effects then we force a hazard on
+      // all builders so that we don't move ops across it.
+      if (!mlir::wouldOpBeTriviallyDead(&op)) {
+        LLVM_DEBUG({
+          llvm::dbgs() << "Side-effecting op forcing flush and freeze:\n";
+          op.dump();
+        });
+        usableBuilders.reset();
+      }
+      // Even though not a streamable op we still want to track it below.
+    }
+
+    // Initialize op info for this op - whether streamable or not. See
+    // partitionStreamableOpsReference for details.
+    auto &opInfo = opInfos[&op];
+    opInfo.hazards.reserve(builders.size() + 1);
+    opInfo.hazards.resize(builders.size(), /*t=*/false);
+
+    IREE::Stream::AffinityAttr affinityAttr;
+    if (auto affinityOp = dyn_cast<IREE::Stream::AffinityOpInterface>(op)) {
+      affinityAttr = affinityOp.getAffinity();
+    }
+
+    LLVM_DEBUG({
+      llvm::dbgs() << "====\nPartitioning op:\n";
+      op.dump();
+    });
+
+    // Set bits for each partition this op may be able to be placed into.
+    llvm::BitVector consumers(builders.size(), /*t=*/false);
+    for (auto result : op.getResults()) {
+      for (auto &use : result.getUses()) {
+        auto &userInfo = opInfos[use.getOwner()];
+        consumers |= userInfo.membership;
+        opInfo.hazards |= userInfo.membership;
+        opInfo.hazards |= userInfo.hazards;
+      }
+    }
+    llvm::BitVector candidates(builders.size(), /*t=*/true);
+    candidates ^= opInfo.hazards;
+    candidates |= consumers;
+    candidates &= usableBuilders;
+
+    // Partitions are emitted in reverse ordinal order so the op must go into
+    // a partition with an ordinal no lower than that of any of its consumers.
+    // The budget and affinity pruning below may remove the latest consumer and
+    // the op must then not fall back to an earlier one (or to an unrelated
+    // earlier partition) that would run after a consumer.
+    int lastConsumerOrdinal = consumers.find_last();
+    if (lastConsumerOrdinal > 0) candidates.reset(0, lastConsumerOrdinal);
+
+    // Prune candidates that do not have a compatible affinity.
+    for (auto ordinal : candidates.set_bits()) {
+      if (!IREE::Stream::AffinityAttr::areCompatible(
+              affinityAttr, builders[ordinal]->affinity)) {
+        LLVM_DEBUG(llvm::dbgs()
+                   << "Candidate partition " << ordinal << " incompatible\n");
+        candidates.reset(ordinal);
+      }
+    }
+
+    // If this op is not streamable then bail here; we've still setup the hazard
+    // map for following iteration.
+    auto streamableOp = dyn_cast<IREE::Stream::StreamableOpInterface>(op);
+    if (!streamableOp) {
+      LLVM_DEBUG(llvm::dbgs() << "Not streamable (skip)\n");
+      continue;
+    }
+
+    // Prune candidates that would exceed the transient memory budget.
+    int64_t resultBytes = costModel.getStaticResultBytes(&op);
+    for (auto ordinal : candidates.set_bits()) {
+      if (builders[ordinal]->transientBytes + resultBytes > maxTransientBytes) {
+        LLVM_DEBUG(llvm::dbgs() << "Candidate partition " << ordinal
+                                << " over transient memory budget\n");
+        candidates.reset(ordinal);
+      }
+    }
+
+    // First see which partitions are consuming this that we can also safely
+    // move in to.
+    consumers &= candidates;
+
+    opInfo.membership.reserve(builders.size() + 1);
+    opInfo.membership.resize(builders.size(), /*t=*/false);
+
+    // If we have one or more consumers we should go into those first.
+    if (consumers.any()) {
+      if (streamableOp.preferCloneToConsumers()) {
+        for (auto consumerOrdinal : consumers.set_bits()) {
+          LLVM_DEBUG(llvm::dbgs() << "Cloning into consumer partition "
+                                  << consumerOrdinal << "\n");
+          addToPartition(op, opInfo, consumerOrdinal, resultBytes);
+        }
+      } else {
+        int consumerOrdinal = consumers.find_last();
+        LLVM_DEBUG(llvm::dbgs() << "Moving into consumer partition "
+                                << consumerOrdinal << "\n");
+        addToPartition(op, opInfo, consumerOrdinal, resultBytes);
+      }
+      LLVM_DEBUG(llvm::dbgs() << "Handled streamable (continue)\n");
+      continue;
+    }
+
+    // No consumers - if there's any candidate then we'll go into that.
+    int firstCandidateOrdinal = candidates.find_first();
+    if (firstCandidateOrdinal != -1) {
+      LLVM_DEBUG(llvm::dbgs() << "Moving to first candidate partition "
+                              << firstCandidateOrdinal << " (continue)\n");
+      addToPartition(op, opInfo, firstCandidateOrdinal, resultBytes);
+      continue;
+    }
+
+    // Mark the op as having hazards against all other partitions.
+    if (!builders.empty()) {
+      opInfo.hazards.set(0, builders.size() - 1);
+    }
+
+    // Create a new partition just for this op.
+    opInfo.membership.resize(opInfo.membership.size() + 1, /*t=*/true);
+    auto builder = std::make_unique<PartitionBuilder>();
+    builder->ordinal = builders.size();
+    builder->affinity = affinityAttr;
+    builder->ops.insert(&op);
+    builder->transientBytes = resultBytes;
+    LLVM_DEBUG(llvm::dbgs()
+               << "Created partition " << builder->ordinal << "\n");
+    builders.push_back(std::move(builder));
+    usableBuilders.resize(builders.size(), /*t=*/true);
+  }
+
+  // Emit partitions in forward order (as they are topologically sorted in
+  // reverse order from our bottom-up walk).
+  for (auto &builder : llvm::reverse(builders)) {
+    partitionSet.partitions.push_back(
+        buildPartition(std::move(builder->ops), builder->affinity));
+  }
+
+  LLVM_DEBUG(partitionSet.dump(block->getParentOp()));
+
+  return partitionSet;
+}
+
+//===----------------------------------------------------------------------===//
+// Concurrency partitioning
+//===----------------------------------------------------------------------===//
+
+// Forms waves the same way as partitionRegionConcurrencyReference but places
+// each op within the range of waves it may legally execute in based on the
+// estimated cost of each wave:
+//  - max-concurrency: waves execute one after another and the ops within a
+//    wave concurrently, so a wave takes about as long as its most expensive op.
+//    Ops are placed into the wave their cost extends the least so that
+//    expensive dispatches with slack overlap with other expensive dispatches
+//    instead of serializing behind them in a wave of their own;
+//  - min-peak-memory: balances the transient bytes produced in each wave,
+//    preferring the earliest wave on ties as the reference algorithm does.
+// Cheap ops are never rebalanced and stay as close to their consumers as
+// possible to keep their results short-lived.
+PartitionSet partitionRegionConcurrencyCostModel(
+    IREE::Stream::PartitioningConfigAttr config, Block *block) {
+  PartitionSet waveSet;
+  PartitioningCostModel costModel;
+
+  auto favor = config.getFavor().getValue();
+  if (favor == IREE::Stream::Favor::Debug) {
+    // Disable partitioning when favoring debugability.
+    return waveSet;
+  }
+
+  struct WaveBuilder {
+    unsigned ordinal;
+    // Ops present in the wave; ops may be present in multiple waves.
+    SetVector<Operation *> ops;
+    // Estimated cost of the most expensive op in the wave.
+    int64_t maxOpCost = 0;
+    // Accumulated static size of all resources produced in the wave.
+    int64_t transientBytes = 0;
+  };
+  SmallVector<std::unique_ptr<WaveBuilder>> builders;
+
+  struct OpInfo {
+    // Which waves the op is contained within.
+    llvm::BitVector membership;
+    // Which waves transitively depend on this operation.
+    llvm::BitVector hazards;
+  };
+  DenseMap<Operation *, OpInfo> opInfos;
+
+  for (auto &op : llvm::reverse(*block)) {
+    // Skip constants; they just add noise (and since they are heavily CSE'd
+    // they have lots of users to test).
+    if (op.hasTrait<OpTrait::ConstantLike>()) {
+      LLVM_DEBUG(llvm::dbgs() << "(ignoring constant)\n");
+      continue;
+    }
+
+    // Initialize op info for this op - whether streamable or not. See
+    // partitionRegionConcurrencyReference for details.
+    auto &opInfo = opInfos[&op];
+    opInfo.hazards.reserve(builders.size() + 1);
+    opInfo.hazards.resize(builders.size(), /*t=*/false);
+
+    LLVM_DEBUG({
+      llvm::dbgs() << "====\nPartitioning op:\n";
+      op.dump();
+    });
+
+    for (auto user : op.getUsers()) {
+      auto &userInfo = opInfos[user];
+      opInfo.hazards |= userInfo.membership;
+      opInfo.hazards |= userInfo.hazards;
+    }
+    llvm::BitVector candidates(builders.size(), /*t=*/true);
+    candidates ^= opInfo.hazards;
+
+    // If this op is not streamable then bail here; we've still setup the hazard
+    // map for following iteration.
+    auto streamableOp = dyn_cast<IREE::Stream::StreamableOpInterface>(op);
+    if (!streamableOp || streamableOp.isMetadata()) {
+      LLVM_DEBUG(llvm::dbgs() << "Not streamable/is subview (skip)\n");
+      continue;
+    }
+
+    opInfo.membership.reserve(builders.size() + 1);
+    opInfo.membership.resize(builders.size(), /*t=*/false);
+
+    int64_t opCost = costModel.getOpCost(&op);
+    int64_t resultBytes = costModel.getStaticResultBytes(&op);
+
+    // Select the wave within the legal range that best fits the op for the
+    // configured favor. Candidates are contiguous as hazards always cover a
+    // prefix of the waves.
+    int waveOrdinal = -1;
+    if (candidates.any()) {
+      if (favor == IREE::Stream::Favor::MinPeakMemory) {
+        waveOrdinal = candidates.find_last();
+        for (auto ordinal : candidates.set_bits()) {
+          if (builders[ordinal]->transientBytes <
+              builders[waveOrdinal]->transientBytes) {
+            waveOrdinal = ordinal;
+          }
+        }
+      } else {
+        // Pick the wave whose estimated duration grows the least by adding
+        // the op; ties go to the earliest wave as in the reference algorithm.
+        auto getWaveCostIncrease = [&](int ordinal) {
+          return std::max<int64_t>(opCost - builders[ordinal]->maxOpCost, 0);
+        };
+        waveOrdinal = candidates.find_first();
+        if (opCost >= kMinBalancedOpCost) {
+          for (auto ordinal : candidates.set_bits()) {
+            if (getWaveCostIncrease(ordinal) <
+                getWaveCostIncrease(waveOrdinal)) {
+              waveOrdinal = ordinal;
+            }
+          }
+        }
+      }
+    }
+    if (waveOrdinal != -1) {
+      LLVM_DEBUG(llvm::dbgs()
+                 << "Moving to candidate wave " << waveOrdinal << " (cost "
+                 << builders[waveOrdinal]->maxOpCost << " vs " << opCost
+                 << ")\n");
+      auto &builder = builders[waveOrdinal];
+      builder->ops.insert(&op);
+      builder->maxOpCost = std::max(builder->maxOpCost, opCost);
+      builder->transientBytes += resultBytes;
+      opInfo.membership.set(waveOrdinal);
+      opInfo.hazards.set(0, waveOrdinal);
+      opInfo.hazards.reset(waveOrdinal);
+      continue;
+    }
+
+    // Mark the op as having hazards against all other waves.
+    opInfo.hazards.set(0, builders.size());
+
+    // Create a new wave just for this op.
+    opInfo.membership.resize(opInfo.membership.size() + 1, /*t=*/true);
+    auto builder = std::make_unique<WaveBuilder>();
+    builder->ordinal = builders.size();
+    builder->ops.insert(&op);
+    builder->maxOpCost = opCost;
+    builder->transientBytes = resultBytes;
+    LLVM_DEBUG(llvm::dbgs() << "Created wave " << builder->ordinal << "\n");
+    builders.push_back(std::move(builder));
+  }
+
+  // Emit waves in forward order (as they are topologically sorted in
+  // reverse order from our bottom-up walk).
+  for (auto &builder : llvm::reverse(builders)) {
+    waveSet.partitions.push_back(buildPartition(std::move(builder->ops)));
+  }
+
+  LLVM_DEBUG(waveSet.dump(block->getParentOp()));
+
+  return waveSet;
+}
+
+}  // namespace Stream
+}  // namespace IREE
+}  // namespace iree_compiler
+}  // namespace mlir
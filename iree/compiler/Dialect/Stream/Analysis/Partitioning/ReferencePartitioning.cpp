@@ -211,6 +211,7 @@ PartitionSet partitionStreamableOpsReference(
     partition.outs = escapingValues;
 
     partition.ops = std::move(builder->ops);
+    partition.affinity = builder->affinity;
     partitionSet.partitions.push_back(std::move(partition));
   }
 
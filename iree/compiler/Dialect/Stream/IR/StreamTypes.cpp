@@ -39,6 +39,17 @@ static llvm::cl::opt<Favor> partitioningFavor(
                    "Favor maximizing concurrency at the cost of additional "
                    "memory consumption.")));
 
+static llvm::cl::opt<PartitioningAlgorithm> partitioningAlgorithm(
+    "iree-stream-partitioning-algorithm",
+    llvm::cl::desc("Default stream partitioning algorithm."),
+    llvm::cl::init(PartitioningAlgorithm::Reference),
+    llvm::cl::values(
+        clEnumValN(PartitioningAlgorithm::Reference, "reference",
+                   "Greedy partitioning based solely on correctness."),
+        clEnumValN(PartitioningAlgorithm::CostModel, "cost-model",
+                   "Partitioning weighted by estimated dispatch cost and "
+                   "transient memory pressure.")));
+
 // TODO(#8506): remove the flag once the bug is fixed.
 static llvm::cl::opt<uint64_t> streamDefaultBufferAlignment(
     "iree-stream-default-buffer-alignment",
@@ -211,6 +222,7 @@ void PartitioningConfigAttr::walkImmediateSubElements(
     function_ref<void(Attribute)> walkAttrsFn,
     function_ref<void(Type)> walkTypesFn) const {
   walkAttrsFn(getFavor());
+  walkAttrsFn(getAlgorithm());
 }
 
 Attribute PartitioningConfigAttr::parse(AsmParser &p, Type type) {
@@ -221,20 +233,35 @@ Attribute PartitioningConfigAttr::parse(AsmParser &p, Type type) {
   } else if (failed(p.parseString(&favorStr))) {
     return {};
   }
+  std::string algorithmStr = "reference";
+  if (succeeded(p.parseOptionalComma())) {
+    if (failed(p.parseString(&algorithmStr))) return {};
+  }
   if (failed(p.parseGreater())) return {};
   auto favor = symbolizeFavor(favorStr);
   if (!favor.hasValue()) {
     p.emitError(p.getNameLoc(), "unknown favor value: ") << favorStr;
     return {};
   }
+  auto algorithm = symbolizePartitioningAlgorithm(algorithmStr);
+  if (!algorithm.hasValue()) {
+    p.emitError(p.getNameLoc(), "unknown partitioning algorithm: ")
+        << algorithmStr;
+    return {};
+  }
   return PartitioningConfigAttr::get(
-      FavorAttr::get(p.getContext(), favor.getValue()));
+      FavorAttr::get(p.getContext(), favor.getValue()),
+      PartitioningAlgorithmAttr::get(p.getContext(), algorithm.getValue()));
 }
 
 void PartitioningConfigAttr::print(AsmPrinter &p) const {
   p << "<";
   p << "favor-";
   p << stringifyFavor(getFavor().getValue());
+  if (getAlgorithm().getValue() != PartitioningAlgorithm::Reference) {
+    p << ", ";
+    p << stringifyPartitioningAlgorithm(getAlgorithm().getValue());
+  }
   p << ">";
 }
 
@@ -247,7 +274,9 @@ PartitioningConfigAttr PartitioningConfigAttr::lookup(Operation *op) {
   }
   // No config found; use defaults.
   auto favorAttr = FavorAttr::get(attrId.getContext(), partitioningFavor);
-  return PartitioningConfigAttr::get(favorAttr);
+  auto algorithmAttr = PartitioningAlgorithmAttr::get(attrId.getContext(),
+                                                      partitioningAlgorithm);
+  return PartitioningConfigAttr::get(favorAttr, algorithmAttr);
 }
 
 //===----------------------------------------------------------------------===//
@@ -328,6 +357,7 @@ Value ResourceType::inferSizeFromValue(Location loc, Value value,
 void StreamDialect::registerAttributes() {
   // Register command line flags:
   (void)partitioningFavor;
+  (void)partitioningAlgorithm;
 
   addAttributes<
 #define GET_ATTRDEF_LIST
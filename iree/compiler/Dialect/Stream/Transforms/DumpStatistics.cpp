@@ -4,6 +4,8 @@
 // See https://llvm.org/LICENSE.txt for license information.
 // SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
 
+#include <algorithm>
+#include <string>
 #include <utility>
 
 #include "iree/compiler/Dialect/Stream/IR/StreamDialect.h"
@@ -13,6 +15,9 @@
 #include "iree/compiler/Dialect/Stream/Transforms/Passes.h"
 #include "iree/compiler/Dialect/Util/IR/UtilDialect.h"
 #include "iree/compiler/Dialect/Util/IR/UtilOps.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SetVector.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/TypeSwitch.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Format.h"
@@ -46,7 +51,15 @@ struct UsageInfo {
   llvm::MapVector<mlir::func::FuncOp, SmallVector<IREE::Stream::CmdDispatchOp>>
       exportDispatchOps;
 
-  // TODO(benvanik): resource allocations.
+  // util.byte_buffer.constant ops embedding resource contents in the module.
+  SmallVector<IREE::Util::ByteBufferConstantOp> bufferConstantOps;
+
+  // stream.resource.alloc ops allocating resources outside of streams.
+  SmallVector<IREE::Stream::ResourceAllocOp> allocOps;
+
+  // stream.resource.map/try_map ops mapping host memory into resources.
+  SmallVector<IREE::Stream::ResourceMapOp> mapOps;
+  SmallVector<IREE::Stream::ResourceTryMapOp> tryMapOps;
 
   // stream.cmd.execute ops containing all relevant device commands.
   SmallVector<IREE::Stream::CmdExecuteOp> executeOps;
@@ -55,6 +68,9 @@ struct UsageInfo {
   // stream.timepoint.await ops indicating host/device synchronization.
   SmallVector<IREE::Stream::TimepointAwaitOp> awaitOps;
 
+  // Top-level functions and initializers performing stream work.
+  SmallVector<FunctionOpInterface> funcLikeOps;
+
   void analyze(mlir::ModuleOp moduleOp) {
     SymbolTable symbolTable(moduleOp);
     for (auto globalOp : moduleOp.getOps<IREE::Util::GlobalOp>()) {
@@ -66,8 +82,17 @@ struct UsageInfo {
       executableOps[executableOp.getName()] = executableOp;
     }
     for (auto funcLikeOp : moduleOp.getOps<FunctionOpInterface>()) {
+      size_t streamOpCount = allocaOps.size() + executeOps.size();
       funcLikeOp.walk([&](Operation *op) {
         TypeSwitch<Operation *>(op)
+            .Case<IREE::Util::ByteBufferConstantOp>(
+                [&](auto op) { bufferConstantOps.push_back(op); })
+            .Case<IREE::Stream::ResourceAllocOp>(
+                [&](auto op) { allocOps.push_back(op); })
+            .Case<IREE::Stream::ResourceMapOp>(
+                [&](auto op) { mapOps.push_back(op); })
+            .Case<IREE::Stream::ResourceTryMapOp>(
+                [&](auto op) { tryMapOps.push_back(op); })
             .Case<IREE::Stream::ResourceAllocaOp>(
                 [&](auto op) { allocaOps.push_back(op); })
             .Case<IREE::Stream::CmdExecuteOp>(
@@ -75,6 +100,9 @@ struct UsageInfo {
             .Case<IREE::Stream::TimepointAwaitOp>(
                 [&](auto op) { awaitOps.push_back(op); });
       });
+      if (allocaOps.size() + executeOps.size() != streamOpCount) {
+        funcLikeOps.push_back(funcLikeOp);
+      }
     }
     for (auto executeOp : executeOps) {
       executeOp.walk([&](IREE::Stream::CmdDispatchOp dispatchOp) {
@@ -89,6 +117,56 @@ struct UsageInfo {
   }
 };
 
+// Returns true if |byteBufferOp| contains constant resource data (as opposed to
+// initial variable values) by checking whether it's mapped as a constant.
+static bool isConstantByteBuffer(
+    IREE::Util::ByteBufferConstantOp byteBufferOp) {
+  for (auto user : byteBufferOp.result().getUsers()) {
+    auto tryMapOp = dyn_cast<IREE::Stream::ResourceTryMapOp>(user);
+    if (!tryMapOp) continue;
+    auto resourceType =
+        tryMapOp.result().getType().cast<IREE::Stream::ResourceType>();
+    if (resourceType.getLifetime() == IREE::Stream::Lifetime::Constant) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Execution statistics for a single function or initializer.
+struct FunctionStatistics {
+  size_t submissionCount = 0;
+  size_t awaitCount = 0;
+  // Maximum transient memory live at any point in the function as allocated
+  // in program order and released at each stream.resource.dealloca.
+  int64_t peakTransientSize = 0;
+  bool peakTransientSizeDynamic = false;
+
+  void analyze(FunctionOpInterface funcLikeOp) {
+    int64_t liveTransientSize = 0;
+    funcLikeOp.walk<WalkOrder::PreOrder>([&](Operation *op) {
+      TypeSwitch<Operation *>(op)
+          .Case<IREE::Stream::CmdExecuteOp>([&](auto op) { ++submissionCount; })
+          .Case<IREE::Stream::TimepointAwaitOp>([&](auto op) { ++awaitCount; })
+          .Case<IREE::Stream::ResourceAllocaOp>([&](auto op) {
+            APInt allocaSize;
+            if (!matchPattern(op.storage_size(), m_ConstantInt(&allocaSize))) {
+              peakTransientSizeDynamic = true;
+              return;
+            }
+            liveTransientSize += allocaSize.getSExtValue();
+            peakTransientSize = std::max(peakTransientSize, liveTransientSize);
+          })
+          .Case<IREE::Stream::ResourceDeallocaOp>([&](auto op) {
+            APInt deallocaSize;
+            if (matchPattern(op.operand_size(), m_ConstantInt(&deallocaSize))) {
+              liveTransientSize -= deallocaSize.getSExtValue();
+            }
+          });
+    });
+  }
+};
+
 // TODO(benvanik): StaticSize helper or something for the dynamic bit.
 struct Statistics {
   // Globals:
@@ -101,14 +179,30 @@ struct Statistics {
 
   // Synchronization:
   size_t awaitCount = 0;
+  size_t mapCount = 0;
+  size_t tryMapCount = 0;
+  int64_t stagingSize = 0;
+  bool stagingSizeDynamic = false;
 
   // Execution:
   size_t submissionCount = 0;
   int64_t transientSize = 0;
   bool transientSizeDynamic = false;
-  // TODO(benvanik): add fill/copy sizes (when possible).
+  // Maximum peakTransientSize of any single function.
+  int64_t peakTransientSize = 0;
+  bool peakTransientSizeDynamic = false;
+  size_t allocationCount = 0;
+  int64_t allocationSize = 0;
+  bool allocationSizeDynamic = false;
+  // Size the allocations would have required without packing. Equal to
+  // allocationSize if no allocations were packed.
+  int64_t unpackedAllocationSize = 0;
   size_t fillCount = 0;
+  int64_t fillSize = 0;
+  bool fillSizeDynamic = false;
   size_t copyCount = 0;
+  int64_t copySize = 0;
+  bool copySizeDynamic = false;
   size_t dispatchCount = 0;
 
   // Executables:
@@ -119,7 +213,6 @@ struct Statistics {
     for (auto it : usageInfo.resourceGlobalOps) {
       auto globalType = it.second.type().dyn_cast<IREE::Stream::ResourceType>();
       if (!globalType) continue;
-      // TODO(benvanik): analyze size in UsageInfo.
       switch (globalType.getLifetime()) {
         case IREE::Stream::Lifetime::Constant:
           ++constantCount;
@@ -131,9 +224,33 @@ struct Statistics {
           continue;
       }
     }
+    // Globals are initialized from packed byte buffers embedded in the module.
+    for (auto byteBufferOp : usageInfo.bufferConstantOps) {
+      bool isConstant = isConstantByteBuffer(byteBufferOp);
+      auto &size = isConstant ? constantSize : variableSize;
+      auto &sizeDynamic =
+          isConstant ? constantSizeDynamic : variableSizeDynamic;
+      if (auto serializableAttr =
+              byteBufferOp.value()
+                  .dyn_cast<IREE::Util::SerializableAttrInterface>()) {
+        size += serializableAttr.getStorageSize();
+      } else {
+        sizeDynamic = true;
+      }
+    }
 
     // Synchronization:
     awaitCount = usageInfo.awaitOps.size();
+    mapCount = usageInfo.mapOps.size();
+    tryMapCount = usageInfo.tryMapOps.size();
+    for (auto mapOp : usageInfo.mapOps) {
+      APInt mapSize;
+      if (matchPattern(mapOp.result_size(), m_ConstantInt(&mapSize))) {
+        stagingSize += mapSize.getSExtValue();
+      } else {
+        stagingSizeDynamic = true;
+      }
+    }
 
     // Execution:
     submissionCount = usageInfo.executeOps.size();
@@ -145,11 +262,50 @@ struct Statistics {
         transientSizeDynamic = true;
       }
     }
+    for (auto funcLikeOp : usageInfo.funcLikeOps) {
+      FunctionStatistics funcStats;
+      funcStats.analyze(funcLikeOp);
+      peakTransientSize =
+          std::max(peakTransientSize, funcStats.peakTransientSize);
+      peakTransientSizeDynamic |= funcStats.peakTransientSizeDynamic;
+    }
+    allocationCount = usageInfo.allocOps.size();
+    for (auto allocOp : usageInfo.allocOps) {
+      for (auto storageSize : allocOp.storage_sizes()) {
+        APInt allocSize;
+        if (!matchPattern(storageSize, m_ConstantInt(&allocSize))) {
+          allocationSizeDynamic = true;
+          continue;
+        }
+        allocationSize += allocSize.getSExtValue();
+        // PackAllocations records the size prior to packing.
+        if (auto unpackedSizeAttr =
+                allocOp->getAttrOfType<IntegerAttr>("stream.unpacked_size")) {
+          unpackedAllocationSize += unpackedSizeAttr.getInt();
+        } else {
+          unpackedAllocationSize += allocSize.getSExtValue();
+        }
+      }
+    }
+    auto accumulateSize = [](Value length, int64_t &size, bool &sizeDynamic) {
+      APInt lengthValue;
+      if (matchPattern(length, m_ConstantInt(&lengthValue))) {
+        size += lengthValue.getSExtValue();
+      } else {
+        sizeDynamic = true;
+      }
+    };
     for (auto executeOp : usageInfo.executeOps) {
       executeOp.walk([&](Operation *op) {
         TypeSwitch<Operation *>(op)
-            .Case<IREE::Stream::CmdFillOp>([&](auto op) { ++fillCount; })
-            .Case<IREE::Stream::CmdCopyOp>([&](auto op) { ++copyCount; })
+            .Case<IREE::Stream::CmdFillOp>([&](auto op) {
+              ++fillCount;
+              accumulateSize(op.target_length(), fillSize, fillSizeDynamic);
+            })
+            .Case<IREE::Stream::CmdCopyOp>([&](auto op) {
+              ++copyCount;
+              accumulateSize(op.length(), copySize, copySizeDynamic);
+            })
             .Case<IREE::Stream::CmdDispatchOp>(
                 [&](auto op) { ++dispatchCount; });
       });
@@ -160,6 +316,44 @@ struct Statistics {
   }
 };
 
+// Statistics about the interface of a single executable export.
+struct ExportStatistics {
+  size_t bindingCount = 0;
+  // Bindings without a known base alignment; these may force the target to
+  // emit slower unaligned loads/stores.
+  size_t unalignedBindingCount = 0;
+  size_t operandCount = 0;
+  size_t dispatchCount = 0;
+
+  void analyze(const UsageInfo &usageInfo,
+               IREE::Stream::ExecutableExportOp exportOp) {
+    auto funcOp = exportOp.getFunctionRef();
+    if (!funcOp) return;
+    for (auto arg : funcOp.getArguments()) {
+      if (!arg.getType().isa<IREE::Stream::BindingType>()) {
+        ++operandCount;
+        continue;
+      }
+      ++bindingCount;
+      if (!funcOp.getArgAttrOfType<IntegerAttr>(arg.getArgNumber(),
+                                                 "stream.alignment")) {
+        ++unalignedBindingCount;
+      }
+    }
+    auto it = usageInfo.exportDispatchOps.find(funcOp);
+    if (it != usageInfo.exportDispatchOps.end()) {
+      dispatchCount = it->second.size();
+    }
+  }
+};
+
+// Formats |size| as `[minimum ]N B (M MiB)`.
+static std::string formatSize(int64_t size, bool sizeDynamic) {
+  return llvm::formatv("{0}{1} B ({2:F2} MiB)", sizeDynamic ? "minimum " : "",
+                       size, size / (1 * 1024 * 1024.0f))
+      .str();
+}
+
 //===----------------------------------------------------------------------===//
 // Pretty printing
 //===----------------------------------------------------------------------===//
@@ -222,9 +416,22 @@ static void prettyPrintStatistics(const UsageInfo &usageInfo,
   os << llvm::formatv(
       "{0}{1} B ({2:F2} MiB)\n", stats.transientSizeDynamic ? "minimum " : "",
       stats.transientSize, stats.transientSize / (1 * 1024 * 1024.0f));
+  os << llvm::formatv(
+      "//  Peak Usage: {0} transient\n",
+      formatSize(stats.peakTransientSize, stats.peakTransientSizeDynamic));
 
-  os << llvm::formatv("//   DMA Fills: {0}\n", stats.fillCount);
-  os << llvm::formatv("//  DMA Copies: {0}\n", stats.copyCount);
+  os << llvm::formatv("// Allocations: {0}, ", stats.allocationCount);
+  os << llvm::formatv(
+      "{0}{1} B ({2:F2} MiB) packed from {3} B ({4:F2} MiB)\n",
+      stats.allocationSizeDynamic ? "minimum " : "", stats.allocationSize,
+      stats.allocationSize / (1 * 1024 * 1024.0f),
+      stats.unpackedAllocationSize,
+      stats.unpackedAllocationSize / (1 * 1024 * 1024.0f));
+
+  os << llvm::formatv("//   DMA Fills: {0}, {1}\n", stats.fillCount,
+                      formatSize(stats.fillSize, stats.fillSizeDynamic));
+  os << llvm::formatv("//  DMA Copies: {0}, {1}\n", stats.copyCount,
+                      formatSize(stats.copySize, stats.copySizeDynamic));
   os << llvm::formatv("//  Dispatches: {0}\n", stats.dispatchCount);
 
   os << llvm::formatv(
@@ -241,11 +448,56 @@ static void prettyPrintGlobalInfo(const UsageInfo &usageInfo, bool verbose,
   prettyPrintSectionHeader("Constants / Variables", os);
   os << "//\n";
 
-  // TODO(benvanik): print global information:
-  // - number of resource globals: constants/variables
-  // - util.byte_buffer.constant sizes (fed into stream.resource.try_map/map)
-  // - variable allocation sizes
-  os << "// TODO\n";
+  Statistics stats;
+  stats.analyze(usageInfo);
+
+  os << llvm::formatv(
+      "//     Constant Globals: {0}, {1} embedded\n", stats.constantCount,
+      formatSize(stats.constantSize, stats.constantSizeDynamic));
+  os << llvm::formatv(
+      "//     Variable Globals: {0}, {1} embedded\n", stats.variableCount,
+      formatSize(stats.variableSize, stats.variableSizeDynamic));
+  os << llvm::formatv("//         Byte Buffers: {0}\n",
+                      usageInfo.bufferConstantOps.size());
+
+  // Variables are allocated up-front and initialized from staging buffers.
+  int64_t variableAllocationSize = 0;
+  bool variableAllocationSizeDynamic = false;
+  for (auto allocOp : usageInfo.allocOps) {
+    for (auto it : llvm::zip(allocOp.results(), allocOp.storage_sizes())) {
+      auto resourceType =
+          std::get<0>(it).getType().cast<IREE::Stream::ResourceType>();
+      if (resourceType.getLifetime() != IREE::Stream::Lifetime::Variable) {
+        continue;
+      }
+      APInt allocSize;
+      if (matchPattern(std::get<1>(it), m_ConstantInt(&allocSize))) {
+        variableAllocationSize += allocSize.getSExtValue();
+      } else {
+        variableAllocationSizeDynamic = true;
+      }
+    }
+  }
+  os << llvm::formatv(
+      "// Variable Allocations: {0}\n",
+      formatSize(variableAllocationSize, variableAllocationSizeDynamic));
+
+  if (verbose) {
+    os << "//\n";
+    for (auto byteBufferOp : usageInfo.bufferConstantOps) {
+      os << llvm::formatv("//   {0} byte buffer: ",
+                          isConstantByteBuffer(byteBufferOp) ? "constant"
+                                                             : "variable");
+      if (auto serializableAttr =
+              byteBufferOp.value()
+                  .dyn_cast<IREE::Util::SerializableAttrInterface>()) {
+        os << formatSize(serializableAttr.getStorageSize(), false);
+      } else {
+        os << "unknown size";
+      }
+      os << "\n";
+    }
+  }
 
   os << "//\n";
 }
@@ -255,12 +507,29 @@ static void prettyPrintSyncInfo(const UsageInfo &usageInfo, bool verbose,
   prettyPrintSectionHeader("Synchronization", os);
   os << "//\n";
 
-  // TODO(benvanik): print host <-> device information:
-  // - number of stream.timepoint.awaits
-  // - staging buffer allocation sizes
-  // - number of buffer mapping operations
-  // - estimated number of submissions (execution with await in the middle)
-  os << "// TODO\n";
+  Statistics stats;
+  stats.analyze(usageInfo);
+
+  os << llvm::formatv("//    D->H Awaits: {0}\n", stats.awaitCount);
+  os << llvm::formatv("//   Buffer Maps: {0} map, {1} try_map\n",
+                      stats.mapCount, stats.tryMapCount);
+  os << llvm::formatv(
+      "// Staging Buffers: {0}\n",
+      formatSize(stats.stagingSize, stats.stagingSizeDynamic));
+
+  // Each host await splits the function timeline; submissions between awaits
+  // can be batched together while those after one cannot.
+  os << "//\n";
+  for (auto funcLikeOp : usageInfo.funcLikeOps) {
+    FunctionStatistics funcStats;
+    funcStats.analyze(funcLikeOp);
+    os << "//   ";
+    prettyPrintOpBreadcrumb(funcLikeOp, os);
+    os << llvm::formatv(": {0} submissions, {1} awaits, peak transient {2}\n",
+                        funcStats.submissionCount, funcStats.awaitCount,
+                        formatSize(funcStats.peakTransientSize,
+                                   funcStats.peakTransientSizeDynamic));
+  }
 
   os << "//\n";
 }
@@ -278,11 +547,53 @@ static void prettyPrintStreamInfo(const UsageInfo &usageInfo,
   os << "\n";
   os << "//\n";
 
-  // TODO(benvanik): print stream information (for each stream.cmd.execute):
-  // - number of unique resources captured
-  // - number of commands of each type
-  // - % concurrently executable
-  os << "// TODO\n";
+  SetVector<Value> capturedResources;
+  capturedResources.insert(executeOp.operands().begin(),
+                           executeOp.operands().end());
+  size_t fillCount = 0;
+  size_t copyCount = 0;
+  size_t dispatchCount = 0;
+  size_t concurrentRegionCount = 0;
+  size_t concurrentCommandCount = 0;
+  executeOp.walk([&](Operation *op) {
+    bool isCommand = TypeSwitch<Operation *, bool>(op)
+                         .Case<IREE::Stream::CmdFillOp>([&](auto op) {
+                           ++fillCount;
+                           return true;
+                         })
+                         .Case<IREE::Stream::CmdCopyOp>([&](auto op) {
+                           ++copyCount;
+                           return true;
+                         })
+                         .Case<IREE::Stream::CmdDispatchOp>([&](auto op) {
+                           ++dispatchCount;
+                           return true;
+                         })
+                         .Case<IREE::Stream::CmdConcurrentOp>([&](auto op) {
+                           ++concurrentRegionCount;
+                           return false;
+                         })
+                         .Default([](Operation *op) { return false; });
+    if (isCommand && op->getParentOfType<IREE::Stream::CmdConcurrentOp>()) {
+      ++concurrentCommandCount;
+    }
+  });
+  size_t commandCount = fillCount + copyCount + dispatchCount;
+
+  os << llvm::formatv("// Captured Resources: {0}\n",
+                      capturedResources.size());
+  os << llvm::formatv("//    Timepoint Await: {0}\n",
+                      executeOp.await_timepoint() ? "yes" : "no");
+  os << llvm::formatv(
+      "//           Commands: {0} ({1} fills, {2} copies, {3} dispatches)\n",
+      commandCount, fillCount, copyCount, dispatchCount);
+  os << llvm::formatv(
+      "//        Concurrency: {0}% ({1} commands in {2} concurrent regions)\n",
+      commandCount
+          ? (int)std::roundf(
+                (concurrentCommandCount / (float)commandCount) * 100.0f)
+          : 0,
+      concurrentCommandCount, concurrentRegionCount);
 }
 
 static void prettyPrintAllStreamInfo(const UsageInfo &usageInfo, bool verbose,
@@ -290,12 +601,24 @@ static void prettyPrintAllStreamInfo(const UsageInfo &usageInfo, bool verbose,
   prettyPrintSectionHeader("Streams", os);
   os << "//\n";
 
-  // TODO(benvanik): aggregate stats:
-  // - number of streams
-  // - (eventually) number of streams per affinity
-  // - average commands per stream
-  // - streams with host dependencies/device dependencies (awaits/etc)
-  os << "// TODO\n";
+  // TODO(benvanik): number of streams per affinity.
+  size_t commandCount = 0;
+  size_t awaitingStreamCount = 0;
+  for (auto executeOp : usageInfo.executeOps) {
+    executeOp.walk([&](Operation *op) {
+      if (isa<IREE::Stream::CmdFillOp, IREE::Stream::CmdCopyOp,
+              IREE::Stream::CmdDispatchOp>(op)) {
+        ++commandCount;
+      }
+    });
+    if (executeOp.await_timepoint()) ++awaitingStreamCount;
+  }
+  size_t streamCount = usageInfo.executeOps.size();
+  os << llvm::formatv("//             Streams: {0}\n", streamCount);
+  os << llvm::formatv("// Commands per Stream: {0:F2} average\n",
+                      streamCount ? commandCount / (float)streamCount : 0.0f);
+  os << llvm::formatv("//   Device Dependency: {0} streams awaiting\n",
+                      awaitingStreamCount);
 
   os << "//\n";
   for (auto executeOp : usageInfo.executeOps) {
@@ -317,17 +640,39 @@ static void prettyPrintExecutableExportInfo(
   os << "\n";
   os << "//\n";
 
-  // TODO(benvanik): interface and usage stats:
-  // - operand info
-  // - binding info
-  //   - misaligned/unaligned/etc - big warning
-  // - incoming dispatches
-  //   - workload params
+  ExportStatistics exportStats;
+  exportStats.analyze(usageInfo, exportOp);
+  os << llvm::formatv("//   Bindings: {0}\n", exportStats.bindingCount);
+  if (exportStats.unalignedBindingCount) {
+    os << llvm::formatv(
+        "//   WARNING: {0} bindings have no known alignment!\n",
+        exportStats.unalignedBindingCount);
+  }
+  os << llvm::formatv("//   Operands: {0}\n", exportStats.operandCount);
+  os << llvm::formatv("// Dispatches: {0}\n", exportStats.dispatchCount);
+
+  // Unique workloads the export is dispatched with; dynamic dimensions are
+  // printed as `?`.
+  SetVector<std::string> workloads;
+  auto it = usageInfo.exportDispatchOps.find(funcOp);
+  if (it != usageInfo.exportDispatchOps.end()) {
+    for (auto dispatchOp : it->second) {
+      SmallVector<std::string> dims;
+      for (auto dim : dispatchOp.workgroup_count()) {
+        APInt dimValue;
+        dims.push_back(matchPattern(dim, m_ConstantInt(&dimValue))
+                           ? std::to_string(dimValue.getSExtValue())
+                           : std::string("?"));
+      }
+      workloads.insert(llvm::join(dims, "x"));
+    }
+  }
+  for (auto &workload : workloads) {
+    os << llvm::formatv("//   - workload {0}\n", workload);
+  }
 
   // TODO(benvanik): ask codegen team if they want anything like a list of
   // linalg named ops, etc.
-
-  os << "// TODO\n";
 }
 
 static void prettyPrintExecutableInfo(const UsageInfo &usageInfo,
@@ -348,11 +693,26 @@ static void prettyPrintAllExecutableInfo(const UsageInfo &usageInfo,
   prettyPrintSectionHeader("Executables", os);
   os << "//\n";
 
-  // TODO(benvanik): aggregate stats:
-  // - number of executables
-  // - total number of exports
-  // - average bindings/operands per export
-  os << "// TODO\n";
+  size_t exportCount = 0;
+  size_t bindingCount = 0;
+  size_t operandCount = 0;
+  for (auto it : usageInfo.executableOps) {
+    for (auto exportOp :
+         it.second.getOps<IREE::Stream::ExecutableExportOp>()) {
+      ExportStatistics exportStats;
+      exportStats.analyze(usageInfo, exportOp);
+      ++exportCount;
+      bindingCount += exportStats.bindingCount;
+      operandCount += exportStats.operandCount;
+    }
+  }
+  os << llvm::formatv("//    Executables: {0}\n",
+                      usageInfo.executableOps.size());
+  os << llvm::formatv("//        Exports: {0}\n", exportCount);
+  os << llvm::formatv("// Bindings/Export: {0:F2} average\n",
+                      exportCount ? bindingCount / (float)exportCount : 0.0f);
+  os << llvm::formatv("// Operands/Export: {0:F2} average\n",
+                      exportCount ? operandCount / (float)exportCount : 0.0f);
 
   os << "//\n";
   for (auto it : usageInfo.executableOps) {
@@ -495,14 +855,25 @@ static void dumpAggregateJSONStructure(const UsageInfo &usageInfo,
   os << "  },\n";
 
   os << "  \"synchronization\": {\n";
-  os << llvm::formatv(kvPairNoComma, "await-count", stats.awaitCount);
+  os << llvm::formatv(kvPair, "await-count", stats.awaitCount);
+  os << llvm::formatv(kvPair, "map-count", stats.mapCount);
+  os << llvm::formatv(kvPair, "try-map-count", stats.tryMapCount);
+  os << llvm::formatv(kvPairNoComma, "staging-size", stats.stagingSize);
   os << "  },\n";
 
   os << "  \"execution\": {\n";
   os << llvm::formatv(kvPair, "submission-count", stats.submissionCount);
   os << llvm::formatv(kvPair, "transient-memory-size", stats.transientSize);
+  os << llvm::formatv(kvPair, "peak-transient-memory-size",
+                      stats.peakTransientSize);
+  os << llvm::formatv(kvPair, "allocation-count", stats.allocationCount);
+  os << llvm::formatv(kvPair, "allocation-size", stats.allocationSize);
+  os << llvm::formatv(kvPair, "unpacked-allocation-size",
+                      stats.unpackedAllocationSize);
   os << llvm::formatv(kvPair, "fill-count", stats.fillCount);
+  os << llvm::formatv(kvPair, "fill-size", stats.fillSize);
   os << llvm::formatv(kvPair, "copy-count", stats.copyCount);
+  os << llvm::formatv(kvPair, "copy-size", stats.copySize);
   os << llvm::formatv(kvPairNoComma, "dispatch-count", stats.dispatchCount);
   os << "  },\n";
 
@@ -511,15 +882,70 @@ static void dumpAggregateJSONStructure(const UsageInfo &usageInfo,
   os << "  }\n";
 }
 
+static void dumpFunctionJSONStructures(const UsageInfo &usageInfo,
+                                       llvm::raw_fd_ostream &os) {
+  llvm::interleave(
+      usageInfo.funcLikeOps, os,
+      [&](FunctionOpInterface funcLikeOp) {
+        FunctionStatistics funcStats;
+        funcStats.analyze(funcLikeOp);
+        os << "  {\n";
+        // Initializers have no symbol name and use the op name instead.
+        auto symbolOp = dyn_cast<SymbolOpInterface>(funcLikeOp.getOperation());
+        os << llvm::formatv("    \"name\": \"{0}\",\n",
+                            symbolOp ? symbolOp.getName()
+                                     : funcLikeOp->getName().getStringRef());
+        os << llvm::formatv("    \"submission-count\": {0},\n",
+                            funcStats.submissionCount);
+        os << llvm::formatv("    \"await-count\": {0},\n",
+                            funcStats.awaitCount);
+        os << llvm::formatv("    \"peak-transient-memory-size\": {0}\n",
+                            funcStats.peakTransientSize);
+        os << "  }";
+      },
+      ",\n");
+  os << "\n";
+}
+
+static void dumpExecutableJSONStructures(const UsageInfo &usageInfo,
+                                         llvm::raw_fd_ostream &os) {
+  llvm::interleave(
+      usageInfo.executableOps, os,
+      [&](auto it) {
+        size_t exportCount = 0;
+        size_t dispatchCount = 0;
+        for (auto exportOp :
+             it.second.template getOps<IREE::Stream::ExecutableExportOp>()) {
+          ExportStatistics exportStats;
+          exportStats.analyze(usageInfo, exportOp);
+          ++exportCount;
+          dispatchCount += exportStats.dispatchCount;
+        }
+        os << "  {\n";
+        os << llvm::formatv("    \"name\": \"{0}\",\n", it.first);
+        os << llvm::formatv("    \"export-count\": {0},\n", exportCount);
+        os << llvm::formatv("    \"dispatch-count\": {0}\n", dispatchCount);
+        os << "  }";
+      },
+      ",\n");
+  os << "\n";
+}
+
 static void dumpJSONStructures(const UsageInfo &usageInfo,
                                llvm::raw_fd_ostream &os) {
   os << "{\n";
 
   os << "\"stream-aggregate\": {\n";
   dumpAggregateJSONStructure(usageInfo, os);
-  os << "}\n";
+  os << "},\n";
+
+  os << "\"functions\": [\n";
+  dumpFunctionJSONStructures(usageInfo, os);
+  os << "],\n";
 
-  // TODO(antiagainst): dump per-execution data if needed.
+  os << "\"executables\": [\n";
+  dumpExecutableJSONStructures(usageInfo, os);
+  os << "]\n";
 
   os << "}\n";
 }
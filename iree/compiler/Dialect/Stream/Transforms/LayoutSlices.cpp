@@ -4,7 +4,7 @@
 // See https://llvm.org/LICENSE.txt for license information.
 // SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
 
-#include <list>
+#include <queue>
 
 #include "iree/compiler/Dialect/Stream/IR/StreamDialect.h"
 #include "iree/compiler/Dialect/Stream/IR/StreamOps.h"
@@ -16,6 +16,7 @@
 #include "iree/compiler/Dialect/Util/IR/UtilTypes.h"
 #include "iree/compiler/Utils/IndexSet.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/MathExtras.h"
 #include "mlir/Dialect/Arithmetic/IR/Arithmetic.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
 #include "mlir/IR/AsmState.h"
@@ -63,65 +64,177 @@ static Value packSlicesWithNoAliasing(
   return builder.createOrFold<IREE::Util::AlignOp>(loc, offset, rangeAlignment);
 }
 
-// Packs a set of statically-sized slices by greedy strip packing.
-//
-// This is the same algorithm used in tflite here:
-// https://github.com/tensorflow/tensorflow/blob/master/tensorflow/lite/simple_memory_arena.cc
-// It's not fantastic and can end up with a significant amount of wastage.
-// They do the packing at runtime and as such care more about performance than
-// we do while doing the packing here offline. For this initial version I
-// wanted to ensure we matched apples/apples their implementation.
-//
-// We should use a set of heuristics and pick the smallest one. There are also
-// some really great papers that have approximations (as all of these are -
-// 2D strip packing is NP-hard) such as
-// https://www.sciencedirect.com/science/article/pii/S0925772113001016 that
-// someone with a brain able to parse mathy papers can try implementing.
-//
-// Slice packed offset SSA values will be updated and start at the given
-// |baseOffset|. Returns |baseOffset| + the total size of the allocation
-// aligned to the requirements of |resourceConfig|.
-static Value packStaticSlicesGreedily(
-    IREE::Stream::ResourcePackOp packOp, Value baseOffset,
-    ArrayRef<Slice> slices, IREE::Stream::ResourceConfigAttr resourceConfig,
-    IndexSet &indexSet, OpBuilder &builder) {
-  int64_t offsetAlignment = resourceConfig.getMinBufferOffsetAlignment();
-  int64_t rangeAlignment = resourceConfig.getMinBufferRangeAlignment();
+//===----------------------------------------------------------------------===//
+// Slice lifetime queries
+//===----------------------------------------------------------------------===//
 
-  struct Reservation {
-    const Slice *slice = nullptr;
-    int64_t staticOffset = 0;
-    int64_t staticSize = 0;
+// Interval tree over slice lifetimes used to find all slices whose lifetimes
+// intersect a given interval in O(logn + k) instead of scanning all slices.
+// The tree is built once from all slices that may be packed together and is
+// immutable; callers filter the results based on their own packing state.
+class SliceIntervalTree {
+ public:
+  explicit SliceIntervalTree(ArrayRef<const Slice *> slices)
+      : nodes(slices.begin(), slices.end()) {
+    llvm::stable_sort(nodes, [](const Slice *lhs, const Slice *rhs) {
+      return lhs->lifetimeStart < rhs->lifetimeStart;
+    });
+    maxEnds.resize(nodes.size());
+    buildMaxEnds(0, nodes.size());
+  }
+
+  // Calls |fn| with each slice whose lifetime intersects [|start|, |end|].
+  void forEachIntersecting(int64_t start, int64_t end,
+                           function_ref<void(const Slice *)> fn) const {
+    query(0, nodes.size(), start, end, fn);
+  }
+
+ private:
+  // The tree is stored implicitly in |nodes| sorted by lifetime start with the
+  // root of each [lo, hi) subtree at its midpoint. |maxEnds| holds the maximum
+  // lifetime end of each subtree for pruning.
+  int64_t buildMaxEnds(size_t lo, size_t hi) {
+    if (lo >= hi) return INT64_MIN;
+    size_t mid = lo + (hi - lo) / 2;
+    int64_t maxEnd = std::max({nodes[mid]->lifetimeEnd, buildMaxEnds(lo, mid),
+                               buildMaxEnds(mid + 1, hi)});
+    maxEnds[mid] = maxEnd;
+    return maxEnd;
+  }
+
+  void query(size_t lo, size_t hi, int64_t start, int64_t end,
+             function_ref<void(const Slice *)> fn) const {
+    if (lo >= hi) return;
+    size_t mid = lo + (hi - lo) / 2;
+    // Nothing in this subtree is live at or after |start|.
+    if (maxEnds[mid] < start) return;
+    query(lo, mid, start, end, fn);
+    // Everything from |mid| onward starts after |end|.
+    if (nodes[mid]->lifetimeStart > end) return;
+    if (nodes[mid]->lifetimeEnd >= start) fn(nodes[mid]);
+    query(mid + 1, hi, start, end, fn);
+  }
+
+  SmallVector<const Slice *> nodes;
+  SmallVector<int64_t> maxEnds;
+};
+
+// Returns a conservative static upper bound on |value| if one can be derived
+// from the ops producing it. Sizes are often clamped (min/select) or computed
+// from bounded values even when not constant.
+static Optional<int64_t> findUpperBound(Value value, int depth = 0) {
+  static constexpr int kMaxDepth = 8;
+  APInt constantValue;
+  if (matchPattern(value, m_ConstantInt(&constantValue))) {
+    return constantValue.getSExtValue();
+  }
+  auto *op = value.getDefiningOp();
+  if (!op || depth >= kMaxDepth) return llvm::None;
+
+  // Returns the bounds of all operands of |op| or None if any are unknown.
+  auto getOperandBounds = [&]() -> Optional<SmallVector<int64_t>> {
+    SmallVector<int64_t> bounds;
+    for (auto operand : op->getOperands()) {
+      auto bound = findUpperBound(operand, depth + 1);
+      if (!bound.hasValue()) return llvm::None;
+      bounds.push_back(bound.getValue());
+    }
+    return bounds;
   };
-  static constexpr int64_t UNASSIGNED = INT64_MAX;
 
-  std::list<Reservation> reservations;
-  int64_t highwaterMark = 0;
-  for (auto &slice : slices) {
-    int64_t bestOffset = UNASSIGNED;
-    int64_t bestOffsetFit = UNASSIGNED;
-    int64_t staticSize =
-        cast<arith::ConstantIndexOp>(slice.dynamicSize.getDefiningOp()).value();
+  if (isa<arith::MinUIOp, IREE::Util::RangeMinOp>(op)) {
+    // Any known operand bounds the result.
+    Optional<int64_t> minBound;
+    for (auto operand : op->getOperands()) {
+      auto bound = findUpperBound(operand, depth + 1);
+      if (!bound.hasValue()) continue;
+      minBound = minBound.hasValue()
+                     ? std::min(minBound.getValue(), bound.getValue())
+                     : bound.getValue();
+    }
+    return minBound;
+  } else if (isa<arith::MaxUIOp, IREE::Util::RangeMaxOp>(op)) {
+    auto bounds = getOperandBounds();
+    if (!bounds.hasValue()) return llvm::None;
+    return *std::max_element(bounds->begin(), bounds->end());
+  } else if (auto selectOp = dyn_cast<mlir::arith::SelectOp>(op)) {
+    auto trueBound = findUpperBound(selectOp.getTrueValue(), depth + 1);
+    auto falseBound = findUpperBound(selectOp.getFalseValue(), depth + 1);
+    if (!trueBound.hasValue() || !falseBound.hasValue()) return llvm::None;
+    return std::max(trueBound.getValue(), falseBound.getValue());
+  } else if (auto alignOp = dyn_cast<IREE::Util::AlignOp>(op)) {
+    auto bound = findUpperBound(alignOp.value(), depth + 1);
+    APInt alignment;
+    if (!bound.hasValue() ||
+        !matchPattern(alignOp.alignment(), m_ConstantInt(&alignment))) {
+      return llvm::None;
+    }
+    return IREE::Util::align(bound.getValue(), alignment);
+  } else if (isa<arith::AddIOp, arith::MulIOp>(op)) {
+    auto bounds = getOperandBounds();
+    if (!bounds.hasValue()) return llvm::None;
+    int64_t lhs = bounds.getValue()[0];
+    int64_t rhs = bounds.getValue()[1];
+    // Sizes are non-negative; negative bounds indicate something we don't
+    // understand.
+    if (lhs < 0 || rhs < 0) return llvm::None;
+    int64_t result = 0;
+    bool overflow = isa<arith::AddIOp>(op)
+                        ? llvm::AddOverflow(lhs, rhs, result)
+                        : llvm::MulOverflow(lhs, rhs, result);
+    if (overflow) return llvm::None;
+    return result;
+  }
+  return llvm::None;
+}
+
+//===----------------------------------------------------------------------===//
+// Static slice packing
+//===----------------------------------------------------------------------===//
+
+// An arena of statically-offset slice reservations.
+// Slices are placed best-fit: into the smallest gap between the reservations
+// of slices with intersecting lifetimes that can hold them, or after all of
+// those reservations if no gap is large enough.
+class StaticSliceArena {
+ public:
+  StaticSliceArena(const SliceIntervalTree &intervalTree,
+                   int64_t offsetAlignment, int64_t rangeAlignment)
+      : intervalTree(intervalTree),
+        offsetAlignment(offsetAlignment),
+        rangeAlignment(rangeAlignment) {}
+
+  // Reserves |staticSize| bytes for |slice| and returns the assigned offset.
+  // Fails if the reservation would extend beyond |maxEnd|.
+  Optional<int64_t> place(const Slice *slice, int64_t staticSize,
+                          int64_t maxEnd = INT64_MAX) {
     int64_t alignedSize = IREE::Util::align(staticSize, rangeAlignment);
 
-    // Iterate through reservations (sorted by ascending offset) and identify
-    // gaps in which the slice will fit. To reduce wastage we want to find the
-    // smallest gap.
-    int64_t currentOffset = 0;
-    for (auto &reservation : reservations) {
-      if (!reservation.slice->intersects(slice)) {
-        // Non-overlapping - we can reuse the currentOffset (assuming we find
-        // no better place).
-        continue;
-      }
+    // Gather reservations live at the same time as the slice sorted by
+    // ascending offset.
+    SmallVector<Reservation> liveReservations;
+    intervalTree.forEachIntersecting(
+        slice->lifetimeStart, slice->lifetimeEnd, [&](const Slice *other) {
+          auto it = reservations.find(other);
+          if (it != reservations.end()) {
+            liveReservations.push_back(it->second);
+          }
+        });
+    llvm::sort(liveReservations, [](const Reservation &lhs,
+                                    const Reservation &rhs) {
+      return lhs.staticOffset < rhs.staticOffset;
+    });
 
-      // If we found a gap >= the required size and smaller than
-      // previous best fit take it.
+    // Find the smallest gap the slice fits in.
+    int64_t bestOffset = UNASSIGNED;
+    int64_t bestOffsetFit = UNASSIGNED;
+    int64_t currentOffset = 0;
+    for (auto &reservation : liveReservations) {
       int64_t alignedOffset = IREE::Util::align(currentOffset, offsetAlignment);
       if (alignedOffset + alignedSize <= reservation.staticOffset &&
           reservation.staticOffset - alignedOffset < bestOffsetFit) {
         bestOffset = alignedOffset;
-        bestOffsetFit = reservation.staticOffset - currentOffset;
+        bestOffsetFit = reservation.staticOffset - alignedOffset;
       }
       currentOffset = std::max(
           currentOffset, reservation.staticOffset + reservation.staticSize);
@@ -129,45 +242,182 @@ static Value packStaticSlicesGreedily(
     if (bestOffset == UNASSIGNED) {
       bestOffset = IREE::Util::align(currentOffset, offsetAlignment);
     }
+    if (bestOffset + alignedSize > maxEnd) return llvm::None;
 
-    // Reserve the memory.
-    Reservation reservation;
-    reservation.slice = &slice;
-    reservation.staticOffset = bestOffset;
-    reservation.staticSize = alignedSize;
-    auto insertionIt = reservations.begin();
-    while (insertionIt != reservations.end() &&
-           insertionIt->staticOffset < reservation.staticOffset) {
-      ++insertionIt;
+    reservations[slice] = {bestOffset, alignedSize};
+    highwaterMark = std::max(highwaterMark, bestOffset + alignedSize);
+    return bestOffset;
+  }
+
+  // Returns the offset assigned to |slice| by a prior place.
+  int64_t getOffset(const Slice *slice) const {
+    return reservations.lookup(slice).staticOffset;
+  }
+
+  // Returns the total number of bytes required for all reservations.
+  int64_t getHighwaterMark() const { return highwaterMark; }
+
+ private:
+  static constexpr int64_t UNASSIGNED = INT64_MAX;
+
+  struct Reservation {
+    int64_t staticOffset = 0;
+    int64_t staticSize = 0;
+  };
+
+  const SliceIntervalTree &intervalTree;
+  int64_t offsetAlignment;
+  int64_t rangeAlignment;
+  DenseMap<const Slice *, Reservation> reservations;
+  int64_t highwaterMark = 0;
+};
+
+static int64_t getStaticSliceSize(const Slice &slice) {
+  return cast<arith::ConstantIndexOp>(slice.dynamicSize.getDefiningOp())
+      .value();
+}
+
+// Packs a set of statically-sized slices by best-fit strip packing.
+//
+// 2D strip packing is NP-hard and every heuristic has inputs it handles poorly
+// so we run a few orderings through the same best-fit placement and keep the
+// one with the smallest total size (preferring the earliest on ties):
+//   - ascending lifetime order: the same order the tflite arena uses
+//     (https://github.com/tensorflow/tensorflow/blob/master/tensorflow/lite/simple_memory_arena.cc)
+//   - descending size: large slices are the hardest to fit so place them first
+//   - descending area (size * lifetime): long-lived large slices constrain the
+//     most placements
+// See https://www.sciencedirect.com/science/article/pii/S0925772113001016 for
+// better approximations should these prove insufficient.
+//
+// Dynamically-sized |boundedSlices| with a known upper bound are then placed
+// into the gaps of the chosen packing as if they were static slices of their
+// upper bound size. Only placements that do not grow the packed size are
+// taken; the rest are appended to |unpackedSlices|.
+//
+// Slice packed offset SSA values will be updated and start at the given
+// |baseOffset|. Returns |baseOffset| + the total size of the allocation
+// aligned to the requirements of |resourceConfig|.
+static Value packStaticSlicesBestFit(
+    IREE::Stream::ResourcePackOp packOp, Value baseOffset,
+    ArrayRef<Slice> slices, ArrayRef<Slice> boundedSlices,
+    IREE::Stream::ResourceConfigAttr resourceConfig, IndexSet &indexSet,
+    OpBuilder &builder, SmallVectorImpl<Slice> &unpackedSlices) {
+  int64_t offsetAlignment = resourceConfig.getMinBufferOffsetAlignment();
+  int64_t rangeAlignment = resourceConfig.getMinBufferRangeAlignment();
+
+  SmallVector<const Slice *> lifetimeOrder;
+  for (auto &slice : slices) lifetimeOrder.push_back(&slice);
+  SmallVector<const Slice *> allSlices = lifetimeOrder;
+  for (auto &slice : boundedSlices) allSlices.push_back(&slice);
+  SliceIntervalTree intervalTree(allSlices);
+
+  // Candidate placement orders.
+  auto sizeOrder = lifetimeOrder;
+  llvm::stable_sort(sizeOrder, [](const Slice *lhs, const Slice *rhs) {
+    return getStaticSliceSize(*lhs) > getStaticSliceSize(*rhs);
+  });
+  auto areaOrder = lifetimeOrder;
+  auto getArea = [](const Slice *slice) {
+    return getStaticSliceSize(*slice) *
+           (slice->lifetimeEnd - slice->lifetimeStart + 1);
+  };
+  llvm::stable_sort(areaOrder, [&](const Slice *lhs, const Slice *rhs) {
+    return getArea(lhs) > getArea(rhs);
+  });
+
+  std::unique_ptr<StaticSliceArena> bestArena;
+  for (auto &order : {lifetimeOrder, sizeOrder, areaOrder}) {
+    auto arena = std::make_unique<StaticSliceArena>(
+        intervalTree, offsetAlignment, rangeAlignment);
+    for (auto *slice : order) {
+      arena->place(slice, getStaticSliceSize(*slice));
+    }
+    LLVM_DEBUG(llvm::dbgs() << "static packing heuristic produced "
+                            << arena->getHighwaterMark() << " bytes\n");
+    if (!bestArena ||
+        arena->getHighwaterMark() < bestArena->getHighwaterMark()) {
+      bestArena = std::move(arena);
     }
-    reservations.insert(insertionIt, reservation);
-    slice.packedOffset.replaceAllUsesWith(builder.createOrFold<arith::AddIOp>(
-        packOp.getLoc(), baseOffset, indexSet.get(bestOffset)));
+  }
 
-    // Update highwater mark indicating how much memory needs to be allocated
-    // for the entire slab.
-    highwaterMark = std::max(highwaterMark, bestOffset + alignedSize);
+  // Try to alias bounded dynamic slices into the static packing. Larger
+  // slices go first as they are the hardest to fit.
+  int64_t highwaterMark =
+      IREE::Util::align(bestArena->getHighwaterMark(), rangeAlignment);
+  SmallVector<std::pair<const Slice *, int64_t>> boundedSizes;
+  for (auto &slice : boundedSlices) {
+    boundedSizes.push_back(
+        {&slice, findUpperBound(slice.dynamicSize).getValue()});
+  }
+  llvm::stable_sort(boundedSizes, [](auto &lhs, auto &rhs) {
+    return lhs.second > rhs.second;
+  });
+  SmallVector<const Slice *> packedSlices = std::move(lifetimeOrder);
+  for (auto &boundedSize : boundedSizes) {
+    auto *slice = boundedSize.first;
+    auto offset = bestArena->place(slice, boundedSize.second, highwaterMark);
+    if (offset.hasValue()) {
+      LLVM_DEBUG(llvm::dbgs() << "aliased dynamic slice with upper bound "
+                              << boundedSize.second << " at offset "
+                              << offset.getValue() << "\n");
+      packedSlices.push_back(slice);
+    } else {
+      unpackedSlices.push_back(*slice);
+    }
   }
 
-  highwaterMark = IREE::Util::align(highwaterMark, rangeAlignment);
-  return builder.createOrFold<arith::AddIOp>(packOp.getLoc(), baseOffset,
+  auto loc = packOp.getLoc();
+  for (auto *slice : packedSlices) {
+    slice->packedOffset.replaceAllUsesWith(builder.createOrFold<arith::AddIOp>(
+        loc, baseOffset, indexSet.get(bestArena->getOffset(slice))));
+  }
+
+  return builder.createOrFold<arith::AddIOp>(loc, baseOffset,
                                              indexSet.get(highwaterMark));
 }
 
+//===----------------------------------------------------------------------===//
+// Dynamic slice packing
+//===----------------------------------------------------------------------===//
+
+// Assigns each of |slices| to a bin such that no two slices in the same bin
+// have intersecting lifetimes. This is interval graph coloring and produces
+// the minimum number of bins. Bins are returned in creation order.
+static SmallVector<SmallVector<const Slice *>> binSlicesByLifetime(
+    ArrayRef<const Slice *> slices) {
+  SmallVector<const Slice *> sortedSlices(slices.begin(), slices.end());
+  llvm::stable_sort(sortedSlices, [](const Slice *lhs, const Slice *rhs) {
+    return lhs->lifetimeStart < rhs->lifetimeStart;
+  });
+
+  // Min-heap of (last lifetime end, bin ordinal) for all bins.
+  using BinEnd = std::pair<int64_t, size_t>;
+  std::priority_queue<BinEnd, std::vector<BinEnd>, std::greater<BinEnd>>
+      binEnds;
+  SmallVector<SmallVector<const Slice *>> bins;
+  for (auto *slice : sortedSlices) {
+    size_t binOrdinal = bins.size();
+    if (!binEnds.empty() && binEnds.top().first < slice->lifetimeStart) {
+      // Reuse the bin that has been free the longest.
+      binOrdinal = binEnds.top().second;
+      binEnds.pop();
+    } else {
+      bins.emplace_back();
+    }
+    bins[binOrdinal].push_back(slice);
+    binEnds.push({slice->lifetimeEnd, binOrdinal});
+  }
+  return bins;
+}
+
 // Packs a set of dynamically-sized slices based on the structural information
 // in the IR. Only slices that have the exact same size will be allowed to
 // alias.
 //
-// We can improve this if we know which sizes are larger/smaller relative to
-// others as then we can do things like reuse an allocation bucket with
-// non-overlapping lifetimes if the thing we are trying to pack in it is
-// definitely <=. If we end up knowing that certain sizes are less than some
-// absolute value then we could also alias with static allocations like if %sz
-// is known less than 1000b it could reuse any static allocation >= 1000b.
-//
-// We could also emit code for efficient runtime bucketing by providing the
-// sorted, compacted, delta-coded lifetime intervals and runtime-computed
-// sizes if we wanted to produce the smallest buffers.
+// Slices with sizes that have a known upper bound are packed along with the
+// static slices (see packStaticSlicesBestFit) and only those that could not
+// alias with static slices are packed here.
 //
 // Slice packed offset SSA values will be updated and start at the given
 // |baseOffset|. Returns |baseOffset| + the total size of the allocation
@@ -194,47 +444,55 @@ static Value packDynamicSlicesConservatively(
   for (auto &sizeBucket : slicesBySize) {
     auto sliceSize = builder.createOrFold<IREE::Util::AlignOp>(
         loc, sizeBucket.first, rangeAlignment);
-    auto &slices = sizeBucket.second;
-    std::stable_sort(slices.begin(), slices.end());
-
-    // Bin the slices by those that do not overlap. All of the allocations in
-    // each bin can alias.
-    // NOTE: O(n^2) in the worst case but there's usually only a small number
-    // of bins (<10) as we have already bucketed by size class. We could do
-    // some sorting and make this O(nlogn) or O(logn) with some interval tree
-    // magic.
-    struct Bin {
-      Value offset;
-      SmallVector<const Slice *> slices;
-      bool intersects(const Slice &slice) const {
-        for (auto *binSlice : slices) {
-          if (binSlice->intersects(slice)) return true;
-        }
-        return false;
-      }
-    };
-    SmallVector<Bin> bins;
-    for (auto *slice : slices) {
-      // Try to find a bin we can reuse (non-intersecting lifetime).
-      Bin *targetBin = nullptr;
-      for (auto &bin : bins) {
-        if (!bin.intersects(*slice)) {
-          targetBin = &bin;
-          break;
-        }
-      }
-      if (!targetBin) {
-        // Allocate a new bin for this slice.
-        bins.push_back({offset, {}});
-        targetBin = &bins.back();
-        auto binSize =
-            builder.createOrFold<arith::AddIOp>(loc, offset, sliceSize);
-        offset = builder.createOrFold<IREE::Util::AlignOp>(loc, binSize,
-                                                           offsetAlignment);
-      }
-      targetBin->slices.push_back(slice);
-      slice->packedOffset.replaceAllUsesWith(targetBin->offset);
+    for (auto &bin : binSlicesByLifetime(sizeBucket.second)) {
+      for (auto *slice : bin) slice->packedOffset.replaceAllUsesWith(offset);
+      auto binSize =
+          builder.createOrFold<arith::AddIOp>(loc, offset, sliceSize);
+      offset = builder.createOrFold<IREE::Util::AlignOp>(loc, binSize,
+                                                         offsetAlignment);
+    }
+  }
+
+  return builder.createOrFold<IREE::Util::AlignOp>(loc, offset, rangeAlignment);
+}
+
+// Packs a set of dynamically-sized slices by computing bin sizes at runtime.
+// Slices of any size are allowed to alias so long as their lifetimes do not
+// intersect and each bin is sized to the largest slice assigned to it. This
+// produces the smallest allocations when sizes are fully dynamic at the cost
+// of emitting max operations for each bin.
+//
+// Slice packed offset SSA values will be updated and start at the given
+// |baseOffset|. Returns |baseOffset| + the total size of the allocation
+// aligned to the requirements of |resourceConfig|.
+static Value packDynamicSlicesWithRuntimeBucketing(
+    IREE::Stream::ResourcePackOp packOp, Value baseOffset,
+    ArrayRef<Slice> slices, IREE::Stream::ResourceConfigAttr resourceConfig,
+    IndexSet &indexSet, OpBuilder &builder) {
+  auto loc = packOp.getLoc();
+  int64_t offsetAlignment = resourceConfig.getMinBufferOffsetAlignment();
+  int64_t rangeAlignment = resourceConfig.getMinBufferRangeAlignment();
+
+  SmallVector<const Slice *> slicePtrs;
+  for (auto &slice : slices) slicePtrs.push_back(&slice);
+
+  Value offset = baseOffset;
+  for (auto &bin : binSlicesByLifetime(slicePtrs)) {
+    // Bin size is the max of all unique slice sizes within it.
+    SetVector<Value> uniqueSizes;
+    for (auto *slice : bin) uniqueSizes.insert(slice->dynamicSize);
+    Value binSize;
+    for (auto size : uniqueSizes) {
+      binSize = binSize ? builder.createOrFold<arith::MaxUIOp>(loc, binSize,
+                                                               size)
+                        : size;
     }
+    binSize =
+        builder.createOrFold<IREE::Util::AlignOp>(loc, binSize, rangeAlignment);
+    for (auto *slice : bin) slice->packedOffset.replaceAllUsesWith(offset);
+    auto binEnd = builder.createOrFold<arith::AddIOp>(loc, offset, binSize);
+    offset =
+        builder.createOrFold<IREE::Util::AlignOp>(loc, binEnd, offsetAlignment);
   }
 
   return builder.createOrFold<IREE::Util::AlignOp>(loc, offset, rangeAlignment);
@@ -260,17 +518,16 @@ class LayoutSlicesPass : public LayoutSlicesBase<LayoutSlicesPass> {
       return;
     }
 
-    // NOTE: we could try several algorithms and compute which packs best. For
-    // now we just pack greedily as it's fast and what most existing ML
-    // frameworks do.
     parentOp.walk([&](IREE::Stream::ResourcePackOp packOp) {
       // Derive resource constraints based on pack affinity.
       auto resourceConfig = IREE::Stream::ResourceConfigAttr::lookup(packOp);
 
-      // Bucket into static and dynamic sizes. Static packing is a much more
-      // constrained problem.
+      // Bucket into static, upper-bounded, and dynamic sizes. Static packing
+      // is a much more constrained problem and bounded slices may be able to
+      // alias with static ones.
       auto allSlices = packOp.getSlices();
       SmallVector<Slice> staticSlices;
+      SmallVector<Slice> boundedSlices;
       SmallVector<Slice> dynamicSlices;
       staticSlices.reserve(allSlices.size());
       dynamicSlices.reserve(allSlices.size());
@@ -278,6 +535,8 @@ class LayoutSlicesPass : public LayoutSlicesBase<LayoutSlicesPass> {
         if (isa_and_nonnull<arith::ConstantOp>(
                 slice.dynamicSize.getDefiningOp())) {
           staticSlices.push_back(slice);
+        } else if (findUpperBound(slice.dynamicSize).hasValue()) {
+          boundedSlices.push_back(slice);
         } else {
           dynamicSlices.push_back(slice);
         }
@@ -287,24 +546,33 @@ class LayoutSlicesPass : public LayoutSlicesBase<LayoutSlicesPass> {
       IndexSet indexSet(packOp.getLoc(), builder);
 
       // First pack all static slices as these are entirely knowable here at
-      // compile time.
+      // compile time. Bounded slices that can reuse static reservations with
+      // non-overlapping lifetimes are packed along with them.
       auto offset = packOp.offset() ? packOp.offset() : indexSet.get(0);
       if (!staticSlices.empty()) {
-        offset = packStaticSlicesGreedily(packOp, offset, staticSlices,
-                                          resourceConfig, indexSet, builder);
+        offset = packStaticSlicesBestFit(packOp, offset, staticSlices,
+                                         boundedSlices, resourceConfig,
+                                         indexSet, builder, dynamicSlices);
 
         // TODO(benvanik): make this an option; it can be useful for debugging
         // this code.
         // offset = packSlicesWithNoAliasing(packOp, offset, staticSlices,
         //                                   resourceConfig, indexSet, builder);
+      } else {
+        dynamicSlices.append(boundedSlices);
       }
 
-      // Next pack all dynamic slices. Depending on the analysis information
-      // available we could reuse static slices with non-overlapping lifetimes
-      // in some cases.
+      // Next pack all remaining dynamic slices.
       if (!dynamicSlices.empty()) {
-        offset = packDynamicSlicesConservatively(
-            packOp, offset, dynamicSlices, resourceConfig, indexSet, builder);
+        if (runtimeBucketing) {
+          offset = packDynamicSlicesWithRuntimeBucketing(
+              packOp, offset, dynamicSlices, resourceConfig, indexSet,
+              builder);
+        } else {
+          offset = packDynamicSlicesConservatively(
+              packOp, offset, dynamicSlices, resourceConfig, indexSet,
+              builder);
+        }
       }
 
       // Total packed length is the current offset after all slices are
@@ -29,6 +29,132 @@ namespace IREE {
 namespace Stream {
 namespace {
 
+//===----------------------------------------------------------------------===//
+// Resource lifetime analysis
+//===----------------------------------------------------------------------===//
+
+// Live range of a resource in terms of op ordinals within its defining block.
+// Escaping resources (returned, stored to globals, used across blocks, etc)
+// have no known end and are live for the remainder of the block.
+struct LiveRange {
+  int64_t start = INT64_MAX;
+  int64_t end = 0;
+  bool escapes = false;
+};
+
+// Computes the live ranges of allocated resources within a single block.
+//
+// Device execution is asynchronous so a resource used by a stream.cmd.execute
+// is only dead once the host has observed the completion of the execution via
+// a stream.timepoint.await on its timepoint (or any timepoint that
+// transitively depends on it). Uses on the host (including through tied
+// results such as the awaited resource values) extend the range up to the use.
+class BlockLivenessAnalysis {
+ public:
+  explicit BlockLivenessAnalysis(Block *block) : block(block) {
+    int64_t ordinal = 0;
+    for (auto &op : *block) opOrdinals[&op] = ordinal++;
+  }
+
+  LiveRange computeLiveRange(Value resource) {
+    LiveRange liveRange;
+    SmallVector<Value> worklist;
+    DenseSet<Value> visitedValues;
+    worklist.push_back(resource);
+    while (!worklist.empty() && !liveRange.escapes) {
+      auto value = worklist.pop_back_val();
+      if (!visitedValues.insert(value).second) continue;
+      for (auto &use : value.getUses()) {
+        auto *userOp = block->findAncestorOpInBlock(*use.getOwner());
+        if (!userOp ||
+            !isa<IREE::Stream::CmdExecuteOp, IREE::Stream::TimepointAwaitOp,
+                 IREE::Stream::ResourceSubviewOp, IREE::Stream::ResourceLoadOp,
+                 IREE::Stream::ResourceStoreOp>(userOp)) {
+          // Unknown or escaping use (returned, stored to a global, exported,
+          // etc); we can't reason about the lifetime.
+          liveRange.escapes = true;
+          break;
+        }
+        int64_t userOrdinal = opOrdinals[userOp];
+        liveRange.start = std::min(liveRange.start, userOrdinal);
+        if (auto executeOp = dyn_cast<IREE::Stream::CmdExecuteOp>(userOp)) {
+          auto completionOrdinal =
+              findCompletionOrdinal(executeOp.result_timepoint());
+          if (!completionOrdinal.hasValue()) {
+            liveRange.escapes = true;
+            break;
+          }
+          liveRange.end = std::max(liveRange.end, completionOrdinal.getValue());
+        } else {
+          liveRange.end = std::max(liveRange.end, userOrdinal);
+        }
+        // Follow aliases of the resource (subviews, awaited values, etc).
+        if (userOp == use.getOwner()) {
+          if (auto tiedOp = dyn_cast<IREE::Util::TiedOpInterface>(userOp)) {
+            for (auto result :
+                 tiedOp.getOperandTiedResults(use.getOperandNumber())) {
+              worklist.push_back(result);
+            }
+          }
+        }
+      }
+    }
+    if (liveRange.escapes) {
+      liveRange.end = block->getOperations().size();
+    } else if (liveRange.start > liveRange.end) {
+      // Unused.
+      liveRange.start = liveRange.end = 0;
+    }
+    return liveRange;
+  }
+
+ private:
+  // Returns the ordinal of the first op in the block that waits on the host
+  // for |timepoint| to be reached or None if the block never waits for it.
+  Optional<int64_t> findCompletionOrdinal(Value timepoint) {
+    auto it = completionOrdinals.find(timepoint);
+    if (it != completionOrdinals.end()) return it->second;
+    completionOrdinals[timepoint] = llvm::None;  // guard against cycles
+    Optional<int64_t> completionOrdinal;
+    auto updateOrdinal = [&](Optional<int64_t> ordinal) {
+      if (!ordinal.hasValue()) return;
+      completionOrdinal =
+          completionOrdinal.hasValue()
+              ? std::min(completionOrdinal.getValue(), ordinal.getValue())
+              : ordinal.getValue();
+    };
+    for (auto *userOp : timepoint.getUsers()) {
+      if (userOp->getBlock() != block) continue;
+      if (isa<IREE::Stream::TimepointAwaitOp>(userOp)) {
+        updateOrdinal(opOrdinals[userOp]);
+      } else if (auto joinOp =
+                     dyn_cast<IREE::Stream::TimepointJoinOp>(userOp)) {
+        updateOrdinal(findCompletionOrdinal(joinOp.result()));
+      } else if (auto executeOp =
+                     dyn_cast<IREE::Stream::CmdExecuteOp>(userOp)) {
+        updateOrdinal(findCompletionOrdinal(executeOp.result_timepoint()));
+      }
+    }
+    completionOrdinals[timepoint] = completionOrdinal;
+    return completionOrdinal;
+  }
+
+  Block *block;
+  DenseMap<Operation *, int64_t> opOrdinals;
+  DenseMap<Value, Optional<int64_t>> completionOrdinals;
+};
+
+// Returns the total size of all |sizes| if they are all constant.
+static Optional<int64_t> sumStaticSizes(ValueRange sizes) {
+  int64_t totalSize = 0;
+  for (auto size : sizes) {
+    APInt staticSize;
+    if (!matchPattern(size, m_ConstantInt(&staticSize))) return llvm::None;
+    totalSize += staticSize.getSExtValue();
+  }
+  return totalSize;
+}
+
 //===----------------------------------------------------------------------===//
 // -iree-stream-pack-allocations
 //===----------------------------------------------------------------------===//
@@ -48,22 +174,51 @@ class PackAllocationsPass : public PackAllocationsBase<PackAllocationsPass> {
       return;
     }
 
-    // This is pretty lazy: we just turn stream.resource.alloc ops into a
-    // stream.resource.pack + stream.resource.alloc of a single resource.
-    // This way we reuse all the resource constraints stuff that the pack op
-    // provides even though all of the resources we allocate have perfectly
-    // overlapping lifetime spans.
+    // Subdivide each multi-result stream.resource.alloc into groups of
+    // resources that travel together and pack each group with
+    // stream.resource.pack. This way we reuse all the resource constraints
+    // stuff that the pack op provides.
     //
-    // In the future, we should be doing deeper lifetime analysis here and
-    // subdividing the allocs based on which resources travel together. We can
-    // also do things like overlap the lifetime of inputs and outputs to
-    // execution regions as usually inputs end their lifetime before the outputs
-    // are produced. In this way we'd use the slice intervals to denote which
-    // are mutually exclusive.
+    // Resources that escape the block must stay live for an unknown duration
+    // and are packed into their own slab with perfectly overlapping lifetime
+    // spans. Resources that die within the block are packed into another slab
+    // with their computed live ranges so that those that are dead before
+    // others are produced (such as inputs and outputs of subsequent execution
+    // regions) can share the same memory. Keeping them separate also lets the
+    // local slab be released independently of the escaping one.
+    DenseMap<Block *, std::unique_ptr<BlockLivenessAnalysis>> livenessAnalyses;
+    SmallVector<IREE::Stream::ResourceAllocOp> allocOps;
     parentOp.walk([&](IREE::Stream::ResourceAllocOp allocOp) {
       // If just one result then ignore (nothing to pack).
       if (allocOp.results().size() == 1) return;
-      auto resourceType = allocOp.results().front().getType();
+      allocOps.push_back(allocOp);
+    });
+    for (auto allocOp : allocOps) {
+      auto &livenessAnalysis = livenessAnalyses[allocOp->getBlock()];
+      if (!livenessAnalysis) {
+        livenessAnalysis =
+            std::make_unique<BlockLivenessAnalysis>(allocOp->getBlock());
+      }
+
+      // Partition resources into escaping and local groups.
+      SmallVector<unsigned> escapingResults;
+      SmallVector<unsigned> localResults;
+      SmallVector<LiveRange> liveRanges;
+      for (auto result : allocOp.results()) {
+        auto liveRange = livenessAnalysis->computeLiveRange(result);
+        LLVM_DEBUG({
+          llvm::dbgs() << "result " << result.getResultNumber() << " live ";
+          if (liveRange.escapes) {
+            llvm::dbgs() << "escapes\n";
+          } else {
+            llvm::dbgs() << "[" << liveRange.start << ", " << liveRange.end
+                         << "]\n";
+          }
+        });
+        (liveRange.escapes ? escapingResults : localResults)
+            .push_back(result.getResultNumber());
+        liveRanges.push_back(liveRange);
+      }
 
       // NOTE: this is risky: we are assuming right now that all of the
       // allocations will fit within the constraints of the system. This is not
@@ -71,39 +226,86 @@ class PackAllocationsPass : public PackAllocationsBase<PackAllocationsPass> {
       // that are not fully addressable. For now we are processing models with
       // small enough workloads and our target devices are relatively lax on
       // things so long as we stay under UINT32_MAX boundaries.
+      OpBuilder builder(allocOp);
+      if (!escapingResults.empty()) {
+        // All slices are 0-0 (overlapping).
+        SmallVector<LiveRange> overlappingRanges(escapingResults.size());
+        for (auto &liveRange : overlappingRanges) liveRange.start = 0;
+        packResults(allocOp, escapingResults, overlappingRanges, builder);
+      }
+      if (!localResults.empty()) {
+        SmallVector<LiveRange> localRanges;
+        for (auto resultIndex : localResults) {
+          localRanges.push_back(liveRanges[resultIndex]);
+        }
+        packResults(allocOp, localResults, localRanges, builder);
+      }
 
-      // All slices are 0-0 (overlapping).
-      size_t sliceCount = allocOp.results().size();
-      SmallVector<int64_t> lifetimeIntervals(sliceCount * 2, 0);
+      allocOp.erase();
+    }
+  }
 
-      OpBuilder builder(allocOp);
-      auto indexType = builder.getIndexType();
-      SmallVector<Type> packedOffsetTypes(sliceCount, indexType);
-      auto packOp = builder.create<IREE::Stream::ResourcePackOp>(
-          allocOp.getLoc(), indexType, packedOffsetTypes, /*offset=*/nullptr,
-          builder.getIndexArrayAttr(lifetimeIntervals), allocOp.storage_sizes(),
-          allocOp.affinityAttr());
+ private:
+  // Allocates a slab for the |resultIndices| of |allocOp| with the given
+  // |liveRanges| and replaces the results with subviews into it.
+  void packResults(IREE::Stream::ResourceAllocOp allocOp,
+                   ArrayRef<unsigned> resultIndices,
+                   ArrayRef<LiveRange> liveRanges, OpBuilder &builder) {
+    auto loc = allocOp.getLoc();
+    auto resourceType = allocOp.results().front().getType();
+    SmallVector<Value> storageSizes;
+    for (auto resultIndex : resultIndices) {
+      storageSizes.push_back(allocOp.storage_sizes()[resultIndex]);
+    }
 
-      // Change the alloc to build just a single resource.
+    // Single resources don't need packing.
+    if (resultIndices.size() == 1) {
       auto newOp = builder.create<IREE::Stream::ResourceAllocOp>(
-          allocOp.getLoc(), resourceType, packOp.total_length(),
-          allocOp.uninitializedAttr(), allocOp.affinityAttr());
-      auto slab = newOp.results().front();
-      auto slabSize = packOp.total_length();
-
-      // Replace all resources with subviews into the new slab.
-      for (auto it : llvm::zip(allocOp.results(), packOp.packed_offsets(),
-                               allocOp.storage_sizes())) {
-        auto originalValue = std::get<0>(it);
-        auto subviewOffset = std::get<1>(it);
-        auto subviewLength = std::get<2>(it);
-        auto subviewOp = builder.create<IREE::Stream::ResourceSubviewOp>(
-            allocOp.getLoc(), slab, slabSize, subviewOffset, subviewLength);
-        originalValue.replaceAllUsesWith(subviewOp.result());
-      }
+          loc, resourceType, storageSizes.front(), allocOp.uninitializedAttr(),
+          allocOp.affinityAttr());
+      allocOp.results()[resultIndices.front()].replaceAllUsesWith(
+          newOp.results().front());
+      return;
+    }
 
-      allocOp.erase();
-    });
+    SmallVector<int64_t> lifetimeIntervals;
+    for (auto &liveRange : liveRanges) {
+      lifetimeIntervals.push_back(liveRange.start);
+      lifetimeIntervals.push_back(liveRange.end);
+    }
+
+    auto indexType = builder.getIndexType();
+    SmallVector<Type> packedOffsetTypes(resultIndices.size(), indexType);
+    auto packOp = builder.create<IREE::Stream::ResourcePackOp>(
+        loc, indexType, packedOffsetTypes, /*offset=*/nullptr,
+        builder.getIndexArrayAttr(lifetimeIntervals), storageSizes,
+        allocOp.affinityAttr());
+
+    // Change the alloc to build just a single resource.
+    auto newOp = builder.create<IREE::Stream::ResourceAllocOp>(
+        loc, resourceType, packOp.total_length(), allocOp.uninitializedAttr(),
+        allocOp.affinityAttr());
+    auto slab = newOp.results().front();
+    auto slabSize = packOp.total_length();
+
+    // Record the size required without any packing so that statistics can
+    // report how much memory was saved.
+    auto unpackedSize = sumStaticSizes(storageSizes);
+    if (unpackedSize.hasValue()) {
+      newOp->setAttr("stream.unpacked_size",
+                     builder.getIndexAttr(unpackedSize.getValue()));
+    }
+
+    // Replace all resources with subviews into the new slab.
+    for (auto it : llvm::zip(resultIndices, packOp.packed_offsets(),
+                             storageSizes)) {
+      auto originalValue = allocOp.results()[std::get<0>(it)];
+      auto subviewOffset = std::get<1>(it);
+      auto subviewLength = std::get<2>(it);
+      auto subviewOp = builder.create<IREE::Stream::ResourceSubviewOp>(
+          loc, slab, slabSize, subviewOffset, subviewLength);
+      originalValue.replaceAllUsesWith(subviewOp.result());
+    }
   }
 };
 
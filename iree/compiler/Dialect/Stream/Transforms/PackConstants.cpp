@@ -4,6 +4,8 @@
 // See https://llvm.org/LICENSE.txt for license information.
 // SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
 
+#include <unordered_map>
+
 #include "iree/compiler/Dialect/Stream/IR/StreamDialect.h"
 #include "iree/compiler/Dialect/Stream/IR/StreamOps.h"
 #include "iree/compiler/Dialect/Stream/IR/StreamTypes.h"
@@ -13,6 +15,7 @@
 #include "iree/compiler/Dialect/Util/IR/UtilOps.h"
 #include "iree/compiler/Dialect/Util/IR/UtilTypes.h"
 #include "iree/compiler/Utils/IndexSet.h"
+#include "llvm/ADT/Sequence.h"
 #include "llvm/Support/Debug.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
 #include "mlir/Dialect/SCF/SCF.h"
@@ -73,6 +76,9 @@ struct PackedSpan {
   // any additional padding for other spans within the buffer (like start
   // offset alignment).
   uint64_t length = 0;
+  // True if the span aliases the data of another span in the same buffer and
+  // contributes no data of its own.
+  bool isAlias = false;
 };
 
 struct StorageResource {
@@ -88,31 +94,99 @@ struct StorageResource {
 };
 
 // Buckets |slices| into 1+ storage resources based on |resourceConfig|.
+//
+// When all slices fit within a single storage resource they are kept in their
+// original order as that order may have been chosen for locality. Otherwise
+// slices are assigned with best-fit decreasing bin packing to minimize the
+// number of resources and the space wasted at the end of each, and then
+// returned to their original relative order within each resource.
 static SmallVector<StorageResource, 8> bucketValuesIntoStorageResources(
     ArrayRef<ConstantSlice> slices,
     IREE::Stream::ResourceConfigAttr resourceConfig) {
-  // TODO(benvanik): replace with a better strategy (best-fit, etc).
-  SmallVector<StorageResource, 8> storageBuffers;
-  storageBuffers.push_back({UnknownLoc::get(resourceConfig.getContext())});
-  StorageResource *currentBuffer = &storageBuffers.back();
-  for (auto slice : slices) {
-    uint64_t offset = IREE::Util::align(
-        currentBuffer->totalSize, resourceConfig.getMinBufferOffsetAlignment());
-    uint64_t unpaddedLength = slice.getRawLength();
-    uint64_t paddedLength = IREE::Util::align(
-        unpaddedLength, resourceConfig.getMinBufferRangeAlignment());
-    if (offset + unpaddedLength > resourceConfig.getMaxAllocationSize()) {
-      // Spilling buffer; make a new one.
-      storageBuffers.push_back({UnknownLoc::get(resourceConfig.getContext())});
-      currentBuffer = &storageBuffers.back();
-      offset = 0;
+  if (slices.empty()) return {};
+  uint64_t offsetAlignment = resourceConfig.getMinBufferOffsetAlignment();
+  uint64_t rangeAlignment = resourceConfig.getMinBufferRangeAlignment();
+  uint64_t maxAllocationSize = resourceConfig.getMaxAllocationSize();
+
+  // Size of each slice when followed by another slice.
+  SmallVector<uint64_t> alignedLengths;
+  uint64_t totalLength = 0;
+  for (auto &slice : slices) {
+    alignedLengths.push_back(
+        IREE::Util::align(slice.getRawLength(), offsetAlignment));
+    totalLength += alignedLengths.back();
+  }
+
+  // Assign slice indices to buckets.
+  SmallVector<SmallVector<unsigned>> buckets;
+  if (totalLength <= maxAllocationSize) {
+    buckets.emplace_back(
+        llvm::to_vector(llvm::seq<unsigned>(0, slices.size())));
+  } else {
+    SmallVector<unsigned> sortedIndices =
+        llvm::to_vector(llvm::seq<unsigned>(0, slices.size()));
+    llvm::stable_sort(sortedIndices, [&](unsigned lhs, unsigned rhs) {
+      return alignedLengths[lhs] > alignedLengths[rhs];
+    });
+    SmallVector<uint64_t> bucketLengths;
+    for (auto sliceIndex : sortedIndices) {
+      uint64_t length = alignedLengths[sliceIndex];
+      int bestBucket = -1;
+      uint64_t bestRemaining = UINT64_MAX;
+      for (auto bucketLength : llvm::enumerate(bucketLengths)) {
+        if (bucketLength.value() >= maxAllocationSize) continue;
+        uint64_t remaining = maxAllocationSize - bucketLength.value();
+        if (length <= remaining && remaining - length < bestRemaining) {
+          bestBucket = bucketLength.index();
+          bestRemaining = remaining - length;
+        }
+      }
+      if (bestBucket == -1) {
+        // Spilling buffer; make a new one. Slices larger than the maximum
+        // allocation size always end up alone in their own buffer.
+        bestBucket = buckets.size();
+        buckets.emplace_back();
+        bucketLengths.push_back(0);
+      }
+      buckets[bestBucket].push_back(sliceIndex);
+      bucketLengths[bestBucket] += length;
     }
-    currentBuffer->spans.push_back({slice, offset, unpaddedLength});
-    currentBuffer->totalSize =
-        std::max(currentBuffer->totalSize, offset + paddedLength);
+    for (auto &bucket : buckets) llvm::sort(bucket);
+    llvm::sort(buckets, [](const SmallVector<unsigned> &lhs,
+                           const SmallVector<unsigned> &rhs) {
+      return lhs.front() < rhs.front();
+    });
   }
-  if (storageBuffers.back().spans.empty()) {
-    storageBuffers.pop_back();
+
+  SmallVector<StorageResource, 8> storageBuffers;
+  for (auto &bucket : buckets) {
+    // The last span in a buffer only needs range alignment and not offset
+    // alignment as nothing follows it. Place the span that saves the most
+    // padding from this last (keeping the original order on ties).
+    auto getTailSavings = [&](unsigned sliceIndex) {
+      return alignedLengths[sliceIndex] -
+             IREE::Util::align(slices[sliceIndex].getRawLength(),
+                               rangeAlignment);
+    };
+    auto tailIt = bucket.begin();
+    for (auto it = bucket.begin(); it != bucket.end(); ++it) {
+      if (getTailSavings(*it) >= getTailSavings(*tailIt)) tailIt = it;
+    }
+    std::rotate(tailIt, std::next(tailIt), bucket.end());
+
+    storageBuffers.push_back({UnknownLoc::get(resourceConfig.getContext())});
+    auto &storageBuffer = storageBuffers.back();
+    for (auto sliceIndex : bucket) {
+      auto &slice = slices[sliceIndex];
+      uint64_t offset =
+          IREE::Util::align(storageBuffer.totalSize, offsetAlignment);
+      uint64_t unpaddedLength = slice.getRawLength();
+      uint64_t paddedLength =
+          IREE::Util::align(unpaddedLength, rangeAlignment);
+      storageBuffer.spans.push_back({slice, offset, unpaddedLength});
+      storageBuffer.totalSize =
+          std::max(storageBuffer.totalSize, offset + paddedLength);
+    }
   }
   return storageBuffers;
 }
@@ -145,15 +219,16 @@ static void packStorageResourceData(StorageResource &storageBuffer,
   SmallVector<Attribute> values;
   int64_t offset = 0;
   for (auto &constantSpan : storageBuffer.spans) {
-    if (constantSpan.length == 0) continue;
+    if (constantSpan.length == 0 || constantSpan.isAlias) continue;
 
     int64_t start = constantSpan.offset;
     int64_t end = start + constantSpan.length;
 
-    // TODO(benvanik): when we start overlapping data we'll want to have a way
-    // to build subranges here by slicing out parts of the attributes we have
-    // coming in. This could be done with a #util.slice<> attr or something
-    // that when serialized performs the offsetting.
+    // NOTE: aliasing spans are fully contained within the span they alias
+    // and are skipped above. If we start partially overlapping data we'll
+    // want to have a way to build subranges here by slicing out parts of the
+    // attributes we have coming in. This could be done with a #util.slice<>
+    // attr or something that when serialized performs the offsetting.
     assert(start >= offset && "expect ordered spans");
 
     int64_t spanPadding = start - offset;
@@ -184,12 +259,159 @@ static void packStorageResourceData(StorageResource &storageBuffer,
   assert(storageBuffer.data && "unable to build composite attr");
 }
 
+// A slice whose data is fully contained within the data of another slice.
+struct SliceAlias {
+  // Slice that will reference the data of |targetIndex|.
+  ConstantSlice slice;
+  // Index of the unique slice containing the data.
+  unsigned targetIndex;
+  // Byte offset of the data within the target slice.
+  uint64_t targetOffset;
+};
+
+// Returns the raw bytes of |slice| if available for comparison.
+// Splats, elided constants, and element types that are not byte-aligned (such
+// as bit-packed i1) are only deduplicated when the attributes are identical as
+// their raw storage does not match the bytes they serialize to.
+static Optional<StringRef> getSliceBytes(const ConstantSlice &slice) {
+  auto denseAttr = slice.value.dyn_cast<DenseElementsAttr>();
+  if (!denseAttr || denseAttr.isSplat()) return llvm::None;
+  auto elementType = denseAttr.getElementType();
+  if (!elementType.isIntOrFloat() ||
+      elementType.getIntOrFloatBitWidth() % 8 != 0) {
+    return llvm::None;
+  }
+  auto rawData = denseAttr.getRawData();
+  return StringRef(rawData.data(), rawData.size());
+}
+
+// Constants larger than this are not searched for subranges that other
+// constants could alias. Small constants (shapes, biases, lookup tables, etc)
+// are the most likely to be repeated as subranges of one another and indexing
+// large constants is expensive.
+static constexpr uint64_t kMaxSubrangeSearchLength = 1 * 1024 * 1024;
+
+// Number of leading bytes hashed to find subrange alias candidates. Slices
+// shorter than this are only deduplicated when fully identical.
+static constexpr uint64_t kSubrangeKeyLength = 8;
+
+// Deduplicates |slices| into |uniqueSlices| and |aliases| of their data.
+// Slices are aliased when their bytes are identical to another slice or when
+// they appear at an offset within another slice that meets the
+// minimum buffer offset alignment of |resourceConfig|.
+static void deduplicateSlices(ArrayRef<ConstantSlice> slices,
+                              IREE::Stream::ResourceConfigAttr resourceConfig,
+                              SmallVectorImpl<ConstantSlice> &uniqueSlices,
+                              SmallVectorImpl<SliceAlias> &aliases) {
+  uint64_t offsetAlignment = resourceConfig.getMinBufferOffsetAlignment();
+
+  // Exact matches first; attributes are uniqued so identical values are
+  // pointer-equal and byte-identical values of differing types compare by
+  // bytes.
+  DenseMap<Attribute, unsigned> attrIndices;
+  DenseMap<StringRef, unsigned> byteIndices;
+  SmallVector<ConstantSlice> candidateSlices;
+  for (auto &slice : slices) {
+    auto attrIt = attrIndices.find(slice.value);
+    if (attrIt != attrIndices.end()) {
+      aliases.push_back({slice, attrIt->second, 0});
+      continue;
+    }
+    auto bytes = getSliceBytes(slice);
+    if (bytes.hasValue()) {
+      auto byteIt = byteIndices.find(bytes.getValue());
+      if (byteIt != byteIndices.end()) {
+        aliases.push_back({slice, byteIt->second, 0});
+        continue;
+      }
+      byteIndices[bytes.getValue()] = uniqueSlices.size();
+    }
+    attrIndices[slice.value] = uniqueSlices.size();
+    uniqueSlices.push_back(slice);
+  }
+
+  // Search for slices contained within larger slices. We walk from largest to
+  // smallest so that containers are always indexed before the slices they may
+  // contain. Candidates are found by hashing the leading bytes of each slice
+  // and every aligned offset of the indexed slices and then verified.
+  SmallVector<unsigned> sortedIndices =
+      llvm::to_vector(llvm::seq<unsigned>(0, uniqueSlices.size()));
+  llvm::stable_sort(sortedIndices, [&](unsigned lhs, unsigned rhs) {
+    return uniqueSlices[lhs].getRawLength() > uniqueSlices[rhs].getRawLength();
+  });
+  std::unordered_map<size_t, SmallVector<std::pair<unsigned, uint64_t>, 1>>
+      subrangeIndex;
+  // Unique slice index -> (container slice index, offset within container).
+  DenseMap<unsigned, std::pair<unsigned, uint64_t>> subrangeAliases;
+  for (auto sliceIndex : sortedIndices) {
+    auto bytes = getSliceBytes(uniqueSlices[sliceIndex]);
+    if (!bytes.hasValue() || bytes->size() < kSubrangeKeyLength) continue;
+
+    // Try to find a container.
+    size_t key = llvm::hash_value(bytes->take_front(kSubrangeKeyLength));
+    auto indexIt = subrangeIndex.find(key);
+    if (indexIt != subrangeIndex.end()) {
+      for (auto candidate : indexIt->second) {
+        auto containerBytes =
+            getSliceBytes(uniqueSlices[candidate.first]).getValue();
+        if (containerBytes.substr(candidate.second, bytes->size()) ==
+            bytes.getValue()) {
+          LLVM_DEBUG(llvm::dbgs() << "aliasing " << bytes->size()
+                                  << "b constant at offset " << candidate.second
+                                  << " of another constant\n");
+          subrangeAliases[sliceIndex] = candidate;
+          break;
+        }
+      }
+    }
+    if (subrangeAliases.count(sliceIndex)) continue;
+
+    // Index this slice so smaller slices can alias it.
+    if (bytes->size() > kMaxSubrangeSearchLength) continue;
+    for (uint64_t offset = 0; offset + kSubrangeKeyLength <= bytes->size();
+         offset += offsetAlignment) {
+      size_t offsetKey =
+          llvm::hash_value(bytes->substr(offset, kSubrangeKeyLength));
+      subrangeIndex[offsetKey].push_back({sliceIndex, offset});
+    }
+  }
+  if (subrangeAliases.empty()) return;
+
+  // Remove aliased slices from the unique set and remap alias targets. As
+  // containers are never aliased themselves there is at most one level of
+  // indirection: an exact alias of a slice that was then found within another.
+  SmallVector<ConstantSlice> remainingSlices;
+  SmallVector<unsigned> remappedIndices(uniqueSlices.size());
+  for (auto it : llvm::enumerate(uniqueSlices)) {
+    auto aliasIt = subrangeAliases.find(it.index());
+    if (aliasIt != subrangeAliases.end()) {
+      aliases.push_back(
+          {it.value(), aliasIt->second.first, aliasIt->second.second});
+      continue;
+    }
+    remappedIndices[it.index()] = remainingSlices.size();
+    remainingSlices.push_back(it.value());
+  }
+  for (auto &alias : aliases) {
+    auto aliasIt = subrangeAliases.find(alias.targetIndex);
+    if (aliasIt != subrangeAliases.end()) {
+      alias.targetIndex = aliasIt->second.first;
+      alias.targetOffset += aliasIt->second.second;
+    }
+    alias.targetIndex = remappedIndices[alias.targetIndex];
+  }
+  uniqueSlices.assign(remainingSlices.begin(), remainingSlices.end());
+}
+
 // Returns zero or more storage resources and the spans values map into.
 // Assume that |slices| have been ordered by prior passes and that order may
 // have some performance-sensitivity (constants are grouped by
 // locality/lifetime/etc).
+// When |deduplicate| is true slices with identical data will share storage;
+// this is only valid for immutable constants as variables are initialized
+// from the storage but are then independently mutable.
 static SmallVector<StorageResource, 8> computePackingMap(
-    ArrayRef<ConstantSlice> slices,
+    ArrayRef<ConstantSlice> slices, bool deduplicate,
     IREE::Stream::ResourceConfigAttr resourceConfig, MLIRContext *context) {
   // This is literally all my brain has brain for right now. The ideal here is
   // that we have a basic static (and ideally profile-guided) sorting pass
@@ -218,13 +440,40 @@ static SmallVector<StorageResource, 8> computePackingMap(
   // things around and waste on silly things like loading times).
   //
   // Here it's all descriptor sets and mapped pages but same thing pretty
-  // much, and passes earlier on may duplicate constants in the pool if it
-  // means they can improve locality at runtime. This pass doesn't dedupe and
-  // just sticks to packing for that reason.
+  // much. Unlike the CD-ROM days duplicating data within a single storage
+  // buffer doesn't help locality as it's all mapped together anyway, so we
+  // dedupe identical values (and values contained within others) and only
+  // pay for their bytes once.
+  SmallVector<ConstantSlice> uniqueSlices;
+  SmallVector<SliceAlias> aliases;
+  if (deduplicate) {
+    deduplicateSlices(slices, resourceConfig, uniqueSlices, aliases);
+  } else {
+    uniqueSlices.append(slices.begin(), slices.end());
+  }
 
   // Build a list of resources and spans (append to current or spill to new).
   auto storageBuffers =
-      bucketValuesIntoStorageResources(slices, resourceConfig);
+      bucketValuesIntoStorageResources(uniqueSlices, resourceConfig);
+
+  // Add spans for aliases pointing at the storage of the slices they alias.
+  if (!aliases.empty()) {
+    DenseMap<Value, std::pair<StorageResource *, uint64_t>> sliceStorage;
+    for (auto &storageBuffer : storageBuffers) {
+      for (auto &span : storageBuffer.spans) {
+        sliceStorage[span.slice.result] = {&storageBuffer, span.offset};
+      }
+    }
+    for (auto &alias : aliases) {
+      auto storage = sliceStorage[uniqueSlices[alias.targetIndex].result];
+      PackedSpan span;
+      span.slice = alias.slice;
+      span.offset = storage.second + alias.targetOffset;
+      span.length = alias.slice.getRawLength();
+      span.isAlias = true;
+      storage.first->spans.push_back(span);
+    }
+  }
 
   // Pack each storage resource bucket into a single data blob.
   for (auto &storageBuffer : storageBuffers) {
@@ -480,10 +729,21 @@ class PackConstantsPass : public PackConstantsBase<PackConstantsPass> {
         });
       }
 
+      // If this is producing constants (vs variables) we can try to go on a
+      // fast-path where we directly map the constant memory. If producing
+      // variables then we always need to stage and clone.
+      auto anyResult = constantsOp.results().front();
+      auto resourceType =
+          anyResult.getType().cast<IREE::Stream::ResourceType>();
+      bool isConstant =
+          resourceType.getLifetime() == IREE::Stream::Lifetime::Constant;
+
       // Perform the packing of dense values to compute the storage resources we
-      // will need and where each value will be placed.
-      auto storageResources =
-          computePackingMap(slices, resourceConfig, constantsOp.getContext());
+      // will need and where each value will be placed. Only immutable constants
+      // may share storage with each other.
+      auto storageResources = computePackingMap(
+          slices, /*deduplicate=*/isConstant, resourceConfig,
+          constantsOp.getContext());
       if (storageResources.empty()) return;
 
       OpBuilder builder(constantsOp);
@@ -503,14 +763,8 @@ class PackConstantsPass : public PackConstantsBase<PackConstantsPass> {
         storageBuffers.push_back(rodataOp);
       }
 
-      // If this is producing constants (vs variables) we can try to go on a
-      // fast-path where we directly map the constant memory. If producing
-      // variables then we always need to stage and clone.
-      auto anyResult = constantsOp.results().front();
-      auto resourceType =
-          anyResult.getType().cast<IREE::Stream::ResourceType>();
       UploadResult uploadResult;
-      if (resourceType.getLifetime() == IREE::Stream::Lifetime::Constant) {
+      if (isConstant) {
         uploadResult = buildTryMapConstantResources(
             constantsOp, resourceType, storageResources, storageBuffers,
             indexSet, builder);
@@ -46,7 +46,9 @@ struct TransformOptions : public PassPipelineOptions<TransformOptions> {
           clEnumValN(IREE::Stream::DumpOutputFormat::Verbose, "verbose",
                      "Pretty printed output with additional IR."),
           clEnumValN(IREE::Stream::DumpOutputFormat::CSV, "csv",
-                     "Comma separated values.")),
+                     "Comma separated values."),
+          clEnumValN(IREE::Stream::DumpOutputFormat::JSON, "json",
+                     "JSON output with nested structures.")),
   };
   Option<std::string> dumpStatisticsFile{
       *this,
@@ -104,6 +104,7 @@ struct ExecutePartitionBuilder {
     executeOp = parentBuilder.create<IREE::Stream::AsyncExecuteOp>(
         fusedLoc, resultTypes, resultSizes, /*awaitTimepoint=*/Value{},
         operands, operandSizes, tiedOperands);
+    if (partition->affinity) executeOp.affinityAttr(partition->affinity);
 
     // Add entry block and arguments.
     auto &entryBlock = executeOp.body().emplaceBlock();
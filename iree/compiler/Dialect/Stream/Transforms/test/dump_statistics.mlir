@@ -1,19 +1,80 @@
 // RUN: iree-opt -split-input-file -pass-pipeline=iree-stream-dump-statistics{output-format=pretty} %s 2>&1 | FileCheck %s -check-prefix=CHECK-PRETTY
 // RUN: iree-opt -split-input-file -pass-pipeline=iree-stream-dump-statistics{output-format=csv} %s 2>&1 | FileCheck %s -check-prefix=CHECK-CSV
+// RUN: iree-opt -split-input-file -pass-pipeline=iree-stream-dump-statistics{output-format=json} %s 2>&1 | FileCheck %s -check-prefix=CHECK-JSON
 
 // CHECK-PRETTY: Aggregate Statistics
-// CHECK-PRETTY:   Constants: 1, 0 B
+// CHECK-PRETTY:   Constants: 1, 192 B
 // CHECK-PRETTY:   Variables: 0, 0 B
 // CHECK-PRETTY:  D->H Syncs: 2
 // CHECK-PRETTY: Submissions: 3, using cumulative 0 B
-// CHECK-PRETTY:   DMA Fills: 0
-// CHECK-PRETTY:  DMA Copies: 2
+// CHECK-PRETTY:  Peak Usage: 0 B (0.00 MiB) transient
+// CHECK-PRETTY: Allocations: 3, 224 B
+// CHECK-PRETTY:   DMA Fills: 0, 0 B
+// CHECK-PRETTY:  DMA Copies: 2, 208 B
 // CHECK-PRETTY:  Dispatches: 3
 // CHECK-PRETTY: Executables: 2, 33% reuse
 
+// CHECK-PRETTY: Constants / Variables
+// CHECK-PRETTY:     Constant Globals: 1, 192 B (0.00 MiB) embedded
+// CHECK-PRETTY:     Variable Globals: 0, 0 B (0.00 MiB) embedded
+// CHECK-PRETTY:         Byte Buffers: 1
+
+// CHECK-PRETTY: Synchronization
+// CHECK-PRETTY:    D->H Awaits: 2
+// CHECK-PRETTY:   Buffer Maps: 1 map, 1 try_map
+// CHECK-PRETTY: Staging Buffers: 192 B
+// CHECK-PRETTY: util.initializer: 1 submissions, 0 awaits
+// CHECK-PRETTY: func.func @func_a: 2 submissions, 2 awaits
+
+// CHECK-PRETTY: Streams
+// CHECK-PRETTY:             Streams: 3
+// CHECK-PRETTY: Commands per Stream: 1.67 average
+// CHECK-PRETTY:   Device Dependency: 2 streams awaiting
+// CHECK-PRETTY: stream.cmd.execute
+// CHECK-PRETTY: Captured Resources: 2
+// CHECK-PRETTY:    Timepoint Await: no
+// CHECK-PRETTY:           Commands: 1 (0 fills, 1 copies, 0 dispatches)
+// CHECK-PRETTY:        Concurrency: 0% (0 commands in 0 concurrent regions)
+
+// CHECK-PRETTY: Executables
+// CHECK-PRETTY:    Executables: 2
+// CHECK-PRETTY:        Exports: 2
+// CHECK-PRETTY: Bindings/Export: 3.00 average
+// CHECK-PRETTY: Operands/Export: 0.00 average
+// CHECK-PRETTY: stream.executable.export @func_a_ex_0::@dispatch_0
+// CHECK-PRETTY:   Bindings: 3
+// CHECK-PRETTY:   Operands: 0
+// CHECK-PRETTY: Dispatches: 2
+// CHECK-PRETTY:   - workload 4x1x1
+// CHECK-PRETTY: stream.executable.export @func_a_ex_1::@dispatch_1
+// CHECK-PRETTY: Dispatches: 1
+
 // CHECK-CSV: ; Aggregate Statistics
 // CHECK-CSV: "Constants","Constant Size","Variables","Variable Size","Awaits","Submissions","Transient Size","Fills","Copies","Dispatches","Executables"
-// CHECK-CSV: 1,0,0,0,2,3,0,0,2,3,2
+// CHECK-CSV: 1,192,0,0,2,3,0,0,2,3,2
+
+// CHECK-JSON: "stream-aggregate": {
+// CHECK-JSON:   "global": {
+// CHECK-JSON:     "constant-size": 192,
+// CHECK-JSON:   "synchronization": {
+// CHECK-JSON:     "await-count": 2,
+// CHECK-JSON:     "map-count": 1,
+// CHECK-JSON:     "try-map-count": 1,
+// CHECK-JSON:     "staging-size": 192
+// CHECK-JSON:   "execution": {
+// CHECK-JSON:     "peak-transient-memory-size": 0,
+// CHECK-JSON:     "copy-size": 208,
+// CHECK-JSON:     "dispatch-count": 3
+// CHECK-JSON: "functions": [
+// CHECK-JSON:     "name": "func_a",
+// CHECK-JSON:     "submission-count": 2,
+// CHECK-JSON:     "await-count": 2,
+// CHECK-JSON: "executables": [
+// CHECK-JSON:     "name": "func_a_ex_0",
+// CHECK-JSON:     "export-count": 1,
+// CHECK-JSON:     "dispatch-count": 2
+// CHECK-JSON:     "name": "func_a_ex_1",
+// CHECK-JSON:     "dispatch-count": 1
 
 util.global private mutable @_constant__timepoint = #stream.timepoint<immediate>
 util.global private @_constant : !stream.resource<constant>
@@ -89,3 +89,32 @@ func.func @layoutMixedStaticDynamic(%size_a: index, %size_b: index) -> (index, i
   // CHECK: return %3, %c0, %c208, %1, %c0
   return %t#0, %t#1, %t#2, %t#3, %t#4 : index, index, index, index, index
 }
+
+// -----
+
+#layoutBoundedDynamicConfig = #stream.resource_config<{
+  max_allocation_size = 1073741824,
+  min_buffer_offset_alignment = 16,
+  max_buffer_range = 1073741824,
+  min_buffer_range_alignment = 16
+}>
+
+// CHECK-LABEL: @layoutBoundedDynamic
+// CHECK-SAME: (%[[SIZE_A:.+]]: index)
+func.func @layoutBoundedDynamic(%size_a: index) -> (index, index, index, index)
+    attributes {stream.resources = #layoutBoundedDynamicConfig} {
+  %c64 = arith.constant 64 : index
+  %c100 = arith.constant 100 : index
+  %c200 = arith.constant 200 : index
+  %size_bounded = arith.minui %size_a, %c64 : index
+  %t:4 = stream.resource.pack slices({
+    [0, 1] = %c200,           // +0
+    [2, 3] = %size_bounded,   // +112 (upper bound 64 fits after [2, 3] below)
+    [2, 3] = %c100,           // +0 (reuse [0, 1])
+  }) : index
+  // Bounded slice aliases into the static reservation of [0, 1]:
+  // 200 align 16 = 208 total bytes required
+  // CHECK: return %c208
+  // CHECK-SAME: %c0, %c112, %c0
+  return %t#0, %t#1, %t#2, %t#3 : index, index, index, index
+}
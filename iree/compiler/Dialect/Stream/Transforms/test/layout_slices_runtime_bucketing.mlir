@@ -0,0 +1,33 @@
+// RUN: iree-opt -split-input-file -pass-pipeline='func.func(iree-stream-layout-slices{runtime-bucketing})' -cse %s | FileCheck %s
+
+#layoutDynamicConfig = #stream.resource_config<{
+  max_allocation_size = 1073741824,
+  min_buffer_offset_alignment = 16,
+  max_buffer_range = 1073741824,
+  min_buffer_range_alignment = 16
+}>
+
+// Tests that dynamic slices with differing sizes alias when their lifetimes do
+// not overlap and that the bin is sized to the max of the slices at runtime.
+
+// CHECK-LABEL: @layoutDynamicRuntimeBucketing
+// CHECK-SAME: (%[[SIZE_A:.+]]: index, %[[SIZE_B:.+]]: index)
+func.func @layoutDynamicRuntimeBucketing(%size_a: index, %size_b: index) -> (index, index, index, index)
+    attributes {stream.resources = #layoutDynamicConfig} {
+  %t:4 = stream.resource.pack slices({
+    [0, 1] = %size_a,
+    [1, 2] = %size_a,
+    [2, 3] = %size_b,
+  }) : index
+
+  // CHECK-DAG: %c0 = arith.constant 0 : index
+  // CHECK-DAG: %c16 = arith.constant 16 : index
+  // CHECK-DAG: %[[BIN0_MAX:.+]] = arith.maxui %[[SIZE_A]], %[[SIZE_B]] : index
+  // CHECK-DAG: %[[BIN0_SIZE:.+]] = util.align %[[BIN0_MAX]], %c16 : index
+  // CHECK-DAG: %[[BIN1_OFFSET:.+]] = arith.addi %c0, %[[BIN0_SIZE]] : index
+  // CHECK-DAG: %[[BIN1_SIZE:.+]] = util.align %[[SIZE_A]], %c16 : index
+  // CHECK-DAG: %[[TOTAL:.+]] = arith.addi %[[BIN1_OFFSET]], %[[BIN1_SIZE]] : index
+
+  // CHECK: return %[[TOTAL]], %c0, %[[BIN1_OFFSET]], %c0
+  return %t#0, %t#1, %t#2, %t#3 : index, index, index, index
+}
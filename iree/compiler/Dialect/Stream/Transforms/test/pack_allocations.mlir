@@ -36,3 +36,47 @@ func.func @packEmpty() {
   util.do_not_optimize(%0) : !stream.resource<transient>
   return
 }
+
+// -----
+
+// Tests that resources whose lifetimes end before others begin are packed with
+// disjoint lifetime intervals so that they can alias and that resources that
+// escape are split into their own slab.
+
+// CHECK-LABEL: @packAllocationsLifetimes
+// CHECK-SAME: (%[[SIZE_A:.+]]: index, %[[SIZE_B:.+]]: index, %[[SIZE_C:.+]]: index)
+func.func @packAllocationsLifetimes(%size_a: index, %size_b: index, %size_c: index) -> !stream.resource<transient> {
+  %c0 = arith.constant 0 : index
+  %c128 = arith.constant 128 : index
+  %c255_i32 = arith.constant 255 : i32
+
+  // Escaping resources get their own slab (here just a single resource).
+  // CHECK: %[[ALLOC_C:.+]] = stream.resource.alloc uninitialized : !stream.resource<transient>{%[[SIZE_C]]}
+
+  //      CHECK: %[[SLICES:.+]]:3 = stream.resource.pack slices({
+  // CHECK-NEXT:   [4, 5] = %[[SIZE_A]],
+  // CHECK-NEXT:   [6, 7] = %[[SIZE_B]]
+  // CHECK-NEXT: }) : index
+  // CHECK: %[[ALLOC:.+]] = stream.resource.alloc uninitialized : !stream.resource<transient>{%[[SLICES]]#0}
+  // CHECK: %[[SLICE_A:.+]] = stream.resource.subview %[[ALLOC]][%[[SLICES]]#1]
+  // CHECK: %[[SLICE_B:.+]] = stream.resource.subview %[[ALLOC]][%[[SLICES]]#2]
+  %0:3 = stream.resource.alloc uninitialized :
+      !stream.resource<transient>{%size_a},
+      !stream.resource<transient>{%size_b},
+      !stream.resource<transient>{%size_c}
+
+  // CHECK: stream.cmd.execute with(%[[SLICE_A]] as
+  %t0 = stream.cmd.execute with(%0#0 as %arg0: !stream.resource<transient>{%size_a}) {
+    stream.cmd.fill %c255_i32, %arg0[%c0 for %c128] : i32 -> !stream.resource<transient>{%size_a}
+  } => !stream.timepoint
+  %1 = stream.timepoint.await %t0 => %0#0 : !stream.resource<transient>{%size_a}
+
+  // CHECK: stream.cmd.execute with(%[[SLICE_B]] as {{.+}}, %[[ALLOC_C]] as
+  %t1 = stream.cmd.execute with(%0#1 as %arg0: !stream.resource<transient>{%size_b}, %0#2 as %arg1: !stream.resource<transient>{%size_c}) {
+    stream.cmd.fill %c255_i32, %arg0[%c0 for %c128] : i32 -> !stream.resource<transient>{%size_b}
+    stream.cmd.fill %c255_i32, %arg1[%c0 for %c128] : i32 -> !stream.resource<transient>{%size_c}
+  } => !stream.timepoint
+  %2:2 = stream.timepoint.await %t1 => %0#1, %0#2 : !stream.resource<transient>{%size_b}, !stream.resource<transient>{%size_c}
+
+  return %2#1 : !stream.resource<transient>
+}
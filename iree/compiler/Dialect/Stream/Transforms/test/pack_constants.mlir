@@ -109,3 +109,115 @@ func.func @splitResourceConstants() -> (!stream.resource<constant>, !stream.reso
   // CHECK: return %[[RES0]], %[[RES1]], %[[IF]]#2
   return %0#0, %0#1, %0#2 : !stream.resource<constant>, !stream.resource<constant>, !stream.timepoint
 }
+
+// -----
+
+// Tests that identical constants share storage and that constants found at an
+// aligned offset within another constant alias its data instead of being
+// stored again.
+
+#dedupeResourceConstantsConfig = #stream.resource_config<{
+  max_allocation_size = 1073741824,
+  min_buffer_offset_alignment = 16,
+  max_buffer_range = 1073741824,
+  min_buffer_range_alignment = 16
+}>
+
+// Only [1..8] and the misaligned [2, 3, 4, 5] are stored.
+//      CHECK: #composite_of_48b = #util.composite<48xi8, [
+// CHECK-NEXT:   dense<[1, 2, 3, 4, 5, 6, 7, 8]> : tensor<8xi32>,
+// CHECK-NEXT:   dense<[2, 3, 4, 5]> : tensor<4xi32>,
+// CHECK-NEXT: ]>
+
+// CHECK-LABEL: @dedupeResourceConstants
+func.func @dedupeResourceConstants() -> (!stream.resource<constant>, !stream.resource<constant>, !stream.resource<constant>, !stream.resource<constant>, !stream.timepoint)
+    attributes {stream.resources = #dedupeResourceConstantsConfig} {
+  %c16 = arith.constant 16 : index
+  %c32 = arith.constant 32 : index
+
+  // CHECK: util.byte_buffer.constant {alignment = 16 : i64} : !util.byte_buffer = #composite_of_48b
+  %0:5 = stream.resource.constants :
+    !stream.resource<constant>{%c32} = dense<[1, 2, 3, 4, 5, 6, 7, 8]> : tensor<8xi32>,
+    !stream.resource<constant>{%c32} = dense<[1, 2, 3, 4, 5, 6, 7, 8]> : tensor<8xi32>,
+    !stream.resource<constant>{%c16} = dense<[5, 6, 7, 8]> : tensor<4xi32>,
+    !stream.resource<constant>{%c16} = dense<[2, 3, 4, 5]> : tensor<4xi32>
+    => !stream.timepoint
+
+  // CHECK: %[[IF:.+]]:2 = scf.if
+  // CHECK-DAG: %[[RES0:.+]] = stream.resource.subview %[[IF]]#0[%c0] : !stream.resource<constant>{%c48} -> !stream.resource<constant>{%c32}
+  // CHECK-DAG: %[[RES1:.+]] = stream.resource.subview %[[IF]]#0[%c0] : !stream.resource<constant>{%c48} -> !stream.resource<constant>{%c32}
+  // CHECK-DAG: %[[RES2:.+]] = stream.resource.subview %[[IF]]#0[%c16] : !stream.resource<constant>{%c48} -> !stream.resource<constant>{%c16}
+  // CHECK-DAG: %[[RES3:.+]] = stream.resource.subview %[[IF]]#0[%c32] : !stream.resource<constant>{%c48} -> !stream.resource<constant>{%c16}
+
+  // CHECK: return %[[RES0]], %[[RES1]], %[[RES2]], %[[RES3]], %[[IF]]#1
+  return %0#0, %0#1, %0#2, %0#3, %0#4 : !stream.resource<constant>, !stream.resource<constant>, !stream.resource<constant>, !stream.resource<constant>, !stream.timepoint
+}
+
+// -----
+
+// Tests that identical values produced as variables are not deduplicated:
+// each variable is initialized from the storage but is independently mutable
+// afterward and must not alias any other.
+
+#dedupeResourceVariablesConfig = #stream.resource_config<{
+  max_allocation_size = 1073741824,
+  min_buffer_offset_alignment = 16,
+  max_buffer_range = 1073741824,
+  min_buffer_range_alignment = 16
+}>
+
+//      CHECK: #composite_of_32b = #util.composite<32xi8, [
+// CHECK-NEXT:   dense<[1, 2, 3, 4]> : tensor<4xi32>,
+// CHECK-NEXT:   dense<[1, 2, 3, 4]> : tensor<4xi32>,
+// CHECK-NEXT: ]>
+
+// CHECK-LABEL: @dedupeResourceVariables
+func.func @dedupeResourceVariables() -> (!stream.resource<variable>, !stream.resource<variable>, !stream.timepoint)
+    attributes {stream.resources = #dedupeResourceVariablesConfig} {
+  %c16 = arith.constant 16 : index
+
+  // CHECK: util.byte_buffer.constant {alignment = 16 : i64} : !util.byte_buffer = #composite_of_32b
+  %0:3 = stream.resource.constants :
+    !stream.resource<variable>{%c16} = dense<[1, 2, 3, 4]> : tensor<4xi32>,
+    !stream.resource<variable>{%c16} = dense<[1, 2, 3, 4]> : tensor<4xi32>
+    => !stream.timepoint
+
+  // CHECK: %[[ALLOC:.+]] = stream.resource.alloc uninitialized : !stream.resource<variable>{%c32}
+  // CHECK-DAG: %[[RES0:.+]] = stream.resource.subview %[[ALLOC]][%c0] : !stream.resource<variable>{%c32} -> !stream.resource<variable>{%c16}
+  // CHECK-DAG: %[[RES1:.+]] = stream.resource.subview %[[ALLOC]][%c16] : !stream.resource<variable>{%c32} -> !stream.resource<variable>{%c16}
+
+  // CHECK: return %[[RES0]], %[[RES1]]
+  return %0#0, %0#1, %0#2 : !stream.resource<variable>, !stream.resource<variable>, !stream.timepoint
+}
+
+// -----
+
+// Tests that constants are not deduplicated based on their in-memory
+// representation when it differs from their serialized bytes: bit-packed i1
+// elements may match the raw storage of an unrelated i8 constant.
+
+#dedupeResourceConstantsI1Config = #stream.resource_config<{
+  max_allocation_size = 1073741824,
+  min_buffer_offset_alignment = 16,
+  max_buffer_range = 1073741824,
+  min_buffer_range_alignment = 16
+}>
+
+// CHECK-LABEL: @dedupeResourceConstantsI1
+func.func @dedupeResourceConstantsI1() -> (!stream.resource<constant>, !stream.resource<constant>, !stream.timepoint)
+    attributes {stream.resources = #dedupeResourceConstantsI1Config} {
+  %c1 = arith.constant 1 : index
+  %c8 = arith.constant 8 : index
+
+  %0:3 = stream.resource.constants :
+    !stream.resource<constant>{%c8} = dense<[true, false, false, false, false, false, false, false]> : tensor<8xi1>,
+    !stream.resource<constant>{%c1} = dense<1> : tensor<1xi8>
+    => !stream.timepoint
+
+  // CHECK: %[[IF:.+]]:2 = scf.if
+  // CHECK-DAG: %[[RES0:.+]] = stream.resource.subview %[[IF]]#0[%c0] : !stream.resource<constant>{%c32} -> !stream.resource<constant>{%c8}
+  // CHECK-DAG: %[[RES1:.+]] = stream.resource.subview %[[IF]]#0[%c16] : !stream.resource<constant>{%c32} -> !stream.resource<constant>{%c1}
+
+  // CHECK: return %[[RES0]], %[[RES1]], %[[IF]]#1
+  return %0#0, %0#1, %0#2 : !stream.resource<constant>, !stream.resource<constant>, !stream.timepoint
+}
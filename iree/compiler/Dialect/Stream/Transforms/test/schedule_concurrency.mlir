@@ -98,3 +98,44 @@ func.func @partitioningForMaxConcurrency(%arg0: !stream.resource<external>, %arg
   %0 = stream.timepoint.await %result_timepoint => %results : !stream.resource<external>{%c20}
   return %0 : !stream.resource<external>
 }
+
+// -----
+
+// Tests that the cost model overlaps expensive work with other expensive work
+// in the waves it may legally be placed in instead of always placing it in the
+// wave closest to its consumers: @dispatch_0 could run alongside either
+// @dispatch_1 or @dispatch_2 but only @dispatch_1 is expensive.
+
+// CHECK-LABEL: @partitioningForMaxConcurrencyCostModel
+// CHECK-SAME: (%[[ARG0:.+]]: !stream.resource<external>)
+func.func @partitioningForMaxConcurrencyCostModel(%arg0: !stream.resource<external>) -> !stream.resource<external>
+    attributes {stream.partitioning = #stream.partitioning_config<"max-concurrency", "cost-model">} {
+  %c1 = arith.constant 1 : index
+  %c20 = arith.constant 20 : index
+  %c128 = arith.constant 128 : index
+  // CHECK: stream.async.execute
+  %results, %result_timepoint = stream.async.execute
+      with(%arg0 as %arg1: !stream.resource<external>{%c20})
+      -> !stream.resource<external>{%c20} {
+
+    // The expensive dispatch_0 overlaps with the expensive dispatch_1 instead
+    // of the cheap dispatch_2 it would be placed with by the reference
+    // algorithm.
+    // CHECK: %[[CON0:.+]]:2 = stream.async.concurrent
+    // CHECK-DAG: stream.async.dispatch @ex::@dispatch_0[%c128, %c128, %c1]
+    // CHECK-DAG: stream.async.dispatch @ex::@dispatch_1[%c128, %c128, %c1]
+    // CHECK: stream.yield
+
+    // CHECK: %[[DISPATCH2:.+]] = stream.async.dispatch @ex::@dispatch_2[%c1, %c1, %c1]
+    // CHECK: stream.async.dispatch @ex::@dispatch_3[%c1, %c1, %c1]
+    // CHECK-NEXT: stream.yield
+
+    %0 = stream.async.dispatch @ex::@dispatch_0[%c128, %c128, %c1](%arg1) : (!stream.resource<external>{%c20}) -> !stream.resource<transient>{%c20}
+    %1 = stream.async.dispatch @ex::@dispatch_1[%c128, %c128, %c1](%arg1) : (!stream.resource<external>{%c20}) -> !stream.resource<transient>{%c20}
+    %2 = stream.async.dispatch @ex::@dispatch_2[%c1, %c1, %c1](%1) : (!stream.resource<transient>{%c20}) -> !stream.resource<transient>{%c20}
+    %3 = stream.async.dispatch @ex::@dispatch_3[%c1, %c1, %c1](%0, %2) : (!stream.resource<transient>{%c20}, !stream.resource<transient>{%c20}) -> !stream.resource<external>{%c20}
+    stream.yield %3 : !stream.resource<external>{%c20}
+  } => !stream.timepoint
+  %0 = stream.timepoint.await %result_timepoint => %results : !stream.resource<external>{%c20}
+  return %0 : !stream.resource<external>
+}
@@ -211,3 +211,85 @@ func.func @deviceHostDeviceCrossing(%arg0: i1) -> !stream.resource<transient> {
   // CHECK: return
   return %4 : !stream.resource<transient>
 }
+
+// -----
+
+// Tests that ops with different affinities are partitioned into separate
+// execution regions that carry the affinity of their ops.
+
+// CHECK-LABEL: @partitionByAffinity
+func.func @partitionByAffinity(%arg0: !stream.resource<external>) -> (!stream.resource<external>, !stream.resource<external>) {
+  %c1 = arith.constant 1 : index
+  %c20 = arith.constant 20 : index
+  // CHECK: stream.async.execute on(#stream.affinity<device = 0>)
+  // CHECK-NEXT: stream.async.dispatch on(#stream.affinity<device = 0>) @ex::@dispatch_0
+  %0 = stream.async.dispatch on(#stream.affinity<device = 0>) @ex::@dispatch_0[%c1, %c1, %c1](%arg0) : (!stream.resource<external>{%c20}) -> !stream.resource<external>{%c20}
+  // CHECK: stream.async.execute on(#stream.affinity<device = 1>)
+  // CHECK-NEXT: stream.async.dispatch on(#stream.affinity<device = 1>) @ex::@dispatch_1
+  %1 = stream.async.dispatch on(#stream.affinity<device = 1>) @ex::@dispatch_1[%c1, %c1, %c1](%arg0) : (!stream.resource<external>{%c20}) -> !stream.resource<external>{%c20}
+  return %0, %1 : !stream.resource<external>, !stream.resource<external>
+}
+
+// -----
+
+// Tests that the cost model does not move a producer into the consumer
+// partition reading the most from it when that partition runs after another
+// consumer of the producer: @dispatch_y1 reads %x twice but runs after
+// @dispatch_w, which depends on %x through @dispatch_y2.
+
+// CHECK-LABEL: @partitionCostModelDiamondHazard
+func.func @partitionCostModelDiamondHazard(%arg0: !stream.resource<external>) -> !stream.resource<external>
+    attributes {stream.partitioning = #stream.partitioning_config<"max-concurrency", "cost-model">} {
+  %c1 = arith.constant 1 : index
+  %c20 = arith.constant 20 : index
+  // CHECK: stream.async.execute on(#stream.affinity<device = 0>)
+  // CHECK-NEXT: stream.async.dispatch on(#stream.affinity<device = 0>) @ex::@dispatch_x
+  // CHECK-NEXT: stream.async.dispatch on(#stream.affinity<device = 0>) @ex::@dispatch_y2
+  // CHECK: stream.async.execute on(#stream.affinity<device = 1>)
+  // CHECK-NEXT: stream.async.dispatch on(#stream.affinity<device = 1>) @ex::@dispatch_w
+  // CHECK: stream.async.execute on(#stream.affinity<device = 0>)
+  // CHECK-NEXT: stream.async.dispatch on(#stream.affinity<device = 0>) @ex::@dispatch_y1
+  %x = stream.async.dispatch on(#stream.affinity<device = 0>) @ex::@dispatch_x[%c1, %c1, %c1](%arg0) : (!stream.resource<external>{%c20}) -> !stream.resource<transient>{%c20}
+  %y2 = stream.async.dispatch on(#stream.affinity<device = 0>) @ex::@dispatch_y2[%c1, %c1, %c1](%x) : (!stream.resource<transient>{%c20}) -> !stream.resource<transient>{%c20}
+  %w = stream.async.dispatch on(#stream.affinity<device = 1>) @ex::@dispatch_w[%c1, %c1, %c1](%y2) : (!stream.resource<transient>{%c20}) -> !stream.resource<transient>{%c20}
+  %y1 = stream.async.dispatch on(#stream.affinity<device = 0>) @ex::@dispatch_y1[%c1, %c1, %c1](%x, %x, %w) : (!stream.resource<transient>{%c20}, !stream.resource<transient>{%c20}, !stream.resource<transient>{%c20}) -> !stream.resource<external>{%c20}
+  return %y1 : !stream.resource<external>
+}
+
+// -----
+
+// Tests that the cost model does not move a producer into a consumer partition
+// that runs after another of its consumers when the consumers are split by the
+// transient memory budget: @dispatch_a reads %x twice but @dispatch_b, which
+// did not fit in the partition of @dispatch_a, runs before it.
+
+#partitionCostModelBudgetConfig = #stream.resource_config<{
+  max_allocation_size = 100,
+  min_buffer_offset_alignment = 16,
+  max_buffer_range = 100,
+  min_buffer_range_alignment = 16
+}>
+
+// CHECK-LABEL: @partitionCostModelBudgetOrder
+func.func @partitionCostModelBudgetOrder(%arg0: !stream.resource<external>) -> (!stream.resource<external>, !stream.resource<external>, !stream.resource<external>)
+    attributes {
+      stream.partitioning = #stream.partitioning_config<"min-peak-memory", "cost-model">,
+      stream.resources = #partitionCostModelBudgetConfig
+    } {
+  %c1 = arith.constant 1 : index
+  %c4 = arith.constant 4 : index
+  %c44 = arith.constant 44 : index
+  %c50 = arith.constant 50 : index
+  %c60 = arith.constant 60 : index
+  // CHECK: stream.async.execute
+  // CHECK-NEXT: stream.async.dispatch @ex::@dispatch_x
+  // CHECK-NEXT: stream.async.dispatch @ex::@dispatch_b
+  // CHECK-NEXT: stream.async.dispatch @ex::@dispatch_c
+  // CHECK: stream.async.execute
+  // CHECK-NEXT: stream.async.dispatch @ex::@dispatch_a
+  %x = stream.async.dispatch @ex::@dispatch_x[%c1, %c1, %c1](%arg0) : (!stream.resource<external>{%c4}) -> !stream.resource<transient>{%c4}
+  %b = stream.async.dispatch @ex::@dispatch_b[%c1, %c1, %c1](%x) : (!stream.resource<transient>{%c4}) -> !stream.resource<external>{%c44}
+  %c = stream.async.dispatch @ex::@dispatch_c[%c1, %c1, %c1](%arg0) : (!stream.resource<external>{%c4}) -> !stream.resource<external>{%c50}
+  %a = stream.async.dispatch @ex::@dispatch_a[%c1, %c1, %c1](%x, %x) : (!stream.resource<transient>{%c4}, !stream.resource<transient>{%c4}) -> !stream.resource<external>{%c60}
+  return %a, %b, %c : !stream.resource<external>, !stream.resource<external>, !stream.resource<external>
+}
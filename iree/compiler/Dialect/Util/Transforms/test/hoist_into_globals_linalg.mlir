@@ -57,3 +57,36 @@ module @broadcast_treated_as_leaf {
   }
   // CHECK-NOT: util.initializer
 }
+
+// -----
+// Verifies that constant weights packed into a mmt4d data layout (padding,
+// expansion to 4D and transposition) are hoisted as a single leaf so that the
+// packing happens once at compile time.
+// CHECK-LABEL: @mmt4d_packed_weights_hoisted
+#map0 = affine_map<(d0, d1, d2, d3) -> (d1, d3, d0, d2)>
+#map1 = affine_map<(d0, d1, d2, d3) -> (d0, d1, d2, d3)>
+module @mmt4d_packed_weights_hoisted {
+  // CHECK: util.global private @[[HOISTED:.*]] : tensor<2x3x4x2xf32>
+  // CHECK-NOT: util.global
+  // CHECK: func @main
+  func.func @main(%lhs: tensor<1x3x8x2xf32>, %acc: tensor<1x2x8x4xf32>) -> (tensor<1x2x8x4xf32>) {
+    %cst = arith.constant dense<1.270000e+02> : tensor<5x6xf32>
+    %zero = arith.constant 0.000000e+00 : f32
+    %0 = tensor.pad %cst low[0, 0] high[1, 2] {
+    ^bb0(%arg0: index, %arg1: index):
+      tensor.yield %zero : f32
+    } : tensor<5x6xf32> to tensor<6x8xf32>
+    %1 = tensor.expand_shape %0 [[0, 1], [2, 3]] : tensor<6x8xf32> into tensor<3x2x2x4xf32>
+    %2 = linalg.init_tensor [2, 3, 4, 2] : tensor<2x3x4x2xf32>
+    %3 = linalg.generic {indexing_maps = [#map0, #map1], iterator_types = ["parallel", "parallel", "parallel", "parallel"]} ins(%1 : tensor<3x2x2x4xf32>) outs(%2 : tensor<2x3x4x2xf32>) {
+    ^bb0(%arg0: f32, %arg1: f32):  // no predecessors
+      linalg.yield %arg0 : f32
+    } -> tensor<2x3x4x2xf32>
+    // CHECK: %[[RHS:.*]] = util.global.load @[[HOISTED]] : tensor<2x3x4x2xf32>
+    // CHECK: linalg.mmt4d
+    // CHECK-SAME: ins(%{{.*}}, %[[RHS]] :
+    %4 = linalg.mmt4d ins(%lhs, %3 : tensor<1x3x8x2xf32>, tensor<2x3x4x2xf32>) outs(%acc : tensor<1x2x8x4xf32>) -> tensor<1x2x8x4xf32>
+    return %4 : tensor<1x2x8x4xf32>
+  }
+  // CHECK: util.initializer
+}
@@ -92,6 +92,14 @@ void buildIREEVMTransformPassPipeline(
       (IREE::Stream::DumpOutputFormat)schedulingOptions.dumpStatisticsFormat;
   streamOptions.dumpStatisticsFile = schedulingOptions.dumpStatisticsFile;
 
+  // Assign the target devices before Flow so that target-dependent data layout
+  // decisions (such as mmt4d tile sizes) can be made on tensors. The HAL
+  // pipeline will leave these untouched.
+  if (!executableOptions.targets.empty()) {
+    passManager.addPass(
+        IREE::HAL::createAssignTargetDevicesPass(executableOptions.targets));
+  }
+
   IREE::Flow::buildFlowTransformPassPipeline(passManager, flowOptions);
   IREE::Stream::buildStreamTransformPassPipeline(passManager, streamOptions);
   IREE::HAL::buildHALTransformPassPipeline(passManager, executableOptions);
@@ -32,6 +32,30 @@ LogicalResult ParseCustomKernelTargetFeaturesForAarch64(
   return success();
 }
 
+LogicalResult ParseCustomKernelTargetFeaturesForX86_64(
+    const llvm::SmallVector<llvm::StringRef> &features,
+    CustomKernelsTargetInfo &targetInfo) {
+  // Unlike on aarch64, target feature strings on x86_64 routinely list dozens
+  // of features (e.g. when derived from the host CPU) so we only pick the ones
+  // we have kernels for and ignore the rest. Features implied by others are
+  // added too as LLVM would enable them.
+  for (auto f : features) {
+    if (f == "+fma") {
+      targetInfo.add(CustomKernelTargetFeature::X86_64Fma);
+    } else if (f == "+avxvnni") {
+      targetInfo.add(CustomKernelTargetFeature::X86_64AvxVnni);
+    } else if (f == "+avx512f") {
+      targetInfo.add(CustomKernelTargetFeature::X86_64Fma);
+      targetInfo.add(CustomKernelTargetFeature::X86_64Avx512f);
+    } else if (f == "+avx512vnni") {
+      targetInfo.add(CustomKernelTargetFeature::X86_64Fma);
+      targetInfo.add(CustomKernelTargetFeature::X86_64Avx512f);
+      targetInfo.add(CustomKernelTargetFeature::X86_64Avx512Vnni);
+    }
+  }
+  return success();
+}
+
 LogicalResult ParseCustomKernelsTargetInfo(
     llvm::StringRef archStr, llvm::StringRef featuresStr,
     CustomKernelsTargetInfo &targetInfo) {
@@ -50,6 +74,10 @@ LogicalResult ParseCustomKernelsTargetInfo(
     targetInfo.init(CustomKernelTargetArch::Aarch64);
     return ParseCustomKernelTargetFeaturesForAarch64(features, targetInfo);
   }
+  if (archStr == "x86_64") {
+    targetInfo.init(CustomKernelTargetArch::X86_64);
+    return ParseCustomKernelTargetFeaturesForX86_64(features, targetInfo);
+  }
 
   // Currently, on unknown arch, we return success as long as no features
   // were specified (we wouldn't know how to parse features for an unknown arch)
@@ -18,7 +18,7 @@ namespace iree_compiler {
 
 // Enumerates target ISAs that we care about. 'int8_t' because we somewhat
 // care because this is used in struct MMTKernel, which is passed by value.
-enum class CustomKernelTargetArch : int8_t { None, Aarch64 };
+enum class CustomKernelTargetArch : int8_t { None, Aarch64, X86_64 };
 
 // Enumerates arch-specific target features that we care about.
 // We explicitly want to stick to the default enumeration values (0, 1, 2, ...,
@@ -34,6 +34,11 @@ enum class CustomKernelTargetFeature {
   // Aarch64 features.
   Aarch64Dotprod,
   Aarch64I8mm,
+  // X86_64 features.
+  X86_64Fma,
+  X86_64AvxVnni,
+  X86_64Avx512f,
+  X86_64Avx512Vnni,
 };
 
 inline bool isFeatureForArch(CustomKernelTargetFeature feature,
@@ -45,6 +50,11 @@ inline bool isFeatureForArch(CustomKernelTargetFeature feature,
       return arch == CustomKernelTargetArch::Aarch64;
     case CustomKernelTargetFeature::Aarch64I8mm:
       return arch == CustomKernelTargetArch::Aarch64;
+    case CustomKernelTargetFeature::X86_64Fma:
+    case CustomKernelTargetFeature::X86_64AvxVnni:
+    case CustomKernelTargetFeature::X86_64Avx512f:
+    case CustomKernelTargetFeature::X86_64Avx512Vnni:
+      return arch == CustomKernelTargetArch::X86_64;
   }
   assert(false && "Unhandled CustomKernelTargetFeature value");
   return false;
@@ -73,6 +83,9 @@ class CustomKernelsTargetInfo {
     assert(isFeatureForArch(f, arch));
     features |= (1ull << static_cast<int>(f));
   }
+  bool operator==(const CustomKernelsTargetInfo &other) const {
+    return arch == other.arch && features == other.features;
+  }
 
  private:
   CustomKernelTargetArch arch = CustomKernelTargetArch::None;
@@ -0,0 +1,310 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/compiler/Utils/EquivalenceUtils.h"
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/PostOrderIterator.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SetVector.h"
+#include "mlir/IR/BlockAndValueMapping.h"
+#include "mlir/IR/BuiltinAttributes.h"
+#include "mlir/IR/RegionGraphTraits.h"
+#include "mlir/IR/SymbolTable.h"
+
+namespace mlir {
+namespace iree_compiler {
+
+namespace {
+
+template <typename Range, typename Pred>
+bool compare_ranges(Range &&lhs, Range &&rhs, Pred pred) {
+  auto lhsIt = lhs.begin();
+  auto rhsIt = rhs.begin();
+  while (lhsIt != lhs.end() && rhsIt != rhs.end()) {
+    if (!pred(*lhsIt++, *rhsIt++)) return false;
+  }
+  if ((lhsIt == lhs.end()) != (rhsIt == rhs.end())) {
+    // Size mismatch. We do this here so that we avoid the O(n) scan that would
+    // have been required to calculate the size above.
+    return false;
+  }
+  return true;
+}
+
+// Maps symbol names defined within the lhs to those defined within the rhs.
+// Symbol references are only equivalent if they reference corresponding
+// symbols; references to symbols defined outside of the ops being compared
+// must match exactly.
+class SymbolMapping {
+ public:
+  // Populates the mapping with all symbols defined by |lhs| and |rhs| and their
+  // nested ops. Returns false if the symbols don't correspond.
+  bool build(Operation &lhs, Operation &rhs) {
+    SmallVector<StringAttr> lhsNames;
+    SmallVector<StringAttr> rhsNames;
+    collectSymbolNames(lhs, lhsNames);
+    collectSymbolNames(rhs, rhsNames);
+    if (lhsNames.size() != rhsNames.size()) return false;
+    for (auto namePair : llvm::zip(lhsNames, rhsNames)) {
+      auto &mappedName = names[std::get<0>(namePair)];
+      // The same name may be defined in multiple nested symbol tables; we
+      // conservatively require they all map the same way.
+      if (mappedName && mappedName != std::get<1>(namePair)) return false;
+      mappedName = std::get<1>(namePair);
+    }
+    return true;
+  }
+
+  bool isEquivalent(StringAttr lhs, StringAttr rhs) const {
+    auto it = names.find(lhs);
+    return it != names.end() ? it->second == rhs : lhs == rhs;
+  }
+
+  bool isEquivalent(Attribute lhs, Attribute rhs) const {
+    if (auto lhsRef = lhs.dyn_cast<SymbolRefAttr>()) {
+      auto rhsRef = rhs.dyn_cast<SymbolRefAttr>();
+      if (!rhsRef) return false;
+      if (!isEquivalent(lhsRef.getRootReference(),
+                        rhsRef.getRootReference())) {
+        return false;
+      }
+      return compare_ranges(
+          lhsRef.getNestedReferences(), rhsRef.getNestedReferences(),
+          [&](FlatSymbolRefAttr lhs, FlatSymbolRefAttr rhs) {
+            return isEquivalent(lhs.getAttr(), rhs.getAttr());
+          });
+    } else if (auto lhsArray = lhs.dyn_cast<ArrayAttr>()) {
+      auto rhsArray = rhs.dyn_cast<ArrayAttr>();
+      if (!rhsArray) return false;
+      return compare_ranges(
+          lhsArray.getValue(), rhsArray.getValue(),
+          [&](Attribute lhs, Attribute rhs) { return isEquivalent(lhs, rhs); });
+    } else if (auto lhsDict = lhs.dyn_cast<DictionaryAttr>()) {
+      auto rhsDict = rhs.dyn_cast<DictionaryAttr>();
+      if (!rhsDict) return false;
+      return isEquivalent(lhsDict.getValue(), rhsDict.getValue());
+    }
+    return lhs == rhs;
+  }
+
+  bool isEquivalent(ArrayRef<NamedAttribute> lhs,
+                    ArrayRef<NamedAttribute> rhs) const {
+    return compare_ranges(
+        lhs, rhs, [&](const NamedAttribute &lhs, const NamedAttribute &rhs) {
+          if (lhs.getName() != rhs.getName()) return false;
+          if (lhs.getName() == SymbolTable::getSymbolAttrName()) {
+            auto lhsName = lhs.getValue().dyn_cast<StringAttr>();
+            auto rhsName = rhs.getValue().dyn_cast<StringAttr>();
+            if (lhsName && rhsName) return isEquivalent(lhsName, rhsName);
+          }
+          return isEquivalent(lhs.getValue(), rhs.getValue());
+        });
+  }
+
+ private:
+  static void collectSymbolNames(Operation &rootOp,
+                                 SmallVectorImpl<StringAttr> &names) {
+    rootOp.walk<WalkOrder::PreOrder>([&](Operation *op) {
+      if (auto nameAttr = op->getAttrOfType<StringAttr>(
+              SymbolTable::getSymbolAttrName())) {
+        names.push_back(nameAttr);
+      }
+    });
+  }
+
+  DenseMap<StringAttr, StringAttr> names;
+};
+
+static bool isStructurallyEquivalentTo(Region &lhs, Region &rhs,
+                                       BlockAndValueMapping &mapping,
+                                       const SymbolMapping &symbols);
+static bool isStructurallyEquivalentTo(Operation &lhs, Operation &rhs,
+                                       BlockAndValueMapping &parentMapping,
+                                       const SymbolMapping &symbols);
+
+// Recursively compares two regions for structural equivalence.
+// Structural equivalence ensures that operations on both the |lhs| and |rhs|
+// have the same attributes and same use-def structure.
+static bool isStructurallyEquivalentTo(Region &lhs, Region &rhs,
+                                       BlockAndValueMapping &mapping,
+                                       const SymbolMapping &symbols) {
+  // Use compare_ranges to walk the block list in parallel and get a boolean in
+  // the case of size mismatch without an O(N) linked-list size query.
+  if (!compare_ranges(
+          lhs.getBlocks(), rhs.getBlocks(),
+          [&](Block &lhsBlock, Block &rhsBlock) {
+            if (lhsBlock.getNumArguments() != rhsBlock.getNumArguments()) {
+              return false;
+            }
+            for (auto argPair :
+                 llvm::zip(lhsBlock.getArguments(), rhsBlock.getArguments())) {
+              auto &lhsArg = std::get<0>(argPair);
+              auto &rhsArg = std::get<1>(argPair);
+              if (lhsArg.getType() != rhsArg.getType()) return false;
+              mapping.map(lhsArg, rhsArg);
+            }
+            mapping.map(&lhsBlock, &rhsBlock);
+            return true;
+          })) {
+    return false;  // block mismatch
+  }
+
+  // Walk the blocks again now that we have a populated mapping.
+  // We do this in topological order so that we have all values required by a
+  // block mapped by the time we reach it observing transitive block dominance.
+  llvm::SetVector<Block *> lhsBlocks;
+  for (Block &b : lhs.getBlocks()) {
+    llvm::ReversePostOrderTraversal<Block *> traversal(&b);
+    lhsBlocks.insert(traversal.begin(), traversal.end());
+  }
+  llvm::SetVector<Block *> rhsBlocks;
+  for (Block &b : rhs.getBlocks()) {
+    llvm::ReversePostOrderTraversal<Block *> traversal(&b);
+    rhsBlocks.insert(traversal.begin(), traversal.end());
+  }
+  if (lhsBlocks.size() != rhsBlocks.size()) return false;
+  for (auto blockPair : llvm::zip(lhsBlocks, rhsBlocks)) {
+    auto &lhsBlock = std::get<0>(blockPair);
+    auto &rhsBlock = std::get<1>(blockPair);
+    if (rhsBlock != mapping.lookup(lhsBlock)) return false;
+    if (!compare_ranges(lhsBlock->getOperations(), rhsBlock->getOperations(),
+                        [&](Operation &lhsOp, Operation &rhsOp) {
+                          return isStructurallyEquivalentTo(lhsOp, rhsOp,
+                                                            mapping, symbols);
+                        })) {
+      return false;
+    }
+  }
+
+  // Equivalent!
+  return true;
+}
+
+static bool isStructurallyEquivalentTo(Operation &lhs, Operation &rhs,
+                                       BlockAndValueMapping &parentMapping,
+                                       const SymbolMapping &symbols) {
+  // Check operation metadata for early-exit opportunities.
+  if (lhs.getName() != rhs.getName()) return false;
+  if (lhs.getNumOperands() != rhs.getNumOperands()) return false;
+  if (lhs.getNumResults() != rhs.getNumResults()) return false;
+  if (lhs.getNumRegions() != rhs.getNumRegions()) return false;
+  if (lhs.getNumSuccessors() != rhs.getNumSuccessors()) return false;
+
+  // Attributes must match exactly except for symbol names and references,
+  // which must correspond according to the symbol mapping.
+  if (!symbols.isEquivalent(lhs.getAttrs(), rhs.getAttrs())) return false;
+
+  // If the op references blocks (such as a branch) then we expect to have them
+  // in the mapping already from the parent region to do the lhs->rhs mapping.
+  for (auto successorPair :
+       llvm::zip(lhs.getSuccessors(), rhs.getSuccessors())) {
+    auto *lhsSuccessor = std::get<0>(successorPair);
+    auto *rhsSuccessor = std::get<1>(successorPair);
+    if (rhsSuccessor != parentMapping.lookup(lhsSuccessor)) return false;
+  }
+
+  // Ensure result types match first and add to the block and value mapping.
+  // For many ops if the result types don't match it's a good (cheap) indicator
+  // that the operands won't match either so this still allows a somewhat-early
+  // exit prior to the full traversal.
+  for (auto resultPair : llvm::zip(lhs.getResults(), rhs.getResults())) {
+    auto &lhsValue = std::get<0>(resultPair);
+    auto &rhsValue = std::get<1>(resultPair);
+    if (lhsValue.getType() != rhsValue.getType()) return false;
+    parentMapping.map(lhsValue, rhsValue);
+  }
+
+  // Check operands using the lhs->rhs mapping; since this op is only consuming
+  // these values they should already be defined in the mapping.
+  for (auto operandPair : llvm::zip(lhs.getOperands(), rhs.getOperands())) {
+    auto &lhsValue = std::get<0>(operandPair);
+    auto &rhsValue = std::get<1>(operandPair);
+    if (lhsValue.getType() != rhsValue.getType()) return false;
+    if (rhsValue != parentMapping.lookup(lhsValue)) return false;
+  }
+
+  // Recurse into regions.
+  for (auto regionPair : llvm::zip(lhs.getRegions(), rhs.getRegions())) {
+    auto &lhsRegion = std::get<0>(regionPair);
+    auto &rhsRegion = std::get<1>(regionPair);
+
+    // If the region is isolated we don't want to reuse any parent mapping or
+    // pollute it with our mappings.
+    BlockAndValueMapping scopedRegionMapping;
+    BlockAndValueMapping regionMapping =
+        lhs.hasTrait<OpTrait::IsIsolatedFromAbove>() ? scopedRegionMapping
+                                                     : parentMapping;
+
+    if (!isStructurallyEquivalentTo(lhsRegion, rhsRegion, regionMapping,
+                                    symbols)) {
+      return false;
+    }
+  }
+
+  // Equivalent!
+  return true;
+}
+
+// Hashes |attr| ignoring the names of any symbols it references.
+static llvm::hash_code computeAttributeHash(Attribute attr) {
+  if (auto refAttr = attr.dyn_cast<SymbolRefAttr>()) {
+    return llvm::hash_value(refAttr.getNestedReferences().size());
+  } else if (auto arrayAttr = attr.dyn_cast<ArrayAttr>()) {
+    llvm::hash_code hash = llvm::hash_value(arrayAttr.size());
+    for (auto elementAttr : arrayAttr) {
+      hash = llvm::hash_combine(hash, computeAttributeHash(elementAttr));
+    }
+    return hash;
+  } else if (auto dictAttr = attr.dyn_cast<DictionaryAttr>()) {
+    llvm::hash_code hash = llvm::hash_value(dictAttr.size());
+    for (auto namedAttr : dictAttr) {
+      hash = llvm::hash_combine(hash, namedAttr.getName(),
+                                computeAttributeHash(namedAttr.getValue()));
+    }
+    return hash;
+  }
+  return hash_value(attr);
+}
+
+}  // namespace
+
+bool isStructurallyEquivalentTo(Operation &lhs, Operation &rhs) {
+  SymbolMapping symbols;
+  if (!symbols.build(lhs, rhs)) return false;
+  BlockAndValueMapping mapping;
+  return isStructurallyEquivalentTo(lhs, rhs, mapping, symbols);
+}
+
+llvm::hash_code computeStructuralHash(Operation &rootOp) {
+  llvm::hash_code hash = llvm::hash_value(0);
+  rootOp.walk<WalkOrder::PreOrder>([&](Operation *op) {
+    hash = llvm::hash_combine(hash, op->getName().getStringRef(),
+                              op->getNumOperands(), op->getNumRegions(),
+                              op->getNumSuccessors());
+    for (auto namedAttr : op->getAttrs()) {
+      hash = llvm::hash_combine(hash, namedAttr.getName());
+      if (namedAttr.getName() == SymbolTable::getSymbolAttrName()) continue;
+      hash = llvm::hash_combine(hash,
+                                computeAttributeHash(namedAttr.getValue()));
+    }
+    for (auto type : op->getResultTypes()) {
+      hash = llvm::hash_combine(hash, type);
+    }
+    for (auto &region : op->getRegions()) {
+      for (auto &block : region) {
+        hash = llvm::hash_combine(hash, block.getNumArguments());
+        for (auto type : block.getArgumentTypes()) {
+          hash = llvm::hash_combine(hash, type);
+        }
+      }
+    }
+  });
+  return hash;
+}
+
+}  // namespace iree_compiler
+}  // namespace mlir
@@ -0,0 +1,62 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_COMPILER_UTILS_EQUIVALENCEUTILS_H_
+#define IREE_COMPILER_UTILS_EQUIVALENCEUTILS_H_
+
+#include "llvm/ADT/Hashing.h"
+#include "mlir/IR/Operation.h"
+#include "mlir/Support/LLVM.h"
+
+namespace mlir {
+namespace iree_compiler {
+
+// Returns true if |lhs| and |rhs| (and all nested ops) are structurally
+// equivalent: they have the same ops with the same attributes, types, and
+// use-def structure.
+//
+// Symbols defined by |lhs|/|rhs| or any op nested within them may have
+// different names so long as they are defined in the same order and all
+// references to them are consistent. This allows for example two executables
+// that differ only in their own name, their entry point names, and the names
+// of their internal functions to be considered equivalent.
+//
+// Example:
+//   flow.executable @lhs {
+//     flow.dispatch.entry @lhs_entry
+//     builtin.module {
+//       func.func @lhs_entry(%arg0 : index) -> index {
+//         %0 = call @lhs_helper(%arg0) : (index) -> index
+//         return %0 : index
+//       }
+//       func.func private @lhs_helper(%arg0 : index) -> index { ... }
+//     }
+//   }
+//   flow.executable @rhs {
+//     flow.dispatch.entry @rhs_entry
+//     builtin.module {
+//       func.func @rhs_entry(%arg0 : index) -> index {
+//         %0 = call @rhs_helper(%arg0) : (index) -> index
+//         return %0 : index
+//       }
+//       func.func private @rhs_helper(%arg0 : index) -> index { ... }
+//     }
+//   }
+//
+//   assert(isStructurallyEquivalentTo(*lhs, *rhs));
+bool isStructurallyEquivalentTo(Operation &lhs, Operation &rhs);
+
+// Returns a hash of the structure of |op| and all nested ops that is consistent
+// with isStructurallyEquivalentTo: equivalent ops always have the same hash.
+// Symbol names and SSA value identities do not contribute to the hash. This
+// is intended to bucket ops such that only those with matching hashes need to
+// be compared.
+llvm::hash_code computeStructuralHash(Operation &op);
+
+}  // namespace iree_compiler
+}  // namespace mlir
+
+#endif  // IREE_COMPILER_UTILS_EQUIVALENCEUTILS_H_
@@ -422,6 +422,54 @@ TEST_P(command_buffer_test, FillBuffer_pattern4_size16_offset0_length8) {
   EXPECT_THAT(actual_buffer, ContainerEq(reference_buffer));
 }
 
+// Reusable (non-one-shot) command buffers, such as those the compiler memoizes
+// at initialization time, must execute their commands again on every
+// submission against the current contents of the buffers they reference.
+TEST_P(command_buffer_test, SubmitReusableCommandBufferMultipleTimes) {
+  iree_hal_buffer_t* source_buffer = NULL;
+  CreateZeroedDeviceBuffer(kDefaultAllocationSize, &source_buffer);
+  iree_hal_buffer_t* target_buffer = NULL;
+  CreateZeroedDeviceBuffer(kDefaultAllocationSize, &target_buffer);
+
+  iree_hal_command_buffer_t* command_buffer = NULL;
+  IREE_ASSERT_OK(iree_hal_command_buffer_create(
+      device_, /*mode=*/0,
+      IREE_HAL_COMMAND_CATEGORY_TRANSFER, IREE_HAL_QUEUE_AFFINITY_ANY,
+      &command_buffer));
+  IREE_ASSERT_OK(iree_hal_command_buffer_begin(command_buffer));
+  IREE_ASSERT_OK(iree_hal_command_buffer_copy_buffer(
+      command_buffer, source_buffer, /*source_offset=*/0, target_buffer,
+      /*target_offset=*/0, /*length=*/kDefaultAllocationSize));
+  IREE_ASSERT_OK(iree_hal_command_buffer_end(command_buffer));
+
+  for (uint8_t i = 1; i <= 3; ++i) {
+    // Change the source and clear the target so that each submission has to
+    // perform the copy again.
+    std::vector<uint8_t> reference_buffer(kDefaultAllocationSize, i);
+    IREE_ASSERT_OK(iree_hal_device_transfer_h2d(
+        device_, reference_buffer.data(), source_buffer, /*target_offset=*/0,
+        kDefaultAllocationSize, IREE_HAL_TRANSFER_BUFFER_FLAG_DEFAULT,
+        iree_infinite_timeout()));
+    IREE_ASSERT_OK(
+        iree_hal_buffer_map_zero(target_buffer, 0, IREE_WHOLE_BUFFER));
+
+    IREE_ASSERT_OK(SubmitCommandBufferAndWait(
+        IREE_HAL_COMMAND_CATEGORY_TRANSFER, command_buffer));
+
+    std::vector<uint8_t> actual_data(kDefaultAllocationSize);
+    IREE_ASSERT_OK(iree_hal_device_transfer_d2h(
+        device_, target_buffer, /*source_offset=*/0, actual_data.data(),
+        actual_data.size(), IREE_HAL_TRANSFER_BUFFER_FLAG_DEFAULT,
+        iree_infinite_timeout()));
+    EXPECT_THAT(actual_data, ContainerEq(reference_buffer))
+        << "submission " << (int)i;
+  }
+
+  iree_hal_command_buffer_release(command_buffer);
+  iree_hal_buffer_release(target_buffer);
+  iree_hal_buffer_release(source_buffer);
+}
+
 TEST_P(command_buffer_test, UpdateBufferWholeBuffer) {
   iree_device_size_t target_buffer_size = 16;
   std::vector<uint8_t> source_buffer{0x01, 0x02, 0x03, 0x04,  //
@@ -12,16 +12,111 @@
 // iree_hal_processor_*_t
 //===----------------------------------------------------------------------===//
 
+#if defined(IREE_ARCH_X86_64)
+
+#if defined(IREE_COMPILER_MSVC)
+#include <immintrin.h>
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif  // IREE_COMPILER_MSVC
+
+static void iree_hal_processor_cpuid(uint32_t leaf, uint32_t subleaf,
+                                     uint32_t out_regs[4]) {
+#if defined(IREE_COMPILER_MSVC)
+  __cpuidex((int*)out_regs, (int)leaf, (int)subleaf);
+#else
+  __cpuid_count(leaf, subleaf, out_regs[0], out_regs[1], out_regs[2],
+                out_regs[3]);
+#endif  // IREE_COMPILER_MSVC
+}
+
+// Returns the XCR0 register indicating which register state the OS saves.
+static uint64_t iree_hal_processor_xgetbv(void) {
+#if defined(IREE_COMPILER_MSVC)
+  return _xgetbv(0);
+#else
+  uint32_t eax = 0, edx = 0;
+  __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+  return ((uint64_t)edx << 32) | eax;
+#endif  // IREE_COMPILER_MSVC
+}
+
+static uint64_t iree_hal_processor_query_data0(void) {
+  uint64_t data0 = 0;
+  uint32_t regs[4] = {0};  // eax, ebx, ecx, edx
+  iree_hal_processor_cpuid(0, 0, regs);
+  const uint32_t max_leaf = regs[0];
+  if (max_leaf < 1) return data0;
+
+  iree_hal_processor_cpuid(1, 0, regs);
+  const uint32_t leaf1_ecx = regs[2];
+  if (leaf1_ecx & (1u << 20)) data0 |= IREE_HAL_PROCESSOR_DATA0_X86_64_SSE4_2;
+
+  // AVX requires the OS to save the YMM state (XCR0 bits 1 and 2) and AVX-512
+  // additionally requires the opmask and ZMM state (XCR0 bits 5, 6, and 7).
+  const bool has_osxsave = (leaf1_ecx & (1u << 27)) != 0;
+  const uint64_t xcr0 = has_osxsave ? iree_hal_processor_xgetbv() : 0;
+  const bool has_ymm_state = (xcr0 & 0x06) == 0x06;
+  const bool has_zmm_state = has_ymm_state && (xcr0 & 0xE0) == 0xE0;
+  if (!has_ymm_state) return data0;
+
+  if (leaf1_ecx & (1u << 28)) data0 |= IREE_HAL_PROCESSOR_DATA0_X86_64_AVX;
+  if (leaf1_ecx & (1u << 12)) data0 |= IREE_HAL_PROCESSOR_DATA0_X86_64_FMA;
+  if (leaf1_ecx & (1u << 29)) data0 |= IREE_HAL_PROCESSOR_DATA0_X86_64_F16C;
+  if (max_leaf < 7) return data0;
+
+  iree_hal_processor_cpuid(7, 0, regs);
+  const uint32_t leaf7_ebx = regs[1];
+  const uint32_t leaf7_ecx = regs[2];
+  if (leaf7_ebx & (1u << 5)) data0 |= IREE_HAL_PROCESSOR_DATA0_X86_64_AVX2;
+  if (!has_zmm_state) return data0;
+  if (leaf7_ebx & (1u << 16)) data0 |= IREE_HAL_PROCESSOR_DATA0_X86_64_AVX512F;
+  if (leaf7_ebx & (1u << 28)) data0 |= IREE_HAL_PROCESSOR_DATA0_X86_64_AVX512CD;
+  if (leaf7_ebx & (1u << 30)) data0 |= IREE_HAL_PROCESSOR_DATA0_X86_64_AVX512BW;
+  if (leaf7_ebx & (1u << 17)) data0 |= IREE_HAL_PROCESSOR_DATA0_X86_64_AVX512DQ;
+  if (leaf7_ebx & (1u << 31)) data0 |= IREE_HAL_PROCESSOR_DATA0_X86_64_AVX512VL;
+  if (leaf7_ecx & (1u << 11)) {
+    data0 |= IREE_HAL_PROCESSOR_DATA0_X86_64_AVX512VNNI;
+  }
+  return data0;
+}
+
+#elif defined(IREE_ARCH_ARM_64) && \
+    (defined(IREE_PLATFORM_ANDROID) || defined(IREE_PLATFORM_LINUX))
+
+#include <sys/auxv.h>
+
+// From the kernel uapi asm/hwcap.h; defined here as older headers lack them.
+#define IREE_HWCAP_ASIMDHP (1ul << 10)
+#define IREE_HWCAP_ASIMDDP (1ul << 20)
+#define IREE_HWCAP2_I8MM (1ul << 13)
+
+static uint64_t iree_hal_processor_query_data0(void) {
+  uint64_t data0 = 0;
+  const unsigned long hwcap = getauxval(AT_HWCAP);
+  const unsigned long hwcap2 = getauxval(AT_HWCAP2);
+  if (hwcap & IREE_HWCAP_ASIMDHP) data0 |= IREE_HAL_PROCESSOR_DATA0_ARM_64_FP16;
+  if (hwcap & IREE_HWCAP_ASIMDDP) {
+    data0 |= IREE_HAL_PROCESSOR_DATA0_ARM_64_DOTPROD;
+  }
+  if (hwcap2 & IREE_HWCAP2_I8MM) data0 |= IREE_HAL_PROCESSOR_DATA0_ARM_64_I8MM;
+  return data0;
+}
+
+#else
+
+// No implementation; executables will use their baseline variants.
+static uint64_t iree_hal_processor_query_data0(void) { return 0; }
+
+#endif  // IREE_ARCH_*
+
 void iree_hal_processor_query(iree_allocator_t temp_allocator,
                               iree_hal_processor_v0_t* out_processor) {
   IREE_ASSERT_ARGUMENT(out_processor);
   IREE_TRACE_ZONE_BEGIN(z0);
   memset(out_processor, 0, sizeof(*out_processor));
-
-  // TODO(benvanik): define processor features we want to query for each arch.
-  // This needs to be baked into the executable library API and made consistent
-  // with the compiler side producing the executables that access it.
-
+  out_processor->data[0] = iree_hal_processor_query_data0();
   IREE_TRACE_ZONE_END(z0);
 }
 
@@ -0,0 +1,144 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/local/executable_environment.h"
+
+#include "iree/base/api.h"
+#include "iree/testing/gtest.h"
+
+#if defined(IREE_ARCH_X86_64) && !defined(IREE_COMPILER_MSVC)
+#include <cpuid.h>
+#elif defined(IREE_ARCH_ARM_64) && \
+    (defined(IREE_PLATFORM_ANDROID) || defined(IREE_PLATFORM_LINUX))
+#include <sys/auxv.h>
+#endif  // IREE_ARCH_*
+
+namespace {
+
+static iree_hal_processor_v0_t QueryProcessor() {
+  iree_hal_processor_v0_t processor;
+  iree_hal_processor_query(iree_allocator_system(), &processor);
+  return processor;
+}
+
+// All bits outside of those defined for the architecture must be zero so that
+// executables compiled against a future bit never select a variant by accident.
+TEST(ProcessorQueryTest, OnlyDefinedBits) {
+  iree_hal_processor_v0_t processor = QueryProcessor();
+#if defined(IREE_ARCH_X86_64)
+  const uint64_t defined_bits =
+      (IREE_HAL_PROCESSOR_DATA0_X86_64_AVX512VNNI << 1) - 1;
+#elif defined(IREE_ARCH_ARM_64)
+  const uint64_t defined_bits = (IREE_HAL_PROCESSOR_DATA0_ARM_64_I8MM << 1) - 1;
+#else
+  const uint64_t defined_bits = 0;
+#endif  // IREE_ARCH_*
+  EXPECT_EQ(0u, processor.data[0] & ~defined_bits);
+  for (size_t i = 1; i < IREE_ARRAYSIZE(processor.data); ++i) {
+    EXPECT_EQ(0u, processor.data[i]);
+  }
+}
+
+#if defined(IREE_ARCH_X86_64) && !defined(IREE_COMPILER_MSVC)
+
+enum CPUIDRegister { EBX = 1, ECX = 2, EDX = 3 };
+
+struct CPUIDFeature {
+  uint64_t processor_bit;
+  uint32_t leaf;
+  CPUIDRegister reg;
+  uint32_t cpuid_bit;
+};
+
+static bool HasCPUIDFeature(const CPUIDFeature& feature) {
+  uint32_t regs[4] = {0};
+  if (!__get_cpuid_count(feature.leaf, 0, &regs[0], &regs[1], &regs[2],
+                         &regs[3])) {
+    return false;
+  }
+  return (regs[feature.reg] & (1u << feature.cpuid_bit)) != 0;
+}
+
+// Each reported bit must be backed by the matching CPUID feature flag.
+TEST(ProcessorQueryTest, BitsMatchCPUID) {
+  static const CPUIDFeature kFeatures[] = {
+      {IREE_HAL_PROCESSOR_DATA0_X86_64_SSE4_2, 1, ECX, 20},
+      {IREE_HAL_PROCESSOR_DATA0_X86_64_AVX, 1, ECX, 28},
+      {IREE_HAL_PROCESSOR_DATA0_X86_64_AVX2, 7, EBX, 5},
+      {IREE_HAL_PROCESSOR_DATA0_X86_64_FMA, 1, ECX, 12},
+      {IREE_HAL_PROCESSOR_DATA0_X86_64_F16C, 1, ECX, 29},
+      {IREE_HAL_PROCESSOR_DATA0_X86_64_AVX512F, 7, EBX, 16},
+      {IREE_HAL_PROCESSOR_DATA0_X86_64_AVX512CD, 7, EBX, 28},
+      {IREE_HAL_PROCESSOR_DATA0_X86_64_AVX512BW, 7, EBX, 30},
+      {IREE_HAL_PROCESSOR_DATA0_X86_64_AVX512DQ, 7, EBX, 17},
+      {IREE_HAL_PROCESSOR_DATA0_X86_64_AVX512VL, 7, EBX, 31},
+      {IREE_HAL_PROCESSOR_DATA0_X86_64_AVX512VNNI, 7, ECX, 11},
+  };
+  iree_hal_processor_v0_t processor = QueryProcessor();
+  for (const auto& feature : kFeatures) {
+    if (processor.data[0] & feature.processor_bit) {
+      EXPECT_TRUE(HasCPUIDFeature(feature))
+          << "processor bit " << feature.processor_bit
+          << " reported without CPUID leaf " << feature.leaf << " bit "
+          << feature.cpuid_bit;
+    }
+  }
+}
+
+// AVX and AVX-512 bits must only be reported when the OS saves the extended
+// register state, which the compiler runtime checks independently.
+TEST(ProcessorQueryTest, VectorBitsRequireOSSupport) {
+  __builtin_cpu_init();
+  iree_hal_processor_v0_t processor = QueryProcessor();
+  const uint64_t avx_bits = IREE_HAL_PROCESSOR_DATA0_X86_64_AVX |
+                            IREE_HAL_PROCESSOR_DATA0_X86_64_AVX2 |
+                            IREE_HAL_PROCESSOR_DATA0_X86_64_FMA |
+                            IREE_HAL_PROCESSOR_DATA0_X86_64_F16C;
+  const uint64_t avx512_bits = IREE_HAL_PROCESSOR_DATA0_X86_64_AVX512F |
+                               IREE_HAL_PROCESSOR_DATA0_X86_64_AVX512CD |
+                               IREE_HAL_PROCESSOR_DATA0_X86_64_AVX512BW |
+                               IREE_HAL_PROCESSOR_DATA0_X86_64_AVX512DQ |
+                               IREE_HAL_PROCESSOR_DATA0_X86_64_AVX512VL |
+                               IREE_HAL_PROCESSOR_DATA0_X86_64_AVX512VNNI;
+  if (processor.data[0] & (avx_bits | avx512_bits)) {
+    EXPECT_TRUE(__builtin_cpu_supports("avx"));
+  }
+  if (processor.data[0] & avx512_bits) {
+    EXPECT_TRUE(__builtin_cpu_supports("avx512f"));
+  }
+}
+
+#elif defined(IREE_ARCH_ARM_64) && \
+    (defined(IREE_PLATFORM_ANDROID) || defined(IREE_PLATFORM_LINUX))
+
+// Each reported bit must be backed by the matching HWCAP/HWCAP2 flag.
+TEST(ProcessorQueryTest, BitsMatchHWCAP) {
+  const unsigned long hwcap = getauxval(AT_HWCAP);
+  const unsigned long hwcap2 = getauxval(AT_HWCAP2);
+  iree_hal_processor_v0_t processor = QueryProcessor();
+  if (processor.data[0] & IREE_HAL_PROCESSOR_DATA0_ARM_64_FP16) {
+    EXPECT_NE(0u, hwcap & (1ul << 10));  // HWCAP_ASIMDHP
+  }
+  if (processor.data[0] & IREE_HAL_PROCESSOR_DATA0_ARM_64_DOTPROD) {
+    EXPECT_NE(0u, hwcap & (1ul << 20));  // HWCAP_ASIMDDP
+  }
+  if (processor.data[0] & IREE_HAL_PROCESSOR_DATA0_ARM_64_I8MM) {
+    EXPECT_NE(0u, hwcap2 & (1ul << 13));  // HWCAP2_I8MM
+  }
+}
+
+#endif  // IREE_ARCH_*
+
+// The environment must carry the same processor information as a direct query.
+TEST(ExecutableEnvironmentTest, InitializeQueriesProcessor) {
+  iree_hal_executable_environment_v0_t environment;
+  iree_hal_executable_environment_initialize(iree_allocator_system(),
+                                             &environment);
+  iree_hal_processor_v0_t processor = QueryProcessor();
+  EXPECT_EQ(processor.data[0], environment.processor.data[0]);
+}
+
+}  // namespace
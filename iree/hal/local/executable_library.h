@@ -234,6 +234,34 @@ typedef struct iree_hal_processor_v0_t {
 static_assert(sizeof(iree_hal_processor_v0_t) % sizeof(uint64_t) == 0,
               "8-byte alignment required");
 
+// Feature bits stored in iree_hal_processor_v0_t::data[0].
+// Only the bits for the architecture the executable was compiled for are ever
+// checked and a bit is only set when the feature is both supported by the
+// processor and enabled by the operating system (such as the extended register
+// state required for AVX and AVX-512 on x86-64).
+//
+// Compiled executables may export multiple variants of their dispatch
+// functions specialized for different feature levels and select the most
+// specialized one supported from their library query function.
+
+// x86-64:
+#define IREE_HAL_PROCESSOR_DATA0_X86_64_SSE4_2 (1ull << 0)
+#define IREE_HAL_PROCESSOR_DATA0_X86_64_AVX (1ull << 1)
+#define IREE_HAL_PROCESSOR_DATA0_X86_64_AVX2 (1ull << 2)
+#define IREE_HAL_PROCESSOR_DATA0_X86_64_FMA (1ull << 3)
+#define IREE_HAL_PROCESSOR_DATA0_X86_64_F16C (1ull << 4)
+#define IREE_HAL_PROCESSOR_DATA0_X86_64_AVX512F (1ull << 5)
+#define IREE_HAL_PROCESSOR_DATA0_X86_64_AVX512CD (1ull << 6)
+#define IREE_HAL_PROCESSOR_DATA0_X86_64_AVX512BW (1ull << 7)
+#define IREE_HAL_PROCESSOR_DATA0_X86_64_AVX512DQ (1ull << 8)
+#define IREE_HAL_PROCESSOR_DATA0_X86_64_AVX512VL (1ull << 9)
+#define IREE_HAL_PROCESSOR_DATA0_X86_64_AVX512VNNI (1ull << 10)
+
+// aarch64:
+#define IREE_HAL_PROCESSOR_DATA0_ARM_64_FP16 (1ull << 0)
+#define IREE_HAL_PROCESSOR_DATA0_ARM_64_DOTPROD (1ull << 1)
+#define IREE_HAL_PROCESSOR_DATA0_ARM_64_I8MM (1ull << 2)
+
 // Defines the environment in which the executable is being used.
 // Executables only have access to the information in this structure and must
 // make all decisions based on it; this ensures executables are portable across
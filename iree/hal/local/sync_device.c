@@ -10,6 +10,7 @@
 #include <stdint.h>
 #include <string.h>
 
+#include "iree/base/internal/arena.h"
 #include "iree/base/tracing.h"
 #include "iree/hal/local/inline_command_buffer.h"
 #include "iree/hal/local/local_descriptor_set.h"
@@ -19,6 +20,7 @@
 #include "iree/hal/local/sync_event.h"
 #include "iree/hal/local/sync_semaphore.h"
 #include "iree/hal/utils/buffer_transfer.h"
+#include "iree/hal/utils/deferred_command_buffer.h"
 
 typedef struct iree_hal_sync_device_t {
   iree_hal_resource_t resource;
@@ -27,6 +29,9 @@ typedef struct iree_hal_sync_device_t {
   iree_allocator_t host_allocator;
   iree_hal_allocator_t* device_allocator;
 
+  // Block pool used for recording reusable command buffers.
+  iree_arena_block_pool_t block_pool;
+
   iree_hal_sync_semaphore_state_t semaphore_state;
 
   iree_host_size_t loader_count;
@@ -81,6 +86,8 @@ iree_status_t iree_hal_sync_device_create(
     device->host_allocator = host_allocator;
     device->device_allocator = device_allocator;
     iree_hal_allocator_retain(device_allocator);
+    iree_arena_block_pool_initialize(32 * 1024, host_allocator,
+                                     &device->block_pool);
 
     device->loader_count = loader_count;
     for (iree_host_size_t i = 0; i < device->loader_count; ++i) {
@@ -111,6 +118,7 @@ static void iree_hal_sync_device_destroy(iree_hal_device_t* base_device) {
     iree_hal_executable_loader_release(device->loaders[i]);
   }
   iree_hal_allocator_release(device->device_allocator);
+  iree_arena_block_pool_deinitialize(&device->block_pool);
   iree_allocator_free(host_allocator, device);
 
   IREE_TRACE_ZONE_END(z0);
@@ -136,6 +144,7 @@ static iree_hal_allocator_t* iree_hal_sync_device_allocator(
 
 static iree_status_t iree_hal_sync_device_trim(iree_hal_device_t* base_device) {
   iree_hal_sync_device_t* device = iree_hal_sync_device_cast(base_device);
+  iree_arena_block_pool_trim(&device->block_pool);
   return iree_hal_allocator_trim(device->device_allocator);
 }
 
@@ -166,10 +175,17 @@ static iree_status_t iree_hal_sync_device_create_command_buffer(
     iree_hal_command_category_t command_categories,
     iree_hal_queue_affinity_t queue_affinity,
     iree_hal_command_buffer_t** out_command_buffer) {
-  // TODO(#4680): implement a non-inline command buffer that stores its commands
-  // and can be submitted later on/multiple-times.
-  return iree_hal_inline_command_buffer_create(
-      base_device, mode, command_categories, queue_affinity,
+  iree_hal_sync_device_t* device = iree_hal_sync_device_cast(base_device);
+  if (iree_all_bits_set(mode, IREE_HAL_COMMAND_BUFFER_MODE_ONE_SHOT)) {
+    // One-shot command buffers execute inline as they are recorded.
+    return iree_hal_inline_command_buffer_create(
+        base_device, mode, command_categories, queue_affinity,
+        iree_hal_device_host_allocator(base_device), out_command_buffer);
+  }
+  // Reusable command buffers store their commands and replay them inline on
+  // each submission.
+  return iree_hal_deferred_command_buffer_create(
+      base_device, mode, command_categories, &device->block_pool,
       iree_hal_device_host_allocator(base_device), out_command_buffer);
 }
 
@@ -227,6 +243,24 @@ static iree_status_t iree_hal_sync_device_create_semaphore(
                                         device->host_allocator, out_semaphore);
 }
 
+// Replays a reusable |command_buffer| by applying it to a transient inline
+// command buffer that executes the commands as they are applied.
+static iree_status_t iree_hal_sync_device_replay_command_buffer(
+    iree_hal_sync_device_t* device, iree_hal_command_buffer_t* command_buffer) {
+  iree_hal_command_buffer_t* inline_command_buffer = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_inline_command_buffer_create(
+      (iree_hal_device_t*)device,
+      IREE_HAL_COMMAND_BUFFER_MODE_ONE_SHOT |
+          IREE_HAL_COMMAND_BUFFER_MODE_ALLOW_INLINE_EXECUTION,
+      iree_hal_command_buffer_allowed_categories(command_buffer),
+      IREE_HAL_QUEUE_AFFINITY_ANY, device->host_allocator,
+      &inline_command_buffer));
+  iree_status_t status = iree_hal_deferred_command_buffer_apply(
+      command_buffer, inline_command_buffer);
+  iree_hal_command_buffer_release(inline_command_buffer);
+  return status;
+}
+
 static iree_status_t iree_hal_sync_device_queue_submit(
     iree_hal_device_t* base_device,
     iree_hal_command_category_t command_categories,
@@ -247,8 +281,15 @@ static iree_status_t iree_hal_sync_device_queue_submit(
         &device->semaphore_state, IREE_HAL_WAIT_MODE_ALL,
         &batch->wait_semaphores, iree_infinite_timeout()));
 
-    // TODO(#4680): if we were doing deferred submissions we would issue them
-    // here. With only inline command buffers we have nothing to do here.
+    // One-shot command buffers have already executed inline during recording
+    // and only reusable command buffers need to be replayed here.
+    for (iree_host_size_t j = 0; j < batch->command_buffer_count; ++j) {
+      iree_hal_command_buffer_t* command_buffer = batch->command_buffers[j];
+      if (iree_hal_deferred_command_buffer_isa(command_buffer)) {
+        IREE_RETURN_IF_ERROR(
+            iree_hal_sync_device_replay_command_buffer(device, command_buffer));
+      }
+    }
 
     // Signal all semaphores now that batch work has completed.
     IREE_RETURN_IF_ERROR(iree_hal_sync_semaphore_multi_signal(
@@ -21,6 +21,7 @@
 #include "iree/hal/local/task_queue.h"
 #include "iree/hal/local/task_semaphore.h"
 #include "iree/hal/utils/buffer_transfer.h"
+#include "iree/hal/utils/deferred_command_buffer.h"
 
 typedef struct iree_hal_task_device_t {
   iree_hal_resource_t resource;
@@ -229,6 +230,13 @@ static iree_status_t iree_hal_task_device_create_command_buffer(
     iree_hal_queue_affinity_t queue_affinity,
     iree_hal_command_buffer_t** out_command_buffer) {
   iree_hal_task_device_t* device = iree_hal_task_device_cast(base_device);
+  if (!iree_all_bits_set(mode, IREE_HAL_COMMAND_BUFFER_MODE_ONE_SHOT)) {
+    // Reusable command buffers are recorded once and replayed into a new task
+    // command buffer on each submission.
+    return iree_hal_deferred_command_buffer_create(
+        base_device, mode, command_categories, &device->large_block_pool,
+        device->host_allocator, out_command_buffer);
+  }
   iree_host_size_t queue_index = iree_hal_task_device_select_queue(
       device, command_categories, queue_affinity);
   return iree_hal_task_command_buffer_create(
@@ -292,6 +300,86 @@ static iree_status_t iree_hal_task_device_create_semaphore(
       device->host_allocator, out_semaphore);
 }
 
+// Replays a reusable |command_buffer| into a new one-shot task command buffer
+// that can be issued to |queue_index|.
+static iree_status_t iree_hal_task_device_replay_command_buffer(
+    iree_hal_task_device_t* device, iree_host_size_t queue_index,
+    iree_hal_command_buffer_t* command_buffer,
+    iree_hal_command_buffer_t** out_command_buffer) {
+  *out_command_buffer = NULL;
+  iree_hal_command_buffer_t* task_command_buffer = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_task_command_buffer_create(
+      (iree_hal_device_t*)device, &device->queues[queue_index].scope,
+      IREE_HAL_COMMAND_BUFFER_MODE_ONE_SHOT,
+      iree_hal_command_buffer_allowed_categories(command_buffer),
+      IREE_HAL_QUEUE_AFFINITY_ANY, &device->large_block_pool,
+      device->host_allocator, &task_command_buffer));
+  iree_status_t status = iree_hal_deferred_command_buffer_apply(
+      command_buffer, task_command_buffer);
+  if (iree_status_is_ok(status)) {
+    *out_command_buffer = task_command_buffer;
+  } else {
+    iree_hal_command_buffer_release(task_command_buffer);
+  }
+  return status;
+}
+
+// Submits |batches| after replacing all reusable command buffers with one-shot
+// task command buffers replayed from them. The queue retains the replayed
+// command buffers until the submission retires.
+static iree_status_t iree_hal_task_device_queue_submit_replayed(
+    iree_hal_task_device_t* device, iree_host_size_t queue_index,
+    iree_host_size_t batch_count, const iree_hal_submission_batch_t* batches) {
+  iree_host_size_t total_command_buffer_count = 0;
+  for (iree_host_size_t i = 0; i < batch_count; ++i) {
+    total_command_buffer_count += batches[i].command_buffer_count;
+  }
+
+  iree_hal_submission_batch_t* replayed_batches = NULL;
+  iree_host_size_t batches_size = batch_count * sizeof(*replayed_batches);
+  iree_host_size_t total_size =
+      batches_size +
+      total_command_buffer_count * sizeof(iree_hal_command_buffer_t*);
+  IREE_RETURN_IF_ERROR(iree_allocator_malloc(
+      device->host_allocator, total_size, (void**)&replayed_batches));
+  iree_hal_command_buffer_t** replayed_command_buffers =
+      (iree_hal_command_buffer_t**)((uint8_t*)replayed_batches + batches_size);
+  memset(replayed_command_buffers, 0,
+         total_command_buffer_count * sizeof(*replayed_command_buffers));
+
+  // Replay each reusable command buffer; the others are passed through.
+  iree_status_t status = iree_ok_status();
+  iree_hal_command_buffer_t** command_buffer_ptr = replayed_command_buffers;
+  for (iree_host_size_t i = 0; i < batch_count; ++i) {
+    replayed_batches[i] = batches[i];
+    replayed_batches[i].command_buffers = command_buffer_ptr;
+    for (iree_host_size_t j = 0; j < batches[i].command_buffer_count; ++j) {
+      iree_hal_command_buffer_t* command_buffer =
+          batches[i].command_buffers[j];
+      if (iree_status_is_ok(status) &&
+          iree_hal_deferred_command_buffer_isa(command_buffer)) {
+        status = iree_hal_task_device_replay_command_buffer(
+            device, queue_index, command_buffer, command_buffer_ptr);
+      } else {
+        *command_buffer_ptr = command_buffer;
+        iree_hal_command_buffer_retain(command_buffer);
+      }
+      ++command_buffer_ptr;
+    }
+  }
+
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_task_queue_submit(&device->queues[queue_index],
+                                        batch_count, replayed_batches);
+  }
+
+  for (iree_host_size_t i = 0; i < total_command_buffer_count; ++i) {
+    iree_hal_command_buffer_release(replayed_command_buffers[i]);
+  }
+  iree_allocator_free(device->host_allocator, replayed_batches);
+  return status;
+}
+
 static iree_status_t iree_hal_task_device_queue_submit(
     iree_hal_device_t* base_device,
     iree_hal_command_category_t command_categories,
@@ -300,6 +388,14 @@ static iree_status_t iree_hal_task_device_queue_submit(
   iree_hal_task_device_t* device = iree_hal_task_device_cast(base_device);
   iree_host_size_t queue_index = iree_hal_task_device_select_queue(
       device, command_categories, queue_affinity);
+  for (iree_host_size_t i = 0; i < batch_count; ++i) {
+    for (iree_host_size_t j = 0; j < batches[i].command_buffer_count; ++j) {
+      if (iree_hal_deferred_command_buffer_isa(batches[i].command_buffers[j])) {
+        return iree_hal_task_device_queue_submit_replayed(
+            device, queue_index, batch_count, batches);
+      }
+    }
+  }
   return iree_hal_task_queue_submit(&device->queues[queue_index], batch_count,
                                     batches);
 }
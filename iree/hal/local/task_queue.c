@@ -278,6 +278,12 @@ typedef struct iree_hal_task_queue_retire_cmd_t {
 
   // A list of semaphores to signal upon retiring.
   iree_hal_semaphore_list_t signal_semaphores;
+
+  // Command buffers retained until the submission retires. This allows
+  // submitters to drop transient command buffers (such as those replayed from
+  // reusable command buffers) immediately after submission.
+  iree_host_size_t command_buffer_count;
+  iree_hal_command_buffer_t** command_buffers;
 } iree_hal_task_queue_retire_cmd_t;
 
 // Retires a submission by signaling semaphores to their desired value and
@@ -324,6 +330,11 @@ static void iree_hal_task_queue_retire_cmd_cleanup(
   // Release all semaphores.
   iree_hal_semaphore_list_release(&cmd->signal_semaphores);
 
+  // Release all command buffers.
+  for (iree_host_size_t i = 0; i < cmd->command_buffer_count; ++i) {
+    iree_hal_command_buffer_release(cmd->command_buffers[i]);
+  }
+
   // Drop all memory used by the submission (**including cmd**).
   iree_arena_allocator_t arena = cmd->arena;
   cmd = NULL;
@@ -336,6 +347,8 @@ static void iree_hal_task_queue_retire_cmd_cleanup(
 static iree_status_t iree_hal_task_queue_retire_cmd_allocate(
     iree_task_scope_t* scope,
     const iree_hal_semaphore_list_t* signal_semaphores,
+    iree_host_size_t command_buffer_count,
+    iree_hal_command_buffer_t** const command_buffers,
     iree_arena_block_pool_t* block_pool,
     iree_hal_task_queue_retire_cmd_t** out_cmd) {
   // Make an arena we'll use for allocating the command itself.
@@ -352,6 +365,8 @@ static iree_status_t iree_hal_task_queue_retire_cmd_allocate(
         &cmd->task);
     iree_task_set_cleanup_fn(&cmd->task.header,
                              iree_hal_task_queue_retire_cmd_cleanup);
+    cmd->command_buffer_count = 0;
+    cmd->command_buffers = NULL;
   }
 
   // Clone the signal semaphores from the batch - we retain them and their
@@ -361,6 +376,20 @@ static iree_status_t iree_hal_task_queue_retire_cmd_allocate(
                                            &cmd->signal_semaphores);
   }
 
+  // Clone and retain the command buffers from the batch.
+  if (iree_status_is_ok(status) && command_buffer_count > 0) {
+    status = iree_arena_allocate(
+        &arena, command_buffer_count * sizeof(*cmd->command_buffers),
+        (void**)&cmd->command_buffers);
+    if (iree_status_is_ok(status)) {
+      cmd->command_buffer_count = command_buffer_count;
+      for (iree_host_size_t i = 0; i < command_buffer_count; ++i) {
+        cmd->command_buffers[i] = command_buffers[i];
+        iree_hal_command_buffer_retain(cmd->command_buffers[i]);
+      }
+    }
+  }
+
   if (iree_status_is_ok(status)) {
     // Transfer ownership of the arena to command.
     memcpy(&cmd->arena, &arena, sizeof(cmd->arena));
@@ -422,8 +451,8 @@ static iree_status_t iree_hal_task_queue_submit_batch(
   // arena which we will use to allocate all other commands.
   iree_hal_task_queue_retire_cmd_t* retire_cmd = NULL;
   IREE_RETURN_IF_ERROR(iree_hal_task_queue_retire_cmd_allocate(
-      &queue->scope, &batch->signal_semaphores, queue->block_pool,
-      &retire_cmd));
+      &queue->scope, &batch->signal_semaphores, batch->command_buffer_count,
+      batch->command_buffers, queue->block_pool, &retire_cmd));
 
   // NOTE: if we fail from here on we must drop the retire_cmd arena.
   iree_status_t status = iree_ok_status();
@@ -457,6 +486,9 @@ static iree_status_t iree_hal_task_queue_submit_batch(
 
   // Last chance for failure - from here on we are submitting.
   if (IREE_UNLIKELY(!iree_status_is_ok(status))) {
+    for (iree_host_size_t i = 0; i < retire_cmd->command_buffer_count; ++i) {
+      iree_hal_command_buffer_release(retire_cmd->command_buffers[i]);
+    }
     iree_arena_deinitialize(&retire_cmd->arena);
     return status;
   }
@@ -40,10 +40,24 @@ static iree_vm_ref_type_descriptor_t iree_hal_executable_layout_descriptor = {
     0};
 static iree_vm_ref_type_descriptor_t iree_hal_semaphore_descriptor = {0};
 
-#define IREE_VM_REGISTER_HAL_C_TYPE(type, name, destroy_fn, descriptor)   \
+// Buffers are shared across forked contexts when they cannot be mutated: either
+// they were never writable (such as constants mapped from module rodata) or
+// their usage declares they will not be updated after initialization.
+static bool iree_hal_buffer_is_shareable(void* ptr) {
+  iree_hal_buffer_t* buffer = (iree_hal_buffer_t*)ptr;
+  return !iree_any_bit_set(
+             iree_hal_buffer_allowed_access(buffer),
+             IREE_HAL_MEMORY_ACCESS_WRITE | IREE_HAL_MEMORY_ACCESS_ANY) ||
+         iree_all_bits_set(iree_hal_buffer_allowed_usage(buffer),
+                           IREE_HAL_BUFFER_USAGE_CONSTANT);
+}
+
+#define IREE_VM_REGISTER_HAL_C_TYPE(type, name, destroy_fn, descriptor,   \
+                                    type_flags)                           \
   descriptor.type_name = iree_make_cstring_view(name);                    \
   descriptor.offsetof_counter = offsetof(iree_hal_resource_t, ref_count); \
   descriptor.destroy = (iree_vm_ref_destroy_t)destroy_fn;                 \
+  descriptor.flags = type_flags;                                          \
   IREE_RETURN_IF_ERROR(iree_vm_ref_register_type(&descriptor));
 
 IREE_API_EXPORT iree_status_t iree_hal_module_register_types(void) {
@@ -52,39 +66,51 @@ IREE_API_EXPORT iree_status_t iree_hal_module_register_types(void) {
 
   IREE_VM_REGISTER_HAL_C_TYPE(iree_hal_allocator_t, "hal.allocator",
                               iree_hal_allocator_destroy,
-                              iree_hal_allocator_descriptor);
+                              iree_hal_allocator_descriptor,
+                              IREE_VM_REF_TYPE_FLAG_SHAREABLE);
+  iree_hal_buffer_descriptor.is_shareable = iree_hal_buffer_is_shareable;
   IREE_VM_REGISTER_HAL_C_TYPE(iree_hal_buffer_t, "hal.buffer",
                               iree_hal_buffer_recycle,
-                              iree_hal_buffer_descriptor);
+                              iree_hal_buffer_descriptor,
+                              IREE_VM_REF_TYPE_FLAG_NONE);
   IREE_VM_REGISTER_HAL_C_TYPE(iree_hal_buffer_view_t, "hal.buffer_view",
                               iree_hal_buffer_view_destroy,
-                              iree_hal_buffer_view_descriptor);
+                              iree_hal_buffer_view_descriptor,
+                              IREE_VM_REF_TYPE_FLAG_NONE);
   IREE_VM_REGISTER_HAL_C_TYPE(iree_hal_command_buffer_t, "hal.command_buffer",
                               iree_hal_command_buffer_destroy,
-                              iree_hal_command_buffer_descriptor);
+                              iree_hal_command_buffer_descriptor,
+                              IREE_VM_REF_TYPE_FLAG_NONE);
   IREE_VM_REGISTER_HAL_C_TYPE(iree_hal_descriptor_set_t, "hal.descriptor_set",
                               iree_hal_descriptor_set_destroy,
-                              iree_hal_descriptor_set_descriptor);
+                              iree_hal_descriptor_set_descriptor,
+                              IREE_VM_REF_TYPE_FLAG_NONE);
   IREE_VM_REGISTER_HAL_C_TYPE(iree_hal_descriptor_set_layout_t,
                               "hal.descriptor_set_layout",
                               iree_hal_descriptor_set_layout_destroy,
-                              iree_hal_descriptor_set_layout_descriptor);
+                              iree_hal_descriptor_set_layout_descriptor,
+                              IREE_VM_REF_TYPE_FLAG_SHAREABLE);
   IREE_VM_REGISTER_HAL_C_TYPE(iree_hal_device_t, "hal.device",
                               iree_hal_device_destroy,
-                              iree_hal_device_descriptor);
+                              iree_hal_device_descriptor,
+                              IREE_VM_REF_TYPE_FLAG_SHAREABLE);
   IREE_VM_REGISTER_HAL_C_TYPE(iree_hal_event_t, "hal.event",
                               iree_hal_event_destroy,
-                              iree_hal_event_descriptor);
+                              iree_hal_event_descriptor,
+                              IREE_VM_REF_TYPE_FLAG_NONE);
   IREE_VM_REGISTER_HAL_C_TYPE(iree_hal_executable_t, "hal.executable",
                               iree_hal_executable_destroy,
-                              iree_hal_executable_descriptor);
+                              iree_hal_executable_descriptor,
+                              IREE_VM_REF_TYPE_FLAG_SHAREABLE);
   IREE_VM_REGISTER_HAL_C_TYPE(iree_hal_executable_layout_t,
                               "hal.executable_layout",
                               iree_hal_executable_layout_destroy,
-                              iree_hal_executable_layout_descriptor);
+                              iree_hal_executable_layout_descriptor,
+                              IREE_VM_REF_TYPE_FLAG_SHAREABLE);
   IREE_VM_REGISTER_HAL_C_TYPE(iree_hal_semaphore_t, "hal.semaphore",
                               iree_hal_semaphore_destroy,
-                              iree_hal_semaphore_descriptor);
+                              iree_hal_semaphore_descriptor,
+                              IREE_VM_REF_TYPE_FLAG_NONE);
 
   has_registered = true;
   return iree_ok_status();
@@ -167,6 +193,44 @@ iree_hal_module_alloc_state(void* self, iree_allocator_t host_allocator,
   return iree_ok_status();
 }
 
+static iree_status_t IREE_API_PTR iree_hal_module_fork_state(
+    void* self, iree_vm_module_state_t* parent_module_state,
+    iree_allocator_t host_allocator,
+    iree_vm_module_state_t** out_module_state) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_hal_module_state_t* parent_state =
+      (iree_hal_module_state_t*)parent_module_state;
+  iree_hal_module_state_t* state = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0,
+      iree_allocator_malloc(host_allocator, sizeof(*state), (void**)&state));
+  memset(state, 0, sizeof(*state));
+  state->host_allocator = host_allocator;
+  state->shared_device = parent_state->shared_device;
+  iree_hal_device_retain(state->shared_device);
+
+  // Executables prepared by the parent are immutable and shared.
+  state->executable_cache = parent_state->executable_cache;
+  iree_hal_executable_cache_retain(state->executable_cache);
+
+  // Submissions are tracked per-context.
+  state->submit_value = 0ull;
+  iree_status_t status = iree_hal_semaphore_create(
+      state->shared_device, state->submit_value, &state->submit_semaphore);
+  if (!iree_status_is_ok(status)) {
+    iree_hal_executable_cache_release(state->executable_cache);
+    iree_hal_device_release(state->shared_device);
+    iree_allocator_free(host_allocator, state);
+    IREE_TRACE_ZONE_END(z0);
+    return status;
+  }
+
+  *out_module_state = (iree_vm_module_state_t*)state;
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
 static void IREE_API_PTR
 iree_hal_module_free_state(void* self, iree_vm_module_state_t* module_state) {
   IREE_TRACE_ZONE_BEGIN(z0);
@@ -1412,6 +1476,7 @@ iree_hal_module_create(iree_hal_device_t* device, iree_allocator_t allocator,
       .destroy = iree_hal_module_destroy,
       .alloc_state = iree_hal_module_alloc_state,
       .free_state = iree_hal_module_free_state,
+      .fork_state = iree_hal_module_fork_state,
       .notify = iree_hal_module_notify,
   };
 
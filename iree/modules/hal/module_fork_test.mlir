@@ -0,0 +1,51 @@
+// Module used by module_test.cc to verify that constant device buffers are
+// shared with forked contexts.
+vm.module @module_fork_test {
+
+  vm.import @hal.ex.shared_device() -> !vm.ref<!hal.device>
+  attributes {nosideeffects}
+
+  vm.import @hal.device.allocator(
+    %device : !vm.ref<!hal.device>
+  ) -> !vm.ref<!hal.allocator>
+  attributes {nosideeffects}
+
+  vm.import @hal.allocator.allocate(
+    %allocator : !vm.ref<!hal.allocator>,
+    %memory_types : i32,
+    %buffer_usage : i32,
+    %allocation_size : i32
+  ) -> !vm.ref<!hal.buffer>
+
+  vm.import @hal.buffer.store(
+    %value : i32,
+    %target_buffer : !vm.ref<!hal.buffer>,
+    %target_offset : i32,
+    %length : i32
+  )
+
+  vm.global.ref private mutable @constant_buffer : !vm.ref<!hal.buffer>
+
+  vm.initializer {
+    %device = vm.call @hal.ex.shared_device() : () -> !vm.ref<!hal.device>
+    %allocator = vm.call @hal.device.allocator(%device) : (!vm.ref<!hal.device>) -> !vm.ref<!hal.allocator>
+    // HostLocal|DeviceVisible, Constant|Transfer|Mapping|Dispatch
+    %memory_types = vm.const.i32 22
+    %buffer_usage = vm.const.i32 15
+    %c0 = vm.const.i32 0
+    %c4 = vm.const.i32 4
+    %buffer = vm.call @hal.allocator.allocate(%allocator, %memory_types, %buffer_usage, %c4) : (!vm.ref<!hal.allocator>, i32, i32, i32) -> !vm.ref<!hal.buffer>
+    %c7 = vm.const.i32 7
+    vm.call @hal.buffer.store(%c7, %buffer, %c0, %c4) : (i32, !vm.ref<!hal.buffer>, i32, i32) -> ()
+    vm.global.store.ref %buffer, @constant_buffer : !vm.ref<!hal.buffer>
+    vm.return
+  }
+
+  // Returns the constant device buffer global.
+  vm.export @get_constant_buffer
+  vm.func @get_constant_buffer() -> !vm.ref<!hal.buffer> {
+    %buffer = vm.global.load.ref @constant_buffer : !vm.ref<!hal.buffer>
+    vm.return %buffer : !vm.ref<!hal.buffer>
+  }
+
+}
@@ -0,0 +1,177 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/modules/hal/module.h"
+
+#include <vector>
+
+#include "iree/base/api.h"
+#include "iree/base/status_cc.h"
+#include "iree/hal/api.h"
+#include "iree/hal/vmvx/registration/driver_module.h"
+#include "iree/modules/hal/module_fork_test_module_c.h"
+#include "iree/modules/hal/module_test_module_c.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+#include "iree/vm/api.h"
+#include "iree/vm/bytecode_module.h"
+#include "iree/vm/ref_cc.h"
+
+namespace iree {
+namespace {
+
+class HALModuleTest : public ::testing::Test {
+ protected:
+  static void SetUpTestSuite() {
+    IREE_CHECK_OK(iree_hal_vmvx_driver_module_register(
+        iree_hal_driver_registry_default()));
+    IREE_ASSERT_OK(iree_hal_module_register_types());
+  }
+
+  void SetUp() override {
+    iree_hal_driver_t* hal_driver = nullptr;
+    IREE_ASSERT_OK(iree_hal_driver_registry_try_create_by_name(
+        iree_hal_driver_registry_default(), iree_make_cstring_view("vmvx"),
+        iree_allocator_system(), &hal_driver));
+    IREE_ASSERT_OK(iree_hal_driver_create_default_device(
+        hal_driver, iree_allocator_system(), &device_));
+    iree_hal_driver_release(hal_driver);
+    IREE_ASSERT_OK(
+        iree_hal_module_create(device_, iree_allocator_system(), &hal_module_));
+
+    const auto* module_file_toc = iree_hal_module_test_module_create();
+    IREE_ASSERT_OK(iree_vm_bytecode_module_create(
+        iree_const_byte_span_t{
+            reinterpret_cast<const uint8_t*>(module_file_toc->data),
+            module_file_toc->size},
+        iree_allocator_null(), iree_allocator_system(), &bytecode_module_));
+
+    const auto* fork_module_file_toc =
+        iree_hal_module_fork_test_module_create();
+    IREE_ASSERT_OK(iree_vm_bytecode_module_create(
+        iree_const_byte_span_t{
+            reinterpret_cast<const uint8_t*>(fork_module_file_toc->data),
+            fork_module_file_toc->size},
+        iree_allocator_null(), iree_allocator_system(), &fork_module_));
+
+    IREE_ASSERT_OK(
+        iree_vm_instance_create(iree_allocator_system(), &instance_));
+    std::vector<iree_vm_module_t*> modules = {hal_module_, bytecode_module_,
+                                              fork_module_};
+    IREE_ASSERT_OK(iree_vm_context_create_with_modules(
+        instance_, IREE_VM_CONTEXT_FLAG_NONE, modules.data(), modules.size(),
+        iree_allocator_system(), &context_));
+  }
+
+  void TearDown() override {
+    iree_vm_context_release(context_);
+    iree_vm_module_release(fork_module_);
+    iree_vm_module_release(bytecode_module_);
+    iree_vm_module_release(hal_module_);
+    iree_vm_instance_release(instance_);
+    iree_hal_device_release(device_);
+  }
+
+  Status Store(iree_vm_context_t* context, int32_t value) {
+    iree_vm_function_t function;
+    IREE_RETURN_IF_ERROR(iree_vm_context_resolve_function(
+        context, iree_make_cstring_view("module_test.store"), &function));
+    vm::ref<iree_vm_list_t> input_list;
+    IREE_RETURN_IF_ERROR(iree_vm_list_create(
+        /*element_type=*/nullptr, 1, iree_allocator_system(), &input_list));
+    auto arg0_value = iree_vm_value_make_i32(value);
+    IREE_RETURN_IF_ERROR(
+        iree_vm_list_push_value(input_list.get(), &arg0_value));
+    return iree_vm_invoke(context, function, IREE_VM_INVOCATION_FLAG_NONE,
+                          /*policy=*/nullptr, input_list.get(),
+                          /*outputs=*/nullptr, iree_allocator_system());
+  }
+
+  StatusOr<int32_t> Load(iree_vm_context_t* context) {
+    iree_vm_function_t function;
+    IREE_RETURN_IF_ERROR(iree_vm_context_resolve_function(
+        context, iree_make_cstring_view("module_test.load"), &function));
+    vm::ref<iree_vm_list_t> output_list;
+    IREE_RETURN_IF_ERROR(iree_vm_list_create(
+        /*element_type=*/nullptr, 1, iree_allocator_system(), &output_list));
+    IREE_RETURN_IF_ERROR(iree_vm_invoke(
+        context, function, IREE_VM_INVOCATION_FLAG_NONE, /*policy=*/nullptr,
+        /*inputs=*/nullptr, output_list.get(), iree_allocator_system()));
+    iree_vm_value_t ret0_value;
+    IREE_RETURN_IF_ERROR(
+        iree_vm_list_get_value(output_list.get(), 0, &ret0_value));
+    return ret0_value.i32;
+  }
+
+  // Returns the constant buffer global of |context|. The buffer is owned by the
+  // module state and only valid while |context| is alive.
+  StatusOr<iree_hal_buffer_t*> GetConstantBuffer(iree_vm_context_t* context) {
+    iree_vm_function_t function;
+    IREE_RETURN_IF_ERROR(iree_vm_context_resolve_function(
+        context, iree_make_cstring_view("module_fork_test.get_constant_buffer"),
+        &function));
+    vm::ref<iree_vm_list_t> output_list;
+    IREE_RETURN_IF_ERROR(iree_vm_list_create(
+        /*element_type=*/nullptr, 1, iree_allocator_system(), &output_list));
+    IREE_RETURN_IF_ERROR(iree_vm_invoke(
+        context, function, IREE_VM_INVOCATION_FLAG_NONE, /*policy=*/nullptr,
+        /*inputs=*/nullptr, output_list.get(), iree_allocator_system()));
+    iree_vm_ref_t ret0_ref = iree_vm_ref_null();
+    IREE_RETURN_IF_ERROR(
+        iree_vm_list_get_ref_assign(output_list.get(), 0, &ret0_ref));
+    return iree_hal_buffer_deref(ret0_ref);
+  }
+
+  iree_hal_device_t* device_ = nullptr;
+  iree_vm_module_t* hal_module_ = nullptr;
+  iree_vm_module_t* bytecode_module_ = nullptr;
+  iree_vm_module_t* fork_module_ = nullptr;
+  iree_vm_instance_t* instance_ = nullptr;
+  iree_vm_context_t* context_ = nullptr;
+};
+
+// Tests that device buffers referenced by globals are not shared with a forked
+// context: the module holding them is initialized anew in the fork and stores
+// in either context are not observed by the other.
+TEST_F(HALModuleTest, ForkIsolatesDeviceBufferGlobals) {
+  IREE_ASSERT_OK(Store(context_, 100));
+
+  iree_vm_context_t* forked_context = nullptr;
+  IREE_ASSERT_OK(iree_vm_context_fork(context_, iree_allocator_system(),
+                                      &forked_context));
+  IREE_ASSERT_OK_AND_ASSIGN(int32_t forked_value, Load(forked_context));
+  EXPECT_EQ(forked_value, 1);
+
+  IREE_ASSERT_OK(Store(forked_context, 200));
+  IREE_ASSERT_OK_AND_ASSIGN(int32_t parent_value, Load(context_));
+  EXPECT_EQ(parent_value, 100);
+
+  IREE_ASSERT_OK(Store(context_, 300));
+  IREE_ASSERT_OK_AND_ASSIGN(forked_value, Load(forked_context));
+  EXPECT_EQ(forked_value, 200);
+
+  iree_vm_context_release(forked_context);
+}
+
+// Tests that constant device buffers referenced by globals are shared with a
+// forked context instead of the module being initialized anew.
+TEST_F(HALModuleTest, ForkSharesConstantBufferGlobals) {
+  IREE_ASSERT_OK_AND_ASSIGN(iree_hal_buffer_t * parent_buffer,
+                            GetConstantBuffer(context_));
+  ASSERT_NE(parent_buffer, nullptr);
+
+  iree_vm_context_t* forked_context = nullptr;
+  IREE_ASSERT_OK(iree_vm_context_fork(context_, iree_allocator_system(),
+                                      &forked_context));
+  IREE_ASSERT_OK_AND_ASSIGN(iree_hal_buffer_t * forked_buffer,
+                            GetConstantBuffer(forked_context));
+  EXPECT_EQ(forked_buffer, parent_buffer);
+
+  iree_vm_context_release(forked_context);
+}
+
+}  // namespace
+}  // namespace iree
@@ -0,0 +1,71 @@
+// Module used by module_test.cc to verify HAL module state handling.
+vm.module @module_test {
+
+  vm.import @hal.ex.shared_device() -> !vm.ref<!hal.device>
+  attributes {nosideeffects}
+
+  vm.import @hal.device.allocator(
+    %device : !vm.ref<!hal.device>
+  ) -> !vm.ref<!hal.allocator>
+  attributes {nosideeffects}
+
+  vm.import @hal.allocator.allocate(
+    %allocator : !vm.ref<!hal.allocator>,
+    %memory_types : i32,
+    %buffer_usage : i32,
+    %allocation_size : i32
+  ) -> !vm.ref<!hal.buffer>
+
+  vm.import @hal.buffer.load(
+    %source_buffer : !vm.ref<!hal.buffer>,
+    %source_offset : i32,
+    %length : i32
+  ) -> i32
+
+  vm.import @hal.buffer.store(
+    %value : i32,
+    %target_buffer : !vm.ref<!hal.buffer>,
+    %target_offset : i32,
+    %length : i32
+  )
+
+  vm.global.ref private mutable @device : !vm.ref<!hal.device>
+  vm.global.ref private mutable @buffer : !vm.ref<!hal.buffer>
+
+  vm.initializer {
+    %device = vm.call @hal.ex.shared_device() : () -> !vm.ref<!hal.device>
+    vm.global.store.ref %device, @device : !vm.ref<!hal.device>
+    %allocator = vm.call @hal.device.allocator(%device) : (!vm.ref<!hal.device>) -> !vm.ref<!hal.allocator>
+    // HostLocal|DeviceVisible, Transfer|Mapping|Dispatch
+    %memory_types = vm.const.i32 22
+    %buffer_usage = vm.const.i32 14
+    %c0 = vm.const.i32 0
+    %c4 = vm.const.i32 4
+    %buffer = vm.call @hal.allocator.allocate(%allocator, %memory_types, %buffer_usage, %c4) : (!vm.ref<!hal.allocator>, i32, i32, i32) -> !vm.ref<!hal.buffer>
+    %c1 = vm.const.i32 1
+    vm.call @hal.buffer.store(%c1, %buffer, %c0, %c4) : (i32, !vm.ref<!hal.buffer>, i32, i32) -> ()
+    vm.global.store.ref %buffer, @buffer : !vm.ref<!hal.buffer>
+    vm.return
+  }
+
+  // Stores |arg0| into the device buffer global.
+  vm.export @store
+  vm.func @store(%arg0 : i32) {
+    %buffer = vm.global.load.ref @buffer : !vm.ref<!hal.buffer>
+    %c0 = vm.const.i32 0
+    %c4 = vm.const.i32 4
+    vm.call @hal.buffer.store(%arg0, %buffer, %c0, %c4) : (i32, !vm.ref<!hal.buffer>, i32, i32) -> ()
+    vm.return
+  }
+
+  // Returns the value stored in the device buffer global.
+  vm.export @load
+  vm.func @load() -> i32 {
+    %buffer = vm.global.load.ref @buffer : !vm.ref<!hal.buffer>
+    %c0 = vm.const.i32 0
+    %c4 = vm.const.i32 4
+    %value = vm.call @hal.buffer.load(%buffer, %c0, %c4) : (!vm.ref<!hal.buffer>, i32, i32) -> i32
+    vm.return %value : i32
+  }
+
+}
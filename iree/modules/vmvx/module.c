@@ -84,6 +84,14 @@ iree_vmvx_module_alloc_state(void* self, iree_allocator_t host_allocator,
   return iree_ok_status();
 }
 
+static iree_status_t IREE_API_PTR
+iree_vmvx_module_fork_state(void* self, iree_vm_module_state_t* parent_state,
+                            iree_allocator_t host_allocator,
+                            iree_vm_module_state_t** out_module_state) {
+  // No state to share (yet).
+  return iree_vmvx_module_alloc_state(self, host_allocator, out_module_state);
+}
+
 static void IREE_API_PTR
 iree_vmvx_module_free_state(void* self, iree_vm_module_state_t* module_state) {
   iree_vmvx_module_state_t* state = (iree_vmvx_module_state_t*)module_state;
@@ -159,6 +167,7 @@ IREE_API_EXPORT iree_status_t iree_vmvx_module_create(
       .destroy = iree_vmvx_module_destroy,
       .alloc_state = iree_vmvx_module_alloc_state,
       .free_state = iree_vmvx_module_free_state,
+      .fork_state = iree_vmvx_module_fork_state,
   };
 
   // Allocate shared module state.
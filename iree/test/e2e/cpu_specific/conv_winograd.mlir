@@ -0,0 +1,160 @@
+// This test compares 3x3 linalg.conv_2d_nhwc_hwcf ops, which the CPU backend
+// rewrites with the Winograd F(2x2, 3x3) and F(4x4, 3x3) algorithms under
+// -iree-flow-enable-conv-winograd-transform (see
+// -iree-flow-convert-conv2d-to-winograd), to the same convolutions written as
+// linalg.generic ops, which are left alone. The shapes are large enough for
+// the transforms to be estimated cheaper than the convolutions.
+
+// Convolution equivalent to linalg.conv_2d_nhwc_hwcf, but not using it.
+func.func private @conv_as_generic_4x4x8x16(%input : tensor<4x4x8x16xf32>, %filter : tensor<3x3x16x32xf32>, %output : tensor<4x2x6x32xf32>) -> tensor<4x2x6x32xf32> {
+  %0 = linalg.generic {
+      indexing_maps = [
+        affine_map<(d0, d1, d2, d3, d4, d5, d6) -> (d0, d1 + d4, d2 + d5, d6)>,
+        affine_map<(d0, d1, d2, d3, d4, d5, d6) -> (d4, d5, d6, d3)>,
+        affine_map<(d0, d1, d2, d3, d4, d5, d6) -> (d0, d1, d2, d3)>],
+      iterator_types = ["parallel", "parallel", "parallel", "parallel", "reduction", "reduction", "reduction"]}
+      ins(%input, %filter : tensor<4x4x8x16xf32>, tensor<3x3x16x32xf32>)
+      outs(%output : tensor<4x2x6x32xf32>) {
+      ^bb0(%arg0: f32, %arg1: f32, %arg2: f32) :
+        %1 = arith.mulf %arg0, %arg1 : f32
+        %2 = arith.addf %arg2, %1 : f32
+        linalg.yield %2 : f32
+      } -> tensor<4x2x6x32xf32>
+  return %0 : tensor<4x2x6x32xf32>
+}
+
+// Convolution equivalent to linalg.conv_2d_nhwc_hwcf, but not using it.
+func.func private @conv_as_generic_4x11x9x16(%input : tensor<4x11x9x16xf32>, %filter : tensor<3x3x16x32xf32>, %output : tensor<4x9x7x32xf32>) -> tensor<4x9x7x32xf32> {
+  %0 = linalg.generic {
+      indexing_maps = [
+        affine_map<(d0, d1, d2, d3, d4, d5, d6) -> (d0, d1 + d4, d2 + d5, d6)>,
+        affine_map<(d0, d1, d2, d3, d4, d5, d6) -> (d4, d5, d6, d3)>,
+        affine_map<(d0, d1, d2, d3, d4, d5, d6) -> (d0, d1, d2, d3)>],
+      iterator_types = ["parallel", "parallel", "parallel", "parallel", "reduction", "reduction", "reduction"]}
+      ins(%input, %filter : tensor<4x11x9x16xf32>, tensor<3x3x16x32xf32>)
+      outs(%output : tensor<4x9x7x32xf32>) {
+      ^bb0(%arg0: f32, %arg1: f32, %arg2: f32) :
+        %1 = arith.mulf %arg0, %arg1 : f32
+        %2 = arith.addf %arg2, %1 : f32
+        linalg.yield %2 : f32
+      } -> tensor<4x9x7x32xf32>
+  return %0 : tensor<4x9x7x32xf32>
+}
+
+// Filter of small multiples of 0.25 that vary along every dimension.
+func.func private @filter_3x3x16x32() -> tensor<3x3x16x32xf32> {
+  %init = linalg.init_tensor [3, 3, 16, 32] : tensor<3x3x16x32xf32>
+  %0 = linalg.generic {
+      indexing_maps = [affine_map<(d0, d1, d2, d3) -> (d0, d1, d2, d3)>],
+      iterator_types = ["parallel", "parallel", "parallel", "parallel"]}
+      outs(%init : tensor<3x3x16x32xf32>) {
+      ^bb0(%arg0 : f32):
+        %c2 = arith.constant 2 : index
+        %c3 = arith.constant 3 : index
+        %c5 = arith.constant 5 : index
+        %c7 = arith.constant 7 : index
+        %c3_f32 = arith.constant 3.0 : f32
+        %scale = arith.constant 0.25 : f32
+        %i0 = linalg.index 0 : index
+        %i1 = linalg.index 1 : index
+        %i2 = linalg.index 2 : index
+        %i3 = linalg.index 3 : index
+        %1 = arith.muli %i0, %c5 : index
+        %2 = arith.muli %i1, %c3 : index
+        %3 = arith.muli %i2, %c2 : index
+        %4 = arith.addi %1, %2 : index
+        %5 = arith.addi %4, %3 : index
+        %6 = arith.addi %5, %i3 : index
+        %7 = arith.remui %6, %c7 : index
+        %8 = arith.index_cast %7 : index to i32
+        %9 = arith.sitofp %8 : i32 to f32
+        %10 = arith.subf %9, %c3_f32 : f32
+        %11 = arith.mulf %10, %scale : f32
+        linalg.yield %11 : f32
+      } -> tensor<3x3x16x32xf32>
+  return %0 : tensor<3x3x16x32xf32>
+}
+
+func.func @conv_winograd_2x2_batch_accumulate() {
+  // Input of small multiples of 0.125 that vary along every dimension.
+  %init = linalg.init_tensor [4, 4, 8, 16] : tensor<4x4x8x16xf32>
+  %gen = linalg.generic {
+      indexing_maps = [affine_map<(d0, d1, d2, d3) -> (d0, d1, d2, d3)>],
+      iterator_types = ["parallel", "parallel", "parallel", "parallel"]}
+      outs(%init : tensor<4x4x8x16xf32>) {
+      ^bb0(%arg0 : f32):
+        %c3 = arith.constant 3 : index
+        %c5 = arith.constant 5 : index
+        %c7 = arith.constant 7 : index
+        %c9 = arith.constant 9 : index
+        %c4_f32 = arith.constant 4.0 : f32
+        %scale = arith.constant 0.125 : f32
+        %i0 = linalg.index 0 : index
+        %i1 = linalg.index 1 : index
+        %i2 = linalg.index 2 : index
+        %i3 = linalg.index 3 : index
+        %1 = arith.muli %i0, %c7 : index
+        %2 = arith.muli %i1, %c5 : index
+        %3 = arith.muli %i2, %c3 : index
+        %4 = arith.addi %1, %2 : index
+        %5 = arith.addi %4, %3 : index
+        %6 = arith.addi %5, %i3 : index
+        %7 = arith.remui %6, %c9 : index
+        %8 = arith.index_cast %7 : index to i32
+        %9 = arith.sitofp %8 : i32 to f32
+        %10 = arith.subf %9, %c4_f32 : f32
+        %11 = arith.mulf %10, %scale : f32
+        linalg.yield %11 : f32
+      } -> tensor<4x4x8x16xf32>
+  %input = util.do_not_optimize(%gen) : tensor<4x4x8x16xf32>
+  %filter = call @filter_3x3x16x32() : () -> tensor<3x3x16x32xf32>
+  %output = util.unfoldable_constant dense<1.0> : tensor<4x2x6x32xf32>
+  %result = linalg.conv_2d_nhwc_hwcf
+      {dilations = dense<1> : tensor<2xi64>, strides = dense<1> : tensor<2xi64>}
+      ins(%input, %filter : tensor<4x4x8x16xf32>, tensor<3x3x16x32xf32>)
+      outs(%output : tensor<4x2x6x32xf32>) -> tensor<4x2x6x32xf32>
+  %expected = call @conv_as_generic_4x4x8x16(%input, %filter, %output) : (tensor<4x4x8x16xf32>, tensor<3x3x16x32xf32>, tensor<4x2x6x32xf32>) -> tensor<4x2x6x32xf32>
+  check.expect_almost_eq(%result, %expected) : tensor<4x2x6x32xf32>
+  return
+}
+
+func.func @conv_winograd_4x4_padded() {
+  // Input of small multiples of 0.125 that vary along every dimension.
+  %init = linalg.init_tensor [4, 11, 9, 16] : tensor<4x11x9x16xf32>
+  %gen = linalg.generic {
+      indexing_maps = [affine_map<(d0, d1, d2, d3) -> (d0, d1, d2, d3)>],
+      iterator_types = ["parallel", "parallel", "parallel", "parallel"]}
+      outs(%init : tensor<4x11x9x16xf32>) {
+      ^bb0(%arg0 : f32):
+        %c3 = arith.constant 3 : index
+        %c5 = arith.constant 5 : index
+        %c9 = arith.constant 9 : index
+        %c4_f32 = arith.constant 4.0 : f32
+        %scale = arith.constant 0.125 : f32
+        %i1 = linalg.index 1 : index
+        %i2 = linalg.index 2 : index
+        %i3 = linalg.index 3 : index
+        %1 = arith.muli %i1, %c5 : index
+        %2 = arith.muli %i2, %c3 : index
+        %3 = arith.addi %1, %2 : index
+        %4 = arith.addi %3, %i3 : index
+        %5 = arith.remui %4, %c9 : index
+        %6 = arith.index_cast %5 : index to i32
+        %7 = arith.sitofp %6 : i32 to f32
+        %8 = arith.subf %7, %c4_f32 : f32
+        %9 = arith.mulf %8, %scale : f32
+        linalg.yield %9 : f32
+      } -> tensor<4x11x9x16xf32>
+  %input = util.do_not_optimize(%gen) : tensor<4x11x9x16xf32>
+  %filter = call @filter_3x3x16x32() : () -> tensor<3x3x16x32xf32>
+  %cst = arith.constant 0.0 : f32
+  %output_init = linalg.init_tensor [4, 9, 7, 32] : tensor<4x9x7x32xf32>
+  %output = linalg.fill ins(%cst : f32) outs(%output_init : tensor<4x9x7x32xf32>) -> tensor<4x9x7x32xf32>
+  %result = linalg.conv_2d_nhwc_hwcf
+      {dilations = dense<1> : tensor<2xi64>, strides = dense<1> : tensor<2xi64>}
+      ins(%input, %filter : tensor<4x11x9x16xf32>, tensor<3x3x16x32xf32>)
+      outs(%output : tensor<4x9x7x32xf32>) -> tensor<4x9x7x32xf32>
+  %expected = call @conv_as_generic_4x11x9x16(%input, %filter, %output) : (tensor<4x11x9x16xf32>, tensor<3x3x16x32xf32>, tensor<4x9x7x32xf32>) -> tensor<4x9x7x32xf32>
+  check.expect_almost_eq(%result, %expected) : tensor<4x9x7x32xf32>
+  return
+}
@@ -1,6 +1,12 @@
 //===----------------------------------------------------------------------===//
 // Linalg matmul ops.
 //===----------------------------------------------------------------------===//
+//
+// The mmt4d tile shapes below match the custom kernels selected for each
+// target (e.g. 8x1x8/8x4x8 for x86-64 AVX2 FMA/AVX-VNNI, 16x1x16/16x4x16 for
+// AVX-512/AVX-512 VNNI). To compare a custom kernel against generic
+// vectorization, benchmark the same function compiled with and without the
+// matching --iree-llvm-target-cpu-features.
 
 func.func @matmul_384x384x512() -> tensor<384x512xf32> {
     %lhs = util.unfoldable_constant dense<1.0> : tensor<384x384xf32>
@@ -25,3 +31,35 @@ func.func @mmt4d_384x384x512_8x1x8() -> tensor<48x64x8x8xf32> {
     %0 = linalg.mmt4d ins(%lhs, %rhs : tensor<48x384x8x1xf32>, tensor<64x384x8x1xf32>) outs(%dst : tensor<48x64x8x8xf32>) -> tensor<48x64x8x8xf32>
     return %0 : tensor<48x64x8x8xf32>
 }
+
+func.func @mmt4d_384x384x512_16x1x16() -> tensor<24x32x16x16xf32> {
+    %lhs = util.unfoldable_constant dense<1.0> : tensor<24x384x16x1xf32>
+    %rhs = util.unfoldable_constant dense<1.0> : tensor<32x384x16x1xf32>
+    %dst = util.unfoldable_constant dense<1.0> : tensor<24x32x16x16xf32>
+    %0 = linalg.mmt4d ins(%lhs, %rhs : tensor<24x384x16x1xf32>, tensor<32x384x16x1xf32>) outs(%dst : tensor<24x32x16x16xf32>) -> tensor<24x32x16x16xf32>
+    return %0 : tensor<24x32x16x16xf32>
+}
+
+func.func @matmul_384x384x512_i8i8i32() -> tensor<384x512xi32> {
+    %lhs = util.unfoldable_constant dense<1> : tensor<384x384xi8>
+    %rhs = util.unfoldable_constant dense<1> : tensor<384x512xi8>
+    %dst = util.unfoldable_constant dense<1> : tensor<384x512xi32>
+    %0 = linalg.matmul ins(%lhs, %rhs : tensor<384x384xi8>, tensor<384x512xi8>) outs(%dst : tensor<384x512xi32>) -> tensor<384x512xi32>
+    return %0 : tensor<384x512xi32>
+}
+
+func.func @mmt4d_384x384x512_8x4x8_i8i8i32() -> tensor<48x64x8x8xi32> {
+    %lhs = util.unfoldable_constant dense<1> : tensor<48x96x8x4xi8>
+    %rhs = util.unfoldable_constant dense<1> : tensor<64x96x8x4xi8>
+    %dst = util.unfoldable_constant dense<1> : tensor<48x64x8x8xi32>
+    %0 = linalg.mmt4d ins(%lhs, %rhs : tensor<48x96x8x4xi8>, tensor<64x96x8x4xi8>) outs(%dst : tensor<48x64x8x8xi32>) -> tensor<48x64x8x8xi32>
+    return %0 : tensor<48x64x8x8xi32>
+}
+
+func.func @mmt4d_384x384x512_16x4x16_i8i8i32() -> tensor<24x32x16x16xi32> {
+    %lhs = util.unfoldable_constant dense<1> : tensor<24x96x16x4xi8>
+    %rhs = util.unfoldable_constant dense<1> : tensor<32x96x16x4xi8>
+    %dst = util.unfoldable_constant dense<1> : tensor<24x32x16x16xi32>
+    %0 = linalg.mmt4d ins(%lhs, %rhs : tensor<24x96x16x4xi8>, tensor<32x96x16x4xi8>) outs(%dst : tensor<24x32x16x16xi32>) -> tensor<24x32x16x16xi32>
+    return %0 : tensor<24x32x16x16xi32>
+}
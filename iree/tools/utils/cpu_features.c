@@ -122,7 +122,72 @@ static bool iree_cpu_features_aarch64_i8mm(iree_cpu_features_t* features) {
 
 typedef iree_cpu_features_t iree_cpu_features_t;
 
-#else  // not defined(IREE_ARCH_ARM_64)
+#elif defined(IREE_ARCH_X86_64)
+
+#if defined(IREE_COMPILER_MSVC)
+#include <immintrin.h>
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif  // IREE_COMPILER_MSVC
+
+// Unlike on aarch64, cpuid and xgetbv are unprivileged and cheap so we just
+// read everything we need once when the struct is allocated.
+struct iree_cpu_features_t {
+  uint32_t leaf1_ecx;
+  uint32_t leaf7_ebx;
+  uint32_t leaf7_ecx;
+  uint32_t leaf7_1_eax;
+  // True if the OS saves the YMM (resp. opmask and ZMM) register state, which
+  // is required to actually use AVX (resp. AVX-512) instructions.
+  bool has_ymm_state;
+  bool has_zmm_state;
+};
+
+static void iree_cpu_features_x86_64_cpuid(uint32_t leaf, uint32_t subleaf,
+                                           uint32_t out_regs[4]) {
+#if defined(IREE_COMPILER_MSVC)
+  __cpuidex((int*)out_regs, (int)leaf, (int)subleaf);
+#else
+  __cpuid_count(leaf, subleaf, out_regs[0], out_regs[1], out_regs[2],
+                out_regs[3]);
+#endif  // IREE_COMPILER_MSVC
+}
+
+static uint64_t iree_cpu_features_x86_64_xgetbv(void) {
+#if defined(IREE_COMPILER_MSVC)
+  return _xgetbv(0);
+#else
+  uint32_t eax = 0, edx = 0;
+  __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+  return ((uint64_t)edx << 32) | eax;
+#endif  // IREE_COMPILER_MSVC
+}
+
+static void iree_cpu_features_x86_64_initialize(
+    iree_cpu_features_t* features) {
+  uint32_t regs[4] = {0};  // eax, ebx, ecx, edx
+  iree_cpu_features_x86_64_cpuid(0, 0, regs);
+  const uint32_t max_leaf = regs[0];
+  if (max_leaf < 1) return;
+  iree_cpu_features_x86_64_cpuid(1, 0, regs);
+  features->leaf1_ecx = regs[2];
+  if (features->leaf1_ecx & (1u << 27)) {  // OSXSAVE
+    const uint64_t xcr0 = iree_cpu_features_x86_64_xgetbv();
+    features->has_ymm_state = (xcr0 & 0x06) == 0x06;
+    features->has_zmm_state = features->has_ymm_state && (xcr0 & 0xE0) == 0xE0;
+  }
+  if (max_leaf < 7) return;
+  iree_cpu_features_x86_64_cpuid(7, 0, regs);
+  const uint32_t max_leaf7_subleaf = regs[0];
+  features->leaf7_ebx = regs[1];
+  features->leaf7_ecx = regs[2];
+  if (max_leaf7_subleaf < 1) return;
+  iree_cpu_features_x86_64_cpuid(7, 1, regs);
+  features->leaf7_1_eax = regs[0];
+}
+
+#else  // not defined(IREE_ARCH_ARM_64) || defined(IREE_ARCH_X86_64)
 
 // Not-implemented case. Decided in PR #8316 to make it non-empty just to avoid
 // edge cases with empty structs.
@@ -134,8 +199,12 @@ struct iree_cpu_features_t {
 
 iree_status_t iree_cpu_features_allocate(iree_allocator_t allocator,
                                          iree_cpu_features_t** cpu_features) {
-  return iree_allocator_malloc(allocator, sizeof(iree_cpu_features_t),
-                               (void**)cpu_features);
+  IREE_RETURN_IF_ERROR(iree_allocator_malloc(
+      allocator, sizeof(iree_cpu_features_t), (void**)cpu_features));
+#if defined(IREE_ARCH_X86_64)
+  iree_cpu_features_x86_64_initialize(*cpu_features);
+#endif  // IREE_ARCH_X86_64
+  return iree_ok_status();
 }
 
 void iree_cpu_features_free(iree_allocator_t allocator,
@@ -159,6 +228,29 @@ iree_status_t iree_cpu_features_query(iree_cpu_features_t* cpu_features,
   }
 #endif  // IREE_ARCH_ARM_64
 
+#ifdef IREE_ARCH_X86_64
+  if (iree_string_view_equal(feature, iree_make_cstring_view("+fma"))) {
+    *result = cpu_features->has_ymm_state &&
+              (cpu_features->leaf1_ecx & (1u << 12));
+    return iree_ok_status();
+  }
+  if (iree_string_view_equal(feature, iree_make_cstring_view("+avxvnni"))) {
+    *result = cpu_features->has_ymm_state &&
+              (cpu_features->leaf7_1_eax & (1u << 4));
+    return iree_ok_status();
+  }
+  if (iree_string_view_equal(feature, iree_make_cstring_view("+avx512f"))) {
+    *result = cpu_features->has_zmm_state &&
+              (cpu_features->leaf7_ebx & (1u << 16));
+    return iree_ok_status();
+  }
+  if (iree_string_view_equal(feature, iree_make_cstring_view("+avx512vnni"))) {
+    *result = cpu_features->has_zmm_state &&
+              (cpu_features->leaf7_ecx & (1u << 11));
+    return iree_ok_status();
+  }
+#endif  // IREE_ARCH_X86_64
+
   return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
                           "Unhandled CPU feature: '%.*s'", (int)feature.size,
                           feature.data);
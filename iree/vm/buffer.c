@@ -82,7 +82,7 @@ IREE_API_EXPORT void iree_vm_buffer_initialize(iree_vm_buffer_access_t access,
 
 IREE_API_EXPORT void iree_vm_buffer_deinitialize(iree_vm_buffer_t* buffer) {
   IREE_ASSERT_ARGUMENT(buffer);
-  iree_atomic_ref_count_abort_if_uses(&buffer->ref_object.counter);
+  iree_vm_ref_object_abort_if_uses(buffer, &iree_vm_buffer_descriptor);
   iree_allocator_free(buffer->allocator, buffer->data.data);
 }
 
@@ -610,22 +610,41 @@ static iree_status_t iree_vm_bytecode_call_import_variadic(
 
 iree_status_t iree_vm_bytecode_dispatch(
     iree_vm_stack_t* stack, iree_vm_bytecode_module_t* module,
-    const iree_vm_function_call_t* call, iree_string_view_t cconv_arguments,
-    iree_string_view_t cconv_results, iree_vm_execution_result_t* out_result) {
+    const iree_vm_function_call_t* call, bool resume,
+    iree_string_view_t cconv_arguments, iree_string_view_t cconv_results,
+    iree_vm_execution_result_t* out_result) {
   memset(out_result, 0, sizeof(*out_result));
 
   // When required emit the dispatch tables here referencing the labels we are
   // defining below.
   DEFINE_DISPATCH_TABLES();
 
-  // Enter function (as this is the initial call).
-  // The callee's return will take care of storing the output registers when it
-  // actually does return, either immediately or in the future via a resume.
   iree_vm_stack_frame_t* current_frame = NULL;
   iree_vm_registers_t regs;
-  IREE_RETURN_IF_ERROR(
-      iree_vm_bytecode_external_enter(stack, call->function, cconv_arguments,
-                                      call->arguments, &current_frame, &regs));
+  int32_t entry_frame_depth = 0;
+  if (resume) {
+    // Resume execution in the frame that yielded. The frame PC was updated
+    // prior to yielding to point at the continuation.
+    current_frame = iree_vm_stack_current_frame(stack);
+    if (IREE_UNLIKELY(!current_frame ||
+                      current_frame->function.module != &module->interface)) {
+      return iree_make_status(IREE_STATUS_FAILED_PRECONDITION,
+                              "stack top is not a yielded frame of the module");
+    }
+    regs = iree_vm_bytecode_get_register_storage(current_frame);
+    entry_frame_depth = ((iree_vm_bytecode_frame_storage_t*)
+                             iree_vm_stack_frame_storage(current_frame))
+                            ->yield_entry_frame_depth;
+  } else {
+    // Enter function (as this is the initial call).
+    // The callee's return will take care of storing the output registers when
+    // it actually does return, either immediately or in the future via a
+    // resume.
+    IREE_RETURN_IF_ERROR(iree_vm_bytecode_external_enter(
+        stack, call->function, cconv_arguments, call->arguments,
+        &current_frame, &regs));
+    entry_frame_depth = current_frame->depth;
+  }
 
   // Primary dispatch state. This is our 'native stack frame' and really
   // just enough to make dereferencing common addresses (like the current
@@ -641,7 +660,6 @@ iree_status_t iree_vm_bytecode_dispatch(
       module->function_descriptor_table[current_frame->function.ordinal]
           .bytecode_offset;
   iree_vm_source_offset_t pc = current_frame->pc;
-  const int32_t entry_frame_depth = current_frame->depth;
 
   BEGIN_DISPATCH_CORE() {
     //===------------------------------------------------------------------===//
@@ -1494,6 +1512,13 @@ iree_status_t iree_vm_bytecode_dispatch(
       iree_vm_bytecode_dispatch_remap_branch_registers(regs, remap_list);
       pc = block_pc;
 
+      // Stash the continuation on the frame so that a resume picks up where
+      // we left off.
+      current_frame->pc = pc;
+      ((iree_vm_bytecode_frame_storage_t*)iree_vm_stack_frame_storage(
+           current_frame))
+          ->yield_entry_frame_depth = entry_frame_depth;
+
       // Return magic status code indicating a yield.
       // This isn't an error, though callers not supporting coroutines will
       // treat it as one and propagate it up.
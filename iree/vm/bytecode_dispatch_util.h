@@ -90,6 +90,11 @@ typedef struct iree_vm_bytecode_frame_storage_t {
   // Relative byte offsets from the head of this struct.
   iree_host_size_t i32_register_offset;
   iree_host_size_t ref_register_offset;
+
+  // Depth of the frame entered from the external caller when this frame
+  // yielded. Only valid on the top frame of a suspended stack and used to
+  // determine where execution returns to the caller upon resume.
+  int32_t yield_entry_frame_depth;
 } iree_vm_bytecode_frame_storage_t;
 
 // Interleaved src-dst register sets for branch register remapping.
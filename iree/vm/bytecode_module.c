@@ -720,6 +720,97 @@ static iree_status_t iree_vm_bytecode_module_alloc_state(
   return iree_ok_status();
 }
 
+static void iree_vm_bytecode_module_free_state(
+    void* self, iree_vm_module_state_t* module_state);
+
+// Forks the |parent_ref| global of |parent_state| into |out_ref| of |state|.
+// Returns IREE_STATUS_UNIMPLEMENTED if the referenced object may be mutated
+// in-place and cannot be copied.
+static iree_status_t iree_vm_bytecode_module_fork_global_ref(
+    iree_vm_bytecode_module_state_t* parent_state, iree_vm_ref_t* parent_ref,
+    iree_vm_bytecode_module_state_t* state, iree_vm_ref_t* out_ref) {
+  if (iree_vm_ref_is_null(parent_ref)) return iree_ok_status();
+
+  if (parent_ref->type == iree_vm_buffer_type_id()) {
+    iree_vm_buffer_t* buffer = iree_vm_buffer_deref(*parent_ref);
+    uintptr_t rodata_offset =
+        (uintptr_t)buffer - (uintptr_t)parent_state->rodata_ref_table;
+    if (rodata_offset <
+        parent_state->rodata_ref_count * sizeof(iree_vm_buffer_t)) {
+      iree_vm_buffer_t* rodata =
+          &state->rodata_ref_table[rodata_offset / sizeof(iree_vm_buffer_t)];
+      return iree_vm_ref_wrap_retain(rodata, iree_vm_buffer_type_id(),
+                                     out_ref);
+    } else if (!iree_all_bits_set(buffer->access,
+                                  IREE_VM_BUFFER_ACCESS_MUTABLE)) {
+      iree_vm_ref_retain(parent_ref, out_ref);
+      return iree_ok_status();
+    }
+    iree_vm_buffer_t* clone = NULL;
+    IREE_RETURN_IF_ERROR(iree_vm_buffer_clone(
+        buffer->access, buffer, 0, iree_vm_buffer_length(buffer),
+        state->allocator, &clone));
+    return iree_vm_ref_wrap_assign(clone, iree_vm_buffer_type_id(), out_ref);
+  }
+
+  if (iree_vm_ref_is_shareable(parent_ref)) {
+    iree_vm_ref_retain(parent_ref, out_ref);
+    return iree_ok_status();
+  }
+
+  iree_string_view_t type_name = iree_vm_ref_type_name(parent_ref->type);
+  return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                          "global of type '%.*s' cannot be forked",
+                          (int)type_name.size, type_name.data);
+}
+
+static iree_status_t iree_vm_bytecode_module_fork_state(
+    void* self, iree_vm_module_state_t* parent_module_state,
+    iree_allocator_t allocator, iree_vm_module_state_t** out_module_state) {
+  IREE_ASSERT_ARGUMENT(parent_module_state);
+  IREE_ASSERT_ARGUMENT(out_module_state);
+  *out_module_state = NULL;
+
+  // Rodata segments and imports are setup the same as any fresh state.
+  iree_vm_module_state_t* module_state = NULL;
+  IREE_RETURN_IF_ERROR(
+      iree_vm_bytecode_module_alloc_state(self, allocator, &module_state));
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_vm_bytecode_module_state_t* parent_state =
+      (iree_vm_bytecode_module_state_t*)parent_module_state;
+  iree_vm_bytecode_module_state_t* state =
+      (iree_vm_bytecode_module_state_t*)module_state;
+
+  // Primitive globals are (usually) a handful of bytes and are copied.
+  memcpy(state->rwdata_storage.data, parent_state->rwdata_storage.data,
+         state->rwdata_storage.data_length);
+
+  // Ref globals may only be shared with the parent when the objects they
+  // reference cannot be observably mutated by either state. Module rodata is
+  // remapped to our own rodata segments (as the parent ones live in its state),
+  // mutable buffers are cloned, and types registered as shareable (such as
+  // executables) or objects their type reports as immutable (such as constant
+  // device buffers) are retained. Anything else (lists, mutable device
+  // buffers, etc) may be mutated in-place and we fall back to running the
+  // module initializers.
+  iree_status_t status = iree_ok_status();
+  for (iree_host_size_t i = 0; i < state->global_ref_count; ++i) {
+    status = iree_vm_bytecode_module_fork_global_ref(
+        parent_state, &parent_state->global_ref_table[i], state,
+        &state->global_ref_table[i]);
+    if (!iree_status_is_ok(status)) break;
+  }
+  if (!iree_status_is_ok(status)) {
+    iree_vm_bytecode_module_free_state(self, module_state);
+    IREE_TRACE_ZONE_END(z0);
+    return status;
+  }
+
+  *out_module_state = module_state;
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
 static void iree_vm_bytecode_module_free_state(
     void* self, iree_vm_module_state_t* module_state) {
   if (!module_state) return;
@@ -793,9 +884,11 @@ static iree_status_t IREE_API_PTR iree_vm_bytecode_module_notify(
   return iree_ok_status();
 }
 
-static iree_status_t iree_vm_bytecode_module_begin_call(
+// Begins or resumes |call| by running the dispatch loop until the function
+// either returns (synchronous) or yields (asynchronous).
+static iree_status_t iree_vm_bytecode_module_dispatch_call(
     void* self, iree_vm_stack_t* stack, const iree_vm_function_call_t* call,
-    iree_vm_execution_result_t* out_result) {
+    bool resume, iree_vm_execution_result_t* out_result) {
   // NOTE: any work here adds directly to the invocation time. Avoid doing too
   // much work or touching too many unlikely-to-be-cached structures (such as
   // walking the FlatBuffer, which may cause page faults).
@@ -839,11 +932,25 @@ static iree_status_t iree_vm_bytecode_module_begin_call(
   // Jump into the dispatch routine to execute bytecode until the function
   // either returns (synchronous) or yields (asynchronous).
   iree_status_t status = iree_vm_bytecode_dispatch(
-      stack, module, call, cconv_arguments, cconv_results, out_result);
+      stack, module, call, resume, cconv_arguments, cconv_results, out_result);
   IREE_TRACE_ZONE_END(z0);
   return status;
 }
 
+static iree_status_t iree_vm_bytecode_module_begin_call(
+    void* self, iree_vm_stack_t* stack, const iree_vm_function_call_t* call,
+    iree_vm_execution_result_t* out_result) {
+  return iree_vm_bytecode_module_dispatch_call(self, stack, call,
+                                               /*resume=*/false, out_result);
+}
+
+static iree_status_t iree_vm_bytecode_module_resume_call(
+    void* self, iree_vm_stack_t* stack, const iree_vm_function_call_t* call,
+    iree_vm_execution_result_t* out_result) {
+  return iree_vm_bytecode_module_dispatch_call(self, stack, call,
+                                               /*resume=*/true, out_result);
+}
+
 IREE_API_EXPORT iree_status_t iree_vm_bytecode_module_create(
     iree_const_byte_span_t flatbuffer_data,
     iree_allocator_t flatbuffer_allocator, iree_allocator_t allocator,
@@ -918,9 +1025,11 @@ IREE_API_EXPORT iree_status_t iree_vm_bytecode_module_create(
 #endif  // IREE_VM_BACKTRACE_ENABLE
   module->interface.alloc_state = iree_vm_bytecode_module_alloc_state;
   module->interface.free_state = iree_vm_bytecode_module_free_state;
+  module->interface.fork_state = iree_vm_bytecode_module_fork_state;
   module->interface.resolve_import = iree_vm_bytecode_module_resolve_import;
   module->interface.notify = iree_vm_bytecode_module_notify;
   module->interface.begin_call = iree_vm_bytecode_module_begin_call;
+  module->interface.resume_call = iree_vm_bytecode_module_resume_call;
   module->interface.get_function_reflection_attr =
       iree_vm_bytecode_module_get_function_reflection_attr;
 
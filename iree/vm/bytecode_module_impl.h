@@ -7,6 +7,7 @@
 #ifndef IREE_VM_BYTECODE_MODULE_IMPL_H_
 #define IREE_VM_BYTECODE_MODULE_IMPL_H_
 
+#include <stdbool.h>
 #include <stdint.h>
 #include <string.h>
 
@@ -120,12 +121,15 @@ typedef struct iree_vm_bytecode_module_state_t {
   iree_allocator_t allocator;
 } iree_vm_bytecode_module_state_t;
 
-// Begins (or resumes) execution of the current frame and continues until
-// either a yield or return. |out_result| will contain the result status for
-// continuation, if needed.
+// Begins execution of |call| and continues until either a yield or return.
+// When |resume| is true the call has previously yielded and execution resumes
+// at the current (top) frame of |stack| instead of entering the function.
+// Yields are indicated by returning IREE_STATUS_DEFERRED. |out_result| will
+// contain the result status for continuation, if needed.
 iree_status_t iree_vm_bytecode_dispatch(iree_vm_stack_t* stack,
                                         iree_vm_bytecode_module_t* module,
                                         const iree_vm_function_call_t* call,
+                                        bool resume,
                                         iree_string_view_t cconv_arguments,
                                         iree_string_view_t cconv_results,
                                         iree_vm_execution_result_t* out_result);
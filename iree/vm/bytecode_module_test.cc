@@ -10,10 +10,123 @@
 
 #include "iree/vm/bytecode_module.h"
 
+#include <array>
+
+#include "iree/base/status_cc.h"
 #include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+#include "iree/vm/api.h"
+#include "iree/vm/bytecode_module_test_module_c.h"
+#include "iree/vm/ref_cc.h"
 
+namespace iree {
 namespace {
 
-// TODO(benvanik): bytecode_module_test.cc for flatbuffer/module implementation.
+// Values observed by the @load function in bytecode_module_test.mlir.
+struct LoadedValues {
+  int32_t value;
+  int32_t buffer_value;
+  int32_t rodata_value;
+};
+
+class VMBytecodeModuleTest : public ::testing::Test {
+ protected:
+  virtual void SetUp() {
+    IREE_CHECK_OK(iree_vm_instance_create(iree_allocator_system(), &instance_));
+
+    const auto* module_file_toc = iree_vm_bytecode_module_test_module_create();
+    IREE_CHECK_OK(iree_vm_bytecode_module_create(
+        iree_const_byte_span_t{
+            reinterpret_cast<const uint8_t*>(module_file_toc->data),
+            module_file_toc->size},
+        iree_allocator_null(), iree_allocator_system(), &module_));
+
+    IREE_CHECK_OK(iree_vm_context_create_with_modules(
+        instance_, IREE_VM_CONTEXT_FLAG_NONE, &module_, 1,
+        iree_allocator_system(), &context_));
+  }
+
+  virtual void TearDown() {
+    iree_vm_context_release(context_);
+    iree_vm_module_release(module_);
+    iree_vm_instance_release(instance_);
+  }
+
+  Status Store(iree_vm_context_t* context, int32_t value) {
+    iree_vm_function_t function;
+    IREE_RETURN_IF_ERROR(iree_vm_context_resolve_function(
+        context, iree_make_cstring_view("bytecode_module_test.store"),
+        &function));
+    vm::ref<iree_vm_list_t> input_list;
+    IREE_RETURN_IF_ERROR(iree_vm_list_create(
+        /*element_type=*/nullptr, 1, iree_allocator_system(), &input_list));
+    auto arg0_value = iree_vm_value_make_i32(value);
+    IREE_RETURN_IF_ERROR(
+        iree_vm_list_push_value(input_list.get(), &arg0_value));
+    return iree_vm_invoke(context, function, IREE_VM_INVOCATION_FLAG_NONE,
+                          /*policy=*/nullptr, input_list.get(),
+                          /*outputs=*/nullptr, iree_allocator_system());
+  }
+
+  StatusOr<LoadedValues> Load(iree_vm_context_t* context) {
+    iree_vm_function_t function;
+    IREE_RETURN_IF_ERROR(iree_vm_context_resolve_function(
+        context, iree_make_cstring_view("bytecode_module_test.load"),
+        &function));
+    vm::ref<iree_vm_list_t> output_list;
+    IREE_RETURN_IF_ERROR(iree_vm_list_create(
+        /*element_type=*/nullptr, 3, iree_allocator_system(), &output_list));
+    IREE_RETURN_IF_ERROR(iree_vm_invoke(
+        context, function, IREE_VM_INVOCATION_FLAG_NONE, /*policy=*/nullptr,
+        /*inputs=*/nullptr, output_list.get(), iree_allocator_system()));
+    std::array<iree_vm_value_t, 3> results;
+    for (size_t i = 0; i < results.size(); ++i) {
+      IREE_RETURN_IF_ERROR(
+          iree_vm_list_get_value(output_list.get(), i, &results[i]));
+    }
+    return LoadedValues{results[0].i32, results[1].i32, results[2].i32};
+  }
+
+  iree_vm_instance_t* instance_ = nullptr;
+  iree_vm_module_t* module_ = nullptr;
+  iree_vm_context_t* context_ = nullptr;
+};
+
+// Tests that a forked context starts from the parent globals and that stores
+// into globals or mutable buffers referenced by them are not observed across
+// the contexts.
+TEST_F(VMBytecodeModuleTest, ForkIsolatesMutableGlobals) {
+  IREE_ASSERT_OK(Store(context_, 100));
+
+  iree_vm_context_t* forked_context = nullptr;
+  IREE_ASSERT_OK(iree_vm_context_fork(context_, iree_allocator_system(),
+                                      &forked_context));
+
+  IREE_ASSERT_OK_AND_ASSIGN(auto forked_values, Load(forked_context));
+  EXPECT_EQ(forked_values.value, 100);
+  EXPECT_EQ(forked_values.buffer_value, 100);
+  EXPECT_EQ(forked_values.rodata_value, 4);
+
+  // Mutating the child must not change the parent.
+  IREE_ASSERT_OK(Store(forked_context, 200));
+  IREE_ASSERT_OK_AND_ASSIGN(auto parent_values, Load(context_));
+  EXPECT_EQ(parent_values.value, 100);
+  EXPECT_EQ(parent_values.buffer_value, 100);
+
+  // Mutating the parent must not change the child.
+  IREE_ASSERT_OK(Store(context_, 300));
+  IREE_ASSERT_OK_AND_ASSIGN(forked_values, Load(forked_context));
+  EXPECT_EQ(forked_values.value, 200);
+  EXPECT_EQ(forked_values.buffer_value, 200);
+
+  // The fork references its own rodata and remains usable after the parent
+  // state is freed.
+  iree_vm_context_release(context_);
+  context_ = forked_context;
+  IREE_ASSERT_OK_AND_ASSIGN(forked_values, Load(context_));
+  EXPECT_EQ(forked_values.buffer_value, 200);
+  EXPECT_EQ(forked_values.rodata_value, 4);
+}
 
 }  // namespace
+}  // namespace iree
@@ -0,0 +1,45 @@
+// Module used by bytecode_module_test.cc to verify module state handling.
+vm.module @bytecode_module_test {
+
+  vm.rodata private @rodata dense<[1, 2, 3, 4]> : tensor<4xi32>
+
+  vm.global.i32 private mutable @value = 0 : i32
+  vm.global.ref private mutable @rodata_buffer : !vm.buffer
+  vm.global.ref private mutable @mutable_buffer : !vm.buffer
+
+  vm.initializer {
+    %rodata = vm.const.ref.rodata @rodata : !vm.buffer
+    vm.global.store.ref %rodata, @rodata_buffer : !vm.buffer
+    %c0 = vm.const.i32 0
+    %c16 = vm.const.i32 16
+    %buffer = vm.buffer.alloc %c16 : !vm.buffer
+    vm.buffer.copy %rodata, %c0, %buffer, %c0, %c16 : !vm.buffer -> !vm.buffer
+    vm.global.store.ref %buffer, @mutable_buffer : !vm.buffer
+    vm.return
+  }
+
+  // Stores |arg0| into the primitive global and the mutable buffer global.
+  vm.export @store
+  vm.func @store(%arg0 : i32) {
+    vm.global.store.i32 %arg0, @value : i32
+    %buffer = vm.global.load.ref @mutable_buffer : !vm.buffer
+    %c0 = vm.const.i32 0
+    vm.buffer.store.i32 %arg0, %buffer[%c0] : i32 -> !vm.buffer
+    vm.return
+  }
+
+  // Returns the primitive global, the first element of the mutable buffer
+  // global, and the last element of the rodata buffer global.
+  vm.export @load
+  vm.func @load() -> (i32, i32, i32) {
+    %value = vm.global.load.i32 @value : i32
+    %c0 = vm.const.i32 0
+    %buffer = vm.global.load.ref @mutable_buffer : !vm.buffer
+    %buffer_value = vm.buffer.load.i32 %buffer[%c0] : !vm.buffer -> i32
+    %c12 = vm.const.i32 12
+    %rodata = vm.global.load.ref @rodata_buffer : !vm.buffer
+    %rodata_value = vm.buffer.load.i32 %rodata[%c12] : !vm.buffer -> i32
+    vm.return %value, %buffer_value, %rodata_value : i32, i32, i32
+  }
+
+}
@@ -33,10 +33,36 @@ struct iree_vm_context_t {
     iree_vm_module_t** modules;
     iree_vm_module_state_t** module_states;
   } list;
+
+  // Stack storage reused across invocations. Only a single block is pooled:
+  // in the common case of one invocation at a time per context this avoids
+  // all host allocations for stacks and concurrent invocations fall back to
+  // storage on their own host stack.
+  struct {
+    // iree_vm_context_stack_storage_t* of the pooled storage, if any.
+    iree_atomic_intptr_t storage;
+    // Capacity of the most recently pooled storage.
+    iree_atomic_intptr_t storage_size;
+    iree_atomic_int32_t reuse_count;
+    iree_atomic_int32_t resize_count;
+  } stack_pool;
 };
 
+// Header of a pooled stack storage block. The usable storage immediately
+// follows the header at IREE_VM_CONTEXT_STACK_STORAGE_OFFSET.
+typedef struct iree_vm_context_stack_storage_t {
+  // Size, in bytes, of the usable storage following the header.
+  iree_host_size_t capacity;
+} iree_vm_context_stack_storage_t;
+
+#define IREE_VM_CONTEXT_STACK_STORAGE_OFFSET \
+  iree_host_align(sizeof(iree_vm_context_stack_storage_t), iree_max_align_t)
+
 static void iree_vm_context_destroy(iree_vm_context_t* context);
 
+// Process-unique counter used to assign context IDs.
+static iree_atomic_int32_t iree_vm_context_next_id = IREE_ATOMIC_VAR_INIT(1);
+
 // Runs a single `() -> ()` function from the module if it exists.
 static iree_status_t iree_vm_context_run_function(
     iree_vm_stack_t* stack, iree_vm_module_t* module,
@@ -228,9 +254,8 @@ IREE_API_EXPORT iree_status_t iree_vm_context_create_with_modules(
   iree_vm_instance_retain(context->instance);
   context->allocator = allocator;
 
-  static iree_atomic_int32_t next_context_id = IREE_ATOMIC_VAR_INIT(1);
-  context->context_id = iree_atomic_fetch_add_int32(&next_context_id, 1,
-                                                    iree_memory_order_seq_cst);
+  context->context_id = iree_atomic_fetch_add_int32(
+      &iree_vm_context_next_id, 1, iree_memory_order_seq_cst);
 
   // TODO(benvanik): allow for non-frozen but static contexts.
   context->is_frozen = module_count > 0;
@@ -258,6 +283,111 @@ IREE_API_EXPORT iree_status_t iree_vm_context_create_with_modules(
   return iree_ok_status();
 }
 
+// Forks the state of |module| from |parent_state| into |context|.
+// Modules that cannot fork have fresh state allocated and run their
+// initializers as during normal registration.
+static iree_status_t iree_vm_context_fork_module(
+    iree_vm_context_t* context, iree_vm_stack_t* stack,
+    iree_vm_module_t* module, iree_vm_module_state_t* parent_state) {
+  iree_host_size_t index = context->list.count;
+  context->list.modules[index] = module;
+  context->list.module_states[index] = NULL;
+  iree_vm_module_retain(module);
+
+  bool needs_init = false;
+  iree_vm_module_state_t* module_state = NULL;
+  iree_status_t status = iree_status_from_code(IREE_STATUS_UNIMPLEMENTED);
+  if (module->fork_state) {
+    status = module->fork_state(module->self, parent_state, context->allocator,
+                                &module_state);
+  }
+  if (iree_status_is_unimplemented(status)) {
+    iree_status_ignore(status);
+    needs_init = true;
+    status =
+        module->alloc_state(module->self, context->allocator, &module_state);
+  }
+  IREE_RETURN_IF_ERROR(status);
+  context->list.module_states[index] = module_state;
+
+  IREE_RETURN_IF_ERROR(
+      iree_vm_context_resolve_module_imports(context, module, module_state));
+  ++context->list.count;
+
+  if (needs_init) {
+    IREE_RETURN_IF_ERROR(iree_vm_context_run_function(
+        stack, module, iree_make_cstring_view("__init")));
+  }
+  return iree_ok_status();
+}
+
+IREE_API_EXPORT iree_status_t iree_vm_context_fork(
+    iree_vm_context_t* parent, iree_allocator_t allocator,
+    iree_vm_context_t** out_context) {
+  IREE_ASSERT_ARGUMENT(parent);
+  IREE_ASSERT_ARGUMENT(out_context);
+  *out_context = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // Create an empty static context with capacity for all parent modules.
+  iree_host_size_t module_count = parent->list.count;
+  iree_host_size_t context_size =
+      sizeof(iree_vm_context_t) + sizeof(iree_vm_module_t*) * module_count +
+      sizeof(iree_vm_module_state_t*) * module_count;
+  iree_vm_context_t* context = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(allocator, context_size, (void**)&context));
+  iree_atomic_ref_count_init(&context->ref_count);
+  context->instance = parent->instance;
+  iree_vm_instance_retain(context->instance);
+  context->allocator = allocator;
+  context->context_id = iree_atomic_fetch_add_int32(
+      &iree_vm_context_next_id, 1, iree_memory_order_seq_cst);
+  context->is_frozen = 1;
+  context->is_static = 1;
+  context->flags = parent->flags;
+  uint8_t* p = (uint8_t*)context + sizeof(iree_vm_context_t);
+  context->list.modules = (iree_vm_module_t**)p;
+  p += sizeof(iree_vm_module_t*) * module_count;
+  context->list.module_states = (iree_vm_module_state_t**)p;
+  context->list.count = 0;
+  context->list.capacity = module_count;
+
+  // VM stack used to call into __init for modules that cannot fork.
+  IREE_VM_INLINE_STACK_INITIALIZE(
+      stack,
+      context->flags & IREE_VM_CONTEXT_FLAG_TRACE_EXECUTION
+          ? IREE_VM_INVOCATION_FLAG_TRACE_EXECUTION
+          : IREE_VM_INVOCATION_FLAG_NONE,
+      iree_vm_context_state_resolver(context), context->allocator);
+
+  // Fork modules in registration order so that imports resolve as they did in
+  // the parent.
+  iree_status_t status = iree_ok_status();
+  for (iree_host_size_t i = 0; i < module_count; ++i) {
+    status =
+        iree_vm_context_fork_module(context, stack, parent->list.modules[i],
+                                    parent->list.module_states[i]);
+    if (!iree_status_is_ok(status)) break;
+  }
+
+  iree_vm_stack_deinitialize(stack);
+
+  if (iree_status_is_ok(status)) {
+    *out_context = context;
+  } else {
+    // Account for a module that was partially forked before failing so that
+    // it is released along with the rest.
+    if (context->list.count < module_count &&
+        context->list.modules[context->list.count]) {
+      ++context->list.count;
+    }
+    iree_vm_context_destroy(context);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
 static void iree_vm_context_destroy(iree_vm_context_t* context) {
   if (!context) return;
 
@@ -276,6 +406,11 @@ static void iree_vm_context_destroy(iree_vm_context_t* context) {
     context->list.module_states = NULL;
   }
 
+  iree_vm_context_stack_storage_t* pooled_storage =
+      (iree_vm_context_stack_storage_t*)iree_atomic_exchange_intptr(
+          &context->stack_pool.storage, 0, iree_memory_order_acquire);
+  iree_allocator_free(context->allocator, pooled_storage);
+
   iree_vm_instance_release(context->instance);
   context->instance = NULL;
 
@@ -488,6 +623,113 @@ IREE_API_EXPORT iree_status_t iree_vm_context_resolve_function(
                           (int)full_name.size, full_name.data);
 }
 
+// Allocates stack storage with room for |capacity| bytes of stack.
+static iree_status_t iree_vm_context_allocate_stack_storage(
+    iree_vm_context_t* context, iree_host_size_t capacity,
+    iree_vm_context_stack_storage_t** out_storage) {
+  *out_storage = NULL;
+  iree_vm_context_stack_storage_t* storage = NULL;
+  IREE_RETURN_IF_ERROR(iree_allocator_malloc(
+      context->allocator, IREE_VM_CONTEXT_STACK_STORAGE_OFFSET + capacity,
+      (void**)&storage));
+  storage->capacity = capacity;
+  *out_storage = storage;
+  return iree_ok_status();
+}
+
+IREE_API_EXPORT iree_status_t iree_vm_context_acquire_stack_storage(
+    iree_vm_context_t* context, iree_byte_span_t* out_storage) {
+  IREE_ASSERT_ARGUMENT(context);
+  IREE_ASSERT_ARGUMENT(out_storage);
+  *out_storage = iree_make_byte_span(NULL, 0);
+
+  iree_vm_context_stack_storage_t* storage =
+      (iree_vm_context_stack_storage_t*)iree_atomic_exchange_intptr(
+          &context->stack_pool.storage, 0, iree_memory_order_acquire);
+  if (storage) {
+    iree_atomic_fetch_add_int32(&context->stack_pool.reuse_count, 1,
+                                iree_memory_order_relaxed);
+  } else if (iree_atomic_load_intptr(&context->stack_pool.storage_size,
+                                     iree_memory_order_relaxed) == 0) {
+    // Pool has not been populated yet (first invocation); the storage will be
+    // returned to the pool on release.
+    IREE_RETURN_IF_ERROR(iree_vm_context_allocate_stack_storage(
+        context, IREE_VM_STACK_DEFAULT_SIZE, &storage));
+  } else {
+    // Pooled storage is in use by another invocation; the caller provides its
+    // own storage instead of us hitting the host allocator.
+    return iree_ok_status();
+  }
+
+  *out_storage = iree_make_byte_span(
+      (uint8_t*)storage + IREE_VM_CONTEXT_STACK_STORAGE_OFFSET,
+      storage->capacity);
+  return iree_ok_status();
+}
+
+IREE_API_EXPORT void iree_vm_context_release_stack_storage(
+    iree_vm_context_t* context, iree_byte_span_t storage,
+    const iree_vm_stack_statistics_t* statistics) {
+  IREE_ASSERT_ARGUMENT(context);
+  IREE_ASSERT_ARGUMENT(statistics);
+  if (!storage.data) return;
+  iree_vm_context_stack_storage_t* block =
+      (iree_vm_context_stack_storage_t*)(storage.data -
+                                         IREE_VM_CONTEXT_STACK_STORAGE_OFFSET);
+
+  if (statistics->resize_count > 0) {
+    // The stack outgrew the storage; replace it with storage large enough to
+    // hold the peak so the next invocation does not need to grow.
+    iree_atomic_fetch_add_int32(&context->stack_pool.resize_count,
+                                (int32_t)statistics->resize_count,
+                                iree_memory_order_relaxed);
+    iree_host_size_t new_capacity = iree_host_align(
+        iree_min(statistics->peak_storage_size, IREE_VM_STACK_MAX_SIZE),
+        iree_max_align_t);
+    if (new_capacity > block->capacity) {
+      iree_allocator_free(context->allocator, block);
+      block = NULL;
+      IREE_IGNORE_ERROR(iree_vm_context_allocate_stack_storage(
+          context, new_capacity, &block));
+      if (!block) {
+        // Let the next invocation repopulate the pool.
+        iree_atomic_store_intptr(&context->stack_pool.storage_size, 0,
+                                 iree_memory_order_relaxed);
+        return;
+      }
+    }
+  }
+
+  // Return the storage to the pool; if another invocation has already returned
+  // storage we drop ours. The block may be acquired by another thread as soon
+  // as it is in the pool so we must not touch it after the exchange.
+  iree_host_size_t block_capacity = block->capacity;
+  intptr_t expected = 0;
+  if (!iree_atomic_compare_exchange_strong_intptr(
+          &context->stack_pool.storage, &expected, (intptr_t)block,
+          iree_memory_order_release, iree_memory_order_relaxed)) {
+    iree_allocator_free(context->allocator, block);
+    return;
+  }
+  iree_atomic_store_intptr(&context->stack_pool.storage_size,
+                           (intptr_t)block_capacity,
+                           iree_memory_order_relaxed);
+}
+
+IREE_API_EXPORT iree_vm_context_stack_statistics_t
+iree_vm_context_query_stack_statistics(iree_vm_context_t* context) {
+  IREE_ASSERT_ARGUMENT(context);
+  iree_vm_context_stack_statistics_t statistics;
+  memset(&statistics, 0, sizeof(statistics));
+  statistics.reuse_count = (uint32_t)iree_atomic_load_int32(
+      &context->stack_pool.reuse_count, iree_memory_order_relaxed);
+  statistics.resize_count = (uint32_t)iree_atomic_load_int32(
+      &context->stack_pool.resize_count, iree_memory_order_relaxed);
+  statistics.storage_size = (iree_host_size_t)iree_atomic_load_intptr(
+      &context->stack_pool.storage_size, iree_memory_order_relaxed);
+  return statistics;
+}
+
 // Calls the '__notify(i32)' function in |module|, if present.
 static iree_status_t iree_vm_context_call_module_notify(
     iree_vm_stack_t* stack, iree_vm_module_t* module,
@@ -60,6 +60,28 @@ IREE_API_EXPORT iree_status_t iree_vm_context_create_with_modules(
     iree_vm_module_t** modules, iree_host_size_t module_count,
     iree_allocator_t allocator, iree_vm_context_t** out_context);
 
+// Creates a new context by forking an existing |parent| context.
+// The new context has the same modules registered as the parent and each
+// module state is forked from the parent state: resources that
+// iree_vm_ref_is_shareable reports as shareable (such as executables, layouts,
+// and constant device buffers referenced by globals) are shared with the
+// parent and host-side mutable state (primitive globals and mutable buffers)
+// is copied. Module initializers are not run for modules that support forking,
+// making this significantly cheaper than creating a new context with the same
+// modules.
+//
+// Modules that do not support forking or whose state references objects that
+// cannot be copied (such as lists or mutable device buffers) are instead
+// initialized as if they were newly registered and do not observe the parent
+// state.
+//
+// The parent must not be executing concurrently with the fork. After forking
+// the two contexts are independent and either may be released first.
+// |out_context| must be released by the caller.
+IREE_API_EXPORT iree_status_t iree_vm_context_fork(
+    iree_vm_context_t* parent, iree_allocator_t allocator,
+    iree_vm_context_t** out_context);
+
 // Retains the given |context| for the caller.
 IREE_API_EXPORT void iree_vm_context_retain(iree_vm_context_t* context);
 
@@ -106,6 +128,40 @@ IREE_API_EXPORT iree_status_t iree_vm_context_resolve_function(
     const iree_vm_context_t* context, iree_string_view_t full_name,
     iree_vm_function_t* out_function);
 
+// Statistics for the stack storage pooled by a context across invocations.
+typedef struct iree_vm_context_stack_statistics_t {
+  // Total number of invocations that reused pooled stack storage.
+  uint32_t reuse_count;
+  // Total number of times a stack had to grow via the host allocator while
+  // executing with pooled storage. Growth only happens when an invocation
+  // exceeds the peak stack size of all prior invocations.
+  uint32_t resize_count;
+  // Size, in bytes, of the currently pooled stack storage.
+  iree_host_size_t storage_size;
+} iree_vm_context_stack_statistics_t;
+
+// Acquires stack storage from the pool maintained by |context|.
+// The storage is sized to the peak stack usage of prior invocations such that
+// repeated invocations of the same functions will not need to grow the stack.
+// If the pooled storage is in use by another invocation |out_storage| is set
+// to an empty span and the caller must provide its own storage (such as a
+// IREE_VM_STACK_DEFAULT_SIZE buffer on the host stack). The storage must be
+// returned with iree_vm_context_release_stack_storage once the stack using it
+// has been deinitialized; releasing an empty span is a no-op.
+IREE_API_EXPORT iree_status_t iree_vm_context_acquire_stack_storage(
+    iree_vm_context_t* context, iree_byte_span_t* out_storage);
+
+// Returns |storage| acquired with iree_vm_context_acquire_stack_storage back
+// to the |context| pool. |statistics| from the stack that used the storage are
+// used to resize the pooled storage if the stack had to grow.
+IREE_API_EXPORT void iree_vm_context_release_stack_storage(
+    iree_vm_context_t* context, iree_byte_span_t storage,
+    const iree_vm_stack_statistics_t* statistics);
+
+// Returns statistics for the stack storage pool of |context|.
+IREE_API_EXPORT iree_vm_context_stack_statistics_t
+iree_vm_context_query_stack_statistics(iree_vm_context_t* context);
+
 // Notifies all modules in the context of a system signal.
 IREE_API_EXPORT iree_status_t iree_vm_context_notify(iree_vm_context_t* context,
                                                      iree_vm_signal_t signal);
@@ -11,6 +11,7 @@
 #include <string.h>
 
 #include "iree/base/api.h"
+#include "iree/base/internal/atomics.h"
 #include "iree/base/tracing.h"
 #include "iree/vm/ref.h"
 #include "iree/vm/stack.h"
@@ -147,8 +148,8 @@ static iree_status_t iree_vm_invoke_marshal_outputs(
 // TODO(benvanik): implement this as an iree_vm_invocation_t sequence.
 static iree_status_t iree_vm_invoke_within(
     iree_vm_context_t* context, iree_vm_stack_t* stack,
-    iree_vm_function_t function, const iree_vm_invocation_policy_t* policy,
-    iree_vm_list_t* inputs, iree_vm_list_t* outputs) {
+    iree_vm_function_t function, iree_vm_list_t* inputs,
+    iree_vm_list_t* outputs) {
   IREE_ASSERT_ARGUMENT(context);
   IREE_ASSERT_ARGUMENT(stack);
 
@@ -187,6 +188,12 @@ static iree_status_t iree_vm_invoke_within(
   iree_vm_execution_result_t result;
   iree_status_t status =
       function.module->begin_call(function.module->self, stack, &call, &result);
+  while (iree_status_is_deferred(status)) {
+    // Yielded; there's nothing else for us to do on this thread so resume
+    // immediately.
+    status = function.module->resume_call(function.module->self, stack, &call,
+                                          &result);
+  }
   if (!iree_status_is_ok(status)) {
     iree_vm_function_call_release(&call, &signature);
     return status;
@@ -204,6 +211,10 @@ IREE_API_EXPORT iree_status_t iree_vm_invoke(
     iree_vm_invocation_flags_t flags, const iree_vm_invocation_policy_t* policy,
     iree_vm_list_t* inputs, iree_vm_list_t* outputs,
     iree_allocator_t allocator) {
+  if (policy) {
+    return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                            "invocation policies are not yet supported");
+  }
   IREE_TRACE_ZONE_BEGIN(z0);
 
   // Force tracing if specified on the context.
@@ -211,16 +222,357 @@ IREE_API_EXPORT iree_status_t iree_vm_invoke(
     flags |= IREE_VM_INVOCATION_FLAG_TRACE_EXECUTION;
   }
 
-  // Allocate a VM stack on the host stack and initialize it.
-  IREE_VM_INLINE_STACK_INITIALIZE(
-      stack, flags, iree_vm_context_state_resolver(context), allocator);
-  iree_status_t status =
-      iree_vm_invoke_within(context, stack, function, policy, inputs, outputs);
+  // Acquire stack storage pooled by the context. The pool sizes the storage to
+  // the peak usage of prior invocations so that repeated invocations run
+  // without any stack growth (and the host allocator traffic that implies).
+  // If another invocation is using the pooled storage we run on the host stack.
+  uint8_t inline_storage[IREE_VM_STACK_DEFAULT_SIZE];
+  iree_byte_span_t stack_storage = iree_make_byte_span(NULL, 0);
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_vm_context_acquire_stack_storage(context, &stack_storage));
+  iree_vm_stack_t* stack = NULL;
+  iree_status_t status = iree_vm_stack_initialize(
+      stack_storage.data
+          ? stack_storage
+          : iree_make_byte_span(inline_storage, sizeof(inline_storage)),
+      flags, iree_vm_context_state_resolver(context), allocator, &stack);
+  iree_vm_stack_statistics_t stack_statistics;
+  memset(&stack_statistics, 0, sizeof(stack_statistics));
+  if (iree_status_is_ok(status)) {
+    status = iree_vm_invoke_within(context, stack, function, inputs, outputs);
+    if (!iree_status_is_ok(status)) {
+      status = IREE_VM_STACK_ANNOTATE_BACKTRACE_IF_ENABLED(stack, status);
+    }
+    stack_statistics = iree_vm_stack_query_statistics(stack);
+    iree_vm_stack_deinitialize(stack);
+  }
+  iree_vm_context_release_stack_storage(context, stack_storage,
+                                        &stack_statistics);
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+//===----------------------------------------------------------------------===//
+// iree_vm_invocation_t
+//===----------------------------------------------------------------------===//
+
+struct iree_vm_invocation_t {
+  iree_atomic_ref_count_t ref_count;
+  iree_allocator_t allocator;
+
+  // Context the invocation executes within; retained.
+  iree_vm_context_t* context;
+
+  iree_vm_function_signature_t signature;
+  iree_string_view_t cconv_results;
+
+  // Call passed to begin_call/resume_call. The argument and result buffers
+  // are allocated inline after the invocation struct.
+  iree_vm_function_call_t call;
+
+  // Stack retained across yields. Its storage is acquired from the context
+  // pool when the invocation begins and returned when it completes. If the
+  // pooled storage was in use |stack_storage| is empty and the stack owns its
+  // own allocation.
+  iree_byte_span_t stack_storage;
+  iree_vm_stack_t* stack;
+
+  // True once begin_call has been issued; subsequent steps resume.
+  bool has_begun;
+
+  // IREE_STATUS_UNAVAILABLE while in-flight and the final (owned) status once
+  // the invocation has completed.
+  iree_status_t status;
+
+  // Outputs marshaled from the call results upon successful completion.
+  iree_vm_list_t* outputs;
+};
+
+static bool iree_vm_invocation_is_completed(
+    const iree_vm_invocation_t* invocation) {
+  return !iree_status_is_unavailable(invocation->status);
+}
+
+IREE_API_EXPORT iree_status_t iree_vm_invocation_create(
+    iree_vm_context_t* context, iree_vm_function_t function,
+    iree_vm_invocation_flags_t flags, const iree_vm_list_t* inputs,
+    iree_allocator_t allocator, iree_vm_invocation_t** out_invocation) {
+  IREE_ASSERT_ARGUMENT(context);
+  IREE_ASSERT_ARGUMENT(out_invocation);
+  *out_invocation = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // Force tracing if specified on the context.
+  if (iree_vm_context_flags(context) & IREE_VM_CONTEXT_FLAG_TRACE_EXECUTION) {
+    flags |= IREE_VM_INVOCATION_FLAG_TRACE_EXECUTION;
+  }
+
+  iree_vm_function_signature_t signature =
+      iree_vm_function_signature(&function);
+  iree_string_view_t cconv_arguments = iree_string_view_empty();
+  iree_string_view_t cconv_results = iree_string_view_empty();
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_vm_function_call_get_cconv_fragments(
+              &signature, &cconv_arguments, &cconv_results));
+  iree_host_size_t arguments_size = 0;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_vm_function_call_compute_cconv_fragment_size(
+              cconv_arguments, /*segment_size_list=*/NULL, &arguments_size));
+  iree_host_size_t results_size = 0;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_vm_function_call_compute_cconv_fragment_size(
+              cconv_results, /*segment_size_list=*/NULL, &results_size));
+
+  // Allocate the invocation with the ABI buffers inline.
+  iree_host_size_t arguments_offset =
+      iree_host_align(sizeof(iree_vm_invocation_t), iree_max_align_t);
+  iree_host_size_t results_offset =
+      arguments_offset + iree_host_align(arguments_size, iree_max_align_t);
+  iree_host_size_t total_size = results_offset + results_size;
+  iree_vm_invocation_t* invocation = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(allocator, total_size, (void**)&invocation));
+  memset(invocation, 0, total_size);
+  iree_atomic_ref_count_init(&invocation->ref_count);
+  invocation->allocator = allocator;
+  invocation->context = context;
+  iree_vm_context_retain(context);
+  invocation->signature = signature;
+  invocation->cconv_results = cconv_results;
+  invocation->call.function = function;
+  invocation->call.arguments = iree_make_byte_span(
+      (uint8_t*)invocation + arguments_offset, arguments_size);
+  invocation->call.results = iree_make_byte_span(
+      (uint8_t*)invocation + results_offset, results_size);
+  invocation->status = iree_status_from_code(IREE_STATUS_UNAVAILABLE);
+
+  // Marshal the inputs now so that the caller may reuse the list immediately.
+  // Refs are retained by the arguments buffer until the call begins.
+  iree_status_t status = iree_vm_invoke_marshal_inputs(
+      cconv_arguments, (iree_vm_list_t*)inputs, invocation->call.arguments);
+
+  // Setup the stack that will hold the invocation state across yields.
+  if (iree_status_is_ok(status)) {
+    status = iree_vm_context_acquire_stack_storage(context,
+                                                   &invocation->stack_storage);
+  }
+  if (iree_status_is_ok(status)) {
+    if (invocation->stack_storage.data) {
+      status = iree_vm_stack_initialize(
+          invocation->stack_storage, flags,
+          iree_vm_context_state_resolver(context), allocator,
+          &invocation->stack);
+    } else {
+      // The pooled storage is in use by another invocation and the stack must
+      // outlive this call so it cannot live on the host stack.
+      status = iree_vm_stack_allocate(flags,
+                                      iree_vm_context_state_resolver(context),
+                                      allocator, &invocation->stack);
+    }
+  }
+
+  if (iree_status_is_ok(status)) {
+    *out_invocation = invocation;
+  } else {
+    iree_status_ignore(iree_vm_invocation_release(invocation));
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+// Tears down the stack and returns its storage to the context.
+static void iree_vm_invocation_release_stack(iree_vm_invocation_t* invocation) {
+  if (invocation->stack && !invocation->stack_storage.data) {
+    iree_vm_stack_free(invocation->stack);
+    invocation->stack = NULL;
+  } else if (invocation->stack) {
+    iree_vm_stack_statistics_t statistics =
+        iree_vm_stack_query_statistics(invocation->stack);
+    iree_vm_stack_deinitialize(invocation->stack);
+    invocation->stack = NULL;
+    iree_vm_context_release_stack_storage(
+        invocation->context, invocation->stack_storage, &statistics);
+  } else if (invocation->stack_storage.data) {
+    iree_vm_stack_statistics_t statistics;
+    memset(&statistics, 0, sizeof(statistics));
+    iree_vm_context_release_stack_storage(
+        invocation->context, invocation->stack_storage, &statistics);
+  }
+  invocation->stack_storage = iree_make_byte_span(NULL, 0);
+}
+
+// Completes |invocation| with |status|, taking ownership of it.
+// On success the results are marshaled into the output list.
+static void iree_vm_invocation_complete(iree_vm_invocation_t* invocation,
+                                        iree_status_t status) {
+  if (iree_status_is_ok(status)) {
+    status = iree_vm_list_create(
+        /*element_type=*/NULL, invocation->cconv_results.size,
+        invocation->allocator, &invocation->outputs);
+    if (iree_status_is_ok(status)) {
+      status = iree_vm_invoke_marshal_outputs(
+          invocation->cconv_results, invocation->call.results,
+          invocation->outputs);
+    }
+  } else if (invocation->stack) {
+    status =
+        IREE_VM_STACK_ANNOTATE_BACKTRACE_IF_ENABLED(invocation->stack, status);
+  }
   if (!iree_status_is_ok(status)) {
-    status = IREE_VM_STACK_ANNOTATE_BACKTRACE_IF_ENABLED(stack, status);
+    iree_vm_list_release(invocation->outputs);
+    invocation->outputs = NULL;
+  }
+
+  // Release any refs that remain in the ABI buffers (arguments if the call
+  // never began or results that were not marshaled out).
+  iree_vm_function_call_release(&invocation->call, &invocation->signature);
+  iree_vm_invocation_release_stack(invocation);
+
+  invocation->status = status;
+}
+
+static void iree_vm_invocation_destroy(iree_vm_invocation_t* invocation) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  if (!iree_vm_invocation_is_completed(invocation)) {
+    iree_vm_invocation_complete(invocation,
+                                iree_status_from_code(IREE_STATUS_CANCELLED));
+  }
+  iree_status_ignore(invocation->status);
+  iree_vm_list_release(invocation->outputs);
+  iree_vm_context_release(invocation->context);
+  iree_allocator_free(invocation->allocator, invocation);
+  IREE_TRACE_ZONE_END(z0);
+}
+
+IREE_API_EXPORT iree_status_t
+iree_vm_invocation_retain(iree_vm_invocation_t* invocation) {
+  IREE_ASSERT_ARGUMENT(invocation);
+  iree_atomic_ref_count_inc(&invocation->ref_count);
+  return iree_ok_status();
+}
+
+IREE_API_EXPORT iree_status_t
+iree_vm_invocation_release(iree_vm_invocation_t* invocation) {
+  if (invocation && iree_atomic_ref_count_dec(&invocation->ref_count) == 1) {
+    iree_vm_invocation_destroy(invocation);
+  }
+  return iree_ok_status();
+}
+
+IREE_API_EXPORT iree_status_t iree_vm_invocation_resume(
+    iree_vm_invocation_t* invocation, bool* out_completed) {
+  IREE_ASSERT_ARGUMENT(invocation);
+  IREE_ASSERT_ARGUMENT(out_completed);
+  *out_completed = true;
+  if (iree_vm_invocation_is_completed(invocation)) return iree_ok_status();
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_vm_module_t* module = invocation->call.function.module;
+  iree_vm_execution_result_t result;
+  iree_status_t status;
+  if (!invocation->has_begun) {
+    invocation->has_begun = true;
+    status = module->begin_call(module->self, invocation->stack,
+                                &invocation->call, &result);
+  } else {
+    status = module->resume_call(module->self, invocation->stack,
+                                 &invocation->call, &result);
+  }
+
+  if (iree_status_is_deferred(status)) {
+    // Yielded; the stack holds all of the state required to resume.
+    *out_completed = false;
+  } else {
+    iree_vm_invocation_complete(invocation, status);
   }
-  iree_vm_stack_deinitialize(stack);
 
   IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
+IREE_API_EXPORT iree_status_t
+iree_vm_invocation_query_status(iree_vm_invocation_t* invocation) {
+  IREE_ASSERT_ARGUMENT(invocation);
+  if (iree_status_is_ok(invocation->status)) return iree_ok_status();
+  return iree_status_clone(invocation->status);
+}
+
+IREE_API_EXPORT const iree_vm_list_t* iree_vm_invocation_output(
+    iree_vm_invocation_t* invocation) {
+  IREE_ASSERT_ARGUMENT(invocation);
+  return iree_status_is_ok(invocation->status) ? invocation->outputs : NULL;
+}
+
+IREE_API_EXPORT iree_status_t iree_vm_invocation_await(
+    iree_vm_invocation_t* invocation, iree_time_t deadline) {
+  IREE_ASSERT_ARGUMENT(invocation);
+  IREE_TRACE_ZONE_BEGIN(z0);
+  bool completed = iree_vm_invocation_is_completed(invocation);
+  while (!completed) {
+    if (iree_time_now() >= deadline) {
+      IREE_TRACE_ZONE_END(z0);
+      return iree_status_from_code(IREE_STATUS_DEADLINE_EXCEEDED);
+    }
+    IREE_RETURN_AND_END_ZONE_IF_ERROR(
+        z0, iree_vm_invocation_resume(invocation, &completed));
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return iree_vm_invocation_query_status(invocation);
+}
+
+IREE_API_EXPORT iree_status_t
+iree_vm_invocation_abort(iree_vm_invocation_t* invocation) {
+  IREE_ASSERT_ARGUMENT(invocation);
+  if (iree_vm_invocation_is_completed(invocation)) return iree_ok_status();
+  iree_vm_invocation_complete(invocation,
+                              iree_status_from_code(IREE_STATUS_ABORTED));
+  return iree_ok_status();
+}
+
+// Loop callback running a single step of an invocation. The invocation is
+// requeued at the back of the loop each time it yields so that all invocations
+// scheduled on the loop make progress in turn.
+static iree_status_t iree_vm_invocation_loop_step(void* user_data,
+                                                  iree_loop_t loop,
+                                                  iree_status_t status) {
+  iree_vm_invocation_t* invocation = (iree_vm_invocation_t*)user_data;
+  bool completed = true;
+  if (iree_status_is_ok(status)) {
+    status = iree_vm_invocation_resume(invocation, &completed);
+  }
+  if (iree_status_is_ok(status) && !completed) {
+    status = iree_loop_call(loop, IREE_LOOP_PRIORITY_DEFAULT,
+                            iree_vm_invocation_loop_step, invocation);
+    if (iree_status_is_ok(status)) return status;
+  }
+  if (!iree_status_is_ok(status)) {
+    // The loop is aborting (or we failed to requeue); fail the invocation
+    // with the reason so that the caller can observe it.
+    if (iree_vm_invocation_is_completed(invocation)) {
+      iree_status_ignore(status);
+    } else {
+      iree_vm_invocation_complete(invocation, status);
+    }
+  }
+  iree_status_ignore(iree_vm_invocation_release(invocation));
+  return iree_ok_status();
+}
+
+IREE_API_EXPORT iree_status_t iree_vm_invocation_schedule(
+    iree_vm_invocation_t* invocation, iree_loop_t loop) {
+  IREE_ASSERT_ARGUMENT(invocation);
+  if (iree_vm_invocation_is_completed(invocation)) {
+    return iree_make_status(IREE_STATUS_FAILED_PRECONDITION,
+                            "invocation has already completed");
+  }
+  // Retained until the invocation completes on the loop.
+  iree_status_ignore(iree_vm_invocation_retain(invocation));
+  iree_status_t status = iree_loop_call(loop, IREE_LOOP_PRIORITY_DEFAULT,
+                                        iree_vm_invocation_loop_step,
+                                        invocation);
+  if (!iree_status_is_ok(status)) {
+    iree_status_ignore(iree_vm_invocation_release(invocation));
+  }
   return status;
 }
@@ -9,6 +9,8 @@
 #ifndef IREE_VM_INVOCATION_H_
 #define IREE_VM_INVOCATION_H_
 
+#include <stdbool.h>
+
 #include "iree/base/api.h"
 #include "iree/vm/context.h"
 #include "iree/vm/list.h"
@@ -23,9 +25,9 @@ typedef struct iree_vm_invocation_policy_t iree_vm_invocation_policy_t;
 
 // Synchronously invokes a function in the VM.
 //
-// |policy| is used to schedule the invocation relative to other pending or
-// in-flight invocations. It may be omitted to leave the behavior up to the
-// implementation.
+// |policy| is reserved for scheduling the invocation relative to other pending
+// or in-flight invocations and must be NULL; use iree_vm_invocation_schedule to
+// interleave invocations.
 //
 // |inputs| is used to pass values and objects into the target function and must
 // match the signature defined by the compiled function. List ownership remains
@@ -40,12 +42,23 @@ IREE_API_EXPORT iree_status_t iree_vm_invoke(
     iree_vm_list_t* inputs, iree_vm_list_t* outputs,
     iree_allocator_t allocator);
 
-// TODO(benvanik): document and implement.
+// Creates a resumable invocation of |function| in |context|.
+//
+// Unlike iree_vm_invoke the invocation does not begin executing until it is
+// resumed with iree_vm_invocation_resume (or driven by iree_vm_invocation_await
+// or iree_vm_invocation_schedule). Invocations may yield when the function
+// executes a yield and all state required to continue is retained by the
+// invocation such that many invocations may be interleaved on a single host
+// thread.
+//
+// |inputs| are marshaled during creation and the list may be reused by the
+// caller immediately.
+//
+// |out_invocation| must be released by the caller.
 IREE_API_EXPORT iree_status_t iree_vm_invocation_create(
     iree_vm_context_t* context, iree_vm_function_t function,
-    iree_vm_invocation_flags_t flags, const iree_vm_invocation_policy_t* policy,
-    const iree_vm_list_t* inputs, iree_allocator_t allocator,
-    iree_vm_invocation_t** out_invocation);
+    iree_vm_invocation_flags_t flags, const iree_vm_list_t* inputs,
+    iree_allocator_t allocator, iree_vm_invocation_t** out_invocation);
 
 // Retains the given |invocation| for the caller.
 IREE_API_EXPORT iree_status_t
@@ -55,6 +68,22 @@ iree_vm_invocation_retain(iree_vm_invocation_t* invocation);
 IREE_API_EXPORT iree_status_t
 iree_vm_invocation_release(iree_vm_invocation_t* invocation);
 
+// Runs |invocation| until it either yields or completes.
+// |out_completed| is set to true if the invocation has completed (successfully
+// or otherwise) and iree_vm_invocation_query_status can be used to retrieve the
+// result. Execution failures are captured by the invocation and not returned
+// from this call. No-op if the invocation has already completed.
+IREE_API_EXPORT iree_status_t iree_vm_invocation_resume(
+    iree_vm_invocation_t* invocation, bool* out_completed);
+
+// Schedules |invocation| for execution on |loop|.
+// The invocation runs until it yields and is then requeued on the loop such
+// that a single thread draining the loop (such as with iree_loop_sync_t)
+// cooperatively interleaves all invocations scheduled on it. The invocation is
+// retained by the loop until it completes.
+IREE_API_EXPORT iree_status_t iree_vm_invocation_schedule(
+    iree_vm_invocation_t* invocation, iree_loop_t loop);
+
 // Queries the completion status of the invocation.
 // Returns one of the following:
 //   IREE_STATUS_OK: the invocation completed successfully.
@@ -75,9 +104,11 @@ IREE_API_EXPORT const iree_vm_list_t* iree_vm_invocation_output(
     iree_vm_invocation_t* invocation);
 
 // Blocks the caller until the invocation completes (successfully or otherwise).
+// The invocation is resumed on the calling thread as many times as required.
 //
 // Returns IREE_STATUS_DEADLINE_EXCEEDED if |deadline| elapses before the
 // invocation completes and otherwise returns iree_vm_invocation_query_status.
+// The deadline is only checked between yields.
 IREE_API_EXPORT iree_status_t iree_vm_invocation_await(
     iree_vm_invocation_t* invocation, iree_time_t deadline);
 
@@ -0,0 +1,329 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/vm/invocation.h"
+
+#include <cstring>
+#include <vector>
+
+#include "iree/base/api.h"
+#include "iree/base/loop_sync.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+#include "iree/vm/context.h"
+#include "iree/vm/instance.h"
+#include "iree/vm/native_module.h"
+#include "iree/vm/ref_cc.h"
+#include "iree/vm/stack.h"
+#include "iree/vm/value.h"
+
+namespace {
+
+//===----------------------------------------------------------------------===//
+// yield_module
+//===----------------------------------------------------------------------===//
+// A native module exporting `yield_module.count(i32 n) -> i32` that yields |n|
+// times before returning the number of times it was resumed. All state is kept
+// in the stack frame as the bytecode interpreter does. Each step appends |n| to
+// the std::vector<int32_t> passed as the module self so that tests can check
+// the order in which invocations executed.
+
+typedef struct {
+  int32_t id;
+  int32_t remaining;
+  int32_t resume_count;
+} yield_frame_t;
+
+static iree_status_t yield_module_step(void* self, iree_vm_stack_t* stack,
+                                       const iree_vm_function_call_t* call) {
+  yield_frame_t* frame = (yield_frame_t*)iree_vm_stack_frame_storage(
+      iree_vm_stack_current_frame(stack));
+  static_cast<std::vector<int32_t>*>(self)->push_back(frame->id);
+  if (frame->remaining > 0) {
+    --frame->remaining;
+    return iree_status_from_code(IREE_STATUS_DEFERRED);
+  }
+  memcpy(call->results.data, &frame->resume_count, sizeof(int32_t));
+  return iree_vm_stack_function_leave(stack);
+}
+
+static iree_status_t yield_module_begin_call(
+    void* self, iree_vm_stack_t* stack, const iree_vm_function_call_t* call,
+    iree_vm_execution_result_t* out_result) {
+  iree_vm_stack_frame_t* callee_frame = NULL;
+  IREE_RETURN_IF_ERROR(iree_vm_stack_function_enter(
+      stack, &call->function, IREE_VM_STACK_FRAME_NATIVE,
+      sizeof(yield_frame_t), NULL, &callee_frame));
+  yield_frame_t* frame =
+      (yield_frame_t*)iree_vm_stack_frame_storage(callee_frame);
+  memcpy(&frame->id, call->arguments.data, sizeof(int32_t));
+  frame->remaining = frame->id;
+  frame->resume_count = 0;
+  return yield_module_step(self, stack, call);
+}
+
+static iree_status_t yield_module_resume_call(
+    void* self, iree_vm_stack_t* stack, const iree_vm_function_call_t* call,
+    iree_vm_execution_result_t* out_result) {
+  yield_frame_t* frame = (yield_frame_t*)iree_vm_stack_frame_storage(
+      iree_vm_stack_current_frame(stack));
+  ++frame->resume_count;
+  return yield_module_step(self, stack, call);
+}
+
+static const iree_vm_native_export_descriptor_t yield_module_exports_[] = {
+    {iree_make_cstring_view("count"), iree_make_cstring_view("0i_i"), 0, NULL},
+};
+static const iree_vm_native_module_descriptor_t yield_module_descriptor_ = {
+    iree_make_cstring_view("yield_module"),
+    0,
+    NULL,
+    IREE_ARRAYSIZE(yield_module_exports_),
+    yield_module_exports_,
+    0,
+    NULL,
+    0,
+    NULL,
+};
+
+static iree_status_t yield_module_create(std::vector<int32_t>* trace,
+                                         iree_allocator_t allocator,
+                                         iree_vm_module_t** out_module) {
+  iree_vm_module_t interface;
+  IREE_RETURN_IF_ERROR(iree_vm_module_initialize(&interface, trace));
+  interface.begin_call = yield_module_begin_call;
+  interface.resume_call = yield_module_resume_call;
+  return iree_vm_native_module_create(&interface, &yield_module_descriptor_,
+                                      allocator, out_module);
+}
+
+class VMInvocationTest : public ::testing::Test {
+ protected:
+  virtual void SetUp() {
+    IREE_CHECK_OK(iree_vm_instance_create(iree_allocator_system(), &instance_));
+    iree_vm_module_t* module = nullptr;
+    IREE_CHECK_OK(
+        yield_module_create(&trace_, iree_allocator_system(), &module));
+    IREE_CHECK_OK(iree_vm_context_create_with_modules(
+        instance_, IREE_VM_CONTEXT_FLAG_NONE, &module, 1,
+        iree_allocator_system(), &context_));
+    iree_vm_module_release(module);
+    IREE_CHECK_OK(iree_vm_context_resolve_function(
+        context_, iree_make_cstring_view("yield_module.count"), &function_));
+  }
+
+  virtual void TearDown() {
+    iree_vm_context_release(context_);
+    iree_vm_instance_release(instance_);
+  }
+
+  iree_vm_invocation_t* CreateInvocation(int32_t yield_count) {
+    iree::vm::ref<iree_vm_list_t> inputs;
+    IREE_CHECK_OK(iree_vm_list_create(/*element_type=*/nullptr, 1,
+                                      iree_allocator_system(), &inputs));
+    iree_vm_value_t arg0 = iree_vm_value_make_i32(yield_count);
+    IREE_CHECK_OK(iree_vm_list_push_value(inputs.get(), &arg0));
+    iree_vm_invocation_t* invocation = nullptr;
+    IREE_CHECK_OK(iree_vm_invocation_create(
+        context_, function_, IREE_VM_INVOCATION_FLAG_NONE, inputs.get(),
+        iree_allocator_system(), &invocation));
+    return invocation;
+  }
+
+  // Synchronously invokes the function and returns its result.
+  int32_t Invoke(int32_t yield_count) {
+    iree::vm::ref<iree_vm_list_t> inputs;
+    IREE_CHECK_OK(iree_vm_list_create(/*element_type=*/nullptr, 1,
+                                      iree_allocator_system(), &inputs));
+    iree_vm_value_t arg0 = iree_vm_value_make_i32(yield_count);
+    IREE_CHECK_OK(iree_vm_list_push_value(inputs.get(), &arg0));
+    iree::vm::ref<iree_vm_list_t> outputs;
+    IREE_CHECK_OK(iree_vm_list_create(/*element_type=*/nullptr, 1,
+                                      iree_allocator_system(), &outputs));
+    IREE_CHECK_OK(iree_vm_invoke(
+        context_, function_, IREE_VM_INVOCATION_FLAG_NONE, /*policy=*/nullptr,
+        inputs.get(), outputs.get(), iree_allocator_system()));
+    iree_vm_value_t value;
+    IREE_CHECK_OK(iree_vm_list_get_value(outputs.get(), 0, &value));
+    return value.i32;
+  }
+
+  static int32_t GetResult(iree_vm_invocation_t* invocation) {
+    const iree_vm_list_t* outputs = iree_vm_invocation_output(invocation);
+    EXPECT_NE(nullptr, outputs);
+    if (!outputs) return -1;
+    iree_vm_value_t value;
+    IREE_EXPECT_OK(iree_vm_list_get_value(outputs, 0, &value));
+    return value.i32;
+  }
+
+  iree_vm_instance_t* instance_ = nullptr;
+  iree_vm_context_t* context_ = nullptr;
+  iree_vm_function_t function_;
+  // Invocation id (the yield count it was created with) of each step executed.
+  std::vector<int32_t> trace_;
+};
+
+// Tests that synchronous invocation transparently resumes yielded calls.
+TEST_F(VMInvocationTest, InvokeResumesYields) {
+  iree::vm::ref<iree_vm_list_t> inputs;
+  IREE_ASSERT_OK(iree_vm_list_create(/*element_type=*/nullptr, 1,
+                                     iree_allocator_system(), &inputs));
+  iree_vm_value_t arg0 = iree_vm_value_make_i32(3);
+  IREE_ASSERT_OK(iree_vm_list_push_value(inputs.get(), &arg0));
+  iree::vm::ref<iree_vm_list_t> outputs;
+  IREE_ASSERT_OK(iree_vm_list_create(/*element_type=*/nullptr, 1,
+                                     iree_allocator_system(), &outputs));
+  IREE_ASSERT_OK(iree_vm_invoke(context_, function_,
+                                IREE_VM_INVOCATION_FLAG_NONE,
+                                /*policy=*/nullptr, inputs.get(), outputs.get(),
+                                iree_allocator_system()));
+  iree_vm_value_t value;
+  IREE_ASSERT_OK(iree_vm_list_get_value(outputs.get(), 0, &value));
+  EXPECT_EQ(3, value.i32);
+}
+
+// Tests that invocations reuse the stack storage pooled by the context and
+// that the pool grows to the peak size of stacks that had to resize.
+TEST_F(VMInvocationTest, StackStoragePool) {
+  const iree_host_size_t default_size = IREE_VM_STACK_DEFAULT_SIZE;
+  iree_vm_context_stack_statistics_t statistics =
+      iree_vm_context_query_stack_statistics(context_);
+  EXPECT_EQ(0u, statistics.reuse_count);
+  EXPECT_EQ(0u, statistics.resize_count);
+  EXPECT_EQ(0u, statistics.storage_size);
+
+  // The first invocation allocates the storage and the second reuses it.
+  EXPECT_EQ(1, Invoke(1));
+  statistics = iree_vm_context_query_stack_statistics(context_);
+  EXPECT_EQ(0u, statistics.reuse_count);
+  EXPECT_EQ(default_size, statistics.storage_size);
+  EXPECT_EQ(2, Invoke(2));
+  statistics = iree_vm_context_query_stack_statistics(context_);
+  EXPECT_EQ(1u, statistics.reuse_count);
+  EXPECT_EQ(0u, statistics.resize_count);
+  EXPECT_EQ(default_size, statistics.storage_size);
+
+  // No storage is allocated while the pooled storage is in use; the caller
+  // falls back to its own storage.
+  iree_byte_span_t storage_a = iree_make_byte_span(NULL, 0);
+  iree_byte_span_t storage_b = iree_make_byte_span(NULL, 0);
+  IREE_ASSERT_OK(iree_vm_context_acquire_stack_storage(context_, &storage_a));
+  IREE_ASSERT_OK(iree_vm_context_acquire_stack_storage(context_, &storage_b));
+  EXPECT_NE(nullptr, storage_a.data);
+  EXPECT_EQ(nullptr, storage_b.data);
+  EXPECT_EQ(0u, storage_b.data_length);
+  EXPECT_EQ(4, Invoke(4));
+  EXPECT_EQ(2u, iree_vm_context_query_stack_statistics(context_).reuse_count);
+
+  // Releasing storage from a stack that grew replaces the pooled storage with
+  // storage large enough for its peak; releasing the empty storage is a no-op.
+  iree_vm_stack_statistics_t stack_statistics;
+  memset(&stack_statistics, 0, sizeof(stack_statistics));
+  stack_statistics.resize_count = 2;
+  stack_statistics.peak_storage_size = 4 * default_size + 1;
+  iree_vm_context_release_stack_storage(context_, storage_a, &stack_statistics);
+  memset(&stack_statistics, 0, sizeof(stack_statistics));
+  iree_vm_context_release_stack_storage(context_, storage_b, &stack_statistics);
+  statistics = iree_vm_context_query_stack_statistics(context_);
+  EXPECT_EQ(2u, statistics.resize_count);
+  EXPECT_GE(statistics.storage_size, 4 * default_size + 1);
+  iree_host_size_t grown_size = statistics.storage_size;
+
+  // Subsequent invocations reuse the grown storage without resizing.
+  IREE_ASSERT_OK(iree_vm_context_acquire_stack_storage(context_, &storage_a));
+  EXPECT_EQ(grown_size, storage_a.data_length);
+  iree_vm_context_release_stack_storage(context_, storage_a, &stack_statistics);
+  EXPECT_EQ(3, Invoke(3));
+  statistics = iree_vm_context_query_stack_statistics(context_);
+  EXPECT_EQ(4u, statistics.reuse_count);
+  EXPECT_EQ(2u, statistics.resize_count);
+  EXPECT_EQ(grown_size, statistics.storage_size);
+}
+
+// Tests manually stepping an invocation through its yields.
+TEST_F(VMInvocationTest, ResumeSteps) {
+  iree_vm_invocation_t* invocation = CreateInvocation(2);
+  iree_status_t status = iree_vm_invocation_query_status(invocation);
+  IREE_EXPECT_STATUS_IS(IREE_STATUS_UNAVAILABLE, status);
+  iree_status_free(status);
+  EXPECT_EQ(nullptr, iree_vm_invocation_output(invocation));
+
+  bool completed = true;
+  IREE_ASSERT_OK(iree_vm_invocation_resume(invocation, &completed));
+  EXPECT_FALSE(completed);
+  IREE_ASSERT_OK(iree_vm_invocation_resume(invocation, &completed));
+  EXPECT_FALSE(completed);
+  IREE_ASSERT_OK(iree_vm_invocation_resume(invocation, &completed));
+  EXPECT_TRUE(completed);
+
+  IREE_EXPECT_OK(iree_vm_invocation_query_status(invocation));
+  EXPECT_EQ(2, GetResult(invocation));
+  IREE_EXPECT_OK(iree_vm_invocation_release(invocation));
+}
+
+// Tests that awaiting drives the invocation to completion.
+TEST_F(VMInvocationTest, Await) {
+  iree_vm_invocation_t* invocation = CreateInvocation(5);
+  IREE_ASSERT_OK(
+      iree_vm_invocation_await(invocation, IREE_TIME_INFINITE_FUTURE));
+  EXPECT_EQ(5, GetResult(invocation));
+  IREE_EXPECT_OK(iree_vm_invocation_release(invocation));
+}
+
+// Tests aborting an in-flight invocation.
+TEST_F(VMInvocationTest, Abort) {
+  iree_vm_invocation_t* invocation = CreateInvocation(5);
+  bool completed = true;
+  IREE_ASSERT_OK(iree_vm_invocation_resume(invocation, &completed));
+  EXPECT_FALSE(completed);
+  IREE_ASSERT_OK(iree_vm_invocation_abort(invocation));
+  iree_status_t status = iree_vm_invocation_query_status(invocation);
+  IREE_EXPECT_STATUS_IS(IREE_STATUS_ABORTED, status);
+  iree_status_free(status);
+  EXPECT_EQ(nullptr, iree_vm_invocation_output(invocation));
+  IREE_EXPECT_OK(iree_vm_invocation_release(invocation));
+}
+
+// Tests interleaving many invocations on a single synchronous loop.
+TEST_F(VMInvocationTest, ScheduleInterleaved) {
+  iree_loop_sync_options_t options = {0};
+  options.max_queue_depth = 16;
+  options.max_wait_count = 1;
+  iree_loop_sync_t* loop_sync = nullptr;
+  IREE_ASSERT_OK(
+      iree_loop_sync_allocate(options, iree_allocator_system(), &loop_sync));
+  iree_loop_sync_scope_t scope;
+  iree_loop_sync_scope_initialize(loop_sync, NULL, NULL, &scope);
+  iree_loop_t loop = iree_loop_sync_scope(&scope);
+
+  std::vector<iree_vm_invocation_t*> invocations;
+  for (int32_t i = 0; i < 8; ++i) {
+    invocations.push_back(CreateInvocation(i));
+    IREE_ASSERT_OK(iree_vm_invocation_schedule(invocations.back(), loop));
+  }
+  IREE_ASSERT_OK(iree_loop_drain(loop, iree_infinite_timeout()));
+
+  // Invocations run one step at a time in the order they were (re)queued:
+  // every invocation begins before any resumes and each round resumes the ones
+  // that still have yields remaining.
+  std::vector<int32_t> expected_trace;
+  for (int32_t round = 0; round < 8; ++round) {
+    for (int32_t i = round; i < 8; ++i) expected_trace.push_back(i);
+  }
+  EXPECT_EQ(expected_trace, trace_);
+
+  for (int32_t i = 0; i < 8; ++i) {
+    IREE_EXPECT_OK(iree_vm_invocation_query_status(invocations[i]));
+    EXPECT_EQ(i, GetResult(invocations[i]));
+    IREE_EXPECT_OK(iree_vm_invocation_release(invocations[i]));
+  }
+
+  iree_loop_sync_scope_deinitialize(&scope);
+  iree_loop_sync_free(loop_sync);
+}
+
+}  // namespace
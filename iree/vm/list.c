@@ -163,7 +163,7 @@ IREE_API_EXPORT void iree_vm_list_deinitialize(iree_vm_list_t* list) {
   IREE_ASSERT_ARGUMENT(list);
   IREE_TRACE_ZONE_BEGIN(z0);
 
-  iree_atomic_ref_count_abort_if_uses(&list->ref_object.counter);
+  iree_vm_ref_object_abort_if_uses(list, &iree_vm_list_descriptor);
   iree_vm_list_reset_range(list, 0, list->count);
   list->count = 0;
 
@@ -357,21 +357,10 @@ iree_vm_list_get_value(const iree_vm_list_t* list, iree_host_size_t i,
   switch (list->storage_mode) {
     case IREE_VM_LIST_STORAGE_MODE_VALUE: {
       out_value->type = list->element_type.value_type;
-      // TODO(benvanik): #ifdef on LITTLE/BIG_ENDIAN and just memcpy.
-      switch (list->element_size) {
-        case 1:
-          out_value->i8 = *(int8_t*)element_ptr;
-          break;
-        case 2:
-          out_value->i16 = *(int16_t*)element_ptr;
-          break;
-        case 4:
-          out_value->i32 = *(int32_t*)element_ptr;
-          break;
-        case 8:
-          out_value->i64 = *(int64_t*)element_ptr;
-          break;
-      }
+      // All union members start at the beginning of the storage and elements
+      // are stored in host-native layout.
+      memcpy(out_value->value_storage, (const void*)element_ptr,
+             list->element_size);
       break;
     }
     case IREE_VM_LIST_STORAGE_MODE_VARIANT: {
@@ -404,21 +393,7 @@ IREE_API_EXPORT iree_status_t iree_vm_list_get_value_as(
   switch (list->storage_mode) {
     case IREE_VM_LIST_STORAGE_MODE_VALUE: {
       value.type = list->element_type.value_type;
-      // TODO(benvanik): #ifdef on LITTLE/BIG_ENDIAN and just memcpy.
-      switch (list->element_size) {
-        case 1:
-          value.i8 = *(int8_t*)element_ptr;
-          break;
-        case 2:
-          value.i16 = *(int16_t*)element_ptr;
-          break;
-        case 4:
-          value.i32 = *(int32_t*)element_ptr;
-          break;
-        case 8:
-          value.i64 = *(int64_t*)element_ptr;
-          break;
-      }
+      memcpy(value.value_storage, (const void*)element_ptr, list->element_size);
       break;
     }
     case IREE_VM_LIST_STORAGE_MODE_VARIANT: {
@@ -465,21 +440,8 @@ IREE_API_EXPORT iree_status_t iree_vm_list_set_value(
   uintptr_t element_ptr = (uintptr_t)list->storage + i * list->element_size;
   switch (list->storage_mode) {
     case IREE_VM_LIST_STORAGE_MODE_VALUE: {
-      // TODO(benvanik): #ifdef on LITTLE/BIG_ENDIAN and just memcpy.
-      switch (list->element_size) {
-        case 1:
-          *(int8_t*)element_ptr = converted_value.i8;
-          break;
-        case 2:
-          *(int16_t*)element_ptr = converted_value.i16;
-          break;
-        case 4:
-          *(int32_t*)element_ptr = converted_value.i32;
-          break;
-        case 8:
-          *(int64_t*)element_ptr = converted_value.i64;
-          break;
-      }
+      memcpy((void*)element_ptr, converted_value.value_storage,
+             list->element_size);
       break;
     }
     case IREE_VM_LIST_STORAGE_MODE_VARIANT: {
@@ -507,6 +469,85 @@ iree_vm_list_push_value(iree_vm_list_t* list, const iree_vm_value_t* value) {
   return iree_vm_list_set_value(list, i, value);
 }
 
+// Verifies that |list| stores primitive values of exactly |value_type| and
+// that |byte_length| is a whole number of elements, returning the count.
+static iree_status_t iree_vm_list_verify_value_range(
+    const iree_vm_list_t* list, iree_vm_value_type_t value_type,
+    iree_host_size_t byte_length, iree_host_size_t* out_count) {
+  if (IREE_UNLIKELY(list->storage_mode != IREE_VM_LIST_STORAGE_MODE_VALUE ||
+                    list->element_type.value_type != value_type)) {
+    return iree_make_status(IREE_STATUS_FAILED_PRECONDITION,
+                            "list does not store values of type %d",
+                            (int)value_type);
+  }
+  if (IREE_UNLIKELY(byte_length % list->element_size != 0)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "value data length %zu is not a multiple of the "
+                            "element size %zu",
+                            byte_length, list->element_size);
+  }
+  *out_count = byte_length / list->element_size;
+  return iree_ok_status();
+}
+
+IREE_API_EXPORT iree_status_t iree_vm_list_get_values(
+    const iree_vm_list_t* list, iree_host_size_t offset,
+    iree_vm_value_type_t value_type, iree_byte_span_t out_values) {
+  iree_host_size_t count = 0;
+  IREE_RETURN_IF_ERROR(iree_vm_list_verify_value_range(
+      list, value_type, out_values.data_length, &count));
+  if (IREE_UNLIKELY(offset > list->count || count > list->count - offset)) {
+    return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                            "range [%zu, %zu) out of bounds (%zu)", offset,
+                            offset + count, list->count);
+  }
+  memcpy(out_values.data,
+         (const uint8_t*)list->storage + offset * list->element_size,
+         out_values.data_length);
+  return iree_ok_status();
+}
+
+IREE_API_EXPORT iree_status_t iree_vm_list_set_values(
+    iree_vm_list_t* list, iree_host_size_t offset,
+    iree_vm_value_type_t value_type, iree_const_byte_span_t values) {
+  iree_host_size_t count = 0;
+  IREE_RETURN_IF_ERROR(iree_vm_list_verify_value_range(
+      list, value_type, values.data_length, &count));
+  if (IREE_UNLIKELY(offset > list->count || count > list->count - offset)) {
+    return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                            "range [%zu, %zu) out of bounds (%zu)", offset,
+                            offset + count, list->count);
+  }
+  memcpy((uint8_t*)list->storage + offset * list->element_size, values.data,
+         values.data_length);
+  return iree_ok_status();
+}
+
+IREE_API_EXPORT iree_status_t iree_vm_list_push_values(
+    iree_vm_list_t* list, iree_vm_value_type_t value_type,
+    iree_const_byte_span_t values) {
+  iree_host_size_t count = 0;
+  IREE_RETURN_IF_ERROR(iree_vm_list_verify_value_range(
+      list, value_type, values.data_length, &count));
+  iree_host_size_t offset = list->count;
+  IREE_RETURN_IF_ERROR(iree_vm_list_resize(list, offset + count));
+  memcpy((uint8_t*)list->storage + offset * list->element_size, values.data,
+         values.data_length);
+  return iree_ok_status();
+}
+
+IREE_API_EXPORT iree_status_t
+iree_vm_list_map_values(iree_vm_list_t* list, iree_vm_value_type_t value_type,
+                        iree_byte_span_t* out_values) {
+  *out_values = iree_make_byte_span(NULL, 0);
+  iree_host_size_t count = 0;
+  IREE_RETURN_IF_ERROR(
+      iree_vm_list_verify_value_range(list, value_type, 0, &count));
+  *out_values =
+      iree_make_byte_span(list->storage, list->count * list->element_size);
+  return iree_ok_status();
+}
+
 IREE_API_EXPORT void* iree_vm_list_get_ref_deref(
     const iree_vm_list_t* list, iree_host_size_t i,
     const iree_vm_ref_type_descriptor_t* type_descriptor) {
@@ -121,6 +121,39 @@ IREE_API_EXPORT iree_status_t iree_vm_list_set_value(
 IREE_API_EXPORT iree_status_t
 iree_vm_list_push_value(iree_vm_list_t* list, const iree_vm_value_t* value);
 
+// Copies the values of elements [offset, offset + count) into |out_values|,
+// where count is derived from the size of |out_values| and |value_type|.
+// The list must store primitive values of exactly |value_type|; no conversion
+// is performed and the values are copied as a single contiguous block.
+IREE_API_EXPORT iree_status_t iree_vm_list_get_values(
+    const iree_vm_list_t* list, iree_host_size_t offset,
+    iree_vm_value_type_t value_type, iree_byte_span_t out_values);
+
+// Sets the values of elements [offset, offset + count) from |values|, where
+// count is derived from the size of |values| and |value_type|. The range must
+// be within the current list size. The list must store primitive values of
+// exactly |value_type|; no conversion is performed and the values are copied as
+// a single contiguous block.
+IREE_API_EXPORT iree_status_t iree_vm_list_set_values(
+    iree_vm_list_t* list, iree_host_size_t offset,
+    iree_vm_value_type_t value_type, iree_const_byte_span_t values);
+
+// Appends all |values| to the end of the list, growing it as required.
+// The list must store primitive values of exactly |value_type|; no conversion
+// is performed and the values are copied as a single contiguous block.
+IREE_API_EXPORT iree_status_t iree_vm_list_push_values(
+    iree_vm_list_t* list, iree_vm_value_type_t value_type,
+    iree_const_byte_span_t values);
+
+// Returns a span borrowing the storage of all elements currently in the list.
+// The list must store primitive values of exactly |value_type| and the span
+// contains iree_vm_list_size elements in the host-native layout of that type.
+// The span may be both read and written but is invalidated by any operation
+// that changes the size or capacity of the list.
+IREE_API_EXPORT iree_status_t
+iree_vm_list_map_values(iree_vm_list_t* list, iree_vm_value_type_t value_type,
+                        iree_byte_span_t* out_values);
+
 // Returns a dereferenced pointer to the given type if the element at the given
 // index matches the type. Returns NULL on error.
 IREE_API_EXPORT void* iree_vm_list_get_ref_deref(
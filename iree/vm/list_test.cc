@@ -8,6 +8,7 @@
 
 #include <cstdint>
 #include <cstring>
+#include <vector>
 
 #include "iree/base/api.h"
 #include "iree/testing/gtest.h"
@@ -115,6 +116,96 @@ TEST_F(VMListTest, UsageI32) {
   iree_vm_list_release(list);
 }
 
+// Tests bulk copies into and out of a primitive value list.
+TEST_F(VMListTest, BulkValuesF32) {
+  iree_vm_type_def_t element_type =
+      iree_vm_type_def_make_value_type(IREE_VM_VALUE_TYPE_F32);
+  iree_vm_list_t* list = nullptr;
+  IREE_ASSERT_OK(
+      iree_vm_list_create(&element_type, 0, iree_allocator_system(), &list));
+
+  std::vector<float> source(1000);
+  for (size_t i = 0; i < source.size(); ++i) source[i] = (float)i * 0.5f;
+  IREE_ASSERT_OK(iree_vm_list_push_values(
+      list, IREE_VM_VALUE_TYPE_F32,
+      iree_make_const_byte_span(source.data(), source.size() * sizeof(float))));
+  IREE_ASSERT_OK(iree_vm_list_push_values(
+      list, IREE_VM_VALUE_TYPE_F32,
+      iree_make_const_byte_span(source.data(), 10 * sizeof(float))));
+  EXPECT_EQ(1010, iree_vm_list_size(list));
+
+  // Element-wise access must agree with the bulk writes.
+  iree_vm_value_t value;
+  IREE_ASSERT_OK(iree_vm_list_get_value(list, 999, &value));
+  EXPECT_EQ(IREE_VM_VALUE_TYPE_F32, value.type);
+  EXPECT_EQ(source[999], value.f32);
+  IREE_ASSERT_OK(iree_vm_list_get_value(list, 1009, &value));
+  EXPECT_EQ(source[9], value.f32);
+
+  // Overwrite a subrange and read it back.
+  float patch[3] = {-1.0f, -2.0f, -3.0f};
+  IREE_ASSERT_OK(iree_vm_list_set_values(
+      list, 100, IREE_VM_VALUE_TYPE_F32,
+      iree_make_const_byte_span(patch, sizeof(patch))));
+  float readback[4] = {0.0f};
+  IREE_ASSERT_OK(iree_vm_list_get_values(
+      list, 99, IREE_VM_VALUE_TYPE_F32,
+      iree_make_byte_span(readback, sizeof(readback))));
+  EXPECT_EQ(source[99], readback[0]);
+  EXPECT_EQ(-1.0f, readback[1]);
+  EXPECT_EQ(-2.0f, readback[2]);
+  EXPECT_EQ(-3.0f, readback[3]);
+
+  // Mapped storage aliases the list elements.
+  iree_byte_span_t span = iree_make_byte_span(NULL, 0);
+  IREE_ASSERT_OK(iree_vm_list_map_values(list, IREE_VM_VALUE_TYPE_F32, &span));
+  EXPECT_EQ(1010 * sizeof(float), span.data_length);
+  ((float*)span.data)[5] = 123.0f;
+  IREE_ASSERT_OK(iree_vm_list_get_value(list, 5, &value));
+  EXPECT_EQ(123.0f, value.f32);
+
+  iree_vm_list_release(list);
+}
+
+// Tests that bulk value access validates types and ranges.
+TEST_F(VMListTest, BulkValuesErrors) {
+  iree_vm_type_def_t element_type =
+      iree_vm_type_def_make_value_type(IREE_VM_VALUE_TYPE_I32);
+  iree_vm_list_t* list = nullptr;
+  IREE_ASSERT_OK(
+      iree_vm_list_create(&element_type, 8, iree_allocator_system(), &list));
+  IREE_ASSERT_OK(iree_vm_list_resize(list, 4));
+
+  int32_t values[8] = {0};
+  EXPECT_THAT(Status(iree_vm_list_set_values(
+                  list, 0, IREE_VM_VALUE_TYPE_F32,
+                  iree_make_const_byte_span(values, 4 * sizeof(int32_t)))),
+              StatusIs(iree::StatusCode::kFailedPrecondition));
+  EXPECT_THAT(Status(iree_vm_list_set_values(
+                  list, 0, IREE_VM_VALUE_TYPE_I32,
+                  iree_make_const_byte_span(values, 3))),
+              StatusIs(iree::StatusCode::kInvalidArgument));
+  EXPECT_THAT(Status(iree_vm_list_set_values(
+                  list, 2, IREE_VM_VALUE_TYPE_I32,
+                  iree_make_const_byte_span(values, 4 * sizeof(int32_t)))),
+              StatusIs(iree::StatusCode::kOutOfRange));
+  EXPECT_THAT(Status(iree_vm_list_get_values(
+                  list, 0, IREE_VM_VALUE_TYPE_I32,
+                  iree_make_byte_span(values, sizeof(values)))),
+              StatusIs(iree::StatusCode::kOutOfRange));
+
+  iree_vm_list_release(list);
+
+  // Variant lists do not have contiguous value storage.
+  IREE_ASSERT_OK(iree_vm_list_create(/*element_type=*/nullptr, 8,
+                                     iree_allocator_system(), &list));
+  iree_byte_span_t span;
+  EXPECT_THAT(
+      Status(iree_vm_list_map_values(list, IREE_VM_VALUE_TYPE_I32, &span)),
+      StatusIs(iree::StatusCode::kFailedPrecondition));
+  iree_vm_list_release(list);
+}
+
 // Tests simple ref object list usage, mainly just for demonstration.
 // Stores ref object type A elements only, equivalent to `!vm.list<!vm.ref<A>>`.
 TEST_F(VMListTest, UsageRef) {
@@ -381,6 +381,19 @@ typedef struct iree_vm_module_t {
   void(IREE_API_PTR* free_state)(void* self,
                                  iree_vm_module_state_t* module_state);
 
+  // Allocates module state data initialized from an existing |parent_state| as
+  // if the module had been initialized in the same way. Immutable resources
+  // referenced by the parent state should be shared (retained) instead of
+  // recreated and only mutable state copied. Imports will be resolved on the
+  // new state as with alloc_state but module initializers will not be run.
+  //
+  // Optional; modules that do not implement this or return
+  // IREE_STATUS_UNIMPLEMENTED will have fresh state allocated with alloc_state
+  // and be initialized as normal.
+  iree_status_t(IREE_API_PTR* fork_state)(
+      void* self, iree_vm_module_state_t* parent_state,
+      iree_allocator_t allocator, iree_vm_module_state_t** out_module_state);
+
   // Resolves the import with the given ordinal to |function|.
   // The function is guaranteed to remain valid for the lifetime of the module
   // state.
@@ -396,14 +409,18 @@ typedef struct iree_vm_module_t {
 
   // Begins a function call with the given |call| arguments.
   // Execution may yield in the case of asynchronous code and require one or
-  // more calls to the resume method to complete.
+  // more calls to the resume method to complete. Yields are indicated by
+  // returning IREE_STATUS_DEFERRED with the stack left intact.
   iree_status_t(IREE_API_PTR* begin_call)(
       void* self, iree_vm_stack_t* stack, const iree_vm_function_call_t* call,
       iree_vm_execution_result_t* out_result);
 
   // Resumes execution of a previously-yielded call.
+  // |call| must be the same call passed to begin_call and its results buffer
+  // will be populated if the call completes. As with begin_call
+  // IREE_STATUS_DEFERRED is returned if the call yields again.
   iree_status_t(IREE_API_PTR* resume_call)(
-      void* self, iree_vm_stack_t* stack,
+      void* self, iree_vm_stack_t* stack, const iree_vm_function_call_t* call,
       iree_vm_execution_result_t* out_result);
 
   // TODO(benvanik): move this/refactor.
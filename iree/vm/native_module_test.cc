@@ -56,12 +56,18 @@ class VMNativeModuleTest : public ::testing::Test {
 
   StatusOr<int32_t> RunFunction(iree_string_view_t function_name,
                                 int32_t arg0) {
+    return RunFunction(context_, function_name, arg0);
+  }
+
+  StatusOr<int32_t> RunFunction(iree_vm_context_t* context,
+                                iree_string_view_t function_name,
+                                int32_t arg0) {
     // Lookup the entry function. This can be cached in an application if
     // multiple calls will be made.
     iree_vm_function_t function;
     IREE_RETURN_IF_ERROR(
         iree_vm_context_resolve_function(
-            context_, iree_make_cstring_view("module_b.entry"), &function),
+            context, iree_make_cstring_view("module_b.entry"), &function),
         "unable to resolve entry point");
 
     // Setup I/O lists and pass in the argument. The result list will be
@@ -78,7 +84,7 @@ class VMNativeModuleTest : public ::testing::Test {
 
     // Invoke the entry function to do our work. Runs synchronously.
     IREE_RETURN_IF_ERROR(
-        iree_vm_invoke(context_, function, IREE_VM_INVOCATION_FLAG_NONE,
+        iree_vm_invoke(context, function, IREE_VM_INVOCATION_FLAG_NONE,
                        /*policy=*/nullptr, input_list.get(), output_list.get(),
                        iree_allocator_system()));
 
@@ -89,7 +95,7 @@ class VMNativeModuleTest : public ::testing::Test {
     return ret0_value.i32;
   }
 
- private:
+ protected:
   iree_vm_instance_t* instance_ = nullptr;
   iree_vm_context_t* context_ = nullptr;
 };
@@ -106,5 +112,32 @@ TEST_F(VMNativeModuleTest, Example) {
   ASSERT_EQ(v2, 8);
 }
 
+// Tests that forked contexts start from the parent state and then diverge.
+TEST_F(VMNativeModuleTest, Fork) {
+  IREE_ASSERT_OK_AND_ASSIGN(
+      int32_t v0, RunFunction(iree_make_cstring_view("module_b.entry"), 1));
+  ASSERT_EQ(v0, 1);
+
+  iree_vm_context_t* forked_context = nullptr;
+  IREE_ASSERT_OK(iree_vm_context_fork(context_, iree_allocator_system(),
+                                      &forked_context));
+  EXPECT_NE(iree_vm_context_id(context_), iree_vm_context_id(forked_context));
+
+  IREE_ASSERT_OK_AND_ASSIGN(
+      int32_t v1, RunFunction(forked_context,
+                              iree_make_cstring_view("module_b.entry"), 2));
+  ASSERT_EQ(v1, 4);
+  IREE_ASSERT_OK_AND_ASSIGN(
+      int32_t v2, RunFunction(iree_make_cstring_view("module_b.entry"), 3));
+  ASSERT_EQ(v2, 5);
+
+  // The fork outlives the parent state changes and remains usable on its own.
+  iree_vm_context_release(context_);
+  context_ = forked_context;
+  IREE_ASSERT_OK_AND_ASSIGN(
+      int32_t v3, RunFunction(iree_make_cstring_view("module_b.entry"), 3));
+  ASSERT_EQ(v3, 8);
+}
+
 }  // namespace
 }  // namespace iree
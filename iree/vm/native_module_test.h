@@ -194,6 +194,20 @@ module_b_free_state(void* self, iree_vm_module_state_t* module_state) {
   iree_allocator_free(state->allocator, state);
 }
 
+// Forks per-context state from an existing context. Imports are resolved again
+// after forking and only the user data needs to be carried over.
+static iree_status_t IREE_API_PTR
+module_b_fork_state(void* self, iree_vm_module_state_t* parent_state,
+                    iree_allocator_t allocator,
+                    iree_vm_module_state_t** out_module_state) {
+  module_b_state_t* state = NULL;
+  IREE_RETURN_IF_ERROR(module_b_alloc_state(
+      self, allocator, (iree_vm_module_state_t**)&state));
+  state->counter = ((module_b_state_t*)parent_state)->counter;
+  *out_module_state = (iree_vm_module_state_t*)state;
+  return iree_ok_status();
+}
+
 // Called once per import function so the module can store the function ref.
 static iree_status_t IREE_API_PTR module_b_resolve_import(
     void* self, iree_vm_module_state_t* module_state, iree_host_size_t ordinal,
@@ -301,6 +315,7 @@ static iree_status_t module_b_create(iree_allocator_t allocator,
   interface.destroy = module_b_destroy;
   interface.alloc_state = module_b_alloc_state;
   interface.free_state = module_b_free_state;
+  interface.fork_state = module_b_fork_state;
   interface.resolve_import = module_b_resolve_import;
   return iree_vm_native_module_create(&interface, &module_b_descriptor_,
                                       allocator, out_module);
@@ -6,6 +6,7 @@
 
 #include "iree/vm/ref.h"
 
+#include <stdlib.h>
 #include <string.h>
 
 #include "iree/base/internal/atomics.h"
@@ -17,32 +18,177 @@
 // or something more complex).
 #define IREE_VM_MAX_TYPE_ID 64
 
-static inline volatile iree_atomic_ref_count_t* iree_vm_get_raw_counter_ptr(
+static inline iree_atomic_ref_count_t* iree_vm_get_raw_counter_ptr(
     void* ptr, const iree_vm_ref_type_descriptor_t* type_descriptor) {
-  return (volatile iree_atomic_ref_count_t*)(((uintptr_t)(ptr)) +
-                                             type_descriptor->offsetof_counter);
+  return (iree_atomic_ref_count_t*)(((uintptr_t)(ptr)) +
+                                    type_descriptor->offsetof_counter);
 }
 
-static inline volatile iree_atomic_ref_count_t* iree_vm_get_ref_counter_ptr(
+static inline iree_atomic_ref_count_t* iree_vm_get_ref_counter_ptr(
     iree_vm_ref_t* ref) {
-  return (volatile iree_atomic_ref_count_t*)(((uintptr_t)ref->ptr) +
-                                             ref->offsetof_counter);
+  return (iree_atomic_ref_count_t*)(((uintptr_t)ref->ptr) +
+                                    ref->offsetof_counter);
+}
+
+//===----------------------------------------------------------------------===//
+// Thread-affine reference counting
+//===----------------------------------------------------------------------===//
+// Thread-affine objects are marked with a bit in their reference counter so
+// that no additional storage is required. The bits below the marker hold an
+// 8-bit tag of the owning thread (used only for debug checks) and the count.
+// Retains and releases of thread-affine objects are a relaxed load and store
+// (plain moves on all targets we care about) instead of a locked RMW.
+//
+// Checking the mode requires a load and branch ahead of each atomic RMW and
+// so support is only compiled in when IREE_VM_REF_THREAD_AFFINITY_ENABLE is
+// set; otherwise retains and releases are exactly the atomic operations.
+
+#define IREE_VM_REF_COUNTER_THREAD_AFFINE 0x40000000
+#define IREE_VM_REF_COUNTER_OWNER_SHIFT 22
+#define IREE_VM_REF_COUNTER_OWNER_MASK 0x3FC00000
+#define IREE_VM_REF_COUNTER_COUNT_MASK 0x003FFFFF
+
+#if IREE_VM_REF_THREAD_AFFINITY_ENABLE
+
+#if IREE_VM_REF_THREAD_AFFINITY_CHECKS_ENABLE
+
+// Returns a nonzero tag for the calling thread. Tags are only 8 bits and may
+// collide after 255 threads, which can only cause missed (not false) errors.
+static int32_t iree_vm_ref_current_thread_tag(void) {
+  static iree_atomic_int32_t next_tag = IREE_ATOMIC_VAR_INIT(0);
+  static IREE_THREAD_LOCAL int32_t thread_tag = 0;
+  if (IREE_UNLIKELY(!thread_tag)) {
+    thread_tag = 1 + (iree_atomic_fetch_add_int32(&next_tag, 1,
+                                                  iree_memory_order_relaxed) %
+                      255);
+  }
+  return thread_tag;
+}
+
+static void iree_vm_ref_check_thread_affinity(int32_t value) {
+  int32_t owner_tag = (value & IREE_VM_REF_COUNTER_OWNER_MASK) >>
+                      IREE_VM_REF_COUNTER_OWNER_SHIFT;
+  if (IREE_UNLIKELY(owner_tag != iree_vm_ref_current_thread_tag())) {
+    // Used from a thread other than the owner; the count is already corrupt or
+    // will be shortly and there's no way to recover.
+    abort();
+  }
+}
+
+#else
+
+static int32_t iree_vm_ref_current_thread_tag(void) { return 0; }
+
+#define iree_vm_ref_check_thread_affinity(value)
+
+#endif  // IREE_VM_REF_THREAD_AFFINITY_CHECKS_ENABLE
+
+static inline void iree_vm_ref_counter_inc(iree_atomic_ref_count_t* counter) {
+  int32_t value = iree_atomic_load_int32(counter, iree_memory_order_relaxed);
+  if (IREE_UNLIKELY(value & IREE_VM_REF_COUNTER_THREAD_AFFINE)) {
+    iree_vm_ref_check_thread_affinity(value);
+    iree_atomic_store_int32(counter, value + 1, iree_memory_order_relaxed);
+  } else {
+    iree_atomic_ref_count_inc(counter);
+  }
+}
+
+// Returns true if the last reference was released.
+static inline bool iree_vm_ref_counter_dec(iree_atomic_ref_count_t* counter) {
+  int32_t value = iree_atomic_load_int32(counter, iree_memory_order_relaxed);
+  if (IREE_UNLIKELY(value & IREE_VM_REF_COUNTER_THREAD_AFFINE)) {
+    iree_vm_ref_check_thread_affinity(value);
+    iree_atomic_store_int32(counter, value - 1, iree_memory_order_relaxed);
+    return (value & IREE_VM_REF_COUNTER_COUNT_MASK) == 1;
+  }
+  return iree_atomic_ref_count_dec(counter) == 1;
+}
+
+IREE_API_EXPORT void iree_vm_ref_object_make_thread_affine(
+    void* ptr, const iree_vm_ref_type_descriptor_t* type_descriptor) {
+  if (!ptr) return;
+  iree_atomic_ref_count_t* counter =
+      iree_vm_get_raw_counter_ptr(ptr, type_descriptor);
+  int32_t value = iree_atomic_load_int32(counter, iree_memory_order_acquire);
+  if (value & IREE_VM_REF_COUNTER_THREAD_AFFINE) return;
+  assert(value <= IREE_VM_REF_COUNTER_COUNT_MASK &&
+         "reference count too large for thread-affine mode");
+  int32_t owner_tag = iree_vm_ref_current_thread_tag();
+  value |= IREE_VM_REF_COUNTER_THREAD_AFFINE |
+           (owner_tag << IREE_VM_REF_COUNTER_OWNER_SHIFT);
+  iree_atomic_store_int32(counter, value, iree_memory_order_relaxed);
+}
+
+IREE_API_EXPORT void iree_vm_ref_object_make_shared(
+    void* ptr, const iree_vm_ref_type_descriptor_t* type_descriptor) {
+  if (!ptr) return;
+  iree_atomic_ref_count_t* counter =
+      iree_vm_get_raw_counter_ptr(ptr, type_descriptor);
+  int32_t value = iree_atomic_load_int32(counter, iree_memory_order_relaxed);
+  if (!(value & IREE_VM_REF_COUNTER_THREAD_AFFINE)) return;
+  iree_vm_ref_check_thread_affinity(value);
+  // Release so that the plain stores made while thread-affine are visible to
+  // any thread that acquires the object after it has been published.
+  iree_atomic_store_int32(counter, value & IREE_VM_REF_COUNTER_COUNT_MASK,
+                          iree_memory_order_release);
+}
+
+IREE_API_EXPORT bool iree_vm_ref_object_is_thread_affine(
+    void* ptr, const iree_vm_ref_type_descriptor_t* type_descriptor) {
+  if (!ptr) return false;
+  iree_atomic_ref_count_t* counter =
+      iree_vm_get_raw_counter_ptr(ptr, type_descriptor);
+  return (iree_atomic_load_int32(counter, iree_memory_order_relaxed) &
+          IREE_VM_REF_COUNTER_THREAD_AFFINE) != 0;
+}
+
+#else
+
+#define iree_vm_ref_counter_inc(counter) iree_atomic_ref_count_inc(counter)
+#define iree_vm_ref_counter_dec(counter) \
+  (iree_atomic_ref_count_dec(counter) == 1)
+
+IREE_API_EXPORT void iree_vm_ref_object_make_thread_affine(
+    void* ptr, const iree_vm_ref_type_descriptor_t* type_descriptor) {}
+
+IREE_API_EXPORT void iree_vm_ref_object_make_shared(
+    void* ptr, const iree_vm_ref_type_descriptor_t* type_descriptor) {}
+
+IREE_API_EXPORT bool iree_vm_ref_object_is_thread_affine(
+    void* ptr, const iree_vm_ref_type_descriptor_t* type_descriptor) {
+  return false;
+}
+
+#endif  // IREE_VM_REF_THREAD_AFFINITY_ENABLE
+
+IREE_API_EXPORT void iree_vm_ref_object_abort_if_uses(
+    void* ptr, const iree_vm_ref_type_descriptor_t* type_descriptor) {
+  iree_atomic_ref_count_t* counter =
+      iree_vm_get_raw_counter_ptr(ptr, type_descriptor);
+  int32_t value = iree_atomic_load_int32(counter, iree_memory_order_seq_cst);
+  if (value & IREE_VM_REF_COUNTER_THREAD_AFFINE) {
+    // Thread-affine objects carry their mode and owner in the upper bits.
+    value &= IREE_VM_REF_COUNTER_COUNT_MASK;
+  }
+  if (IREE_UNLIKELY(value != 1)) {
+    abort();
+  }
 }
 
 IREE_API_EXPORT void iree_vm_ref_object_retain(
     void* ptr, const iree_vm_ref_type_descriptor_t* type_descriptor) {
   if (!ptr) return;
-  volatile iree_atomic_ref_count_t* counter =
+  iree_atomic_ref_count_t* counter =
       iree_vm_get_raw_counter_ptr(ptr, type_descriptor);
-  iree_atomic_ref_count_inc(counter);
+  iree_vm_ref_counter_inc(counter);
 }
 
 IREE_API_EXPORT void iree_vm_ref_object_release(
     void* ptr, const iree_vm_ref_type_descriptor_t* type_descriptor) {
   if (!ptr) return;
-  volatile iree_atomic_ref_count_t* counter =
+  iree_atomic_ref_count_t* counter =
       iree_vm_get_raw_counter_ptr(ptr, type_descriptor);
-  if (iree_atomic_ref_count_dec(counter) == 1) {
+  if (iree_vm_ref_counter_dec(counter)) {
     if (type_descriptor->destroy) {
       // NOTE: this makes us not re-entrant, but I think that's OK.
       type_descriptor->destroy(ptr);
@@ -94,6 +240,26 @@ iree_vm_ref_type_name(iree_vm_ref_type_t type) {
   return iree_vm_ref_type_descriptors[type]->type_name;
 }
 
+IREE_API_EXPORT iree_vm_ref_type_flags_t
+iree_vm_ref_type_flags(iree_vm_ref_type_t type) {
+  if (type == 0 || type >= IREE_VM_MAX_TYPE_ID) {
+    return IREE_VM_REF_TYPE_FLAG_NONE;
+  }
+  return iree_vm_ref_type_descriptors[type]->flags;
+}
+
+IREE_API_EXPORT bool iree_vm_ref_is_shareable(const iree_vm_ref_t* ref) {
+  if (!ref->ptr || ref->type == 0 || ref->type >= IREE_VM_MAX_TYPE_ID) {
+    return false;
+  }
+  const iree_vm_ref_type_descriptor_t* descriptor =
+      iree_vm_ref_type_descriptors[ref->type];
+  if (iree_all_bits_set(descriptor->flags, IREE_VM_REF_TYPE_FLAG_SHAREABLE)) {
+    return true;
+  }
+  return descriptor->is_shareable && descriptor->is_shareable(ref->ptr);
+}
+
 IREE_API_EXPORT const iree_vm_ref_type_descriptor_t*
 iree_vm_ref_lookup_registered_type(iree_string_view_t full_name) {
   for (int i = 1; i <= IREE_VM_MAX_TYPE_ID; ++i) {
@@ -109,7 +275,7 @@ iree_vm_ref_lookup_registered_type(iree_string_view_t full_name) {
 // Useful debugging tool:
 #if 0
 static void iree_vm_ref_trace(const char* msg, iree_vm_ref_t* ref) {
-  volatile iree_atomic_ref_count_t* counter = iree_vm_get_ref_counter_ptr(ref);
+  iree_atomic_ref_count_t* counter = iree_vm_get_ref_counter_ptr(ref);
   iree_string_view_t name = iree_vm_ref_type_name(ref->type);
   fprintf(stderr, "%s %.*s 0x%p %d\n", msg, (int)name.size, name.data, ref->ptr,
           counter->__val);
@@ -148,9 +314,9 @@ IREE_API_EXPORT iree_status_t iree_vm_ref_wrap_retain(void* ptr,
                                                       iree_vm_ref_t* out_ref) {
   IREE_RETURN_IF_ERROR(iree_vm_ref_wrap_assign(ptr, type, out_ref));
   if (out_ref->ptr) {
-    volatile iree_atomic_ref_count_t* counter =
+    iree_atomic_ref_count_t* counter =
         iree_vm_get_ref_counter_ptr(out_ref);
-    iree_atomic_ref_count_inc(counter);
+    iree_vm_ref_counter_inc(counter);
     iree_vm_ref_trace("WRAP RETAIN", out_ref);
   }
   return iree_ok_status();
@@ -162,9 +328,9 @@ IREE_API_EXPORT void iree_vm_ref_retain(iree_vm_ref_t* ref,
   // potentially release.
   iree_vm_ref_t temp_ref = *ref;
   if (ref->ptr) {
-    volatile iree_atomic_ref_count_t* counter =
+    iree_atomic_ref_count_t* counter =
         iree_vm_get_ref_counter_ptr(ref);
-    iree_atomic_ref_count_inc(counter);
+    iree_vm_ref_counter_inc(counter);
     iree_vm_ref_trace("RETAIN", ref);
   }
   if (out_ref->ptr) {
@@ -211,8 +377,8 @@ IREE_API_EXPORT void iree_vm_ref_release(iree_vm_ref_t* ref) {
   if (ref->type == IREE_VM_REF_TYPE_NULL || ref->ptr == NULL) return;
 
   iree_vm_ref_trace("RELEASE", ref);
-  volatile iree_atomic_ref_count_t* counter = iree_vm_get_ref_counter_ptr(ref);
-  if (iree_atomic_ref_count_dec(counter) == 1) {
+  iree_atomic_ref_count_t* counter = iree_vm_get_ref_counter_ptr(ref);
+  if (iree_vm_ref_counter_dec(counter)) {
     const iree_vm_ref_type_descriptor_t* type_descriptor =
         iree_vm_ref_get_type_descriptor(ref->type);
     if (type_descriptor->destroy) {
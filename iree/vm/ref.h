@@ -89,6 +89,21 @@ static_assert(
 
 typedef void(IREE_API_PTR* iree_vm_ref_destroy_t)(void* ptr);
 
+// Bitfield describing how objects of a ref type may be used.
+enum iree_vm_ref_type_flag_bits_t {
+  IREE_VM_REF_TYPE_FLAG_NONE = 0u,
+  // Objects of the type are immutable once created (or only expose internally
+  // synchronized state that is intended to be shared) and references to them
+  // may be shared across contexts, such as when forking a context, without
+  // one context observing changes made by another.
+  IREE_VM_REF_TYPE_FLAG_SHAREABLE = 1u << 0,
+};
+typedef uint32_t iree_vm_ref_type_flags_t;
+
+// Returns true if the object with base |ptr| cannot be observably mutated and
+// references to it may be shared across contexts.
+typedef bool(IREE_API_PTR* iree_vm_ref_is_shareable_t)(void* ptr);
+
 // Describes a type for the VM.
 typedef struct iree_vm_ref_type_descriptor_t {
   // Function called when references of this type reach 0 and should be
@@ -102,6 +117,12 @@ typedef struct iree_vm_ref_type_descriptor_t {
   iree_vm_ref_type_t type : 24;
   // Unretained type name that can be used for debugging.
   iree_string_view_t type_name;
+  // Flags describing how objects of the type may be used.
+  iree_vm_ref_type_flags_t flags;
+  // Optional function used to share individual objects of types that are not
+  // IREE_VM_REF_TYPE_FLAG_SHAREABLE, such as immutable instances of an
+  // otherwise mutable type.
+  iree_vm_ref_is_shareable_t is_shareable;
 } iree_vm_ref_type_descriptor_t;
 
 // Directly retains the object with base |ptr| with the given |type_descriptor|.
@@ -120,6 +141,47 @@ IREE_API_EXPORT void iree_vm_ref_object_retain(
 IREE_API_EXPORT void iree_vm_ref_object_release(
     void* ptr, const iree_vm_ref_type_descriptor_t* type_descriptor);
 
+// Switches the object with base |ptr| to thread-affine reference counting.
+// Retains and releases of thread-affine objects use plain (non-atomic)
+// increments and decrements and must all happen on the calling thread. This is
+// useful for objects such as temporary lists that are created, populated, and
+// consumed within a single invocation and would otherwise pay for atomic
+// operations on every retain/release.
+//
+// The caller must hold the only reference or otherwise guarantee that no other
+// thread is accessing the object. Before the object is shared with another
+// thread iree_vm_ref_object_make_shared must be called from the owning thread.
+// When IREE_VM_REF_THREAD_AFFINITY_CHECKS_ENABLE is set retains and releases
+// from other threads abort.
+//
+// Thread-affine counting is only available when the runtime is built with
+// IREE_VM_REF_THREAD_AFFINITY_ENABLE; otherwise this is a no-op and the object
+// continues to use atomic reference counting.
+//
+// Only types whose reference count is exclusively managed through the
+// iree_vm_ref_* functions (such as vm.list and vm.buffer) may be made
+// thread-affine; C++ iree::vm::RefObject types manipulate their counters
+// directly and are not supported.
+IREE_API_EXPORT void iree_vm_ref_object_make_thread_affine(
+    void* ptr, const iree_vm_ref_type_descriptor_t* type_descriptor);
+
+// Switches the object with base |ptr| back to atomic reference counting so that
+// it can be shared across threads. Must be called from the owning thread.
+IREE_API_EXPORT void iree_vm_ref_object_make_shared(
+    void* ptr, const iree_vm_ref_type_descriptor_t* type_descriptor);
+
+// Returns true if the object with base |ptr| uses thread-affine reference
+// counting.
+IREE_API_EXPORT bool iree_vm_ref_object_is_thread_affine(
+    void* ptr, const iree_vm_ref_type_descriptor_t* type_descriptor);
+
+// Aborts the program if the object with base |ptr| has any reference other
+// than the one held by the caller. Used when deinitializing objects that were
+// initialized in-place (such as on the stack) as any remaining reference would
+// point at invalid memory. Handles both atomic and thread-affine objects.
+IREE_API_EXPORT void iree_vm_ref_object_abort_if_uses(
+    void* ptr, const iree_vm_ref_type_descriptor_t* type_descriptor);
+
 // Registers a user-defined type with the IREE C ref system.
 // The provided destroy function will be used to destroy objects when their
 // reference count goes to 0. NULL can be used to no-op the destruction if the
@@ -138,6 +200,16 @@ iree_vm_ref_register_type(iree_vm_ref_type_descriptor_t* descriptor);
 IREE_API_EXPORT iree_string_view_t
 iree_vm_ref_type_name(iree_vm_ref_type_t type);
 
+// Returns the flags of the given type or IREE_VM_REF_TYPE_FLAG_NONE if the
+// type is not registered.
+IREE_API_EXPORT iree_vm_ref_type_flags_t
+iree_vm_ref_type_flags(iree_vm_ref_type_t type);
+
+// Returns true if the object referenced by |ref| may be shared across contexts
+// because either its type is IREE_VM_REF_TYPE_FLAG_SHAREABLE or the type
+// reports that the particular object cannot be mutated.
+IREE_API_EXPORT bool iree_vm_ref_is_shareable(const iree_vm_ref_t* ref);
+
 // Returns the registered type descriptor for the given type, if found.
 IREE_API_EXPORT const iree_vm_ref_type_descriptor_t*
 iree_vm_ref_lookup_registered_type(iree_string_view_t full_name);
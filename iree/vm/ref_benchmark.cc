@@ -0,0 +1,71 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "benchmark/benchmark.h"
+#include "iree/base/api.h"
+#include "iree/base/logging.h"
+#include "iree/vm/buffer.h"
+#include "iree/vm/builtin_types.h"
+#include "iree/vm/list.h"
+#include "iree/vm/ref.h"
+
+namespace {
+
+// NOTE: thread-affine variants only differ from the atomic ones when built with
+// IREE_VM_REF_THREAD_AFFINITY_ENABLE (as ref_thread_affine_benchmark is).
+static iree_vm_buffer_t* CreateBuffer(bool thread_affine) {
+  IREE_CHECK_OK(iree_vm_register_builtin_types());
+  iree_vm_buffer_t* buffer = NULL;
+  IREE_CHECK_OK(iree_vm_buffer_create(IREE_VM_BUFFER_ACCESS_MUTABLE, 16,
+                                      iree_allocator_system(), &buffer));
+  if (thread_affine) {
+    iree_vm_ref_object_make_thread_affine(buffer,
+                                          iree_vm_buffer_get_descriptor());
+  }
+  return buffer;
+}
+
+// Benchmarks a retain/release pair on a single object.
+static void BM_RetainRelease(benchmark::State& state, bool thread_affine) {
+  iree_vm_buffer_t* buffer = CreateBuffer(thread_affine);
+  iree_vm_ref_t ref = iree_vm_buffer_move_ref(buffer);
+  for (auto _ : state) {
+    iree_vm_ref_t ref_copy = {0};
+    iree_vm_ref_retain(&ref, &ref_copy);
+    benchmark::DoNotOptimize(ref_copy);
+    iree_vm_ref_release(&ref_copy);
+  }
+  iree_vm_ref_release(&ref);
+}
+BENCHMARK_CAPTURE(BM_RetainRelease, atomic, false);
+BENCHMARK_CAPTURE(BM_RetainRelease, thread_affine, true);
+
+// Benchmarks populating and clearing a list with references to the same
+// object, as happens when passing arguments and results to functions.
+static void BM_ListPushRefs(benchmark::State& state, bool thread_affine) {
+  iree_vm_buffer_t* buffer = CreateBuffer(thread_affine);
+  iree_vm_ref_t ref = iree_vm_buffer_move_ref(buffer);
+  iree_host_size_t element_count = (iree_host_size_t)state.range(0);
+  iree_vm_list_t* list = NULL;
+  IREE_CHECK_OK(iree_vm_list_create(/*element_type=*/NULL, element_count,
+                                    iree_allocator_system(), &list));
+  if (thread_affine) {
+    iree_vm_ref_object_make_thread_affine(list, iree_vm_list_get_descriptor());
+  }
+  for (auto _ : state) {
+    for (iree_host_size_t i = 0; i < element_count; ++i) {
+      IREE_CHECK_OK(iree_vm_list_push_ref_retain(list, &ref));
+    }
+    IREE_CHECK_OK(iree_vm_list_resize(list, 0));
+  }
+  state.SetItemsProcessed(state.iterations() * element_count);
+  iree_vm_list_release(list);
+  iree_vm_ref_release(&ref);
+}
+BENCHMARK_CAPTURE(BM_ListPushRefs, atomic, false)->Arg(64)->Arg(4096);
+BENCHMARK_CAPTURE(BM_ListPushRefs, thread_affine, true)->Arg(64)->Arg(4096);
+
+}  // namespace
@@ -7,10 +7,13 @@
 #include "iree/vm/ref.h"
 
 #include <cstddef>
+#include <thread>
 
 #include "iree/base/api.h"
 #include "iree/testing/gtest.h"
 #include "iree/testing/status_matchers.h"
+#include "iree/vm/buffer.h"
+#include "iree/vm/builtin_types.h"
 #include "iree/vm/ref_cc.h"
 
 namespace {
@@ -88,6 +91,62 @@ TEST(VMRefTest, TypeRegistration) {
                          iree_make_cstring_view("asodjfaoisdjfaoisdfj")));
 }
 
+// Tests that objects are shareable when their type is or when the type
+// reports the individual object as shareable.
+TEST(VMRefTest, IsShareable) {
+  iree_vm_ref_t null_ref = {0};
+  EXPECT_FALSE(iree_vm_ref_is_shareable(&null_ref));
+
+  static iree_vm_ref_type_descriptor_t shareable_descriptor = {0};
+  if (shareable_descriptor.type == IREE_VM_REF_TYPE_NULL) {
+    shareable_descriptor.type_name = iree_make_cstring_view("ShareableCType");
+    shareable_descriptor.offsetof_counter =
+        offsetof(ref_object_c_t, ref_object.counter);
+    shareable_descriptor.destroy =
+        +[](void* ptr) { delete reinterpret_cast<ref_object_c_t*>(ptr); };
+    shareable_descriptor.flags = IREE_VM_REF_TYPE_FLAG_SHAREABLE;
+    IREE_ASSERT_OK(iree_vm_ref_register_type(&shareable_descriptor));
+  }
+  iree_vm_ref_t shareable_ref = {0};
+  IREE_ASSERT_OK(iree_vm_ref_wrap_assign(
+      new ref_object_c_t(), shareable_descriptor.type, &shareable_ref));
+  EXPECT_TRUE(iree_vm_ref_is_shareable(&shareable_ref));
+  iree_vm_ref_release(&shareable_ref);
+
+  // Objects with data == 0 are treated as immutable by the type.
+  static iree_vm_ref_type_descriptor_t per_object_descriptor = {0};
+  if (per_object_descriptor.type == IREE_VM_REF_TYPE_NULL) {
+    per_object_descriptor.type_name = iree_make_cstring_view("MaybeCType");
+    per_object_descriptor.offsetof_counter =
+        offsetof(ref_object_c_t, ref_object.counter);
+    per_object_descriptor.destroy =
+        +[](void* ptr) { delete reinterpret_cast<ref_object_c_t*>(ptr); };
+    per_object_descriptor.is_shareable = +[](void* ptr) {
+      return reinterpret_cast<ref_object_c_t*>(ptr)->data == 0;
+    };
+    IREE_ASSERT_OK(iree_vm_ref_register_type(&per_object_descriptor));
+  }
+  auto* immutable_object = new ref_object_c_t();
+  immutable_object->data = 0;
+  iree_vm_ref_t immutable_ref = {0};
+  IREE_ASSERT_OK(iree_vm_ref_wrap_assign(
+      immutable_object, per_object_descriptor.type, &immutable_ref));
+  EXPECT_TRUE(iree_vm_ref_is_shareable(&immutable_ref));
+  iree_vm_ref_release(&immutable_ref);
+  iree_vm_ref_t mutable_ref = {0};
+  IREE_ASSERT_OK(iree_vm_ref_wrap_assign(
+      new ref_object_c_t(), per_object_descriptor.type, &mutable_ref));
+  EXPECT_FALSE(iree_vm_ref_is_shareable(&mutable_ref));
+  iree_vm_ref_release(&mutable_ref);
+
+  RegisterTypeC();
+  iree_vm_ref_t c_ref = {0};
+  IREE_ASSERT_OK(iree_vm_ref_wrap_assign(new ref_object_c_t(), kCTypeID,
+                                         &c_ref));
+  EXPECT_FALSE(iree_vm_ref_is_shareable(&c_ref));
+  iree_vm_ref_release(&c_ref);
+}
+
 // Tests wrapping a simple C struct.
 TEST(VMRefTest, WrappingCStruct) {
   RegisterTypeC();
@@ -449,4 +508,118 @@ TEST(VMRefTest, EqualityDifferentTypes) {
   iree_vm_ref_release(&a_ref);
 }
 
+#if IREE_VM_REF_THREAD_AFFINITY_ENABLE
+
+// Tests retaining and releasing a thread-affine object.
+TEST(VMRefTest, ThreadAffineRetainRelease) {
+  RegisterTypeC();
+  const iree_vm_ref_type_descriptor_t* descriptor =
+      iree_vm_ref_lookup_registered_type(iree_make_cstring_view("CType"));
+  iree_vm_ref_t ref = {0};
+  IREE_EXPECT_OK(iree_vm_ref_wrap_assign(new ref_object_c_t(), kCTypeID, &ref));
+  EXPECT_FALSE(iree_vm_ref_object_is_thread_affine(ref.ptr, descriptor));
+  iree_vm_ref_object_make_thread_affine(ref.ptr, descriptor);
+  EXPECT_TRUE(iree_vm_ref_object_is_thread_affine(ref.ptr, descriptor));
+
+  iree_vm_ref_t ref_copy = {0};
+  iree_vm_ref_retain(&ref, &ref_copy);
+  iree_vm_ref_object_retain(ref.ptr, descriptor);
+  iree_vm_ref_object_release(ref.ptr, descriptor);
+  iree_vm_ref_release(&ref_copy);
+
+  // Switching back to shared mode must preserve the count.
+  iree_vm_ref_object_make_shared(ref.ptr, descriptor);
+  EXPECT_FALSE(iree_vm_ref_object_is_thread_affine(ref.ptr, descriptor));
+  EXPECT_EQ(1, ReadCounter(&ref));
+  iree_vm_ref_release(&ref);
+}
+
+// Tests that the last release of a thread-affine object destroys it.
+TEST(VMRefTest, ThreadAffineDestroy) {
+  struct DestroyTracker : public ref_object_c_t {
+    explicit DestroyTracker(bool* destroyed) : destroyed(destroyed) {}
+    bool* destroyed;
+  };
+  static iree_vm_ref_type_descriptor_t descriptor = {0};
+  if (descriptor.type == IREE_VM_REF_TYPE_NULL) {
+    descriptor.type_name = iree_make_cstring_view("DestroyTracker");
+    descriptor.offsetof_counter = offsetof(ref_object_c_t, ref_object.counter);
+    descriptor.destroy = +[](void* ptr) {
+      auto* tracker = reinterpret_cast<DestroyTracker*>(ptr);
+      *tracker->destroyed = true;
+      delete tracker;
+    };
+    IREE_ASSERT_OK(iree_vm_ref_register_type(&descriptor));
+  }
+
+  bool destroyed = false;
+  iree_vm_ref_t ref = {0};
+  IREE_EXPECT_OK(iree_vm_ref_wrap_assign(new DestroyTracker(&destroyed),
+                                         descriptor.type, &ref));
+  iree_vm_ref_object_make_thread_affine(ref.ptr, &descriptor);
+  iree_vm_ref_t ref_copy = {0};
+  iree_vm_ref_retain(&ref, &ref_copy);
+  iree_vm_ref_release(&ref);
+  EXPECT_FALSE(destroyed);
+  iree_vm_ref_release(&ref_copy);
+  EXPECT_TRUE(destroyed);
+}
+
+// Tests that deinitializing an in-place thread-affine object holding only the
+// initial reference succeeds.
+TEST(VMRefTest, ThreadAffineDeinitialize) {
+  IREE_ASSERT_OK(iree_vm_register_builtin_types());
+  uint8_t storage[16] = {0};
+  iree_vm_buffer_t buffer;
+  iree_vm_buffer_initialize(IREE_VM_BUFFER_ACCESS_MUTABLE,
+                            iree_make_byte_span(storage, sizeof(storage)),
+                            iree_allocator_null(), &buffer);
+  iree_vm_ref_object_make_thread_affine(&buffer,
+                                        iree_vm_buffer_get_descriptor());
+  iree_vm_ref_object_retain(&buffer, iree_vm_buffer_get_descriptor());
+  iree_vm_ref_object_release(&buffer, iree_vm_buffer_get_descriptor());
+  iree_vm_buffer_deinitialize(&buffer);
+}
+
+#if IREE_VM_REF_THREAD_AFFINITY_CHECKS_ENABLE
+
+// Tests that retaining a thread-affine object from a thread other than its
+// owner aborts.
+TEST(VMRefDeathTest, ThreadAffineCrossThreadRetain) {
+  RegisterTypeC();
+  const iree_vm_ref_type_descriptor_t* descriptor =
+      iree_vm_ref_lookup_registered_type(iree_make_cstring_view("CType"));
+  iree_vm_ref_t ref = {0};
+  IREE_EXPECT_OK(iree_vm_ref_wrap_assign(new ref_object_c_t(), kCTypeID, &ref));
+  iree_vm_ref_object_make_thread_affine(ref.ptr, descriptor);
+  EXPECT_DEATH(
+      {
+        std::thread thread(
+            [&]() { iree_vm_ref_object_retain(ref.ptr, descriptor); });
+        thread.join();
+      },
+      "");
+  iree_vm_ref_release(&ref);
+}
+
+#endif  // IREE_VM_REF_THREAD_AFFINITY_CHECKS_ENABLE
+
+#else
+
+// Tests that objects remain atomically counted when thread-affine counting is
+// not compiled in.
+TEST(VMRefTest, ThreadAffineDisabled) {
+  RegisterTypeC();
+  const iree_vm_ref_type_descriptor_t* descriptor =
+      iree_vm_ref_lookup_registered_type(iree_make_cstring_view("CType"));
+  iree_vm_ref_t ref = {0};
+  IREE_EXPECT_OK(iree_vm_ref_wrap_assign(new ref_object_c_t(), kCTypeID, &ref));
+  iree_vm_ref_object_make_thread_affine(ref.ptr, descriptor);
+  EXPECT_FALSE(iree_vm_ref_object_is_thread_affine(ref.ptr, descriptor));
+  EXPECT_EQ(1, ReadCounter(&ref));
+  iree_vm_ref_release(&ref);
+}
+
+#endif  // IREE_VM_REF_THREAD_AFFINITY_ENABLE
+
 }  // namespace
@@ -173,6 +173,16 @@ struct iree_vm_stack_t {
   iree_host_size_t frame_storage_size;
   void* frame_storage;
 
+  // Offset of frame_storage from the base of the storage provided during
+  // initialization. Used to report the total storage size required.
+  iree_host_size_t frame_storage_offset;
+
+  // Peak frame_storage_size observed over the lifetime of the stack.
+  iree_host_size_t frame_storage_peak_size;
+
+  // Total number of times iree_vm_stack_grow has reallocated storage.
+  uint32_t resize_count;
+
   // Flags controlling the behavior of the invocation owning this stack.
   iree_vm_invocation_flags_t flags;
 
@@ -221,6 +231,7 @@ IREE_API_EXPORT iree_status_t iree_vm_stack_initialize(
   stack->frame_storage_capacity = storage.data_length - storage_offset;
   stack->frame_storage_size = 0;
   stack->frame_storage = storage.data + storage_offset;
+  stack->frame_storage_offset = storage_offset;
 
   stack->top = NULL;
 
@@ -278,6 +289,15 @@ IREE_API_EXPORT void iree_vm_stack_free(iree_vm_stack_t* stack) {
   IREE_TRACE_ZONE_END(z0);
 }
 
+IREE_API_EXPORT iree_vm_stack_statistics_t
+iree_vm_stack_query_statistics(const iree_vm_stack_t* stack) {
+  iree_vm_stack_statistics_t statistics;
+  statistics.resize_count = stack->resize_count;
+  statistics.peak_storage_size =
+      stack->frame_storage_offset + stack->frame_storage_peak_size;
+  return statistics;
+}
+
 IREE_API_EXPORT iree_vm_invocation_flags_t
 iree_vm_stack_invocation_flags(const iree_vm_stack_t* stack) {
   return stack->flags;
@@ -354,6 +374,7 @@ static iree_status_t iree_vm_stack_grow(iree_vm_stack_t* stack,
   stack->frame_storage = new_storage;
   stack->frame_storage_capacity = new_capacity;
   stack->owns_frame_storage = true;
+  ++stack->resize_count;
 
 #define REBASE_POINTER(type, ptr, old_base, new_base)           \
   if (ptr) {                                                    \
@@ -423,6 +444,9 @@ IREE_API_EXPORT iree_status_t iree_vm_stack_function_enter(
 
   stack->frame_storage_size = new_top;
   stack->top = frame_header;
+  if (new_top > stack->frame_storage_peak_size) {
+    stack->frame_storage_peak_size = new_top;
+  }
 
   IREE_TRACE({
     if (frame_type != IREE_VM_STACK_FRAME_NATIVE) {
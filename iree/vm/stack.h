@@ -188,6 +188,22 @@ IREE_API_EXPORT iree_status_t iree_vm_stack_allocate(
 // Frees a dynamically-allocated |stack| from iree_vm_stack_allocate.
 IREE_API_EXPORT void iree_vm_stack_free(iree_vm_stack_t* stack);
 
+// Statistics tracked over the lifetime of a stack.
+typedef struct iree_vm_stack_statistics_t {
+  // Total number of times the frame storage was grown via the allocator.
+  // Steady-state invocations should observe 0 when stack storage is sized
+  // appropriately (such as when pooled by iree_vm_context_t).
+  uint32_t resize_count;
+  // Peak storage size, in bytes, including the stack header and all frames.
+  // Storage of at least this size can be provided to iree_vm_stack_initialize
+  // for a subsequent invocation of the same function to avoid any growth.
+  iree_host_size_t peak_storage_size;
+} iree_vm_stack_statistics_t;
+
+// Returns the statistics accumulated by |stack| since initialization.
+IREE_API_EXPORT iree_vm_stack_statistics_t
+iree_vm_stack_query_statistics(const iree_vm_stack_t* stack);
+
 // Returns the flags controlling the invocation this stack is used with.
 IREE_API_EXPORT iree_vm_invocation_flags_t
 iree_vm_stack_invocation_flags(const iree_vm_stack_t* stack);
@@ -6,6 +6,8 @@
 
 #include "iree/vm/stack.h"
 
+#include <vector>
+
 #include "iree/base/api.h"
 #include "iree/testing/gtest.h"
 #include "iree/testing/status_matchers.h"
@@ -120,6 +122,50 @@ TEST(VMStackTest, StackOverflow) {
   iree_vm_stack_deinitialize(stack);
 }
 
+// Tests that growth is tracked and that the reported peak storage size is
+// sufficient to run the same frames again without growing.
+TEST(VMStackTest, GrowthStatistics) {
+  iree_vm_state_resolver_t state_resolver = {nullptr, SentinelStateResolver};
+  iree_vm_stack_t* stack = nullptr;
+  IREE_ASSERT_OK(iree_vm_stack_allocate(IREE_VM_INVOCATION_FLAG_NONE,
+                                        state_resolver, iree_allocator_system(),
+                                        &stack));
+
+  iree_vm_function_t function_a = {MODULE_A_SENTINEL,
+                                   IREE_VM_FUNCTION_LINKAGE_INTERNAL, 0};
+  static const int kFrameCount = 8;
+  static const iree_host_size_t kFrameSize = 4 * 1024;
+  for (int i = 0; i < kFrameCount; ++i) {
+    IREE_ASSERT_OK(iree_vm_stack_function_enter(stack, &function_a,
+                                                IREE_VM_STACK_FRAME_NATIVE,
+                                                kFrameSize, NULL, NULL));
+  }
+  for (int i = 0; i < kFrameCount; ++i) {
+    IREE_ASSERT_OK(iree_vm_stack_function_leave(stack));
+  }
+  iree_vm_stack_statistics_t statistics =
+      iree_vm_stack_query_statistics(stack);
+  EXPECT_GE(statistics.resize_count, 1u);
+  EXPECT_GE(statistics.peak_storage_size, kFrameCount * kFrameSize);
+  iree_vm_stack_free(stack);
+
+  // Reusing storage of the peak size should require no growth.
+  std::vector<uint8_t> storage(statistics.peak_storage_size);
+  IREE_ASSERT_OK(iree_vm_stack_initialize(
+      iree_make_byte_span(storage.data(), storage.size()),
+      IREE_VM_INVOCATION_FLAG_NONE, state_resolver, iree_allocator_null(),
+      &stack));
+  for (int i = 0; i < kFrameCount; ++i) {
+    IREE_ASSERT_OK(iree_vm_stack_function_enter(stack, &function_a,
+                                                IREE_VM_STACK_FRAME_NATIVE,
+                                                kFrameSize, NULL, NULL));
+  }
+  statistics = iree_vm_stack_query_statistics(stack);
+  EXPECT_EQ(0u, statistics.resize_count);
+  EXPECT_EQ(storage.size(), statistics.peak_storage_size);
+  iree_vm_stack_deinitialize(stack);
+}
+
 // Tests unbalanced stack popping.
 TEST(VMStackTest, UnbalancedPop) {
   iree_vm_state_resolver_t state_resolver = {nullptr, SentinelStateResolver};
@@ -0,0 +1,75 @@
+vm.module @yield_ops {
+
+  //===--------------------------------------------------------------------===//
+  // vm.yield
+  //===--------------------------------------------------------------------===//
+  // The functions here are invoked with iree_vm_invoke, which resumes each
+  // yield until the function returns.
+
+  vm.export @test_yield
+  vm.func @test_yield() {
+    %c1 = vm.const.i32 1
+    %c1dno = util.do_not_optimize(%c1) : i32
+    vm.yield ^bb1
+  ^bb1:
+    vm.check.eq %c1dno, %c1, "value changed across yield" : i32
+    vm.return
+  }
+
+  vm.export @test_yield_operands
+  vm.func @test_yield_operands() {
+    %c2 = vm.const.i32 2
+    %c3 = vm.const.i32 3
+    %c5 = vm.const.i32 5
+    %c2dno = util.do_not_optimize(%c2) : i32
+    %c3dno = util.do_not_optimize(%c3) : i32
+    vm.yield ^bb1(%c3dno, %c2dno : i32, i32)
+  ^bb1(%a : i32, %b : i32):
+    vm.check.eq %a, %c3, "first operand lost across yield" : i32
+    vm.check.eq %b, %c2, "second operand lost across yield" : i32
+    %sum = vm.add.i32 %a, %b : i32
+    vm.check.eq %sum, %c5, "error!" : i32
+    vm.return
+  }
+
+  vm.export @test_yield_loop
+  vm.func @test_yield_loop() {
+    %c0 = vm.const.i32 0
+    %c1 = vm.const.i32 1
+    %c4 = vm.const.i32 4
+    %c0dno = util.do_not_optimize(%c0) : i32
+    vm.br ^loop(%c0dno : i32)
+  ^loop(%i : i32):
+    %next = vm.add.i32 %i, %c1 : i32
+    %done = vm.cmp.eq.i32 %next, %c4 : i32
+    vm.cond_br %done, ^exit(%next : i32), ^yield(%next : i32)
+  ^yield(%j : i32):
+    vm.yield ^loop(%j : i32)
+  ^exit(%result : i32):
+    vm.check.eq %result, %c4, "error!" : i32
+    vm.return
+  }
+
+  // Yields from within an internal call; resuming must continue in the callee
+  // and then return to the caller.
+  vm.export @test_yield_in_callee
+  vm.func @test_yield_in_callee() {
+    %c3 = vm.const.i32 3
+    %c7 = vm.const.i32 7
+    %c3dno = util.do_not_optimize(%c3) : i32
+    %0 = vm.call @yield_add4(%c3dno) : (i32) -> i32
+    vm.check.eq %0, %c7, "error!" : i32
+    vm.return
+  }
+
+  vm.func private @yield_add4(%arg0 : i32) -> i32 {
+    %c4 = vm.const.i32 4
+    vm.yield ^bb1
+  ^bb1:
+    %0 = vm.add.i32 %arg0, %c4 : i32
+    vm.yield ^bb2(%0 : i32)
+  ^bb2(%1 : i32):
+    vm.return %1 : i32
+  }
+
+}
@@ -0,0 +1,335 @@
+#!/usr/bin/env python3
+
+# Copyright 2022 The IREE Authors
+#
+# Licensed under the Apache License v2.0 with LLVM Exceptions.
+# See https://llvm.org/LICENSE.txt for license information.
+# SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+"""Tunes the lowering configurations of the CPU dispatches of a model offline.
+
+The model is compiled once with the default configurations and the compiler
+reports (--iree-codegen-llvm-tuning-report) the root op, loop ranges, tile
+sizes and pipeline chosen for every dispatch along with the key identifying
+the executable. Candidate tile sizes are then generated around each default
+configuration; each candidate is compiled through a tuning database
+(--iree-codegen-llvm-tuning-database) holding the best configurations found so
+far plus the candidate and benchmarked with iree-benchmark-module. Dispatches
+are tuned one after another (coordinate descent) and the winners are written
+to a tuning database that later compilations consume with
+--iree-codegen-llvm-tuning-database=<database>.
+
+Candidates that fail to compile (e.g. because the pipeline rejects the tile
+sizes) are skipped. The sources of the tuned executables are dumped to the
+`sources` directory of --work_dir for inspection.
+
+Example:
+  python3 scripts/tune_cpu_dispatches.py \\
+    --input=model.mlir \\
+    --compile_arg=--iree-input-type=mhlo \\
+    --compile_arg=--iree-hal-target-backends=dylib-llvm-aot \\
+    --compile_arg=--iree-llvm-target-cpu-features=host \\
+    --database=model_tuning.json
+"""
+
+import argparse
+import json
+import os
+import subprocess
+import tempfile
+from typing import Any, Dict, List, Optional, Sequence
+
+# Version of the tuning database format; see
+# iree/compiler/Codegen/LLVMCPU/TuningDatabase.h.
+TUNING_DATABASE_VERSION = 1
+
+# Factors applied to the default tile sizes to generate candidates.
+TILE_SIZE_FACTORS = [0.5, 2]
+
+# Time units reported by Google Benchmark in milliseconds.
+TIME_UNIT_TO_MS = {"ns": 1e-6, "us": 1e-3, "ms": 1.0, "s": 1e3}
+
+
+def parse_arguments():
+  """Parses command line arguments."""
+  parser = argparse.ArgumentParser(
+      description=__doc__, formatter_class=argparse.RawTextHelpFormatter)
+  parser.add_argument("--input",
+                      type=str,
+                      required=True,
+                      metavar="<input-file>",
+                      help="The model to tune, as accepted by iree-compile")
+  parser.add_argument("--database",
+                      type=str,
+                      required=True,
+                      metavar="<database-file>",
+                      help="The tuning database to write. Entries of an "
+                      "existing database for other dispatches are kept")
+  parser.add_argument("--compile_arg",
+                      action="append",
+                      default=[],
+                      metavar="<compile-arg>",
+                      help="Additional argument for iree-compile; may be "
+                      "repeated")
+  parser.add_argument("--iree_compile",
+                      type=str,
+                      default="iree-compile",
+                      metavar="<path>",
+                      help="Path to iree-compile")
+  parser.add_argument("--iree_benchmark_module",
+                      type=str,
+                      default="iree-benchmark-module",
+                      metavar="<path>",
+                      help="Path to iree-benchmark-module")
+  parser.add_argument("--driver",
+                      type=str,
+                      default="dylib",
+                      metavar="<driver>",
+                      help="The IREE driver to benchmark with")
+  parser.add_argument("--entry_function",
+                      type=str,
+                      default=None,
+                      metavar="<entry-function>",
+                      help="The function to benchmark with --function_input. "
+                      "When omitted the module is compiled with "
+                      "--iree-flow-export-benchmark-funcs and all exported "
+                      "benchmark functions are run")
+  parser.add_argument("--function_input",
+                      action="append",
+                      default=[],
+                      metavar="<function-input>",
+                      help="Input of --entry_function; may be repeated")
+  parser.add_argument("--benchmark_repetitions",
+                      type=int,
+                      default=5,
+                      help="Repetitions of each benchmark; the median is used")
+  parser.add_argument("--max_candidates",
+                      type=int,
+                      default=16,
+                      help="Maximum number of candidates tried per dispatch")
+  parser.add_argument("--min_improvement",
+                      type=float,
+                      default=0.01,
+                      help="Minimum relative improvement for a candidate to "
+                      "replace the best configuration")
+  parser.add_argument("--work_dir",
+                      type=str,
+                      default=None,
+                      metavar="<dir>",
+                      help="Directory for intermediate files; a temporary "
+                      "directory is used by default")
+  return parser.parse_args()
+
+
+def run_command(command: Sequence[str]) -> Optional[str]:
+  """Runs `command` and returns its stdout, or None if it failed."""
+  process = subprocess.run(command,
+                           stdout=subprocess.PIPE,
+                           stderr=subprocess.PIPE,
+                           universal_newlines=True)
+  if process.returncode != 0:
+    print(f"  `{' '.join(command)}` failed:")
+    print("\n".join(process.stderr.splitlines()[:10]))
+    return None
+  return process.stdout
+
+
+def format_compilation_info(config: Dict[str, Any]) -> str:
+  """Returns the #iree_codegen.compilation_info attribute for `config`."""
+  tile_sizes = ", ".join(
+      "[" + ", ".join(str(size) for size in level) + "]"
+      for level in config["tile_sizes"])
+  lowering_config = f"tile_sizes = [{tile_sizes}]"
+  if config.get("native_vector_size"):
+    native_vector_size = ", ".join(
+        str(size) for size in config["native_vector_size"])
+    lowering_config += f", native_vector_size = [{native_vector_size}]"
+  workgroup_size = ", ".join(
+      str(size) for size in config.get("workgroup_size", []))
+  return ("#iree_codegen.compilation_info<"
+          f"lowering_config = <{lowering_config}>, "
+          f"translation_info = <{config['pipeline']}>, "
+          f"workgroup_size = [{workgroup_size}]>")
+
+
+def generate_candidates(record: Dict[str, Any],
+                        max_candidates: int) -> List[Dict[str, Any]]:
+  """Generates candidate configurations around the default one in `record`.
+
+  Each nonzero tile size of each tiling level is scaled by TILE_SIZE_FACTORS,
+  first one size at a time and then all sizes of a level together. Sizes are
+  clamped to the static loop ranges and duplicates of the default are dropped.
+  """
+  default_tile_sizes = record["tile_sizes"]
+  loop_ranges = record.get("loop_ranges", [])
+
+  def clamp(dim, size):
+    size = max(1, int(size))
+    if dim < len(loop_ranges) and loop_ranges[dim] > 0:
+      size = min(size, loop_ranges[dim])
+    return size
+
+  variants = []
+  for level, sizes in enumerate(default_tile_sizes):
+    tiled_dims = [dim for dim, size in enumerate(sizes) if size != 0]
+    for factor in TILE_SIZE_FACTORS:
+      for dim in tiled_dims:
+        variants.append((level, [dim], factor))
+      if len(tiled_dims) > 1:
+        variants.append((level, tiled_dims, factor))
+
+  candidates = []
+  seen = {json.dumps(default_tile_sizes)}
+  for level, dims, factor in variants:
+    tile_sizes = [list(sizes) for sizes in default_tile_sizes]
+    for dim in dims:
+      tile_sizes[level][dim] = clamp(dim, tile_sizes[level][dim] * factor)
+    signature = json.dumps(tile_sizes)
+    if signature in seen:
+      continue
+    seen.add(signature)
+    candidate = dict(record)
+    candidate["tile_sizes"] = tile_sizes
+    candidates.append(candidate)
+    if len(candidates) >= max_candidates:
+      break
+  return candidates
+
+
+def write_database(path: str, entries: Dict[tuple, Dict[str, Any]]):
+  """Writes `entries` keyed by (key, entry point) as a tuning database."""
+  database = {
+      "version": TUNING_DATABASE_VERSION,
+      "entries": [entries[k] for k in sorted(entries)],
+  }
+  with open(path, "w") as f:
+    json.dump(database, f, indent=2)
+    f.write("\n")
+
+
+def read_database(path: str) -> Dict[tuple, Dict[str, Any]]:
+  """Reads the entries of the tuning database at `path`, if it exists."""
+  if not os.path.exists(path):
+    return {}
+  with open(path) as f:
+    database = json.load(f)
+  if database.get("version", TUNING_DATABASE_VERSION) != \
+      TUNING_DATABASE_VERSION:
+    raise ValueError(f"unsupported tuning database version in {path}")
+  return {(entry["key"], entry["entry_point"]): entry
+          for entry in database["entries"]}
+
+
+class Tuner(object):
+  """Compiles and benchmarks the model under different tuning databases."""
+
+  def __init__(self, args, work_dir: str):
+    self.args = args
+    self.work_dir = work_dir
+    self.run_count = 0
+
+  def compile(self, database: Optional[str],
+              report: Optional[str]) -> Optional[str]:
+    """Compiles the model and returns the path of the module, or None."""
+    self.run_count += 1
+    module = os.path.join(self.work_dir, f"module_{self.run_count}.vmfb")
+    command = [self.args.iree_compile, self.args.input, "-o", module]
+    command += self.args.compile_arg
+    if not self.args.entry_function:
+      command.append("--iree-flow-export-benchmark-funcs")
+    if database:
+      command.append(f"--iree-codegen-llvm-tuning-database={database}")
+    if report:
+      command.append(f"--iree-codegen-llvm-tuning-report={report}")
+      sources = os.path.join(self.work_dir, "sources")
+      command.append(f"--iree-hal-dump-executable-sources-to={sources}")
+    if run_command(command) is None:
+      return None
+    return module
+
+  def benchmark(self, module: str) -> Optional[float]:
+    """Returns the median time in ms of the benchmarks of `module`."""
+    command = [
+        self.args.iree_benchmark_module, f"--module_file={module}",
+        f"--driver={self.args.driver}", "--benchmark_format=json",
+        f"--benchmark_repetitions={self.args.benchmark_repetitions}",
+        "--benchmark_report_aggregates_only=true"
+    ]
+    if self.args.entry_function:
+      command.append(f"--entry_function={self.args.entry_function}")
+      command += [f"--function_input={i}" for i in self.args.function_input]
+    output = run_command(command)
+    os.remove(module)
+    if output is None:
+      return None
+    total_ms = 0.0
+    for benchmark in json.loads(output)["benchmarks"]:
+      if benchmark.get("aggregate_name", "median") != "median":
+        continue
+      total_ms += benchmark["real_time"] * TIME_UNIT_TO_MS[
+          benchmark.get("time_unit", "ns")]
+    return total_ms
+
+  def measure(self, database: Optional[str] = None,
+              report: Optional[str] = None) -> Optional[float]:
+    module = self.compile(database, report)
+    if module is None:
+      return None
+    return self.benchmark(module)
+
+
+def main(args):
+  work_dir = args.work_dir or tempfile.mkdtemp(prefix="iree-tuning-")
+  os.makedirs(work_dir, exist_ok=True)
+  tuner = Tuner(args, work_dir)
+
+  # Compile with the default configurations to find the dispatches to tune.
+  report = os.path.join(work_dir, "report.jsonl")
+  if os.path.exists(report):
+    os.remove(report)
+  best_ms = tuner.measure(report=report)
+  if best_ms is None:
+    raise RuntimeError("failed to compile or benchmark the default model")
+  records = {}
+  with open(report) as f:
+    for line in f:
+      record = json.loads(line)
+      records.setdefault((record["key"], record["entry_point"]), record)
+  print(f"Default configuration: {best_ms:.3f} ms, "
+        f"{len(records)} dispatches to tune")
+
+  database = os.path.join(work_dir, "database.json")
+  best_entries = {}
+  for dispatch, record in records.items():
+    print(f"Tuning {record['entry_point']} ({record['root_op']}, "
+          f"loop ranges {record.get('loop_ranges')}, "
+          f"tile sizes {record['tile_sizes']})")
+    for candidate in generate_candidates(record, args.max_candidates):
+      entry = {
+          "key": dispatch[0],
+          "entry_point": dispatch[1],
+          "compilation_info": format_compilation_info(candidate),
+      }
+      entries = dict(best_entries)
+      entries[dispatch] = entry
+      write_database(database, entries)
+      candidate_ms = tuner.measure(database=database)
+      if candidate_ms is None:
+        continue
+      print(f"  {candidate['tile_sizes']}: {candidate_ms:.3f} ms")
+      if candidate_ms < best_ms * (1 - args.min_improvement):
+        entry["time_ms"] = candidate_ms
+        best_entries[dispatch] = entry
+        best_ms = candidate_ms
+
+  # Merge with the entries of the existing database for other dispatches.
+  entries = read_database(args.database)
+  for dispatch in records:
+    entries.pop(dispatch, None)
+  entries.update(best_entries)
+  write_database(args.database, entries)
+  print(f"Tuned configuration: {best_ms:.3f} ms, {len(best_entries)} "
+        f"dispatches improved; wrote {args.database}")
+
+
+if __name__ == "__main__":
+  main(parse_arguments())